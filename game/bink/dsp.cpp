@@ -0,0 +1,403 @@
+#include "dsp.h"
+#include "dsp_idct.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#define BINK_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BINK_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+using namespace Bink;
+using namespace Bink::Dsp;
+
+namespace {
+
+struct ScalarOp {
+  static int add(int a, int b) { return a+b; }
+  static int sub(int a, int b) { return a-b; }
+  static int mul(int c, int x) { return int(uint32_t(c)*uint32_t(x)) >> 11; }
+  };
+
+// reference implementation: columns, then rows
+void scalarIdct(int32_t out[64], const int32_t* block) {
+  int temp[64];
+  for(int i=0; i<8; ++i) {
+    const int32_t* src = block+i;
+    if((src[8]|src[16]|src[24]|src[32]|src[40]|src[48]|src[56])==0) {
+      for(int r=0; r<8; ++r)
+        temp[r*8+i] = src[0];
+      continue;
+      }
+    int v[8];
+    for(int r=0; r<8; ++r)
+      v[r] = src[r*8];
+    idct1d<ScalarOp>(v);
+    for(int r=0; r<8; ++r)
+      temp[r*8+i] = v[r];
+    }
+  for(int i=0; i<8; ++i) {
+    int v[8];
+    for(int c=0; c<8; ++c)
+      v[c] = temp[i*8+c];
+    idct1d<ScalarOp>(v);
+    for(int c=0; c<8; ++c)
+      out[i*8+c] = (v[c] + 0x7F)>>8;
+    }
+  }
+
+void scalarIdctPut(uint8_t* dst, const int32_t* block) {
+  int32_t out[64];
+  scalarIdct(out,block);
+  for(int i=0; i<64; ++i)
+    dst[i] = uint8_t(out[i]);
+  }
+
+void scalarIdctAdd(uint8_t* dst, const uint8_t* prev, const int32_t* block) {
+  int32_t out[64];
+  scalarIdct(out,block);
+  for(int i=0; i<64; ++i)
+    dst[i] = uint8_t(prev[i]+out[i]);
+  }
+
+// BT.601, fixed point 8.8: 1.164*(Y-16), 1.596*V, 0.392*U, 0.813*V, 2.017*U
+inline uint8_t clampU8(int v) {
+  return uint8_t(std::clamp(v,0,255));
+  }
+
+inline void yuvPixel(uint8_t* rgba, int y, int u, int v) {
+  const int c = 298*(y-16) + 128;
+  const int d = u - 128;
+  const int e = v - 128;
+  rgba[0] = clampU8((c + 409*e)         >> 8);
+  rgba[1] = clampU8((c - 100*d - 208*e) >> 8);
+  rgba[2] = clampU8((c + 516*d)         >> 8);
+  rgba[3] = 255;
+  }
+
+void yuvTail(uint8_t* dst0, uint8_t* dst1, const uint8_t* py0, const uint8_t* py1,
+             const uint8_t* pu, const uint8_t* pv, uint32_t x, uint32_t w) {
+  for(; x<w; ++x) {
+    yuvPixel(dst0+x*4,py0[x],pu[x/2],pv[x/2]);
+    if(py1!=nullptr)
+      yuvPixel(dst1+x*4,py1[x],pu[x/2],pv[x/2]);
+    }
+  }
+
+void scalarYuvRow2(uint8_t* dst0, uint8_t* dst1, const uint8_t* py0, const uint8_t* py1,
+                   const uint8_t* pu, const uint8_t* pv, uint32_t w) {
+  yuvTail(dst0,dst1,py0,py1,pu,pv,0,w);
+  }
+
+#if defined(BINK_SSE2)
+struct Sse2Op {
+  static __m128i add(__m128i a, __m128i b) { return _mm_add_epi32(a,b); }
+  static __m128i sub(__m128i a, __m128i b) { return _mm_sub_epi32(a,b); }
+  static __m128i mul(int c, __m128i x) {
+    // no mullo_epi32 in SSE2: multiply even and odd lanes separately
+    const __m128i k  = _mm_set1_epi32(c);
+    const __m128i ev = _mm_mul_epu32(x,k);
+    const __m128i od = _mm_mul_epu32(_mm_srli_epi64(x,32),k);
+    const __m128i lo = _mm_unpacklo_epi32(_mm_shuffle_epi32(ev,_MM_SHUFFLE(0,0,2,0)),
+                                          _mm_shuffle_epi32(od,_MM_SHUFFLE(0,0,2,0)));
+    return _mm_srai_epi32(lo,11);
+    }
+  };
+
+inline void transpose4(__m128i& a, __m128i& b, __m128i& c, __m128i& d) {
+  const __m128i t0 = _mm_unpacklo_epi32(a,b);
+  const __m128i t1 = _mm_unpacklo_epi32(c,d);
+  const __m128i t2 = _mm_unpackhi_epi32(a,b);
+  const __m128i t3 = _mm_unpackhi_epi32(c,d);
+  a = _mm_unpacklo_epi64(t0,t1);
+  b = _mm_unpackhi_epi64(t0,t1);
+  c = _mm_unpacklo_epi64(t2,t3);
+  d = _mm_unpackhi_epi64(t2,t3);
+  }
+
+inline void transpose8(__m128i lo[8], __m128i hi[8]) {
+  transpose4(lo[0],lo[1],lo[2],lo[3]);
+  transpose4(lo[4],lo[5],lo[6],lo[7]);
+  transpose4(hi[0],hi[1],hi[2],hi[3]);
+  transpose4(hi[4],hi[5],hi[6],hi[7]);
+  for(int i=0; i<4; ++i)
+    std::swap(lo[4+i],hi[i]);
+  }
+
+// 8 rows of idct output in lo/hi halves
+void sse2Idct(__m128i lo[8], __m128i hi[8], const int32_t* block) {
+  for(int r=0; r<8; ++r) {
+    lo[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block+r*8  ));
+    hi[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block+r*8+4));
+    }
+  idct1d<Sse2Op>(lo);
+  idct1d<Sse2Op>(hi);
+  transpose8(lo,hi);
+  idct1d<Sse2Op>(lo);
+  idct1d<Sse2Op>(hi);
+  const __m128i bias = _mm_set1_epi32(0x7F);
+  for(int i=0; i<8; ++i) {
+    lo[i] = _mm_srai_epi32(_mm_add_epi32(lo[i],bias),8);
+    hi[i] = _mm_srai_epi32(_mm_add_epi32(hi[i],bias),8);
+    }
+  transpose8(lo,hi);
+  }
+
+inline void sse2Store8(uint8_t* dst, __m128i lo, __m128i hi) {
+  // keep low byte, same as uint8_t cast
+  const __m128i mask = _mm_set1_epi32(0xFF);
+  const __m128i w    = _mm_packs_epi32(_mm_and_si128(lo,mask),_mm_and_si128(hi,mask));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(dst),_mm_packus_epi16(w,w));
+  }
+
+void sse2IdctPut(uint8_t* dst, const int32_t* block) {
+  __m128i lo[8], hi[8];
+  sse2Idct(lo,hi,block);
+  for(int r=0; r<8; ++r)
+    sse2Store8(dst+r*8,lo[r],hi[r]);
+  }
+
+void sse2IdctAdd(uint8_t* dst, const uint8_t* prev, const int32_t* block) {
+  __m128i lo[8], hi[8];
+  sse2Idct(lo,hi,block);
+  const __m128i zero = _mm_setzero_si128();
+  for(int r=0; r<8; ++r) {
+    const __m128i p = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(prev+r*8)),zero);
+    lo[r] = _mm_add_epi32(lo[r],_mm_unpacklo_epi16(p,zero));
+    hi[r] = _mm_add_epi32(hi[r],_mm_unpackhi_epi16(p,zero));
+    sse2Store8(dst+r*8,lo[r],hi[r]);
+    }
+  }
+
+inline __m128i loadChroma4(const uint8_t* p) {
+  int32_t v = 0;
+  std::memcpy(&v,p,4);
+  __m128i c = _mm_unpacklo_epi8(_mm_cvtsi32_si128(v),_mm_setzero_si128());
+  c = _mm_unpacklo_epi16(c,c); // each chroma sample covers 2 pixels
+  return _mm_sub_epi16(c,_mm_set1_epi16(128));
+  }
+
+inline __m128i yuvChannel(__m128i c, __m128i chroma) {
+  return _mm_srai_epi32(_mm_add_epi32(c,chroma),8);
+  }
+
+inline void storeRgba8(uint8_t* dst, __m128i r16, __m128i g16, __m128i b16) {
+  const __m128i r  = _mm_packus_epi16(r16,r16);
+  const __m128i g  = _mm_packus_epi16(g16,g16);
+  const __m128i b  = _mm_packus_epi16(b16,b16);
+  const __m128i rg = _mm_unpacklo_epi8(r,g);
+  const __m128i ba = _mm_unpacklo_epi8(b,_mm_set1_epi8(-1));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),    _mm_unpacklo_epi16(rg,ba));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+16), _mm_unpackhi_epi16(rg,ba));
+  }
+
+inline void yuvRow8(uint8_t* dst, const uint8_t* py,
+                    const __m128i re[2], const __m128i gde[2], const __m128i bd[2]) {
+  const __m128i kY  = _mm_set_epi16(128,298, 128,298, 128,298, 128,298);
+  const __m128i one = _mm_set1_epi16(1);
+  __m128i y = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(py));
+  y = _mm_sub_epi16(_mm_unpacklo_epi8(y,_mm_setzero_si128()),_mm_set1_epi16(16));
+
+  const __m128i c0 = _mm_madd_epi16(_mm_unpacklo_epi16(y,one),kY);
+  const __m128i c1 = _mm_madd_epi16(_mm_unpackhi_epi16(y,one),kY);
+
+  const __m128i r = _mm_packs_epi32(yuvChannel(c0,re [0]),yuvChannel(c1,re [1]));
+  const __m128i g = _mm_packs_epi32(yuvChannel(c0,gde[0]),yuvChannel(c1,gde[1]));
+  const __m128i b = _mm_packs_epi32(yuvChannel(c0,bd [0]),yuvChannel(c1,bd [1]));
+  storeRgba8(dst,r,g,b);
+  }
+
+void sse2YuvRow2(uint8_t* dst0, uint8_t* dst1, const uint8_t* py0, const uint8_t* py1,
+                 const uint8_t* pu, const uint8_t* pv, uint32_t w) {
+  const __m128i kR = _mm_set_epi16(0,409,    0,409,    0,409,    0,409);
+  const __m128i kG = _mm_set_epi16(-208,-100, -208,-100, -208,-100, -208,-100);
+  const __m128i kB = _mm_set_epi16(0,516,    0,516,    0,516,    0,516);
+  const __m128i zero = _mm_setzero_si128();
+  uint32_t x = 0;
+  for(; x+8<=w; x+=8) {
+    const __m128i d = loadChroma4(pu+x/2);
+    const __m128i e = loadChroma4(pv+x/2);
+    const __m128i re [2] = {_mm_madd_epi16(_mm_unpacklo_epi16(e,zero),kR), _mm_madd_epi16(_mm_unpackhi_epi16(e,zero),kR)};
+    const __m128i gde[2] = {_mm_madd_epi16(_mm_unpacklo_epi16(d,e),   kG), _mm_madd_epi16(_mm_unpackhi_epi16(d,e),   kG)};
+    const __m128i bd [2] = {_mm_madd_epi16(_mm_unpacklo_epi16(d,zero),kB), _mm_madd_epi16(_mm_unpackhi_epi16(d,zero),kB)};
+    yuvRow8(dst0+x*4,py0+x,re,gde,bd);
+    if(py1!=nullptr)
+      yuvRow8(dst1+x*4,py1+x,re,gde,bd);
+    }
+  yuvTail(dst0,dst1,py0,py1,pu,pv,x,w);
+  }
+#endif
+
+#if defined(BINK_NEON)
+struct NeonOp {
+  static int32x4_t add(int32x4_t a, int32x4_t b) { return vaddq_s32(a,b); }
+  static int32x4_t sub(int32x4_t a, int32x4_t b) { return vsubq_s32(a,b); }
+  static int32x4_t mul(int c, int32x4_t x)       { return vshrq_n_s32(vmulq_s32(vdupq_n_s32(c),x),11); }
+  };
+
+inline void transpose4(int32x4_t& a, int32x4_t& b, int32x4_t& c, int32x4_t& d) {
+  const int32x4x2_t ab = vtrnq_s32(a,b);
+  const int32x4x2_t cd = vtrnq_s32(c,d);
+  a = vcombine_s32(vget_low_s32 (ab.val[0]),vget_low_s32 (cd.val[0]));
+  b = vcombine_s32(vget_low_s32 (ab.val[1]),vget_low_s32 (cd.val[1]));
+  c = vcombine_s32(vget_high_s32(ab.val[0]),vget_high_s32(cd.val[0]));
+  d = vcombine_s32(vget_high_s32(ab.val[1]),vget_high_s32(cd.val[1]));
+  }
+
+inline void transpose8(int32x4_t lo[8], int32x4_t hi[8]) {
+  transpose4(lo[0],lo[1],lo[2],lo[3]);
+  transpose4(lo[4],lo[5],lo[6],lo[7]);
+  transpose4(hi[0],hi[1],hi[2],hi[3]);
+  transpose4(hi[4],hi[5],hi[6],hi[7]);
+  for(int i=0; i<4; ++i)
+    std::swap(lo[4+i],hi[i]);
+  }
+
+void neonIdct(int32x4_t lo[8], int32x4_t hi[8], const int32_t* block) {
+  for(int r=0; r<8; ++r) {
+    lo[r] = vld1q_s32(block+r*8  );
+    hi[r] = vld1q_s32(block+r*8+4);
+    }
+  idct1d<NeonOp>(lo);
+  idct1d<NeonOp>(hi);
+  transpose8(lo,hi);
+  idct1d<NeonOp>(lo);
+  idct1d<NeonOp>(hi);
+  const int32x4_t bias = vdupq_n_s32(0x7F);
+  for(int i=0; i<8; ++i) {
+    lo[i] = vshrq_n_s32(vaddq_s32(lo[i],bias),8);
+    hi[i] = vshrq_n_s32(vaddq_s32(hi[i],bias),8);
+    }
+  transpose8(lo,hi);
+  }
+
+inline void neonStore8(uint8_t* dst, int32x4_t lo, int32x4_t hi) {
+  // truncating narrow keeps low byte, same as uint8_t cast
+  const uint16x8_t w = vcombine_u16(vmovn_u32(vreinterpretq_u32_s32(lo)),vmovn_u32(vreinterpretq_u32_s32(hi)));
+  vst1_u8(dst,vmovn_u16(w));
+  }
+
+void neonIdctPut(uint8_t* dst, const int32_t* block) {
+  int32x4_t lo[8], hi[8];
+  neonIdct(lo,hi,block);
+  for(int r=0; r<8; ++r)
+    neonStore8(dst+r*8,lo[r],hi[r]);
+  }
+
+void neonIdctAdd(uint8_t* dst, const uint8_t* prev, const int32_t* block) {
+  int32x4_t lo[8], hi[8];
+  neonIdct(lo,hi,block);
+  for(int r=0; r<8; ++r) {
+    const uint16x8_t p = vmovl_u8(vld1_u8(prev+r*8));
+    lo[r] = vaddq_s32(lo[r],vreinterpretq_s32_u32(vmovl_u16(vget_low_u16 (p))));
+    hi[r] = vaddq_s32(hi[r],vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(p))));
+    neonStore8(dst+r*8,lo[r],hi[r]);
+    }
+  }
+
+inline int16x8_t loadChroma4(const uint8_t* p) {
+  uint32_t v = 0;
+  std::memcpy(&v,p,4);
+  const uint8x8_t c = vcreate_u8(v);
+  const uint8x8_t x = vzip_u8(c,c).val[0]; // each chroma sample covers 2 pixels
+  return vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(x)),vdupq_n_s16(128));
+  }
+
+inline uint8x8_t yuvChannel(int32x4_t c0, int32x4_t c1, int32x4_t ch0, int32x4_t ch1) {
+  const int32x4_t v0 = vshrq_n_s32(vaddq_s32(c0,ch0),8);
+  const int32x4_t v1 = vshrq_n_s32(vaddq_s32(c1,ch1),8);
+  return vqmovun_s16(vcombine_s16(vqmovn_s32(v0),vqmovn_s32(v1)));
+  }
+
+inline void yuvRow8(uint8_t* dst, const uint8_t* py,
+                    const int32x4_t re[2], const int32x4_t gde[2], const int32x4_t bd[2]) {
+  const int16x8_t y  = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(py))),vdupq_n_s16(16));
+  const int32x4_t c0 = vmlal_n_s16(vdupq_n_s32(128),vget_low_s16 (y),298);
+  const int32x4_t c1 = vmlal_n_s16(vdupq_n_s32(128),vget_high_s16(y),298);
+
+  uint8x8x4_t px;
+  px.val[0] = yuvChannel(c0,c1,re [0],re [1]);
+  px.val[1] = yuvChannel(c0,c1,gde[0],gde[1]);
+  px.val[2] = yuvChannel(c0,c1,bd [0],bd [1]);
+  px.val[3] = vdup_n_u8(255);
+  vst4_u8(dst,px);
+  }
+
+void neonYuvRow2(uint8_t* dst0, uint8_t* dst1, const uint8_t* py0, const uint8_t* py1,
+                 const uint8_t* pu, const uint8_t* pv, uint32_t w) {
+  uint32_t x = 0;
+  for(; x+8<=w; x+=8) {
+    const int16x8_t d = loadChroma4(pu+x/2);
+    const int16x8_t e = loadChroma4(pv+x/2);
+    const int32x4_t re [2] = {vmull_n_s16(vget_low_s16(e),409), vmull_n_s16(vget_high_s16(e),409)};
+    const int32x4_t gde[2] = {vmlal_n_s16(vmull_n_s16(vget_low_s16 (d),-100),vget_low_s16 (e),-208),
+                              vmlal_n_s16(vmull_n_s16(vget_high_s16(d),-100),vget_high_s16(e),-208)};
+    const int32x4_t bd [2] = {vmull_n_s16(vget_low_s16(d),516), vmull_n_s16(vget_high_s16(d),516)};
+    yuvRow8(dst0+x*4,py0+x,re,gde,bd);
+    if(py1!=nullptr)
+      yuvRow8(dst1+x*4,py1+x,re,gde,bd);
+    }
+  yuvTail(dst0,dst1,py0,py1,pu,pv,x,w);
+  }
+#endif
+
+bool cpuHasAvx2() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  int r[4] = {};
+  __cpuid(r,1);
+  const bool osxsave = (r[2] & (1<<27))!=0;
+  const bool avx     = (r[2] & (1<<28))!=0;
+  if(!osxsave || !avx || (_xgetbv(0) & 0x6)!=0x6)
+    return false;
+  __cpuidex(r,7,0);
+  return (r[1] & (1<<5))!=0;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+  }
+
+const Kernels& selectKernels() {
+  const Kernels* k = &scalarKernels();
+  if(auto simd = simdKernels())
+    k = simd;
+  if(auto avx2 = avx2Kernels(); avx2!=nullptr && cpuHasAvx2())
+    k = avx2;
+  return *k;
+  }
+
+}
+
+const Kernels& Dsp::scalarKernels() {
+  static const Kernels k = {"scalar", scalarIdctPut, scalarIdctAdd, scalarYuvRow2};
+  return k;
+  }
+
+const Kernels* Dsp::simdKernels() {
+#if defined(BINK_SSE2)
+  static const Kernels k = {"sse2", sse2IdctPut, sse2IdctAdd, sse2YuvRow2};
+  return &k;
+#elif defined(BINK_NEON)
+  static const Kernels k = {"neon", neonIdctPut, neonIdctAdd, neonYuvRow2};
+  return &k;
+#else
+  return nullptr;
+#endif
+  }
+
+const Kernels& Dsp::kernels() {
+  static const Kernels& k = selectKernels();
+  return k;
+  }
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Bink {
+namespace Dsp {
+
+// 8x8 block kernels and color conversion; every implementation is bit-exact with scalar one
+struct Kernels final {
+  const char* name = "";
+  // dst = idct(block)
+  void (*idctPut)(uint8_t* dst, const int32_t* block) = nullptr;
+  // dst = prev + idct(block)
+  void (*idctAdd)(uint8_t* dst, const uint8_t* prev, const int32_t* block) = nullptr;
+  // two luma rows, that share one chroma row, into RGBA8; py1/dst1 can be null for odd height
+  void (*yuvRow2)(uint8_t* dst0, uint8_t* dst1, const uint8_t* py0, const uint8_t* py1,
+                  const uint8_t* pu, const uint8_t* pv, uint32_t w) = nullptr;
+  };
+
+const Kernels& scalarKernels();
+const Kernels* simdKernels(); // SSE2 or NEON, if available at compile time
+const Kernels* avx2Kernels(); // compiled separately, see dsp_avx2.cpp
+// best kernels for current cpu, selected at runtime
+const Kernels& kernels();
+
+}
+}
@@ -0,0 +1,143 @@
+#include "dsp.h"
+
+// compiled with AVX2 enabled (see CMakeLists.txt); used only if cpu supports it
+#if defined(__AVX2__)
+#include "dsp_idct.h"
+#include <cstring>
+#include <immintrin.h>
+
+using namespace Bink;
+using namespace Bink::Dsp;
+
+namespace {
+
+struct Avx2Op {
+  static __m256i add(__m256i a, __m256i b) { return _mm256_add_epi32(a,b); }
+  static __m256i sub(__m256i a, __m256i b) { return _mm256_sub_epi32(a,b); }
+  static __m256i mul(int c, __m256i x)     { return _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(c),x),11); }
+  };
+
+inline void transpose8(__m256i v[8]) {
+  const __m256i t0 = _mm256_unpacklo_epi32(v[0],v[1]);
+  const __m256i t1 = _mm256_unpackhi_epi32(v[0],v[1]);
+  const __m256i t2 = _mm256_unpacklo_epi32(v[2],v[3]);
+  const __m256i t3 = _mm256_unpackhi_epi32(v[2],v[3]);
+  const __m256i t4 = _mm256_unpacklo_epi32(v[4],v[5]);
+  const __m256i t5 = _mm256_unpackhi_epi32(v[4],v[5]);
+  const __m256i t6 = _mm256_unpacklo_epi32(v[6],v[7]);
+  const __m256i t7 = _mm256_unpackhi_epi32(v[6],v[7]);
+
+  const __m256i u0 = _mm256_unpacklo_epi64(t0,t2);
+  const __m256i u1 = _mm256_unpackhi_epi64(t0,t2);
+  const __m256i u2 = _mm256_unpacklo_epi64(t1,t3);
+  const __m256i u3 = _mm256_unpackhi_epi64(t1,t3);
+  const __m256i u4 = _mm256_unpacklo_epi64(t4,t6);
+  const __m256i u5 = _mm256_unpackhi_epi64(t4,t6);
+  const __m256i u6 = _mm256_unpacklo_epi64(t5,t7);
+  const __m256i u7 = _mm256_unpackhi_epi64(t5,t7);
+
+  v[0] = _mm256_permute2x128_si256(u0,u4,0x20);
+  v[1] = _mm256_permute2x128_si256(u1,u5,0x20);
+  v[2] = _mm256_permute2x128_si256(u2,u6,0x20);
+  v[3] = _mm256_permute2x128_si256(u3,u7,0x20);
+  v[4] = _mm256_permute2x128_si256(u0,u4,0x31);
+  v[5] = _mm256_permute2x128_si256(u1,u5,0x31);
+  v[6] = _mm256_permute2x128_si256(u2,u6,0x31);
+  v[7] = _mm256_permute2x128_si256(u3,u7,0x31);
+  }
+
+// v[r] - row r of idct output
+void avx2Idct(__m256i v[8], const int32_t* block) {
+  for(int r=0; r<8; ++r)
+    v[r] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block+r*8));
+  idct1d<Avx2Op>(v);
+  transpose8(v);
+  idct1d<Avx2Op>(v);
+  const __m256i bias = _mm256_set1_epi32(0x7F);
+  for(int i=0; i<8; ++i)
+    v[i] = _mm256_srai_epi32(_mm256_add_epi32(v[i],bias),8);
+  transpose8(v);
+  }
+
+inline void avx2Store8(uint8_t* dst, __m256i v) {
+  // keep low byte, same as uint8_t cast
+  v = _mm256_and_si256(v,_mm256_set1_epi32(0xFF));
+  const __m128i w = _mm_packs_epi32(_mm256_castsi256_si128(v),_mm256_extracti128_si256(v,1));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(dst),_mm_packus_epi16(w,w));
+  }
+
+void avx2IdctPut(uint8_t* dst, const int32_t* block) {
+  __m256i v[8];
+  avx2Idct(v,block);
+  for(int r=0; r<8; ++r)
+    avx2Store8(dst+r*8,v[r]);
+  }
+
+void avx2IdctAdd(uint8_t* dst, const uint8_t* prev, const int32_t* block) {
+  __m256i v[8];
+  avx2Idct(v,block);
+  for(int r=0; r<8; ++r) {
+    const __m256i p = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(prev+r*8)));
+    avx2Store8(dst+r*8,_mm256_add_epi32(v[r],p));
+    }
+  }
+
+// 8 pixels: 32-bit lanes, same arithmetic as scalar yuvPixel
+inline void yuvRow8(uint8_t* dst, const uint8_t* py, __m256i re, __m256i gde, __m256i bd) {
+  const __m256i y = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(py)));
+  const __m256i c = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(y,_mm256_set1_epi32(16)),_mm256_set1_epi32(298)),
+                                     _mm256_set1_epi32(128));
+  const __m256i r = _mm256_srai_epi32(_mm256_add_epi32(c,re), 8);
+  const __m256i g = _mm256_srai_epi32(_mm256_add_epi32(c,gde),8);
+  const __m256i b = _mm256_srai_epi32(_mm256_add_epi32(c,bd), 8);
+
+  // per 128-bit lane: r0..3 g0..3 b0..3 a0..3, saturated as clamp to [0,255]
+  const __m256i rg   = _mm256_packs_epi32(r,g);
+  const __m256i ba   = _mm256_packs_epi32(b,_mm256_set1_epi32(255));
+  const __m256i px   = _mm256_packus_epi16(rg,ba);
+  const __m256i mask = _mm256_setr_epi8(0,4,8,12, 1,5,9,13, 2,6,10,14, 3,7,11,15,
+                                        0,4,8,12, 1,5,9,13, 2,6,10,14, 3,7,11,15);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),_mm256_shuffle_epi8(px,mask));
+  }
+
+inline __m256i loadChroma4(const uint8_t* p) {
+  int32_t v = 0;
+  std::memcpy(&v,p,4);
+  const __m128i c = _mm_cvtsi32_si128(v);
+  // each chroma sample covers 2 pixels
+  return _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_unpacklo_epi8(c,c)),_mm256_set1_epi32(128));
+  }
+
+void avx2YuvRow2(uint8_t* dst0, uint8_t* dst1, const uint8_t* py0, const uint8_t* py1,
+                 const uint8_t* pu, const uint8_t* pv, uint32_t w) {
+  uint32_t x = 0;
+  for(; x+8<=w; x+=8) {
+    const __m256i d   = loadChroma4(pu+x/2);
+    const __m256i e   = loadChroma4(pv+x/2);
+    const __m256i re  = _mm256_mullo_epi32(e,_mm256_set1_epi32(409));
+    const __m256i gde = _mm256_add_epi32(_mm256_mullo_epi32(d,_mm256_set1_epi32(-100)),
+                                         _mm256_mullo_epi32(e,_mm256_set1_epi32(-208)));
+    const __m256i bd  = _mm256_mullo_epi32(d,_mm256_set1_epi32(516));
+    yuvRow8(dst0+x*4,py0+x,re,gde,bd);
+    if(py1!=nullptr)
+      yuvRow8(dst1+x*4,py1+x,re,gde,bd);
+    }
+  if(x<w) {
+    // odd tail: x is even, so chroma stays aligned
+    const Kernels* tail = simdKernels()!=nullptr ? simdKernels() : &scalarKernels();
+    tail->yuvRow2(dst0+x*4, dst1!=nullptr ? dst1+x*4 : nullptr, py0+x, py1!=nullptr ? py1+x : nullptr,
+                  pu+x/2, pv+x/2, w-x);
+    }
+  }
+
+}
+
+const Kernels* Dsp::avx2Kernels() {
+  static const Kernels k = {"avx2", avx2IdctPut, avx2IdctAdd, avx2YuvRow2};
+  return &k;
+  }
+#else
+const Bink::Dsp::Kernels* Bink::Dsp::avx2Kernels() {
+  return nullptr;
+  }
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+// generic form of Bink inverse DCT; shared by SIMD implementations
+// Op: V, add(V,V), sub(V,V), mul(int,V) = (c*x)>>11 with wrapping 32-bit multiply
+namespace Bink {
+namespace Dsp {
+
+enum {
+  IDCT_A1 = 2896, /* (1/sqrt(2))<<12 */
+  IDCT_A2 = 2217,
+  IDCT_A3 = 3784,
+  IDCT_A4 = -5352
+  };
+
+template<class Op, class V>
+static inline void idct1d(V v[8]) {
+  const V a0 = Op::add(v[0],v[4]);
+  const V a1 = Op::sub(v[0],v[4]);
+  const V a2 = Op::add(v[2],v[6]);
+  const V a3 = Op::mul(IDCT_A1,Op::sub(v[2],v[6]));
+  const V a4 = Op::add(v[5],v[3]);
+  const V a5 = Op::sub(v[5],v[3]);
+  const V a6 = Op::add(v[1],v[7]);
+  const V a7 = Op::sub(v[1],v[7]);
+  const V b0 = Op::add(a4,a6);
+  const V b1 = Op::mul(IDCT_A3,Op::add(a5,a7));
+  const V b2 = Op::add(Op::sub(Op::mul(IDCT_A4,a5),b0),b1);
+  const V b3 = Op::sub(Op::mul(IDCT_A1,Op::sub(a6,a4)),b2);
+  const V b4 = Op::sub(Op::add(Op::mul(IDCT_A2,a7),b3),b1);
+
+  const V a02 = Op::add(a0,a2);
+  const V a0m = Op::sub(a0,a2);
+  const V a13 = Op::sub(Op::add(a1,a3),a2);
+  const V a1m = Op::add(Op::sub(a1,a3),a2);
+  v[0] = Op::add(a02,b0);
+  v[1] = Op::add(a13,b2);
+  v[2] = Op::add(a1m,b3);
+  v[3] = Op::sub(a0m,b4);
+  v[4] = Op::add(a0m,b4);
+  v[5] = Op::sub(a1m,b3);
+  v[6] = Op::sub(a13,b2);
+  v[7] = Op::sub(a02,b0);
+  }
+
+}
+}
@@ -1,8 +1,17 @@
 #include "frame.h"
+#include "dsp.h"
 
 #include <algorithm>
 #include <cstring>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define BINK_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BINK_NEON
+#endif
+
 using namespace Bink;
 
 void Frame::Plane::setSize(uint32_t iw, uint32_t ih) {
@@ -17,12 +26,8 @@ void Frame::Plane::setSize(uint32_t iw, uint32_t ih) {
 
 void Frame::Plane::getPixels8x8(uint32_t rx, uint32_t ry, uint8_t* out) const {
   const uint8_t* d = dat.data();
-
-  for(uint32_t y=0; y<8; ++y) {
-    for(uint32_t x=0; x<8; ++x) {
-      out[x+y*8] = d[(x+rx) + (y+ry)*stride];
-      }
-    }
+  for(uint32_t y=0; y<8; ++y)
+    std::memcpy(out+y*8, d + (rx + (y+ry)*stride), 8);
   }
 
 void Frame::Plane::getBlock8x8(uint32_t bx, uint32_t by, uint8_t* out) const {
@@ -31,21 +36,31 @@ void Frame::Plane::getBlock8x8(uint32_t bx, uint32_t by, uint8_t* out) const {
 
 void Frame::Plane::putBlock8x8(uint32_t bx, uint32_t by, const uint8_t* in) {
   uint8_t* d = dat.data();
-
-  for(uint32_t y=0; y<8; ++y) {
-    for(uint32_t x=0; x<8; ++x) {
-      d[(x+bx*8) + (y+by*8)*stride] = in[x+y*8];
-      }
-    }
+  for(uint32_t y=0; y<8; ++y)
+    std::memcpy(d + (bx*8 + (y+by*8)*stride), in+y*8, 8);
   }
 
 void Frame::Plane::putScaledBlock(uint32_t bx, uint32_t by, const uint8_t* in) {
-  uint8_t* d = dat.data();
-  for(uint32_t y=0; y<16; ++y) {
-    uint32_t y2 = y/2;
-    for(uint32_t x=0; x<16; ++x) {
-      d[(x+bx*8) + (y+by*8)*stride] = in[(x/2)+y2*8];
-      }
+  uint8_t* d = dat.data() + (bx*8 + by*8*stride);
+  for(uint32_t y=0; y<8; ++y) {
+    uint8_t* row0 = d + (2*y  )*stride;
+    uint8_t* row1 = d + (2*y+1)*stride;
+#if defined(BINK_SSE2)
+    const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in+y*8));
+    const __m128i w = _mm_unpacklo_epi8(v,v);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(row0),w);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(row1),w);
+#elif defined(BINK_NEON)
+    const uint8x8_t   v = vld1_u8(in+y*8);
+    const uint8x8x2_t w = vzip_u8(v,v);
+    const uint8x16_t  q = vcombine_u8(w.val[0],w.val[1]);
+    vst1q_u8(row0,q);
+    vst1q_u8(row1,q);
+#else
+    for(uint32_t x=0; x<16; ++x)
+      row0[x] = in[x/2 + y*8];
+    std::memcpy(row1,row0,16);
+#endif
     }
   }
 
@@ -66,6 +81,31 @@ const Frame::Audio& Frame::audio(uint8_t id) const {
   return aud[id];
   }
 
+void Frame::yuvToRgba(uint8_t* rgba, uint32_t rowBegin, uint32_t rowEnd) const {
+  auto& pY = planes[0];
+  auto& pU = planes[1];
+  auto& pV = planes[2];
+
+  const uint32_t w       = pY.w;
+  auto           yuvRow2 = Dsp::kernels().yuvRow2;
+  rowEnd = std::min(rowEnd,pY.h);
+
+  uint32_t y = rowBegin;
+  if(y<rowEnd && y%2==1) {
+    // unaligned start: second row of a 2x2 chroma block
+    yuvRow2(rgba+size_t(y)*w*4, nullptr, pY.dat.data()+y*pY.stride, nullptr,
+            pU.dat.data()+(y/2)*pU.stride, pV.dat.data()+(y/2)*pV.stride, w);
+    ++y;
+    }
+  for(; y<rowEnd; y+=2) {
+    const bool pair = (y+1<rowEnd);
+    uint8_t*   dst  = rgba+size_t(y)*w*4;
+    yuvRow2(dst, pair ? dst+size_t(w)*4 : nullptr,
+            pY.dat.data()+y*pY.stride, pair ? pY.dat.data()+(y+1)*pY.stride : nullptr,
+            pU.dat.data()+(y/2)*pU.stride, pV.dat.data()+(y/2)*pV.stride, w);
+    }
+  }
+
 void Frame::setSize(uint32_t w, uint32_t h) {
   planes[0].setSize(w,h);
   planes[1].setSize(w/2,h/2);
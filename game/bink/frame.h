@@ -25,6 +25,7 @@ class Frame final {
 
         uint8_t        at(uint32_t x, uint32_t y) const;
         const uint8_t* data() const { return dat.data(); }
+        uint32_t       pitch() const { return stride; }
 
       private:
         void setSize(uint32_t w, uint32_t h);
@@ -50,6 +51,9 @@ class Frame final {
     const Audio& audio(uint8_t id) const;
     size_t       audioCount()      const { return aud.size(); }
 
+    // BT.601 integer conversion of rows [rowBegin,rowEnd) into tightly packed RGBA8 image
+    void         yuvToRgba(uint8_t* rgba, uint32_t rowBegin, uint32_t rowEnd) const;
+
   private:
     Plane              planes[4];
     std::vector<Audio> aud;
@@ -1,4 +1,7 @@
 #include "video.h"
+#include "dsp.h"
+
+#include "utils/workers.h"
 
 #ifdef __GNUC__
 // TODO: fix clang warnings
@@ -576,69 +579,6 @@ static int av_log2(unsigned v) {
   return int(std::log2(v));
   }
 
-template<class T>
-static void idctTransform(T* dest, const int* src,
-                          int s0, int s1, int s2, int s3, int s4, int s5, int s6, int s7,
-                          int d0, int d1, int d2, int d3, int d4, int d5, int d6, int d7,
-                          T (*munge)(int)) {
-  enum {
-    A1 = 2896, /* (1/sqrt(2))<<12 */
-    A2 = 2217,
-    A3 = 3784,
-    A4 = -5352
-    };
-  static int (*mul)(int,int) = [](int x,int y) -> int { return int(uint32_t(x)*uint32_t(y)) >> 11; };
-
-  const int a0 = (src)[s0] + (src)[s4];
-  const int a1 = (src)[s0] - (src)[s4];
-  const int a2 = (src)[s2] + (src)[s6];
-  const int a3 = mul(A1, (src)[s2] - (src)[s6]);
-  const int a4 = (src)[s5] + (src)[s3];
-  const int a5 = (src)[s5] - (src)[s3];
-  const int a6 = (src)[s1] + (src)[s7];
-  const int a7 = (src)[s1] - (src)[s7];
-  const int b0 = a4 + a6;
-  const int b1 = mul(A3, a5 + a7);
-  const int b2 = mul(A4, a5) - b0 + b1;
-  const int b3 = mul(A1, a6 - a4) - b2;
-  const int b4 = mul(A2, a7) + b3 - b1;
-  dest[d0] = munge(a0+a2   +b0);
-  dest[d1] = munge(a1+a3-a2+b2);
-  dest[d2] = munge(a1-a3+a2+b3);
-  dest[d3] = munge(a0-a2   -b4);
-  dest[d4] = munge(a0-a2   +b4);
-  dest[d5] = munge(a1-a3+a2-b3);
-  dest[d6] = munge(a1+a3-a2-b2);
-  dest[d7] = munge(a0+a2   -b0);
-  }
-
-template<class T>
-static void idctCol(T* dest, const int* src) {
-  static T (*munge)(int) = [](int x) -> T { return T(x); };
-  idctTransform(dest,src,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,munge);
-  }
-
-template<class T>
-static void idctRow(T* dest, const int* src) {
-  static T (*munge)(int) = [](int x) -> T { return T((x + 0x7F)>>8); };
-  idctTransform(dest,src,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,munge);
-  }
-
-static void bink_idct_col(int *dest, const int32_t *src) {
-  if((src[8]|src[16]|src[24]|src[32]|src[40]|src[48]|src[56])==0) {
-    dest[0]  =
-        dest[8]  =
-        dest[16] =
-        dest[24] =
-        dest[32] =
-        dest[40] =
-        dest[48] =
-        dest[56] = src[0];
-    } else {
-    idctCol(dest, src);
-    }
-  }
-
 template<class T>
 static void BF(T& x, T& y, const T& a, const T& b) {
   x = a-b;
@@ -825,7 +765,8 @@ Video::AudioCtx::AudioCtx(uint16_t sampleRate, uint8_t channels, bool isDct)
   :sampleRate(sampleRate), channelsCnt(channels), isDct(isDct) {
   }
 
-Video::Video(Input* file) : fin(file) {
+Video::Video(Input* file, uint8_t bufferedFrames) : fin(file) {
+  frames.resize(std::max<uint8_t>(bufferedFrames,2));
   packet.reserve(4*1024*1024);
 
   uint32_t codec = rl32();
@@ -927,7 +868,7 @@ Video::~Video() {
 
 const Frame& Video::nextFrame() {
   if(frameCounter==index.size())
-    return frames[frameCounter%2];
+    return lastFrameData();
   try {
     readPacket();
     }
@@ -935,11 +876,19 @@ const Frame& Video::nextFrame() {
     frameCounter++;
     throw;
     }
-  auto& f = frames[frameCounter%2];
+  auto& f = currentFrameData();
   frameCounter++;
   return f;
   }
 
+Frame& Video::currentFrameData() {
+  return frames[frameCounter%frames.size()];
+  }
+
+Frame& Video::lastFrameData() {
+  return frames[(frameCounter+frames.size()-1)%frames.size()];
+  }
+
 size_t Video::frameCount() const {
   return index.size();
   }
@@ -961,7 +910,11 @@ void Video::readPacket() {
 
   fin->seek(id.pos+smush_size);
 
-  uint32_t videoSize = id.size;
+  // audio tracks and video have independent bitstreams and state: tracks are decoded as worker tasks,
+  // concurrently with video. Group joins them before frame is returned (also on exception)
+  Workers::Group audio;
+  uint32_t       videoSize = id.size;
+  audPacket.resize(aud.size());
   for(size_t i=0; i<aud.size(); ++i) {
     uint32_t audioSize = rl32();
     if(audioSize+4 > videoSize) {
@@ -970,12 +923,12 @@ void Video::readPacket() {
       throw std::runtime_error(buf);
       }
     if(audioSize >= 4) { // This doesn't look good
-      packet.resize(audioSize);
-      fin->read(packet.data(),packet.size());
-      parseAudio(packet,i);
+      audPacket[i].resize(audioSize);
+      fin->read(audPacket[i].data(),audPacket[i].size());
+      audio.run([this,i]() { parseAudio(audPacket[i],i); });
       } else {
       fin->skip(audioSize);
-      frames[frameCounter%2].aud[i].samples.clear();
+      currentFrameData().aud[i].samples.clear();
       }
     videoSize -= (audioSize+4);
     }
@@ -983,6 +936,7 @@ void Video::readPacket() {
   packet.resize(videoSize);
   fin->read(packet.data(),packet.size());
   parseFrame(packet);
+  audio.wait();
   }
 
 void Video::merge(BitStream& gb, uint8_t *dst, uint8_t *src, int size) {
@@ -1171,8 +1125,8 @@ void Video::decodePlane(BitStream& gb, int planeId, bool chroma) {
   const int bh     = chroma ? (this->height + 15) >> 4 : (this->height + 7) >> 3;
   const int width  = this->width  >> (chroma ? 1 : 0);
 
-  auto& plane = frames[frameCounter%2]    .planes[planeId];
-  auto& last  = frames[(frameCounter+1)%2].planes[planeId];
+  auto& plane = currentFrameData().planes[planeId];
+  auto& last  = lastFrameData()   .planes[planeId];
 
   if(revision == 'k' && gb.getBit()) {
     uint8_t value = uint8_t(gb.getBits(8));
@@ -1186,6 +1140,7 @@ void Video::decodePlane(BitStream& gb, int planeId, bool chroma) {
   for(int i=0; i<BINK_NB_SRC; i++)
     readBundle(gb,i);
 
+  const Dsp::Kernels& dsp = Dsp::kernels();
   uint8_t dst[8*8] = {};
   for(int by = 0; by < bh; by++) {
     readBlockTypes  (gb,bundle[BINK_SRC_BLOCK_TYPES]);
@@ -1242,11 +1197,7 @@ void Video::decodePlane(BitStream& gb, int planeId, bool chroma) {
           int coef_count=0, coef_idx[64]={};
           int quant_idx = readDctCoeffs(gb, dctblock, bink_scan, coef_count, coef_idx, -1);
           unquantizeDctCoeffs(dctblock, bink_intra_quant[quant_idx], coef_count, coef_idx, bink_scan);
-          int temp[64]={};
-          for(int i=0; i<8; i++)
-            bink_idct_col(&temp[i], &dctblock[i]);
-          for(int i=0; i<8; i++)
-            idctRow(&dst[i*8], &temp[8*i]);
+          dsp.idctPut(dst, dctblock);
           break;
           }
         case INTER_BLOCK:   {
@@ -1260,14 +1211,7 @@ void Video::decodePlane(BitStream& gb, int planeId, bool chroma) {
           int coef_count=0, coef_idx[64]={};
           int quant_idx = readDctCoeffs(gb, dctblock, bink_scan, coef_count, coef_idx, -1);
           unquantizeDctCoeffs(dctblock, bink_inter_quant[quant_idx], coef_count, coef_idx, bink_scan);
-
-          int temp[64]={};
-          for(int i=0; i<8; i++)
-            bink_idct_col(&temp[i], &dctblock[i]);
-          for(int i = 0; i < 8; i++)
-            idctRow(&dctblock[i*8], &temp[8*i]);
-          for(int i=0; i<64; ++i)
-            dst[i] = uint8_t(prev[i]+dctblock[i]);
+          dsp.idctAdd(dst, prev, dctblock);
           break;
           }
         case RUN_BLOCK:     {
@@ -1888,7 +1832,7 @@ void Video::parseAudio(const std::vector<uint8_t>& data, size_t id) {
   gb.skip(32); // skip reported size
 
   auto& aud = this->aud[id];
-  auto& ret = frames[frameCounter%2].aud[id].samples;
+  auto& ret = currentFrameData().aud[id].samples;
   ret.reserve(ret.capacity());
   ret.clear();
 
@@ -1919,7 +1863,7 @@ void Video::parseAudio(const std::vector<uint8_t>& data, size_t id) {
       break;
     }
 
-  // frames[frameCounter%2].setSamples(uint8_t(id),ret.data(),ret.size());
+  // currentFrameData().setSamples(uint8_t(id),ret.data(),ret.size());
   }
 
 void Video::parseAudioBlock(BitStream& gb, AudioCtx& aud) {
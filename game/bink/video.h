@@ -49,7 +49,8 @@ class Video final {
       bool     isMono     = false;
       };
 
-    explicit Video(Input* file);
+    // bufferedFrames: how many decoded frames stay valid, minimum is 2 (current and reference one)
+    explicit Video(Input* file, uint8_t bufferedFrames = 2);
     Video(const Video&) = delete;
     ~Video();
 
@@ -179,6 +180,8 @@ class Video final {
     uint8_t  getHuff(BitStream& gb, const Tree& tree);
     int      getVlc2(BitStream& gb, int16_t (*table)[2], int bits, int max_depth);
     void     readPacket();
+    Frame&   currentFrameData();
+    Frame&   lastFrameData();
     void     parseFrame(const std::vector<uint8_t>& data);
     void     decodePlane(BitStream& gb, int planeId, bool chroma);
     void     initLengths(int width, int bw);
@@ -222,9 +225,10 @@ class Video final {
     std::vector<Index>      index;
 
     FrameRate               fRate;
-    Frame                   frames[2] = {};
+    std::vector<Frame>      frames;
 
     std::vector<uint8_t>    packet;
+    std::vector<std::vector<uint8_t>> audPacket;
     uint32_t                frameCounter = 0;
 
     // video
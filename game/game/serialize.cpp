@@ -12,18 +12,6 @@
 #include <Tempest/Log>
 #include <Tempest/Application>
 
-size_t Serialize::writeFunc(void* pOpaque, uint64_t file_ofs, const void* pBuf, size_t n) {
-  auto& self = *reinterpret_cast<Serialize*>(pOpaque);
-  file_ofs += mz_zip_get_archive_file_start_offset(&self.impl);
-  if(file_ofs!=self.curOffset) {
-    self.impl.m_last_error = MZ_ZIP_FILE_SEEK_FAILED;
-    return 0;
-    }
-  size_t ret = self.fout->write(pBuf,n);
-  self.curOffset+=ret;
-  return ret;
-  }
-
 size_t Serialize::readFunc(void* pOpaque, uint64_t file_ofs, void* pBuf, size_t n) {
   auto& self = *reinterpret_cast<Serialize*>(pOpaque);
   file_ofs += mz_zip_get_archive_file_start_offset(&self.impl);
@@ -50,19 +38,15 @@ size_t Serialize::readFunc(void* pOpaque, uint64_t file_ofs, void* pBuf, size_t
   return ret;
   }
 
-Serialize::Serialize() {}
+Serialize::Serialize() : isWriter(true) {
+  entryName.reserve(256);
+  }
 
 //static uint64_t time0 = 0;
 
-Serialize::Serialize(Tempest::ODevice& fout) : fout(&fout) {
+Serialize::Serialize(Tempest::ODevice& fout) : fout(&fout), isWriter(true) {
   //time0 = Tempest::Application::tickCount();
-  entryBuf .resize(1*1024*1024);
   entryName.reserve(256);
-
-  impl.m_pWrite           = Serialize::writeFunc;
-  impl.m_pIO_opaque       = this;
-  impl.m_zip_type         = MZ_ZIP_TYPE_USER;
-  mz_zip_writer_init_v2(&impl, 0, 0);
   }
 
 Serialize::Serialize(Tempest::IDevice& fin) : fin(&fin) {
@@ -77,9 +61,9 @@ Serialize::Serialize(Tempest::IDevice& fin) : fin(&fin) {
 
 Serialize::~Serialize() {
   closeEntry();
-  if(fout!=nullptr) {
-    mz_zip_writer_finalize_archive(&impl);
-    mz_zip_writer_end(&impl);
+  if(isWriter && fout!=nullptr) {
+    if(!flush(*fout))
+      Tempest::Log::e("unable to write game archive");
     //Tempest::Log::d("save time = ", Tempest::Application::tickCount()-time0);
     }
   }
@@ -90,23 +74,37 @@ std::string_view Serialize::worldName() const {
   return "_";
   }
 
+bool Serialize::flush(Tempest::ODevice& dest) noexcept {
+  try {
+    closeEntry();
+    }
+  catch(...) {
+    return false;
+    }
+  const bool ok = ZipWriter::write(dest,entries,compression);
+  entries  .clear();
+  entryDirs.clear();
+  fout = nullptr;
+  return ok;
+  }
+
 void Serialize::closeEntry() {
-  if(fout==nullptr)
+  if(!isWriter)
     return;
   if(entryBuf.empty())
     return;
 
-  mz_uint level  = entryBuf.size()>256 ? MZ_BEST_COMPRESSION : MZ_NO_COMPRESSION;
-  mz_bool status = mz_zip_writer_add_mem(&impl, entryName.c_str(), entryBuf.data(), entryBuf.size(), level);
+  Entry e;
+  e.name = entryName;
+  e.data = std::move(entryBuf);
+  entries.emplace_back(std::move(e));
   entryBuf .clear();
   entryName.clear();
-  if(!status)
-    throw std::runtime_error("unable to write entry in game archive");
   }
 
 bool Serialize::implSetEntry(std::string_view fname) {
   size_t prefix = 0;
-  if(fout!=nullptr) {
+  if(isWriter) {
     while(prefix<fname.size() && prefix<entryName.size()) {
       if(entryName[prefix]!=fname[prefix])
         break;
@@ -115,18 +113,15 @@ bool Serialize::implSetEntry(std::string_view fname) {
     }
   closeEntry();
   entryName = fname;
-  if(fout!=nullptr) {
+  if(isWriter) {
     for(size_t i=prefix; i<entryName.size(); ++i) {
       if(entryName[i]=='/' && i+1<entryName.size()) {
-        const char prev = entryName[i+1];
-        entryName[i+1] = '\0';
-        mz_uint32 id = mz_uint32(-1);
-        if(!mz_zip_reader_locate_file_v2(&impl, entryName.c_str(), nullptr, 0, &id)) {
-          mz_bool status = mz_zip_writer_add_mem(&impl, entryName.c_str(), NULL, 0, MZ_NO_COMPRESSION);
-          if(!status)
-            throw std::runtime_error("unable to allocate entry in game archive");
+        auto dir = std::string_view(entryName).substr(0,i+1);
+        if(entryDirs.emplace(dir).second) {
+          Entry e;
+          e.name = dir;
+          entries.emplace_back(std::move(e));
           }
-        entryName[i+1] = prev;
         }
       }
     return true;
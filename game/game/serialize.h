@@ -7,6 +7,8 @@
 #include <Tempest/Matrix4x4>
 
 #include <vector>
+#include <unordered_set>
+#include <algorithm>
 #include <cstdint>
 #include <array>
 #include <type_traits>
@@ -22,6 +24,7 @@
 #include "gametime.h"
 #include "constants.h"
 #include "utils/string_frm.h"
+#include "utils/zipwriter.h"
 
 class WayPoint;
 class Npc;
@@ -34,13 +37,19 @@ class SaveGameHeader;
 class Serialize {
   public:
     enum Version : uint16_t {
-      Current = 45
+      Current = 46
       };
+    Serialize();
     Serialize(Tempest::ODevice& fout);
     Serialize(Tempest::IDevice&  fin);
     Serialize(Serialize&&)=default;
     ~Serialize();
 
+    // compression level of archive entries: 0 - store, 1..10 - deflate
+    void     setCompression(int level) { compression = std::clamp(level,0,int(MZ_UBER_COMPRESSION)); }
+    // compress all entries and write archive to fout; used by in-memory writer
+    bool     flush(Tempest::ODevice& fout) noexcept;
+
     uint16_t version()              const { return wldVer; }
     void     setVersion(uint16_t v)       { wldVer = v;    }
     uint16_t globalVersion()        const { return curVer; }
@@ -77,7 +86,7 @@ class Serialize {
 
     void readNpc(phoenix::vm& vm, std::shared_ptr<phoenix::c_npc>& npc);
   private:
-    Serialize();
+    using Entry = ZipWriter::Entry;
 
     // trivial types
     void implWrite(bool      i) { implWrite(uint8_t(i ? 1 : 0)); }
@@ -265,7 +274,6 @@ class Serialize {
     void implWrite(Interactive*  mobsi);
     void implRead (Interactive*& mobsi);
 
-    static size_t writeFunc(void *pOpaque, uint64_t file_ofs, const void *pBuf, size_t n);
     static size_t readFunc (void *pOpaque, uint64_t file_ofs, void *pBuf, size_t n);
 
     void   closeEntry();
@@ -285,5 +293,10 @@ class Serialize {
     uint64_t                 readOffset = 0;
     Tempest::ODevice*        fout      = nullptr;
     Tempest::IDevice*        fin       = nullptr;
+
+    bool                     isWriter    = false;
+    int                      compression = MZ_BEST_COMPRESSION;
+    std::vector<Entry>       entries;
+    std::unordered_set<std::string> entryDirs;
   };
 
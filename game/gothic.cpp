@@ -2,9 +2,12 @@
 
 #include <Tempest/Log>
 #include <Tempest/TextCodec>
+#include <Tempest/Application>
+#include <Tempest/File>
 
 #include <cstring>
 #include <cctype>
+#include <cstdio>
 
 #include <phoenix/ext/daedalus_classes.hh>
 
@@ -64,6 +67,12 @@ Gothic::Gothic() {
   defaults->set("GAME", "animatedWindows",     1);
   defaults->set("GAME", "useGothic1Controls",  0);
   defaults->set("GAME", "highlightMeleeFocus", 0);
+  defaults->set("GAME", "saveCompression",      9); // 0 - store, 1..10 - deflate level
+  defaults->set("GAME", "quickSaveCompression", 1);
+  defaults->set("GAME", "aiLod",                0); // far npcs are ticked less often
+  defaults->set("GAME", "aiFarTickPeriod",      2); // in frames, 1 - every frame
+  defaults->set("GAME", "aiFar2TickPeriod",     8);
+  defaults->set("GAME", "aiFar2RoutineOnly",    1);
 
   defaults->set("SKY_OUTDOOR", "zSunName",   "unsun5.tga");
   defaults->set("SKY_OUTDOOR", "zSunSize",   200);
@@ -154,6 +163,7 @@ Gothic::Gothic() {
   }
 
 Gothic::~Gothic() {
+  finishSaveWrite();
   instance = nullptr;
   }
 
@@ -425,6 +435,8 @@ void Gothic::implStartLoadSave(std::string_view banner,
       auto curState = one;
       auto err = (curState==LoadState::Loading) ? LoadState::FailedLoad : LoadState::FailedSave;
       try {
+        if(curState==LoadState::Loading)
+          finishSaveWrite(); // savegame might be still written in background
         next        = f(std::move(game));
         pendingGame = std::move(next);
         loadingFlag.compare_exchange_strong(curState,LoadState::Finalize);
@@ -470,6 +482,49 @@ void Gothic::cancelLoading() {
     }
   }
 
+void Gothic::startSaveWrite(std::string_view slot, std::unique_ptr<Serialize>&& archive) {
+  // keep order of writes to the same slot
+  finishSaveWrite();
+  saveTh = std::thread([this, slot=std::string(slot), ar=std::move(archive)]() noexcept {
+    Workers::setThreadName("Save thread");
+    const uint64_t time0 = Application::tickCount();
+    const auto     tmp   = slot + ".tmp";
+    bool           ok    = false;
+    try {
+      Tempest::WFile f(tmp);
+      ok = ar->flush(f);
+      }
+    catch(const std::exception& e) {
+      Tempest::Log::e("saving error: ",e.what());
+      }
+    // rename replaces slot atomically; windows refuses to overwrite existing file
+    if(ok && std::rename(tmp.c_str(),slot.c_str())!=0) {
+#if defined(_WIN32)
+      std::remove(slot.c_str());
+      ok = (std::rename(tmp.c_str(),slot.c_str())==0);
+#else
+      ok = false;
+#endif
+      }
+    if(!ok) {
+      Tempest::Log::e("unable to write savegame: \"",slot,"\"");
+      std::remove(tmp.c_str());
+      saveFailed.store(true);
+      return;
+      }
+    Tempest::Log::i("savegame written in background: ",Application::tickCount()-time0,"ms");
+    });
+  }
+
+void Gothic::finishSaveWrite() {
+  if(saveTh.joinable())
+    saveTh.join();
+  }
+
+bool Gothic::checkSaveFailed() {
+  return saveFailed.exchange(false);
+  }
+
 void Gothic::tick(uint64_t dt) {
   if(pendingChapter){
     if(aiIsDlgFinished()) {
@@ -488,7 +543,7 @@ void Gothic::updateAnimation(uint64_t dt) {
   }
 
 void Gothic::quickSave() {
-  save("save_slot_0.sav","Quick save");
+  onSaveGame("save_slot_0.sav","Quick save",true);
   }
 
 void Gothic::quickLoad() {
@@ -496,7 +551,7 @@ void Gothic::quickLoad() {
   }
 
 void Gothic::save(std::string_view slot, std::string_view name) {
-  onSaveGame(slot,name);
+  onSaveGame(slot,name,false);
   }
 
 void Gothic::load(std::string_view slot) {
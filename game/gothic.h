@@ -22,6 +22,7 @@ class VisualFxDefinitions;
 class ParticlesDefinitions;
 class MusicDefinitions;
 class IniFile;
+class Serialize;
 
 class Gothic final {
   public:
@@ -106,6 +107,9 @@ class Gothic final {
     void         startLoad(std::string_view banner, const std::function<std::unique_ptr<GameSession>(std::unique_ptr<GameSession>&&)> f);
     void         startSave(Tempest::Texture2d&& tex, const std::function<std::unique_ptr<GameSession>(std::unique_ptr<GameSession>&&)> f);
     void         cancelLoading();
+    void         startSaveWrite(std::string_view slot, std::unique_ptr<Serialize>&& archive);
+    void         finishSaveWrite();
+    bool         checkSaveFailed();
 
     void         tick(uint64_t dt);
 
@@ -123,7 +127,7 @@ class Gothic final {
 
     Tempest::Signal<void(std::string_view)>                             onStartGame;
     Tempest::Signal<void(std::string_view)>                             onLoadGame;
-    Tempest::Signal<void(std::string_view,std::string_view)>            onSaveGame;
+    Tempest::Signal<void(std::string_view,std::string_view,bool)>       onSaveGame;
 
     Tempest::Signal<void(Npc&,Npc&,AiOuputPipe*&)>                      onDialogPipe;
     Tempest::Signal<void(bool&)>                                        isDialogClose;
@@ -186,6 +190,8 @@ class Gothic final {
     Tempest::Texture2d                      saveTex;
     std::atomic_int                         loadProgress{0};
     std::thread                             loaderTh;
+    std::thread                             saveTh;
+    std::atomic_bool                        saveFailed{false};
     std::atomic<LoadState>                  loadingFlag{LoadState::Idle};
 
     std::unique_ptr<GameSession>            game, pendingGame;
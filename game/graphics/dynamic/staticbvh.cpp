@@ -0,0 +1,237 @@
+#include "staticbvh.h"
+
+#include <algorithm>
+#include <cfloat>
+
+using namespace Tempest;
+
+static float bboxAxis(const Vec3& v, int axis) {
+  switch(axis) {
+    case 0: return v.x;
+    case 1: return v.y;
+    }
+  return v.z;
+  }
+
+float StaticBvh::area(const Vec3& b0, const Vec3& b1) {
+  const Vec3 d = b1-b0;
+  if(d.x<0 || d.y<0 || d.z<0)
+    return 0;
+  return d.x*d.y + d.y*d.z + d.z*d.x;
+  }
+
+void StaticBvh::merge(Vec3* dst, const Vec3* src) {
+  dst[0].x = std::min(dst[0].x, src[0].x);
+  dst[0].y = std::min(dst[0].y, src[0].y);
+  dst[0].z = std::min(dst[0].z, src[0].z);
+  dst[1].x = std::max(dst[1].x, src[1].x);
+  dst[1].y = std::max(dst[1].y, src[1].y);
+  dst[1].z = std::max(dst[1].z, src[1].z);
+  }
+
+void StaticBvh::build() {
+  nodes.clear();
+  cost = 0;
+  if(items.size()==0)
+    return;
+  nodes.reserve((items.size()/8)+1);
+  nodes.resize(1);
+  build(0,0,uint32_t(items.size()));
+  cost0 = cost;
+  built = items.size();
+  }
+
+void StaticBvh::build(uint32_t node, uint32_t begin, uint32_t end) {
+  const size_t sz = end-begin;
+  Item*        b  = items.data()+begin;
+  Item*        e  = items.data()+end;
+
+  Vec3 bbox[2] = {b->bbox[0], b->bbox[1]};
+  Vec3 cbox[2] = {b->midTr,   b->midTr  };
+  for(auto i=b; i!=e; ++i) {
+    merge(bbox,i->bbox);
+    const Vec3 mid[2] = {i->midTr, i->midTr};
+    merge(cbox,mid);
+    }
+
+  nodes[node].bbox[0] = bbox[0];
+  nodes[node].bbox[1] = bbox[1];
+  nodes[node].begin   = begin;
+  nodes[node].end     = end;
+  nodes[node].child   = 0;
+
+  const  float  blockSz     = 5*100;
+  const  auto   boxSz       = bbox[1]-bbox[0];
+  static size_t minNodeSize = 16;
+  if(sz<=minNodeSize || (boxSz.x<blockSz && boxSz.y<blockSz && boxSz.z<blockSz)) {
+    // avoid cache-line stealing, on push
+    std::sort(b,e,[](const Item& l, const Item& r) {
+      return l.vSet < r.vSet;
+      });
+    for(auto i=b; i!=e; ++i)
+      i->leaf = node;
+    auto& n = nodes[node];
+    n.area0 = area(bbox[0],bbox[1]);
+    n.cost  = n.area0*float(sz);
+    cost += n.cost;
+    return;
+    }
+
+  const auto cSz  = cbox[1]-cbox[0];
+  int        axis = 0;
+  if(cSz.y>cSz.x && cSz.y>=cSz.z)
+    axis = 1;
+  else if(cSz.z>cSz.x && cSz.z>cSz.y)
+    axis = 2;
+
+  // binned SAH split, along widest centroid axis
+  static constexpr size_t binCount = 16;
+  struct Bin {
+    Vec3   bbox[2] = {Vec3(FLT_MAX,FLT_MAX,FLT_MAX), Vec3(-FLT_MAX,-FLT_MAX,-FLT_MAX)};
+    size_t cnt     = 0;
+    };
+  const float cMin  = bboxAxis(cbox[0],axis);
+  const float cLen  = bboxAxis(cbox[1],axis) - cMin;
+  auto        binOf = [&](const Item& i) {
+    const float  k  = (bboxAxis(i.midTr,axis)-cMin)/cLen;
+    const size_t id = size_t(k*float(binCount));
+    return std::min(id, binCount-1);
+    };
+
+  size_t split = 0;
+  if(cLen>0) {
+    Bin bins[binCount] = {};
+    for(auto i=b; i!=e; ++i) {
+      auto& bin = bins[binOf(*i)];
+      merge(bin.bbox,i->bbox);
+      bin.cnt++;
+      }
+
+    float rArea[binCount] = {};
+    Bin   acc;
+    for(size_t i=binCount-1; i>0; --i) {
+      merge(acc.bbox,bins[i].bbox);
+      acc.cnt += bins[i].cnt;
+      rArea[i] = area(acc.bbox[0],acc.bbox[1])*float(acc.cnt);
+      }
+
+    float bestCost = FLT_MAX;
+    acc = Bin();
+    for(size_t i=0; i+1<binCount; ++i) {
+      merge(acc.bbox,bins[i].bbox);
+      acc.cnt += bins[i].cnt;
+      if(acc.cnt==0 || acc.cnt==sz)
+        continue;
+      const float c = area(acc.bbox[0],acc.bbox[1])*float(acc.cnt) + rArea[i+1];
+      if(c<bestCost) {
+        bestCost = c;
+        split    = i+1;
+        }
+      }
+    }
+
+  Item* mid = nullptr;
+  if(split>0) {
+    mid = std::partition(b,e,[&](const Item& i) { return binOf(i)<split; });
+    }
+  if(mid==nullptr || mid==b || mid==e) {
+    // degenerate distribution - fallback to median split
+    mid = b+sz/2;
+    std::nth_element(b,mid,e,[axis](const Item& l, const Item& r) {
+      return bboxAxis(l.midTr,axis) < bboxAxis(r.midTr,axis);
+      });
+    }
+
+  const uint32_t child = uint32_t(nodes.size());
+  const uint32_t m     = uint32_t(std::distance(items.data(),mid));
+  nodes.resize(nodes.size()+2);
+  nodes[node].child     = child;
+  nodes[child+0].parent = node;
+  nodes[child+1].parent = node;
+  build(child+0, begin, m  );
+  build(child+1, m,     end);
+  }
+
+uint32_t StaticBvh::findLeaf(const Vec3* bbox) const {
+  uint32_t node = 0;
+  while(nodes[node].child!=0) {
+    const uint32_t ch = nodes[node].child;
+    float delta[2] = {};
+    float ar   [2] = {};
+    for(uint32_t i=0; i<2; ++i) {
+      auto& b = nodes[ch+i].bbox;
+      Vec3  u[2] = {b[0], b[1]};
+      merge(u,bbox);
+      ar   [i] = area(b[0],b[1]);
+      delta[i] = area(u[0],u[1]) - ar[i];
+      }
+    // smallest enlargement first, then smallest area
+    if(delta[0]<delta[1] || (delta[0]==delta[1] && ar[0]<=ar[1]))
+      node = ch+0; else
+      node = ch+1;
+    }
+  return node;
+  }
+
+bool StaticBvh::fits(uint32_t leaf, const Vec3* bbox) const {
+  auto& n = nodes[leaf];
+  Vec3  grown[2] = {n.bbox[0], n.bbox[1]};
+  merge(grown,bbox);
+  return area(grown[0],grown[1]) <= n.area0*maxGrowth;
+  }
+
+size_t StaticBvh::insert(uint32_t leaf, const Item& itm) {
+  auto&        n  = nodes[leaf];
+  const size_t id = items.size();
+  items.push_back(itm);
+  items[id].leaf = leaf;
+  items[id].next = n.extra;
+  n.extra = uint32_t(id);
+  return id;
+  }
+
+void StaticBvh::refit(std::vector<uint32_t>& leaves) {
+  if(leaves.size()==0)
+    return;
+  std::sort(leaves.begin(),leaves.end());
+  leaves.erase(std::unique(leaves.begin(),leaves.end()),leaves.end());
+
+  for(auto node:leaves) {
+    auto&    n       = nodes[node];
+    uint32_t alive   = 0;
+    Vec3     bbox[2] = {};
+    auto     add     = [&](const Item& itm) {
+      if(itm.tok==size_t(-1))
+        return;
+      if(alive==0) {
+        bbox[0] = itm.bbox[0];
+        bbox[1] = itm.bbox[1];
+        }
+      merge(bbox,itm.bbox);
+      alive++;
+      };
+    for(size_t i=n.begin; i<n.end; ++i)
+      add(items[i]);
+    for(auto i=n.extra; i!=NoItem; i=items[i].next)
+      add(items[i]);
+
+    const float c = alive==0 ? 0 : area(bbox[0],bbox[1])*float(alive);
+    cost  += c - n.cost;
+    n.cost = c;
+    if(alive==0)
+      continue;
+    n.bbox[0] = bbox[0];
+    n.bbox[1] = bbox[1];
+
+    while(node!=0) {
+      node = nodes[node].parent;
+      auto& p  = nodes[node];
+      auto& l  = nodes[p.child+0].bbox;
+      auto& r  = nodes[p.child+1].bbox;
+      p.bbox[0] = l[0];
+      p.bbox[1] = l[1];
+      merge(p.bbox,r);
+      }
+    }
+  leaves.clear();
+  }
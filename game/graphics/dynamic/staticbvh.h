@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Tempest/Point>
+
+#include <cstdint>
+#include <vector>
+
+class VisibleSet;
+
+// BVH over static objects: SAH build, then incremental updates - refit of leaves
+// and reinsertion of moved objects into existing leaves, until next rebuild
+class StaticBvh final {
+  public:
+    static constexpr uint32_t NoItem = uint32_t(-1);
+
+    struct Item {
+      size_t        tok  = size_t(-1); // size_t(-1) - dead item
+      uint32_t      gen  = 0;
+      uint32_t      leaf = 0;
+      uint32_t      next = NoItem; // list of items, reinserted into same leaf
+      VisibleSet*   vSet = nullptr;
+      Tempest::Vec3 bbox[2];
+      Tempest::Vec3 midTr;
+      };
+
+    struct Node {
+      Tempest::Vec3 bbox[2];
+      uint32_t      parent = 0;
+      uint32_t      child  = 0;
+      uint32_t      begin  = 0;
+      uint32_t      end    = 0;
+      uint32_t      extra  = NoItem;
+      float         area0  = 0; // leaf area, at build time
+      float         cost   = 0; // leaf area * alive items
+      };
+
+    std::vector<Node> nodes;
+    std::vector<Item> items;
+    size_t            built = 0; // items, placed by build; tail of array is reinserted items
+    double            cost  = 0; // sum of leaf costs
+    double            cost0 = 0; // at build time
+
+    void     build();
+    uint32_t findLeaf(const Tempest::Vec3* bbox) const;
+    bool     fits(uint32_t leaf, const Tempest::Vec3* bbox) const;
+    size_t   insert(uint32_t leaf, const Item& itm);
+    void     refit(std::vector<uint32_t>& leaves);
+
+    static float area(const Tempest::Vec3& b0, const Tempest::Vec3& b1);
+    static void  merge(Tempest::Vec3* dst, const Tempest::Vec3* src);
+
+  private:
+    // leaf may grow by this factor (relative to build time), before objects are moved to other leaf
+    static constexpr float maxGrowth = 1.5f;
+
+    void build(uint32_t node, uint32_t begin, uint32_t end);
+  };
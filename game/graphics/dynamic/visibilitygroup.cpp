@@ -34,13 +34,15 @@ VisibilityGroup::Token::~Token() {
   t.vSet = nullptr;
   group->freeList.push_back(id);
   if(group==&owner->stat)
-    owner->updateThree = true;
+    owner->detachStatic(id);
   }
 
 void VisibilityGroup::Token::setObject(VisibleSet* b, size_t i) {
   auto& t = group->tokens[id];
   t.vSet = b;
   t.id   = i;
+  if(group==&owner->stat)
+    owner->invalidateStatic(id);
   }
 
 void VisibilityGroup::Token::setObjMatrix(const Matrix4x4& at) {
@@ -50,7 +52,7 @@ void VisibilityGroup::Token::setObjMatrix(const Matrix4x4& at) {
   t.pos        = at;
   t.updateBbox = true;
   if(group==&owner->stat)
-    owner->updateThree = true;
+    owner->invalidateStatic(id);
   }
 
 void VisibilityGroup::Token::setGroup(Group gr) {
@@ -61,18 +63,23 @@ void VisibilityGroup::Token::setGroup(Group gr) {
     return;
 
   const auto prevId = id;
+  const auto tok    = group->tokens[id];
   if(g.freeList.size()>0) {
     size_t id2 = g.freeList.back();
     g.freeList.pop_back();
-    g.tokens[id2] = group->tokens[id];
+    g.tokens[id2] = tok;
     id = id2;
     } else {
-    g.tokens.push_back(group->tokens[id]);
+    g.tokens.push_back(tok);
     id = g.tokens.size()-1;
     }
   group->tokens[prevId] = Tok();
   group->freeList.push_back(prevId);
+  if(group==&owner->stat)
+    owner->detachStatic(prevId);
   group = &g;
+  if(group==&owner->stat)
+    owner->invalidateStatic(id);
   }
 
 void VisibilityGroup::Token::setBounds(const Bounds& bbox) {
@@ -82,7 +89,7 @@ void VisibilityGroup::Token::setBounds(const Bounds& bbox) {
   t.bbox       = bbox;
   t.updateBbox = true;
   if(group==&owner->stat)
-    owner->updateThree = true;
+    owner->invalidateStatic(id);
   }
 
 const Bounds& VisibilityGroup::Token::bounds() const {
@@ -99,6 +106,10 @@ VisibilityGroup::VisibilityGroup(const std::pair<Vec3, Vec3>& bbox) {
   stat.freeList.reserve(4);
   }
 
+VisibilityGroup::~VisibilityGroup() {
+  rebuildTask.wait();
+  }
+
 VisibilityGroup::TokList& VisibilityGroup::group(Group gr) {
   switch(gr) {
     case G_Default:   return def;
@@ -108,143 +119,225 @@ VisibilityGroup::TokList& VisibilityGroup::group(Group gr) {
   return def;
   }
 
-void VisibilityGroup::buildTree() {
-  treeTok.resize(stat.tokens.size());
+void VisibilityGroup::invalidateStatic(size_t id) {
+  if(statInfo.size()<stat.tokens.size())
+    statInfo.resize(stat.tokens.size());
+  auto& inf = statInfo[id];
+  inf.gen++;
+  if(inf.dirty)
+    return;
+  inf.dirty = true;
+  statDirty.push_back(id);
+  }
+
+void VisibilityGroup::detachStatic(size_t id) {
+  if(statInfo.size()<stat.tokens.size())
+    statInfo.resize(stat.tokens.size());
+  auto& inf = statInfo[id];
+  // bump generation, so in-flight rebuild will drop this token
+  inf.gen++;
+  if(inf.treeId==size_t(-1))
+    return;
+  auto& itm = tree.items[inf.treeId];
+  itm.tok    = size_t(-1);
+  inf.treeId = size_t(-1);
+  refitLeaves.push_back(itm.leaf);
+  treeDead++;
+  }
 
-  size_t tSz = 0;
-  for(auto& t:stat.tokens) {
+void VisibilityGroup::addPending(size_t id) {
+  auto& inf = statInfo[id];
+  if(inf.pending)
+    return;
+  inf.pending = true;
+  statPending.push_back(id);
+  }
+
+void VisibilityGroup::itemBbox(const Tok& t, Vec3* bbox) {
+  auto& b = t.bbox.bbox;
+  Vec3 pt[8] = {
+    {b[0].x,b[0].y,b[0].z},
+    {b[1].x,b[0].y,b[0].z},
+    {b[0].x,b[1].y,b[0].z},
+    {b[1].x,b[1].y,b[0].z},
+
+    {b[0].x,b[0].y,b[1].z},
+    {b[1].x,b[0].y,b[1].z},
+    {b[0].x,b[1].y,b[1].z},
+    {b[1].x,b[1].y,b[1].z},
+    };
+  for(auto& i:pt)
+    t.pos.project(i);
+
+  bbox[0] = pt[0];
+  bbox[1] = pt[0];
+  for(auto& i:pt) {
+    bbox[0].x = std::min(bbox[0].x, i.x);
+    bbox[0].y = std::min(bbox[0].y, i.y);
+    bbox[0].z = std::min(bbox[0].z, i.z);
+    bbox[1].x = std::max(bbox[1].x, i.x);
+    bbox[1].y = std::max(bbox[1].y, i.y);
+    bbox[1].z = std::max(bbox[1].z, i.z);
+    }
+  }
+
+VisibilityGroup::Tree VisibilityGroup::snapshotTree() const {
+  Tree ret;
+  ret.items.reserve(stat.tokens.size());
+  for(size_t i=0; i<stat.tokens.size(); ++i) {
+    auto& t = stat.tokens[i];
     if(t.vSet==nullptr)
       continue;
-    auto& b = t.bbox.bbox;
-    Vec3 pt[8] = {
-      {b[0].x,b[0].y,b[0].z},
-      {b[1].x,b[0].y,b[0].z},
-      {b[0].x,b[1].y,b[0].z},
-      {b[1].x,b[1].y,b[0].z},
-
-      {b[0].x,b[0].y,b[1].z},
-      {b[1].x,b[0].y,b[1].z},
-      {b[0].x,b[1].y,b[1].z},
-      {b[1].x,b[1].y,b[1].z},
-      };
-    for(auto& i:pt)
-      t.pos.project(i);
-
-    auto& tx = treeTok[tSz];
-    tx.self    = &t;
-    tx.bbox[0] = pt[0];
-    tx.bbox[1] = pt[1];
-    for(auto& i:pt) {
-      tx.bbox[0].x = std::min(tx.bbox[0].x, i.x);
-      tx.bbox[0].y = std::min(tx.bbox[0].y, i.y);
-      tx.bbox[0].z = std::min(tx.bbox[0].z, i.z);
-      tx.bbox[1].x = std::max(tx.bbox[1].x, i.x);
-      tx.bbox[1].y = std::max(tx.bbox[1].y, i.y);
-      tx.bbox[1].z = std::max(tx.bbox[1].z, i.z);
-      }
+    StaticBvh::Item tx;
+    tx.tok  = i;
+    tx.gen  = statInfo[i].gen;
+    tx.vSet = t.vSet;
+    itemBbox(t,tx.bbox);
     tx.midTr = (tx.bbox[1]+tx.bbox[0])*0.5f;
-    ++tSz;
+    ret.items.push_back(tx);
     }
-  treeTok .resize(tSz);
-  treeNode.resize(tSz);
-  treeNode.resize(2); // dummy node + root
-  buildTree(1,treeTok.data(),treeTok.data()+treeTok.size(),0);
+  return ret;
+  }
 
-  uint8_t maxTh = Workers::maxThreads();
-  size_t  depth = 1;
+void VisibilityGroup::startRebuild(bool async) {
+  Tree next = snapshotTree();
+  if(!async) {
+    next.build();
+    applyTree(std::move(next));
+    return;
+    }
 
+  rebuildActive = true;
+  rebuildTask.run([this, next = std::move(next)]() mutable {
+    next.build();
+    rebuilt = std::move(next);
+    rebuildReady.store(true);
+    });
+  }
+
+void VisibilityGroup::applyTree(Tree&& next) {
+  for(auto& i:tree.items)
+    if(i.tok!=size_t(-1))
+      statInfo[i.tok].treeId = size_t(-1);
+
+  tree     = std::move(next);
+  treeDead = 0;
+  refitLeaves.clear();
+  for(size_t i=0; i<tree.items.size(); ++i) {
+    auto& itm = tree.items[i];
+    auto& inf = statInfo[itm.tok];
+    if(stat.tokens[itm.tok].vSet==nullptr || inf.gen!=itm.gen) {
+      // token was modified, while tree was in flight
+      itm.tok = size_t(-1);
+      refitLeaves.push_back(itm.leaf);
+      treeDead++;
+      continue;
+      }
+    inf.treeId = i;
+    }
+
+  for(auto id:statPending)
+    statInfo[id].pending = false;
+  statPending.clear();
+  for(size_t i=0; i<stat.tokens.size(); ++i) {
+    if(stat.tokens[i].vSet!=nullptr && statInfo[i].treeId==size_t(-1))
+      addPending(i);
+    }
+
+  uint32_t maxTh = Workers::maxThreads();
+  size_t  depth = 0;
   if(maxTh>=8)
     depth = 3;
   else if(maxTh>=4)
     depth = 2;
   else if(maxTh>=2)
     depth = 1;
-  else if(maxTh>=0)
-    depth = 0;
   treeTasks.clear();
-  buildTreeTasks(1,depth,treeTok.data(),treeTok.data()+treeTok.size());
+  buildTreeTasks(0,depth);
   }
 
-void VisibilityGroup::buildTree(size_t node, TreeItm* begin, TreeItm* end, size_t step) {
-  size_t sz = size_t(std::distance(begin,end));
+void VisibilityGroup::buildTreeTasks(size_t node, size_t depth) {
+  if(tree.nodes.size()<=node)
+    return;
+  auto& n = tree.nodes[node];
+  if(n.child==0 || depth==0) {
+    treeTasks.push_back(node);
+    return;
+    }
+  buildTreeTasks(n.child+0, depth-1);
+  buildTreeTasks(n.child+1, depth-1);
+  }
 
-  Vec3 bbox[2] = {};
-  for(auto i=begin; i!=end; ++i) {
-    if(bbox[0]==bbox[1]) {
-      bbox[0] = i->bbox[0];
-      bbox[1] = i->bbox[1];
+void VisibilityGroup::updateStaticTree() {
+  for(auto id:statDirty) {
+    auto& inf = statInfo[id];
+    auto& t   = stat.tokens[id];
+    inf.dirty = false;
+    if(t.vSet==nullptr)
+      continue;
+    if(inf.treeId==size_t(-1)) {
+      addPending(id);
+      continue;
       }
-    bbox[0].x = std::min(bbox[0].x, i->bbox[0].x);
-    bbox[0].y = std::min(bbox[0].y, i->bbox[0].y);
-    bbox[0].z = std::min(bbox[0].z, i->bbox[0].z);
 
-    bbox[1].x = std::max(bbox[1].x, i->bbox[1].x);
-    bbox[1].y = std::max(bbox[1].y, i->bbox[1].y);
-    bbox[1].z = std::max(bbox[1].z, i->bbox[1].z);
-    }
+    auto& itm  = tree.items[inf.treeId];
+    Vec3  bbox[2] = {};
+    itemBbox(t,bbox);
 
-  Node n;
-  n.bbox.assign(bbox);
-  treeNode[node] = n;
-
-  const  float  blockSz     = 5*100;
-  const  auto   boxSz       = bbox[1]-bbox[0];
-  static size_t minNodeSize = 16;
-  if(sz<=minNodeSize || (boxSz.x<blockSz && boxSz.y<blockSz && boxSz.z<blockSz)) {
-    // avoid cache-line stealing, on push
-    std::sort(begin,end,[](const TreeItm& l, const TreeItm& r) {
-      return l.self->vSet < r.self->vSet;
-      });
-    treeNode[node].isLeaf = true;
-    return;
+    if(!tree.fits(itm.leaf,bbox)) {
+      // object moved far away from it's leaf - reinsert into best leaf, or overflow list
+      if(!reinsertStatic(id,bbox)) {
+        detachStatic(id);
+        addPending(id);
+        }
+      continue;
+      }
+    itm.bbox[0] = bbox[0];
+    itm.bbox[1] = bbox[1];
+    itm.midTr   = (bbox[1]+bbox[0])*0.5f;
+    itm.gen     = inf.gen;
+    refitLeaves.push_back(itm.leaf);
     }
+  statDirty.clear();
 
-  if(step==0) {
-    std::sort(begin,end,[](const TreeItm& l, const TreeItm& r) {
-      return l.self->bbox.r < r.self->bbox.r;
-      });
-    }
-  else switch(step%3) {
-    case 0:{
-      std::sort(begin,end,[](const TreeItm& l, const TreeItm& r) {
-        return l.midTr.x < r.midTr.x;
-        });
-      break;
-      }
-    case 1:{
-      std::sort(begin,end,[](const TreeItm& l, const TreeItm& r) {
-        return l.midTr.y < r.midTr.y;
-        });
-      break;
-      }
-    case 2:{
-      std::sort(begin,end,[](const TreeItm& l, const TreeItm& r) {
-        return l.midTr.z < r.midTr.z;
-        });
-      break;
+  tree.refit(refitLeaves);
+
+  size_t cnt = 0;
+  for(auto id:statPending) {
+    auto& inf = statInfo[id];
+    if(stat.tokens[id].vSet==nullptr || inf.treeId!=size_t(-1)) {
+      inf.pending = false;
+      continue;
       }
+    statPending[cnt] = id;
+    ++cnt;
     }
-  
-  treeNode.resize(std::max(treeNode.size(),node*2+2));
-  buildTree(node*2+0, begin,      begin+sz/2, step+1);
-  buildTree(node*2+1, begin+sz/2, begin+sz,   step+1);
+  statPending.resize(cnt);
   }
 
-void VisibilityGroup::buildTreeTasks(size_t node, size_t depth, TreeItm* begin, TreeItm* end) {
-  if(treeNode.size()<=node)
-    return;
-  auto& n = treeNode[node];
-  if(n.isLeaf || depth==0) {
-    TreeTask task = {};
-    task.begin = begin;
-    task.end   = end;
-    task.node  = node;
-    treeTasks.push_back(task);
-    return;
-    }
-  auto sz = size_t(std::distance(begin,end));
-  buildTreeTasks(node*2+0, depth-1, begin,      begin+sz/2);
-  buildTreeTasks(node*2+1, depth-1, begin+sz/2, begin+sz  );
+bool VisibilityGroup::reinsertStatic(size_t id, const Vec3* bbox) {
+  if(tree.nodes.size()==0)
+    return false;
+
+  const uint32_t leaf = tree.findLeaf(bbox);
+  if(!tree.fits(leaf,bbox))
+    return false;
+
+  // old slot stays dead, until next rebuild
+  detachStatic(id);
+
+  auto&           inf = statInfo[id];
+  StaticBvh::Item itm;
+  itm.tok     = id;
+  itm.gen     = inf.gen;
+  itm.vSet    = stat.tokens[id].vSet;
+  itm.bbox[0] = bbox[0];
+  itm.bbox[1] = bbox[1];
+  itm.midTr   = (bbox[1]+bbox[0])*0.5f;
+
+  inf.treeId = tree.insert(leaf,itm);
+  refitLeaves.push_back(leaf);
+  return true;
   }
 
 VisibilityGroup::Token VisibilityGroup::get(Group g) {
@@ -257,15 +350,32 @@ VisibilityGroup::Token VisibilityGroup::get(Group g) {
     gr.tokens.emplace_back();
     }
   if(&gr==&stat) {
-    updateThree = true;
+    invalidateStatic(id);
     }
   return Token(*this, gr,id);
   }
 
 void VisibilityGroup::pass(const Frustrum f[]) {
-  if(updateThree) {
-    buildTree();
-    updateThree = false;
+  if(rebuildReady.load()) {
+    rebuildTask.wait();
+    applyTree(std::move(rebuilt));
+    rebuilt       = Tree();
+    rebuildReady  = false;
+    rebuildActive = false;
+    }
+
+  updateStaticTree();
+  if(!rebuildActive) {
+    // SAH-cost of leaves, relative to freshly built tree
+    static const double maxCostGrowth = 1.25;
+    const size_t alive    = tree.items.size()-treeDead;
+    const size_t overflow = statPending.size()+treeDead;
+    if(statPending.size()>alive)
+      startRebuild(false); // mostly initial load - build in place
+    else if(overflow>std::max<size_t>(256, alive/16))
+      startRebuild(true);
+    else if(tree.cost>tree.cost0*maxCostGrowth)
+      startRebuild(true);
     }
 
   Workers::parallelFor(resetableSets,[](VisibleSet *v){
@@ -282,6 +392,9 @@ void VisibilityGroup::pass(const Frustrum f[]) {
 
   testStaticObjectsThreaded(f);
 
+  Workers::parallelFor(statPending,[this,&f](size_t id) {
+    testVisibility(stat.tokens[id],f);
+    });
   Workers::parallelFor(def.tokens,[&f](Tok& t) {
     testVisibility(t,f);
     });
@@ -300,37 +413,55 @@ void VisibilityGroup::buildVSetIndex(const std::vector<ObjectsBucket*>& index) {
 
 void VisibilityGroup::testStaticObjectsThreaded(const Frustrum f[]) {
   Workers::parallelTasks(treeTasks.size(),[&](uintptr_t taskId) {
-    auto& t = treeTasks[taskId];
+    auto node = treeTasks[taskId];
     for(uint8_t c=SceneGlobals::V_Shadow0; c<SceneGlobals::V_Count; ++c)
-      testStaticObjects(f,SceneGlobals::VisCamera(c),t.node, t.begin,t.end);
+      testStaticObjects(f,SceneGlobals::VisCamera(c),node);
     });
   }
 
-void VisibilityGroup::setVisible(SceneGlobals::VisCamera c, TreeItm* begin, TreeItm* end) {
-  for(auto i=begin; i!=end; ++i) {
-    auto& v = *i->self->vSet;
-    v.push(i->self->id, c);
+void VisibilityGroup::setVisible(SceneGlobals::VisCamera c, const Node& n) {
+  for(size_t i=n.begin; i<n.end; ++i) {
+    auto id = tree.items[i].tok;
+    if(id==size_t(-1))
+      continue;
+    auto& t = stat.tokens[id];
+    t.vSet->push(t.id, c);
+    }
+  if(tree.items.size()>tree.built)
+    setVisibleExtra(c,n);
+  }
+
+void VisibilityGroup::setVisibleExtra(SceneGlobals::VisCamera c, const Node& n) {
+  if(n.child!=0) {
+    setVisibleExtra(c,tree.nodes[n.child+0]);
+    setVisibleExtra(c,tree.nodes[n.child+1]);
+    return;
+    }
+  for(auto i=n.extra; i!=StaticBvh::NoItem; i=tree.items[i].next) {
+    auto id = tree.items[i].tok;
+    if(id==size_t(-1))
+      continue;
+    auto& t = stat.tokens[id];
+    t.vSet->push(t.id, c);
     }
   }
 
-void VisibilityGroup::testStaticObjects(const Frustrum f[], SceneGlobals::VisCamera c,
-                                        size_t node, TreeItm* begin, TreeItm* end) {
-  if(treeNode.size()<=node)
+void VisibilityGroup::testStaticObjects(const Frustrum f[], SceneGlobals::VisCamera c, size_t node) {
+  if(tree.nodes.size()<=node)
     return;
-  auto& n       = treeNode[node];
-  auto  visible = f[c].testBbox(n.bbox.bbox[0],n.bbox.bbox[1]);
+  auto& n       = tree.nodes[node];
+  auto  visible = f[c].testBbox(n.bbox[0],n.bbox[1]);
 
-  if(n.isLeaf || visible==Frustrum::T_Full) {
-    setVisible(SceneGlobals::VisCamera(c),begin,end);
+  if(n.child==0 || visible==Frustrum::T_Full) {
+    setVisible(c,n);
     return;
     }
   if(visible==Frustrum::T_Invisible) {
     return;
     }
 
-  size_t sz = size_t(std::distance(begin,end));
-  testStaticObjects(f,c, node*2+0, begin,     begin+sz/2);
-  testStaticObjects(f,c, node*2+1, begin+sz/2,end);
+  testStaticObjects(f,c, n.child+0);
+  testStaticObjects(f,c, n.child+1);
   }
 
 void VisibilityGroup::testVisibility(Tok& t, const Frustrum f[]) {
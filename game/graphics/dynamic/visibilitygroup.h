@@ -2,9 +2,12 @@
 
 #include <Tempest/Matrix4x4>
 #include <cstdint>
+#include <atomic>
 
 #include "graphics/sceneglobals.h"
 #include "graphics/bounds.h"
+#include "utils/workers.h"
+#include "staticbvh.h"
 
 class Frustrum;
 class VisibleSet;
@@ -16,6 +19,7 @@ class VisibilityGroup {
 
   public:
     VisibilityGroup(const std::pair<Tempest::Vec3, Tempest::Vec3>& bbox);
+    ~VisibilityGroup();
 
     enum Group : uint8_t {
       G_Default,
@@ -65,39 +69,50 @@ class VisibilityGroup {
       };
     TokList def, stat, alwaysVis;
 
-    struct TreeItm {
-      Tok*          self = nullptr;
-      Tempest::Vec3 bbox[2];
-      Tempest::Vec3 midTr;
+    // bookkeeping of static tokens, parallel to stat.tokens
+    struct StatInfo {
+      size_t   treeId  = size_t(-1);
+      uint32_t gen     = 0;
+      bool     dirty   = false;
+      bool     pending = false;
       };
-    struct Node {
-      Bounds        bbox;
-      bool          isLeaf = false;
-      Frustrum::Ret visible[SceneGlobals::V_Count] = {};
-      };
-    struct TreeTask {
-      TreeItm* begin = nullptr;
-      TreeItm* end   = nullptr;
-      size_t   node  = 0;
-      };
-    std::vector<Node>        treeNode;
-    std::vector<TreeItm>     treeTok;
-    std::vector<TreeTask>    treeTasks;
+    std::vector<StatInfo>    statInfo;
+    std::vector<size_t>      statDirty;
+    std::vector<size_t>      statPending;
+
+    using Tree = StaticBvh;
+    using Node = StaticBvh::Node;
+    Tree                     tree;
+    size_t                   treeDead = 0;
+    std::vector<size_t>      treeTasks;
+    std::vector<uint32_t>    refitLeaves;
+
+    Workers::Group           rebuildTask;
+    std::atomic_bool         rebuildReady{false};
+    bool                     rebuildActive = false;
+    Tree                     rebuilt;
 
     std::vector<VisibleSet*> resetableSets;
 
-    bool                     updateThree = false;
+    void     invalidateStatic(size_t id);
+    void     detachStatic(size_t id);
+    void     addPending(size_t id);
+
+    void     updateStaticTree();
+    bool     reinsertStatic(size_t id, const Tempest::Vec3* bbox);
+    void     startRebuild(bool async);
+    Tree     snapshotTree() const;
+    void     applyTree(Tree&& next);
 
-    void     buildTree();
-    void     buildTree(size_t node, TreeItm* begin, TreeItm* end, size_t step);
-    void     buildTreeTasks(size_t node, size_t depth, TreeItm* begin, TreeItm* end);
+    void     buildTreeTasks(size_t node, size_t depth);
     TokList& group(Group gr);
 
-    static void setVisible  (SceneGlobals::VisCamera c, TreeItm* begin, TreeItm* end);
+    static void itemBbox(const Tok& t, Tempest::Vec3* bbox);
+    void        setVisible(SceneGlobals::VisCamera c, const Node& n);
+    void        setVisibleExtra(SceneGlobals::VisCamera c, const Node& n);
 
     void        testStaticObjectsThreaded(const Frustrum f[]);
-    void        testStaticObjects(const Frustrum f[], SceneGlobals::VisCamera c,
-                                  size_t node, TreeItm* begin, TreeItm* end);
+    void        testStaticObjects(const Frustrum f[], SceneGlobals::VisCamera c, size_t node);
     static void testVisibility(Tok& t, const Frustrum f[]);
     static bool subpixelMeshTest(const Tok& t, const Frustrum& f, float edgeX, float edgeY);
   };
@@ -348,8 +348,28 @@ const phoenix::vobs::light_preset& LightGroup::findPreset(std::string_view prese
   return zero;
   }
 
+void LightGroup::cullLights() {
+  Frustrum fr;
+  fr.make(scene.viewProject(),1,1);
+
+  // range() is maximum of range animation, so bound is valid for any frame
+  LightBucket* bucket[2] = {&bucketSt, &bucketDyn};
+  for(auto b:bucket) {
+    b->visible.clear();
+    for(size_t i=0; i<b->light.size(); ++i) {
+      auto& l = b->light[i];
+      if(l.range()>0 && fr.testPoint(l.position(),l.range()))
+        b->visible.push_back(uint32_t(i));
+      }
+    }
+  }
+
 void LightGroup::tick(uint64_t time) {
-  for(size_t i=0; i<bucketDyn.light.size(); ++i) {
+  std::lock_guard<std::recursive_mutex> guard(sync);
+  cullLights();
+
+  // animation is function of time, so lights out of view can skip updates
+  for(auto i:bucketDyn.visible) {
     auto& light = bucketDyn.light[i];
     light.update(time);
 
@@ -357,13 +377,16 @@ void LightGroup::tick(uint64_t time) {
     ssbo.pos   = light.position();
     ssbo.color = light.currentColor();
     ssbo.range = light.currentRange();
+    }
 
+  if(!bucketDyn.visible.empty()) {
     for(auto& updated:bucketDyn.updated)
       updated = false;
     }
   }
 
 void LightGroup::preFrameUpdate(uint8_t fId) {
+  std::lock_guard<std::recursive_mutex> guard(sync);
   auto& device = Resources::device();
   LightBucket* bucket[2] = {&bucketSt, &bucketDyn};
   for(auto b:bucket) {
@@ -378,6 +401,23 @@ void LightGroup::preFrameUpdate(uint8_t fId) {
       }
     }
 
+  for(auto b:bucket) {
+    auto& vis = b->visible;
+    auto& buf = b->visibleSsbo[fId];
+    // light might be freed after tick; ids are ascending
+    while(!vis.empty() && vis.back()>=b->data.size())
+      vis.pop_back();
+    const size_t sz = vis.size()*sizeof(vis[0]);
+    if(sz==0)
+      continue;
+    if(buf.byteSize()<sz) {
+      // visible count changes with camera: grow with reserve, to not reallocate every frame
+      buf = device.ssbo(BufferHeap::Upload,nullptr,std::max(sz+sz/2,buf.byteSize()*2));
+      b->ubo[fId].set(11,buf);
+      }
+    buf.update(vis.data(),0,sz);
+    }
+
   Frustrum fr;
   fr.make(scene.viewProject(),1,1);
 
@@ -398,13 +438,13 @@ void LightGroup::draw(Encoder<CommandBuffer>& cmd, uint8_t fId) {
     return;
 
   auto& p = shader();
-  if(bucketSt.data.size()>0) {
+  if(bucketSt.visible.size()>0) {
     cmd.setUniforms(p,bucketSt.ubo[fId]);
-    cmd.draw(vbo,ibo, 0,ibo.size(), 0,bucketSt.data.size());
+    cmd.draw(vbo,ibo, 0,ibo.size(), 0,bucketSt.visible.size());
     }
-  if(bucketDyn.data.size()>0) {
+  if(bucketDyn.visible.size()>0) {
     cmd.setUniforms(p,bucketDyn.ubo[fId]);
-    cmd.draw(vbo,ibo, 0,ibo.size(), 0,bucketDyn.data.size());
+    cmd.draw(vbo,ibo, 0,ibo.size(), 0,bucketDyn.visible.size());
     }
   }
 
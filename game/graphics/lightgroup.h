@@ -87,6 +87,9 @@ class LightGroup final {
       std::vector<size_t>      freeList;
       Tempest::DescriptorSet   ubo[Resources::MaxFramesInFlight];
 
+      std::vector<uint32_t>    visible; // culled by view frustum, instances to draw
+      Tempest::StorageBuffer   visibleSsbo[Resources::MaxFramesInFlight];
+
       size_t                   alloc();
       void                     free(size_t id);
       };
@@ -98,6 +101,7 @@ class LightGroup final {
     LightSource&                       getL(size_t id);
 
     Tempest::RenderPipeline&           shader() const;
+    void                               cullLights();
 
     const phoenix::vobs::light_preset& findPreset(std::string_view preset) const;
 
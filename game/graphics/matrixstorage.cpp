@@ -1,5 +1,6 @@
 #include "matrixstorage.h"
 
+#include <algorithm>
 #include <cstdint>
 
 #include "graphics/mesh/pose.h"
@@ -25,8 +26,7 @@ MatrixStorage::Id::~Id() {
 void MatrixStorage::Id::set(const Tempest::Matrix4x4* mat) {
   if(heapPtr!=nullptr) {
     std::memcpy(heapPtr->data.data()+rgn.begin, mat, rgn.size*sizeof(Tempest::Matrix4x4));
-    for(uint8_t i=0; i<Resources::MaxFramesInFlight; ++i)
-      heapPtr->durty[i].store(true);
+    heapPtr->durty.mark(rgn.begin,rgn.size);
     }
   }
 
@@ -34,11 +34,7 @@ void MatrixStorage::Id::set(const Tempest::Matrix4x4& obj, size_t offset) {
   if(heapPtr==nullptr)
     return;
   heapPtr->data[rgn.begin+offset] = obj;
-
-  if(heapPtr==&heapPtr->owner->upload)
-    return;
-  for(uint8_t i=0; i<Resources::MaxFramesInFlight; ++i)
-    heapPtr->durty[i].store(true);
+  heapPtr->durty.mark(rgn.begin+offset,1);
   }
 
 const StorageBuffer& MatrixStorage::Id::ssbo(uint8_t fId) const {
@@ -54,39 +50,43 @@ BufferHeap MatrixStorage::Id::heap() const {
   return BufferHeap::Upload;
   }
 
-
 MatrixStorage::MatrixStorage() {
   upload.data.reserve(2048);
-  upload.data.resize(1);
+  grow(upload,1);
   upload.data[0].identity();
   upload.owner = this;
 
   device.data.reserve(2048);
-  device.data.resize(1);
+  grow(device,1);
   device.data[0].identity();
   device.owner = this;
   }
 
 bool MatrixStorage::commit(uint8_t fId) {
   bool ret = commit(upload,fId);
-  if(device.durty[fId].load()) {
-    ret |= commit(device,fId);
-    device.durty[fId].store(false);
-    }
+  ret |= commit(device,fId);
   return ret;
   }
 
 bool MatrixStorage::commit(Heap& heap, uint8_t fId) {
+  heap.durty.collect();
+
   auto&  obj = heap.gpu[fId];
   size_t sz  = heap.data.size() * sizeof(Tempest::Matrix4x4);
-  if(obj.byteSize()==sz) {
-    obj.update(heap.data);
-    return false;
+  if(obj.byteSize()!=sz) {
+    auto  bh     = (&heap==&upload ? BufferHeap::Upload : BufferHeap::Device);
+    auto& device = Resources::device();
+    obj = device.ssbo(bh,heap.data.data(),sz);
+    heap.durty.clear(fId);
+    return true;
     }
-  auto  bh     = (&heap==&upload ? BufferHeap::Upload : BufferHeap::Device);
-  auto& device = Resources::device();
-  obj = device.ssbo(bh,heap.data.data(),sz);
-  return true;
+
+  // upload runs of dirty pages; close runs are merged, to keep number of copies low
+  heap.durty.runs(fId,heap.data.size(),MergeGap,[&](size_t begin, size_t end) {
+    const size_t msz = sizeof(Tempest::Matrix4x4);
+    obj.update(heap.data.data()+begin, begin*msz, (end-begin)*msz);
+    });
+  return false;
   }
 
 MatrixStorage::Id MatrixStorage::alloc(BufferHeap heap, size_t nbones) {
@@ -94,30 +94,33 @@ MatrixStorage::Id MatrixStorage::alloc(BufferHeap heap, size_t nbones) {
     return Id(upload,Range());
 
   auto& h = (heap==BufferHeap::Upload ? upload : device);
-  for(size_t i=0; i<h.rgn.size(); ++i) {
-    if(h.rgn[i].size==nbones) {
-      auto ret = h.rgn[i];
-      h.rgn.erase(h.rgn.begin()+intptr_t(i));
+  for(int pass=0; pass<2 && h.freeCount>0; ++pass) {
+    // exact size first, then smallest larger range
+    for(size_t i=nbones; i<h.freeList.size(); ++i) {
+      auto& fl = h.freeList[i];
+      if(fl.empty())
+        continue;
+      Range ret = fl.back();
+      fl.pop_back();
+      h.freeCount--;
+      if(ret.size>nbones) {
+        Range rest;
+        rest.begin = ret.begin+nbones;
+        rest.size  = ret.size -nbones;
+        free(h,rest);
+        ret.size   = nbones;
+        }
       return Id(h,ret);
       }
+    // nothing fits: merge adjacent free ranges, before growing the heap
+    if(pass==0)
+      coalesce(h);
     }
-  size_t retId = size_t(-1);
-  for(size_t i=0; i<h.rgn.size(); ++i) {
-    if(h.rgn[i].size>nbones && (retId==size_t(-1) || h.rgn[i].size<h.rgn[retId].size)) {
-      retId = i;
-      }
-    }
-  if(retId!=size_t(-1)) {
-    Range ret = h.rgn[retId];
-    ret.size = nbones;
-    h.rgn[retId].begin += nbones;
-    h.rgn[retId].size  -= nbones;
-    return Id(h,ret);
-    }
+
   Range r;
   r.begin = h.data.size();
   r.size  = nbones;
-  h.data.resize(h.data.size()+r.size);
+  grow(h,h.data.size()+r.size);
   return Id(h,r);
   }
 
@@ -128,19 +131,35 @@ const Tempest::StorageBuffer& MatrixStorage::ssbo(Tempest::BufferHeap heap, uint
   }
 
 void MatrixStorage::free(Heap& heap, const Range& r) {
-  for(auto& i:heap.rgn) {
-    if(i.begin+i.size==r.begin) {
-      i.size+=r.size;
-      return;
-      }
-    if(r.begin+r.size==i.begin) {
-      i.begin -= r.size;
-      i.size  += r.size;
-      return;
-      }
+  if(r.size==0)
+    return;
+  if(heap.freeList.size()<=r.size)
+    heap.freeList.resize(r.size+1);
+  heap.freeList[r.size].push_back(r);
+  heap.freeCount++;
+  }
+
+void MatrixStorage::grow(Heap& heap, size_t size) {
+  heap.data.resize(size);
+  heap.durty.resize(size);
+  }
+
+void MatrixStorage::coalesce(Heap& heap) {
+  std::vector<Range> rgn;
+  rgn.reserve(heap.freeCount);
+  for(auto& i:heap.freeList) {
+    rgn.insert(rgn.end(),i.begin(),i.end());
+    i.clear();
     }
-  auto at = std::lower_bound(heap.rgn.begin(),heap.rgn.end(),r,[](const Range& l, const Range& r){
+  heap.freeCount = 0;
+
+  std::sort(rgn.begin(),rgn.end(),[](const Range& l, const Range& r){
     return l.begin<r.begin;
     });
-  heap.rgn.insert(at,r);
+  for(size_t i=0; i<rgn.size(); ) {
+    Range r = rgn[i];
+    for(++i; i<rgn.size() && r.begin+r.size==rgn[i].begin; ++i)
+      r.size += rgn[i].size;
+    free(heap,r);
+    }
   }
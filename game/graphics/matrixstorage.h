@@ -6,6 +6,7 @@
 
 #include <vector>
 
+#include "utils/dirtypages.h"
 #include "resources.h"
 
 class MatrixStorage {
@@ -45,15 +46,23 @@ class MatrixStorage {
     bool commit(uint8_t fId);
 
   private:
+    // dirty tracking granularity, in matrices; dirty runs closer than MergeGap pages are uploaded as one
+    enum { PageSize = 8, MergeGap = 2 };
+
     bool commit(Heap& heap, uint8_t fId);
     void free(Heap& heap, const Range& r);
+    void grow(Heap& heap, size_t size);
+    void coalesce(Heap& heap);
 
     struct Heap {
-      MatrixStorage*                  owner = nullptr;
-      std::vector<Range>              rgn;
-      std::vector<Tempest::Matrix4x4> data;
-      Tempest::StorageBuffer          gpu[Resources::MaxFramesInFlight];
-      std::atomic_bool                durty[Resources::MaxFramesInFlight] = {};
+      MatrixStorage*                     owner = nullptr;
+      // free ranges by size
+      std::vector<std::vector<Range>>    freeList;
+      size_t                             freeCount = 0;
+      std::vector<Tempest::Matrix4x4>    data;
+      Tempest::StorageBuffer             gpu[Resources::MaxFramesInFlight];
+      // written by Id::set from any thread
+      DirtyPages<PageSize,Resources::MaxFramesInFlight> durty;
       };
     Heap upload, device;
   };
@@ -1,5 +1,6 @@
 #include "protomesh.h"
 
+#include <cstring>
 #include <Tempest/Log>
 
 #include "graphics/mesh/submesh/packedmesh.h"
@@ -60,9 +61,9 @@ ProtoMesh::ProtoMesh(PackedMesh&& pm, const std::vector<phoenix::morph_animation
     samplesCnt += i.samples.size();
     }
 
-  morphIndex   = Resources::ssbo(nullptr, indexSzAligned*aniList.size());
-  morphSamples = Resources::ssbo(nullptr, samplesCnt*sizeof(Vec4));
-
+  // may run on prefetch workers: prepare on cpu and upload once, under gpu lock of Resources::ssbo
+  std::vector<uint8_t> indexData(indexSzAligned*aniList.size());
+  std::vector<Vec4>    samplesData(samplesCnt);
   std::vector<int32_t> remapId;
   std::vector<Vec4>    samples;
 
@@ -71,8 +72,8 @@ ProtoMesh::ProtoMesh(PackedMesh&& pm, const std::vector<phoenix::morph_animation
   for(size_t i=0; i<aniList.size(); ++i) {
     remap(aniList[i],pm.verticesId,remapId,samples,samplesCnt);
 
-    morphIndex  .update(remapId.data(), i*indexSzAligned,        remapId.size()*sizeof(remapId[0]));
-    morphSamples.update(samples.data(), samplesCnt*sizeof(Vec4), samples.size()*sizeof(Vec4)      );
+    std::memcpy(indexData.data()+i*indexSzAligned, remapId.data(), remapId.size()*sizeof(remapId[0]));
+    std::copy(samples.begin(), samples.end(), samplesData.begin()+ptrdiff_t(samplesCnt));
 
     morph[i] = mkAnimation(aniList[i]);
     morph[i].index = (i*indexSzAligned)/sizeof(int32_t);
@@ -80,6 +81,9 @@ ProtoMesh::ProtoMesh(PackedMesh&& pm, const std::vector<phoenix::morph_animation
     samplesCnt += samples.size();
     }
 
+  morphIndex   = Resources::ssbo(indexData.data(),   indexData.size());
+  morphSamples = Resources::ssbo(samplesData.data(), samplesData.size()*sizeof(Vec4));
+
   if(morph.size()>0) {
     for(auto& a:attach) {
       a.morph.anim    = &morph;
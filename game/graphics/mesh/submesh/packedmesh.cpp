@@ -7,6 +7,7 @@
 #include <unordered_set>
 
 #include "game/compatibility/phoenix.h"
+#include "utils/cachefile.h"
 #include "gothic.h"
 
 using namespace Tempest;
@@ -511,8 +512,9 @@ void PackedMesh::packMeshletsLnd(const phoenix::mesh& mesh) {
       meshlets[i].updateBounds(mesh);
 
     SubMesh pack;
-    pack.material  = mesh.materials[mId];
-    pack.iboOffset = indices.size();
+    pack.material   = mesh.materials[mId];
+    pack.materialId = uint32_t(mId);
+    pack.iboOffset  = indices.size();
     for(auto& i:meshlets)
       i.flush(vertices,indices,indices8,meshletBounds,mesh);
     pack.iboLength = indices.size() - pack.iboOffset;
@@ -668,6 +670,61 @@ std::pair<Vec3, Vec3> PackedMesh::bbox() const {
   return std::make_pair(mBbox[0],mBbox[1]);
   }
 
+std::vector<uint8_t> PackedMesh::serialize() const {
+  CacheFile::Writer out;
+  out.put(CacheVersion);
+  out.put(uint32_t(sizeof(Vertex)));
+  out.put(uint8_t(Gothic::inst().doMeshShading() ? 1 : 0)); // indices8 depend on it
+  out.put(vertices);
+  out.put(indices);
+  out.put(indices8);
+  out.put(meshletBounds);
+  out.put(mBbox);
+  out.put(uint8_t(isUsingAlphaTest ? 1 : 0));
+
+  out.put(uint64_t(subMeshes.size()));
+  for(auto& i:subMeshes) {
+    out.put(i.materialId);
+    out.put(uint64_t(i.iboOffset));
+    out.put(uint64_t(i.iboLength));
+    }
+  return out.data();
+  }
+
+bool PackedMesh::deserialize(std::vector<uint8_t>& data, const phoenix::mesh& src) {
+  CacheFile::Reader in(data);
+  uint32_t version = 0, vertSz = 0;
+  uint8_t  meshShading = 0, alphaTest = 0;
+  uint64_t subCount = 0;
+  if(!in.get(version) || version!=CacheVersion || !in.get(vertSz) || vertSz!=sizeof(Vertex))
+    return false;
+  if(!in.get(meshShading) || (meshShading!=0)!=Gothic::inst().doMeshShading())
+    return false;
+  in.get(vertices);
+  in.get(indices);
+  in.get(indices8);
+  in.get(meshletBounds);
+  in.get(mBbox);
+  in.get(alphaTest);
+  if(!in.get(subCount) || subCount>src.materials.size())
+    return false;
+
+  isUsingAlphaTest = (alphaTest!=0);
+  subMeshes.resize(size_t(subCount));
+  for(auto& i:subMeshes) {
+    uint64_t off = 0, len = 0;
+    in.get(i.materialId);
+    in.get(off);
+    in.get(len);
+    if(!in.isOk() || i.materialId>=src.materials.size() || off>indices.size() || len>indices.size()-off)
+      return false;
+    i.material  = src.materials[i.materialId];
+    i.iboOffset = size_t(off);
+    i.iboLength = size_t(len);
+    }
+  return in.isEnd();
+  }
+
 void PackedMesh::computeBbox() {
   if(vertices.size()==0) {
     mBbox[0] = Vec3();
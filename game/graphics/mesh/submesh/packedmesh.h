@@ -35,8 +35,9 @@ class PackedMesh {
 
     struct SubMesh final {
       phoenix::material material;
-      size_t            iboOffset = 0;
-      size_t            iboLength = 0;
+      uint32_t          materialId = 0; // index in source mesh, for landscape
+      size_t            iboOffset  = 0;
+      size_t            iboLength  = 0;
       };
 
     struct Bounds final {
@@ -55,6 +56,7 @@ class PackedMesh {
     std::vector<uint32_t>    verticesId; // only for morph meshes
     bool                     isUsingAlphaTest = true;
 
+    PackedMesh() = default;
     PackedMesh(const phoenix::proto_mesh& mesh, PkgType type);
     PackedMesh(const phoenix::mesh& mesh, PkgType type);
     PackedMesh(const phoenix::softskin_mesh&  mesh);
@@ -63,7 +65,13 @@ class PackedMesh {
 
     std::pair<Tempest::Vec3,Tempest::Vec3> bbox() const;
 
+    // binary image of packed landscape, for on-disk cache; materials are stored as indices in source mesh
+    std::vector<uint8_t> serialize() const;
+    bool                 deserialize(std::vector<uint8_t>& data, const phoenix::mesh& src);
+
   private:
+    static constexpr uint32_t CacheVersion = 1;
+
     Tempest::Vec3 mBbox[2];
 
     struct SkeletalData {
@@ -1,11 +1,14 @@
 #include "pfxbucket.h"
 
 #include "graphics/mesh/submesh/pfxemittermesh.h"
+#include "pfxintegrate.h"
 #include "pfxobjects.h"
 #include "particlefx.h"
 
 #include "world/objects/npc.h"
 
+#include <atomic>
+
 using namespace Tempest;
 
 static uint64_t ppsDiff(const ParticleFx& decl, bool loop, uint64_t time0, uint64_t time1) {
@@ -23,14 +26,34 @@ static uint64_t ppsDiff(const ParticleFx& decl, bool loop, uint64_t time0, uint6
   return emitted1-emitted0;
   }
 
-float PfxBucket::ParState::lifeTime() const {
-  return 1.f-life/float(maxLife);
+// seed of next bucket
+static std::atomic<uint32_t> bucketSeed{0};
+
+void PfxBucket::Particles::resize(size_t sz, size_t trlCapacity) {
+  life   .resize(sz,0);
+  maxLife.resize(sz,1);
+  for(int c=0; c<3; ++c) {
+    pos[c].resize(sz,0.f);
+    dir[c].resize(sz,0.f);
+    }
+  if(trlCapacity>0) {
+    trlHead.resize(sz,0);
+    trlSize.resize(sz,0);
+    trail  .resize(sz*trlCapacity);
+    }
   }
 
-std::mt19937 PfxBucket::rndEngine;
+void PfxBucket::Particles::set(size_t i, const Vec3& p, const Vec3& d) {
+  pos[0][i] = p.x;
+  pos[1][i] = p.y;
+  pos[2][i] = p.z;
+  dir[0][i] = d.x;
+  dir[1][i] = d.y;
+  dir[2][i] = d.z;
+  }
 
 PfxBucket::PfxBucket(const ParticleFx &decl, PfxObjects& parent, VisualObjects& visual)
-  :decl(decl), parent(parent), visual(visual)  {
+  :decl(decl), parent(parent), visual(visual), rndEngine(bucketSeed.fetch_add(1))  {
   item = visual.get(decl.visMaterial);
 
   if(!item.isEmpty())
@@ -43,8 +66,19 @@ PfxBucket::PfxBucket(const ParticleFx &decl, PfxObjects& parent, VisualObjects&
   if(blockSize==0)
     blockSize=1;
 
+  visBits |= uint32_t(decl.visZBias ? 1 : 0);
+  visBits |= uint32_t(decl.visTexIsQuadPoly ? 1 : 0) << 1;
+  visBits |= uint32_t(decl.visYawAlign ? 1 : 0) << 2;
+  visBits |= uint32_t(0) << 3; // TODO: trails
+  visBits |= uint32_t(decl.visOrientation) << 4;
+
   if(decl.hasTrails()) {
     maxTrlTime = uint64_t(decl.trlFadeSpeed*1000.f);
+    if(maxTrlTime>0) {
+      // trail points are decimated to trlStep, so ring never overflows on high fps
+      trlCapacity = 32;
+      trlStep     = maxTrlTime/(trlCapacity-2);
+      }
 
     Material mat = decl.visMaterial;
     mat.tex = decl.trlTexture;
@@ -83,11 +117,8 @@ size_t PfxBucket::allocBlock() {
   b.offset    = particles.size();
   b.timeTotal = 0;
 
-  particles.resize(particles.size()+blockSize);
+  particles.resize(particles.size()+blockSize,trlCapacity);
   pfxCpu   .resize(particles.size());
-
-  for(size_t i=0; i<blockSize; ++i)
-    particles[b.offset+i].life = 0;
   return block.size()-1;
   }
 
@@ -165,7 +196,7 @@ bool PfxBucket::shrink() {
     block.pop_back();
     }
   if(particles.size()!=block.size()*blockSize) {
-    particles.resize(block.size()*blockSize);
+    particles.resize(block.size()*blockSize,trlCapacity);
     pfxCpu   .resize(particles.size());
     return true;
     }
@@ -181,68 +212,67 @@ float PfxBucket::randf(float base, float var) {
   }
 
 void PfxBucket::init(PfxBucket::Block& block, ImplEmitter& emitter, size_t particle) {
-  auto& p   = particles[particle];
-
-  p.life    = uint16_t(randf(decl.lspPartAvg,decl.lspPartVar));
-  p.maxLife = p.life;
+  const uint16_t life = uint16_t(randf(decl.lspPartAvg,decl.lspPartVar));
+  Vec3           pos  = {};
+  Vec3           dir  = {};
 
   // TODO: pfx.shpDistribType, pfx.shpDistribWalkSpeed;
   switch(decl.shpType) {
     case ParticleFx::EmitterType::Point:{
-      p.pos = Vec3();
+      pos = Vec3();
       break;
       }
     case ParticleFx::EmitterType::Line:{
       float at = randf();
-      p.pos = Vec3(at,at,at);
+      pos = Vec3(at,at,at);
       break;
       }
     case ParticleFx::EmitterType::Box:{
       if(decl.shpIsVolume) {
-        p.pos = Vec3(randf()*2.f-1.f,
-                     randf()*2.f-1.f,
-                     randf()*2.f-1.f);
-        p.pos*=0.5;
+        pos = Vec3(randf()*2.f-1.f,
+                   randf()*2.f-1.f,
+                   randf()*2.f-1.f);
+        pos*=0.5;
         } else {
         // TODO
-        p.pos = Vec3(randf()*2.f-1.f,
-                     randf()*2.f-1.f,
-                     randf()*2.f-1.f);
-        p.pos*=0.5;
+        pos = Vec3(randf()*2.f-1.f,
+                   randf()*2.f-1.f,
+                   randf()*2.f-1.f);
+        pos*=0.5;
         }
       break;
       }
     case ParticleFx::EmitterType::Sphere:{
       float theta = float(2.0*M_PI)*randf();
       float phi   = std::acos(1.f - 2.f * randf());
-      p.pos = Vec3(std::sin(phi) * std::cos(theta),
-                   std::sin(phi) * std::sin(theta),
-                   std::cos(phi));
-      //p.pos*=0.5;
+      pos = Vec3(std::sin(phi) * std::cos(theta),
+                 std::sin(phi) * std::sin(theta),
+                 std::cos(phi));
+      //pos*=0.5;
       if(decl.shpIsVolume)
-        p.pos*=randf();
+        pos*=randf();
       break;
       }
     case ParticleFx::EmitterType::Circle:{
       float a = float(2.0*M_PI)*randf();
-      p.pos = Vec3(std::sin(a),
-                   0,
-                   std::cos(a));
-      //p.pos*=0.5;
+      pos = Vec3(std::sin(a),
+                 0,
+                 std::cos(a));
+      //pos*=0.5;
       if(decl.shpIsVolume)
-        p.pos = p.pos*std::sqrt(randf());
+        pos = pos*std::sqrt(randf());
       break;
       }
     case ParticleFx::EmitterType::Mesh:{
-      p.pos = Vec3();
+      pos = Vec3();
       auto mesh = (emitter.mesh!=nullptr) ? emitter.mesh : decl.shpMesh;
       auto pose = (emitter.mesh!=nullptr) ? emitter.pose : nullptr;
       if(mesh!=nullptr) {
-        auto pos = mesh->randCoord(randf(),pose);
-        pos -= emitter.pos;
-        p.pos = emitter.direction[0]*pos.x +
-                emitter.direction[1]*pos.y +
-                emitter.direction[2]*pos.z;
+        auto mp = mesh->randCoord(randf(),pose);
+        mp -= emitter.pos;
+        pos = emitter.direction[0]*mp.x +
+              emitter.direction[1]*mp.y +
+              emitter.direction[2]*mp.z;
         }
       break;
       }
@@ -251,21 +281,21 @@ void PfxBucket::init(PfxBucket::Block& block, ImplEmitter& emitter, size_t parti
   if(decl.shpType!=ParticleFx::EmitterType::Point &&
      decl.shpType!=ParticleFx::EmitterType::Mesh) {
     Vec3 dim = decl.shpDim*decl.shpScale(block.timeTotal);
-    p.pos.x*=dim.x;
-    p.pos.y*=dim.y;
-    p.pos.z*=dim.z;
+    pos.x*=dim.x;
+    pos.y*=dim.y;
+    pos.z*=dim.z;
     }
 
   switch(decl.shpFOR) {
     case ParticleFx::Frame::Object:
     case ParticleFx::Frame::Node: {
-      p.pos += emitter.direction[0]*decl.shpOffsetVec.x +
-               emitter.direction[1]*decl.shpOffsetVec.y +
-               emitter.direction[2]*decl.shpOffsetVec.z;
+      pos += emitter.direction[0]*decl.shpOffsetVec.x +
+             emitter.direction[1]*decl.shpOffsetVec.y +
+             emitter.direction[2]*decl.shpOffsetVec.z;
       break;
       }
     case ParticleFx::Frame::World: {
-      p.pos += decl.shpOffsetVec;
+      pos += decl.shpOffsetVec;
       break;
       }
     }
@@ -278,7 +308,7 @@ void PfxBucket::init(PfxBucket::Block& block, ImplEmitter& emitter, size_t parti
       float dx    = sn * std::cos(theta);
       float dz    = sn * std::sin(theta);
 
-      p.dir       = Vec3(dx,dy,dz);
+      dir         = Vec3(dx,dy,dz);
       break;
       }
     case ParticleFx::Dir::Dir: {
@@ -301,13 +331,13 @@ void PfxBucket::init(PfxBucket::Block& block, ImplEmitter& emitter, size_t parti
       switch(decl.dirFOR) {
         case ParticleFx::Frame::Object:
         case ParticleFx::Frame::Node: {
-          p.dir = emitter.direction[0]*dx +
-                  emitter.direction[1]*dy +
-                  emitter.direction[2]*dz;
+          dir = emitter.direction[0]*dx +
+                emitter.direction[1]*dy +
+                emitter.direction[2]*dz;
           break;
           }
         case ParticleFx::Frame::World: {
-          p.dir = Vec3(dx,dy,dz);
+          dir = Vec3(dx,dy,dz);
           break;
           }
         }
@@ -332,81 +362,104 @@ void PfxBucket::init(PfxBucket::Block& block, ImplEmitter& emitter, size_t parti
           break;
           }
         }
-      p.dir += targetPos - (emitter.pos+p.pos);
+      dir += targetPos - (emitter.pos+pos);
       break;
     }
 
   if(!decl.useEmittersFOR)
-    p.pos += emitter.pos;
+    pos += emitter.pos;
 
-  auto l = p.dir.length();
+  auto l = dir.length();
   if(l!=0.f) {
     float velocity = randf(decl.velAvg,decl.velVar);
-    p.dir = p.dir*velocity/l;
+    dir = dir*velocity/l;
+    }
+
+  particles.life   [particle] = life;
+  particles.maxLife[particle] = life;
+  particles.set(particle,pos,dir);
+  if(trlCapacity>0) {
+    particles.trlHead[particle] = 0;
+    particles.trlSize[particle] = 0;
     }
   }
 
 void PfxBucket::finalize(size_t particle) {
-  particles[particle] = {};
-  pfxCpu   [particle] = {};
+  particles.life[particle] = 0;
+  particles.set(particle,Vec3(),Vec3());
+  if(trlCapacity>0)
+    particles.trlSize[particle] = 0;
+  pfxCpu[particle] = {};
   }
 
-void PfxBucket::tick(Block& sys, ImplEmitter& emitter, size_t particle, uint64_t dt) {
-  ParState& ps = particles[particle+sys.offset];
-  if(ps.life==0)
-    return;
-
-  if(ps.life<=dt){
-    ps.life = 0;
-    sys.count--;
-    finalize(particle+sys.offset);
-    return;
+void PfxBucket::tick(Block& sys, ImplEmitter& emitter, uint64_t dt) {
+  uint16_t* life = particles.life.data() + sys.offset;
+  for(size_t i=0; i<blockSize; ++i) {
+    if(life[i]==0)
+      continue;
+    if(life[i]<=dt) {
+      sys.count--;
+      finalize(i+sys.offset);
+      continue;
+      }
+    life[i] = uint16_t(life[i]-dt);
     }
 
-  const float dtF = float(dt);
+  float* pos[3] = {};
+  float* dir[3] = {};
+  for(int c=0; c<3; ++c) {
+    pos[c] = particles.pos[c].data() + sys.offset;
+    dir[c] = particles.dir[c].data() + sys.offset;
+    }
+  Pfx::integrate(life,pos,dir,blockSize,float(dt),decl.flyGravity);
 
-  // eval particle
-  ps.life  = uint16_t(ps.life-dt);
-  ps.pos  += ps.dir*dtF;
-  ps.dir  += decl.flyGravity*dtF;
+  if(maxTrlTime!=0) {
+    for(size_t i=0; i<blockSize; ++i)
+      if(life[i]!=0)
+        tickTrail(i+sys.offset,emitter);
+    }
+  }
 
-  if(maxTrlTime!=0)
-    tickTrail(ps,emitter,dt);
+PfxBucket::Trail& PfxBucket::trail(size_t particle, size_t i) {
+  // capacity is power of two
+  const size_t at = (particles.trlHead[particle]+i)&(trlCapacity-1);
+  return particles.trail[particle*trlCapacity + at];
   }
 
-void PfxBucket::tickTrail(ParState& ps, ImplEmitter& emitter, uint64_t dt) {
-  for(auto& i:ps.trail)
-    i.time+=dt;
+void PfxBucket::tickTrail(size_t particle, ImplEmitter& emitter) {
+  auto& head = particles.trlHead[particle];
+  auto& size = particles.trlSize[particle];
 
   Trail tx;
+  tx.born = trlTime;
   if(decl.useEmittersFOR)
-    tx.pos = ps.pos + emitter.pos; else
-    tx.pos = ps.pos;
-
-  if(ps.trail.size()==0) {
-    ps.trail.push_back(tx);
-    }
-  else if(ps.trail.back().pos!=tx.pos) {
-    bool extrude = false;
-    if(false && ps.trail.size()>1) {
-      auto u = tx.pos              - ps.trail[ps.trail.size()-2].pos;
-      auto v = ps.trail.back().pos - ps.trail[ps.trail.size()-2].pos;
-      if(std::abs(Vec3::dotProduct(u,v)-u.length()*v.length()) < 0.001f)
-        extrude = true;
+    tx.pos = particles.position(particle) + emitter.pos; else
+    tx.pos = particles.position(particle);
+
+  if(size==0) {
+    trail(particle,size) = tx;
+    size++;
+    }
+  else if(trail(particle,size-1).pos!=tx.pos) {
+    if(size>1 && trlTime-trail(particle,size-2).born<trlStep) {
+      // too close to previous point: move the head
+      trail(particle,size-1) = tx;
+      } else {
+      if(size==trlCapacity) {
+        head = uint16_t((head+1)&(trlCapacity-1));
+        size--;
+        }
+      trail(particle,size) = tx;
+      size++;
       }
-    if(extrude)
-      ps.trail.back() = tx; else
-      ps.trail.push_back(tx);
     }
   else {
-    ps.trail.back().time = 0;
+    trail(particle,size-1).born = trlTime;
     }
 
-  for(size_t rm=0; rm<=ps.trail.size(); ++rm) {
-    if(rm==ps.trail.size() || ps.trail[rm].time<maxTrlTime) {
-      ps.trail.erase(ps.trail.begin(),ps.trail.begin()+int(rm));
-      break;
-      }
+  while(size>0 && trlTime-trail(particle,0).born>=maxTrlTime) {
+    head = uint16_t((head+1)&(trlCapacity-1));
+    size--;
     }
   }
 
@@ -420,6 +473,7 @@ void PfxBucket::tick(uint64_t dt, const Vec3& viewPos) {
 
 void PfxBucket::implTickCommon(uint64_t dt, const Vec3& viewPos) {
   bool doShrink = false;
+  trlTime += dt;
   for(auto& emitter:impl) {
     if(emitter.st==S_Free)
       continue;
@@ -427,13 +481,8 @@ void PfxBucket::implTickCommon(uint64_t dt, const Vec3& viewPos) {
     const auto dp     = emitter.pos-viewPos;
     const bool nearby = (dp.quadLength()<PfxObjects::viewRage*PfxObjects::viewRage);
 
-    if(emitter.next==nullptr && decl.ppsCreateEm!=nullptr && emitter.waitforNext<dt && emitter.st==S_Active) {
-      emitter.next.reset(new PfxEmitter(parent,decl.ppsCreateEm));
-      auto& e = *emitter.next;
-      e.setPosition(emitter.pos.x,emitter.pos.y,emitter.pos.z);
-      e.setActive(true);
-      e.setLooped(emitter.isLoop);
-      }
+    if(emitter.next==nullptr && decl.ppsCreateEm!=nullptr && emitter.waitforNext<dt && emitter.st==S_Active)
+      pendingNext.push_back(size_t(&emitter-impl.data()));
 
     if(emitter.waitforNext>=dt)
       emitter.waitforNext-=dt;
@@ -441,8 +490,7 @@ void PfxBucket::implTickCommon(uint64_t dt, const Vec3& viewPos) {
     if(emitter.block!=size_t(-1)) {
       auto& p = getBlock(emitter);
       if(p.count>0) {
-        for(size_t i=0;i<blockSize;++i)
-          tick(p,emitter,i,dt);
+        tick(p,emitter,dt);
         if(p.count==0 && (emitter.st==S_Fade || !nearby)) {
           // free mem
           freeBlock(emitter.block);
@@ -470,6 +518,20 @@ void PfxBucket::implTickCommon(uint64_t dt, const Vec3& viewPos) {
     shrink();
   }
 
+void PfxBucket::tickNext() {
+  for(auto id:pendingNext) {
+    auto& emitter = impl[id];
+    if(emitter.next!=nullptr || emitter.st!=S_Active)
+      continue;
+    emitter.next.reset(new PfxEmitter(parent,decl.ppsCreateEm));
+    auto& e = *emitter.next;
+    e.setPosition(emitter.pos.x,emitter.pos.y,emitter.pos.z);
+    e.setActive(true);
+    e.setLooped(emitter.isLoop);
+    }
+  pendingNext.clear();
+  }
+
 void PfxBucket::implTickDecals(uint64_t, const Vec3&) {
   for(auto& emitter:impl) {
     if(emitter.st==S_Free)
@@ -482,7 +544,7 @@ void PfxBucket::implTickDecals(uint64_t, const Vec3&) {
       } else
     if(emitter.st==S_Fade) {
       for(size_t i=0; i<blockSize; ++i)
-        particles[p.offset+i].life = 0;
+        particles.life[p.offset+i] = 0;
       p.count = 0;
       freeBlock(emitter.block);
       emitter.st = S_Free;
@@ -494,12 +556,12 @@ void PfxBucket::tickEmit(Block& p, ImplEmitter& emitter, uint64_t emited) {
   size_t lastI = 0;
   for(size_t id=1; emited>0; ++id) {
     const size_t i  = id%blockSize;
-    ParState&    ps = particles[i+p.offset];
-    if(ps.life==0) { // free slot
+    const auto&  life = particles.life[i+p.offset];
+    if(life==0) { // free slot
       --emited;
       lastI = i;
       init(p,emitter,i+p.offset);
-      if(ps.life==0)
+      if(life==0)
         continue;
       p.count++;
       } else {
@@ -542,28 +604,30 @@ void PfxBucket::preFrameUpdate(uint8_t fId) {
 void PfxBucket::buildSsbo() {
   buildSsboTrails();
 
-  auto  colorS          = decl.visTexColorStart;
-  auto  colorE          = decl.visTexColorEnd;
-  auto  visSizeStart    = decl.visSizeStart;
-  auto  visSizeEndScale = decl.visSizeEndScale;
-  auto  visAlphaStart   = decl.visAlphaStart;
-  auto  visAlphaEnd     = decl.visAlphaEnd;
-  auto  visAlphaFunc    = decl.visMaterial.alpha;
+  const auto  colorS          = decl.visTexColorStart;
+  const auto  colorE          = decl.visTexColorEnd;
+  const auto  visSizeStart    = decl.visSizeStart;
+  const auto  visSizeEndScale = decl.visSizeEndScale;
+  const auto  visAlphaStart   = decl.visAlphaStart;
+  const auto  visAlphaEnd     = decl.visAlphaEnd;
+  const bool  additive        = (decl.visMaterial.alpha==Material::AlphaFunc::AdditiveLight);
 
   for(auto& p:block) {
     if(p.count==0)
       continue;
 
-    for(size_t pId=0; pId<blockSize; ++pId) {
-      ParState& ps = particles[pId+p.offset];
-      auto&     px = pfxCpu   [pId+p.offset];
+    const uint16_t* life    = particles.life   .data() + p.offset;
+    const uint16_t* maxLife = particles.maxLife.data() + p.offset;
+    PfxState*       px      = pfxCpu           .data() + p.offset;
+    const Vec3      offset  = decl.useEmittersFOR ? p.pos : Vec3();
 
-      if(ps.life==0) {
-        px.size = Vec3();
+    for(size_t i=0; i<blockSize; ++i) {
+      if(life[i]==0) {
+        px[i].size = Vec3();
         continue;
         }
 
-      const float a     = ps.lifeTime();
+      const float a     = 1.f - float(life[i])/float(maxLife[i]);
       const Vec3  cl    = colorS*(1.f-a)        + colorE*a;
       const float clA   = visAlphaStart*(1.f-a) + visAlphaEnd*a;
 
@@ -579,7 +643,7 @@ void PfxBucket::buildSsbo() {
         uint8_t a=255;
         } color;
 
-      if(visAlphaFunc==Material::AlphaFunc::AdditiveLight) {
+      if(additive) {
         color.r = uint8_t(cl.x*clA);
         color.g = uint8_t(cl.y*clA);
         color.b = uint8_t(cl.z*clA);
@@ -590,9 +654,13 @@ void PfxBucket::buildSsbo() {
         color.b = uint8_t(cl.z);
         color.a = uint8_t(clA*255);
         }
-      uint32_t colorU32;
-      std::memcpy(&colorU32,&color,4);
-      buildBilboard(px,p,ps, colorU32, szX,szY,szZ);
+
+      auto& v = px[i];
+      v.pos   = particles.position(p.offset+i) + offset;
+      v.size  = Vec3(szX,szY,szZ);
+      std::memcpy(&v.color,&color,4);
+      v.bits0 = visBits;
+      v.dir   = particles.direction(p.offset+i);
       }
     }
   }
@@ -603,42 +671,28 @@ void PfxBucket::buildSsboTrails() {
 
   trlCpu.reserve(trlCpu.size());
   trlCpu.clear();
+  if(trlCapacity==0)
+    return;
 
-  for(auto& p:particles) {
-    if(p.life==0)
+  for(size_t i=0; i<particles.size(); ++i) {
+    if(particles.life[i]==0)
       continue;
-    if(p.trail.size()<2)
+    const size_t size = particles.trlSize[i];
+    if(size<2)
       continue;
 
-    float maxT = float(std::min(maxTrlTime,p.trail[0].time));
-    for(size_t r=1; r<p.trail.size(); ++r) {
+    float maxT = float(std::min(maxTrlTime,trlTime-trail(i,0).born));
+    for(size_t r=1; r<size; ++r) {
       PfxState st;
-      buildTrailSegment(st,p.trail[r-1],p.trail[r],maxT);
+      buildTrailSegment(st,trail(i,r-1),trail(i,r),maxT);
       trlCpu.push_back(st);
       }
     }
   }
 
-void PfxBucket::buildBilboard(PfxState& v, const Block& p, const ParState& ps, const uint32_t color,
-                              float szX, float szY, float szZ) {
-  if(decl.useEmittersFOR)
-    v.pos = ps.pos + p.pos; else
-    v.pos = ps.pos;
-
-  v.size  = Vec3(szX,szY,szZ);
-  v.color = color;
-  v.bits0 = 0;
-  v.bits0 |= uint32_t(decl.visZBias ? 1 : 0);
-  v.bits0 |= uint32_t(decl.visTexIsQuadPoly ? 1 : 0) << 1;
-  v.bits0 |= uint32_t(decl.visYawAlign ? 1 : 0) << 2;
-  v.bits0 |= uint32_t(0) << 3; // TODO: trails
-  v.bits0 |= uint32_t(decl.visOrientation) << 4;
-  v.dir   = ps.dir;
-  }
-
 void PfxBucket::buildTrailSegment(PfxState& v, const Trail& a, const Trail& b, float maxT) {
-  float    tA  = 1.f - float(a.time)/maxT;
-  float    tB  = 1.f - float(b.time)/maxT;
+  float    tA  = 1.f - float(trlTime-a.born)/maxT;
+  float    tB  = 1.f - float(trlTime-b.born)/maxT;
 
   uint32_t clA = mkTrailColor(tA);
   uint32_t clB = mkTrailColor(tB);
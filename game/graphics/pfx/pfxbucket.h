@@ -1,6 +1,8 @@
 #pragma once
 
 #include <Tempest/VertexBuffer>
+#include <mutex>
+#include <random>
 #include <vector>
 
 #include "graphics/pfx/pfxobjects.h"
@@ -60,8 +62,15 @@ class PfxBucket {
     void                        freeEmitter(size_t& id);
 
     ImplEmitter&                get(size_t id) { return impl[id]; }
+    // tick and buildSsbo touch only this bucket, so different buckets can run in parallel; caller holds sync
     void                        tick(uint64_t dt, const Tempest::Vec3& viewPos);
     void                        buildSsbo();
+    // creates ppsCreateEm emitters, requested by last tick; serial, as it allocates in other buckets.
+    // Child emitter is ticked first time on next frame, so it starts one frame later, than on a serial tick
+    void                        tickNext();
+
+    // guards emitters and particles of this bucket; order: parent.sync, then sync
+    std::recursive_mutex        sync;
 
   private:
     struct Block final {
@@ -76,16 +85,24 @@ class PfxBucket {
 
     struct Trail final {
       Tempest::Vec3 pos;
-      uint64_t      time = 0;
+      uint64_t      born = 0; // trlTime, when point was added
       };
 
-    struct ParState final {
-      uint16_t      life=0, maxLife=1;
-      Tempest::Vec3 pos, dir;
+    // structure of arrays, indexed by [block.offset + i]
+    struct Particles final {
+      std::vector<uint16_t> life, maxLife;
+      std::vector<float>    pos[3], dir[3]; // x, y, z
+
+      // trails: ring of trlCapacity points per particle, oldest point at trlHead
+      std::vector<uint16_t> trlHead, trlSize;
+      std::vector<Trail>    trail;
 
-      std::vector<Trail> trail;
+      size_t        size() const { return life.size(); }
+      void          resize(size_t sz, size_t trlCapacity);
 
-      float         lifeTime() const;
+      Tempest::Vec3 position (size_t i) const { return Tempest::Vec3(pos[0][i],pos[1][i],pos[2][i]); }
+      Tempest::Vec3 direction(size_t i) const { return Tempest::Vec3(dir[0][i],dir[1][i],dir[2][i]); }
+      void          set(size_t i, const Tempest::Vec3& p, const Tempest::Vec3& d);
       };
 
     void                        tickEmit(Block& p, ImplEmitter& emitter, uint64_t emited);
@@ -94,27 +111,28 @@ class PfxBucket {
     size_t                      allocBlock();
     void                        freeBlock(size_t& s);
 
-    static float                randf();
-    static float                randf(float base, float var);
+    float                       randf();
+    float                       randf(float base, float var);
 
     Block&                      getBlock(ImplEmitter& emitter);
     Block&                      getBlock(PfxEmitter&  emitter);
 
     void                        init     (Block& block, ImplEmitter& emitter, size_t particle);
     void                        finalize (size_t particle);
-    void                        tick     (Block& sys, ImplEmitter& emitter, size_t particle, uint64_t dt);
-    void                        tickTrail(ParState& ps, ImplEmitter& emitter, uint64_t dt);
+    void                        tick     (Block& sys, ImplEmitter& emitter, uint64_t dt);
+    void                        tickTrail(size_t particle, ImplEmitter& emitter);
+    Trail&                      trail    (size_t particle, size_t i);
 
     void                        implTickCommon(uint64_t dt, const Tempest::Vec3& viewPos);
     void                        implTickDecals(uint64_t dt, const Tempest::Vec3& viewPos);
 
     void                        buildSsboTrails();
-    void                        buildBilboard(PfxState& v, const Block& p, const ParState& ps, const uint32_t color,
-                                              float szX, float szY, float szZ);
     void                        buildTrailSegment(PfxState& v, const Trail& a, const Trail& b, float maxT);
     uint32_t                    mkTrailColor(float clA) const;
 
     VisualObjects&              visual;
+    // own engine: buckets are ticked concurrently, and particles must not depend on which thread ticks them
+    std::mt19937                rndEngine;
 
     ObjectsBucket::Item         item;
     Tempest::StorageBuffer      pfxGpu[Resources::MaxFramesInFlight];
@@ -124,16 +142,19 @@ class PfxBucket {
     Tempest::StorageBuffer      trlGpu[Resources::MaxFramesInFlight];
     std::vector<PfxState>       trlCpu;
 
-    uint64_t                    maxTrlTime = 0;
-    size_t                      blockSize = 0;
+    uint64_t                    maxTrlTime  = 0;
+    uint64_t                    trlTime     = 0;
+    uint64_t                    trlStep     = 0;
+    size_t                      trlCapacity = 0;
+    size_t                      blockSize   = 0;
+    uint32_t                    visBits     = 0;
 
-    std::vector<ParState>       particles;
+    Particles                   particles;
     std::vector<ImplEmitter>    impl;
+    std::vector<size_t>         pendingNext;
     std::vector<Block>          block;
     bool                        forceUpdate[Resources::MaxFramesInFlight] = {};
 
-    static std::mt19937         rndEngine;
-
     friend class PfxEmitter;
   };
 
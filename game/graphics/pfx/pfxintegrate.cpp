@@ -0,0 +1,58 @@
+#include "pfxintegrate.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#define PFX_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PFX_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace Tempest;
+
+void Pfx::integrate(const uint16_t* life, float* pos[3], float* dir[3], size_t n, float dt, const Vec3& gravity) {
+  const float g[3] = {gravity.x*dt, gravity.y*dt, gravity.z*dt};
+  size_t i = 0;
+#if defined(PFX_SSE2)
+  const __m128  vdt  = _mm_set1_ps(dt);
+  const __m128  vg[] = {_mm_set1_ps(g[0]), _mm_set1_ps(g[1]), _mm_set1_ps(g[2])};
+  const __m128i zero = _mm_setzero_si128();
+  for(; i+4<=n; i+=4) {
+    __m128i l    = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(life+i));
+    l            = _mm_unpacklo_epi16(l,zero);
+    __m128  dead = _mm_castsi128_ps(_mm_cmpeq_epi32(l,zero));
+    __m128  mdt  = _mm_andnot_ps(dead,vdt);
+    for(int c=0; c<3; ++c) {
+      __m128 p = _mm_loadu_ps(pos[c]+i);
+      __m128 d = _mm_loadu_ps(dir[c]+i);
+      p = _mm_add_ps(p,_mm_mul_ps(d,mdt));
+      d = _mm_add_ps(d,_mm_andnot_ps(dead,vg[c]));
+      _mm_storeu_ps(pos[c]+i,p);
+      _mm_storeu_ps(dir[c]+i,d);
+      }
+    }
+#elif defined(PFX_NEON)
+  const float32x4_t vdt = vdupq_n_f32(dt);
+  for(; i+4<=n; i+=4) {
+    const uint32x4_t  alive = vmvnq_u32(vceqq_u32(vmovl_u16(vld1_u16(life+i)),vdupq_n_u32(0)));
+    const float32x4_t mdt   = vreinterpretq_f32_u32(vandq_u32(alive,vreinterpretq_u32_f32(vdt)));
+    for(int c=0; c<3; ++c) {
+      const float32x4_t mg = vreinterpretq_f32_u32(vandq_u32(alive,vreinterpretq_u32_f32(vdupq_n_f32(g[c]))));
+      float32x4_t p = vld1q_f32(pos[c]+i);
+      float32x4_t d = vld1q_f32(dir[c]+i);
+      p = vmlaq_f32(p,d,mdt);
+      d = vaddq_f32(d,mg);
+      vst1q_f32(pos[c]+i,p);
+      vst1q_f32(dir[c]+i,d);
+      }
+    }
+#endif
+  for(; i<n; ++i) {
+    if(life[i]==0)
+      continue;
+    for(int c=0; c<3; ++c) {
+      pos[c][i] += dir[c][i]*dt;
+      dir[c][i] += g[c];
+      }
+    }
+  }
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <Tempest/Vec>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Pfx {
+
+// pos += dir*dt; dir += gravity*dt; for alive (life!=0) particles only.
+// Structure of arrays: pos[c], dir[c] - x, y, z planes of n particles
+void integrate(const uint16_t* life, float* pos[3], float* dir[3], size_t n, float dt, const Tempest::Vec3& gravity);
+
+}
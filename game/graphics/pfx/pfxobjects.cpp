@@ -1,10 +1,12 @@
 #include "pfxobjects.h"
 
 #include <Tempest/Log>
+#include <chrono>
 #include <cstring>
 #include <cassert>
 
 #include "graphics/sceneglobals.h"
+#include "utils/workers.h"
 
 #include "pfxbucket.h"
 #include "particlefx.h"
@@ -40,11 +42,34 @@ void PfxObjects::tick(uint64_t ticks) {
   if(dt==0)
     return;
 
-  for(auto& i:bucket)
-    i.tick(dt,viewerPos);
+  const auto time0 = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::recursive_mutex> guard(sync);
+    tickList.clear();
+    for(auto& i:bucket)
+      tickList.push_back(&i);
+  }
 
-  for(auto& i:bucket)
-    i.buildSsbo();
+  // one task per bucket: costs differ a lot between effects.
+  // Buckets are removed only in preFrameUpdate, on this thread; emitters of other threads wait for PfxBucket::sync
+  Workers::parallelTasks(tickList.size(),[this,dt](uintptr_t id) {
+    auto& b = *tickList[id];
+    std::lock_guard<std::recursive_mutex> guard(b.sync);
+    b.tick(dt,viewerPos);
+    b.buildSsbo();
+    });
+
+  {
+    std::lock_guard<std::recursive_mutex> guard(sync);
+    for(auto i:tickList)
+      i->tickNext();
+  }
+  // tick is well below a millisecond: measure in microseconds, average over several frames
+  tickSum += std::chrono::duration<float,std::micro>(std::chrono::steady_clock::now()-time0).count();
+  if(++tickFrame%tickFrames==0) {
+    tickAvg = tickSum/float(tickFrames*1000);
+    tickSum = 0;
+    }
 
   lastUpdate = ticks;
   }
@@ -55,6 +80,7 @@ bool PfxObjects::isInPfxRange(const Vec3& pos) const {
   }
 
 void PfxObjects::preFrameUpdate(uint8_t fId) {
+  std::lock_guard<std::recursive_mutex> guard(sync);
   for(auto i=bucket.begin(), end = bucket.end(); i!=end; ) {
     if(i->isEmpty()) {
       i = bucket.erase(i);
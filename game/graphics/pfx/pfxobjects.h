@@ -29,6 +29,8 @@ class PfxObjects final {
     bool       isInPfxRange(const Tempest::Vec3& pos) const;
 
     void       preFrameUpdate(uint8_t fId);
+    // wall time of tick, milliseconds per frame
+    float      tickTime() const { return tickAvg; }
 
   private:
     struct SpriteEmitter {
@@ -47,11 +49,17 @@ class PfxObjects final {
     std::recursive_mutex          sync;
 
     std::list<PfxBucket>          bucket;
+    std::vector<PfxBucket*>       tickList;
     std::vector<SpriteEmitter>    spriteEmit;
 
     Tempest::Vec3                 viewerPos={};
     uint64_t                      lastUpdate=0;
 
+    static constexpr uint64_t     tickFrames=64;
+    uint64_t                      tickFrame=0;
+    float                         tickSum=0;
+    float                         tickAvg=0;
+
   friend class PfxEmitter;
   friend class TrlObjects;
   };
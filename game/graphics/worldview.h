@@ -72,6 +72,7 @@ class WorldView {
     const Tempest::AccelerationStructure& landscapeTlas();
     const SceneGlobals&  sceneGlobals() const { return sGlobal; }
     const Sky&           sky() const { return gSky; }
+    float                pfxTickTime() const { return pfxGroup.tickTime(); }
 
   private:
     const World&  owner;
@@ -237,8 +237,11 @@ void MainWindow::paintEvent(PaintEvent& event) {
   renderer.dbgDraw(p);
 
   if(Gothic::inst().doFrate() && !Gothic::inst().isDesktop()) {
-    char fpsT[64]={};
-    std::snprintf(fpsT,sizeof(fpsT),"fps = %.2f",fps.get());
+    char fpsT[96]={};
+    if(world!=nullptr && world->view()!=nullptr)
+      std::snprintf(fpsT,sizeof(fpsT),"fps = %.2f pfx = %.2fms ai = %.2fms%s",fps.get(),double(world->view()->pfxTickTime()),
+                    double(world->npcTickTime()),world->isAiLod() ? " (lod)" : ""); else
+      std::snprintf(fpsT,sizeof(fpsT),"fps = %.2f",fps.get());
     //string_frm fpsT("fps = ", fps.get(), " ", info);
 
     auto& fnt = Resources::font();
@@ -785,6 +788,9 @@ uint64_t MainWindow::tick() {
     return 0;
   lastTick  = time;
 
+  if(Gothic::inst().checkSaveFailed())
+    Gothic::inst().onPrint("unable to write savegame file");
+
   auto st = Gothic::inst().checkLoading();
   if(st==Gothic::LoadState::Finalize || st==Gothic::LoadState::FailedLoad || st==Gothic::LoadState::FailedSave) {
     Gothic::inst().finishLoading();
@@ -959,20 +965,26 @@ void MainWindow::loadGame(std::string_view slot) {
   update();
   }
 
-void MainWindow::saveGame(std::string_view slot, std::string_view name) {
+void MainWindow::saveGame(std::string_view slot, std::string_view name, bool quick) {
   auto tex = renderer.screenshoot(cmdId);
   auto pm  = device.readPixels(textureCast(tex));
 
   if(dialogs.isActive())
     return;
 
-  Gothic::inst().startSave(std::move(textureCast(tex)),[slot=std::string(slot),name=std::string(name),pm](std::unique_ptr<GameSession>&& game){
+  const int  level = Gothic::settingsGetI("GAME", quick ? "quickSaveCompression" : "saveCompression");
+
+  Gothic::inst().startSave(std::move(textureCast(tex)),[slot=std::string(slot),name=std::string(name),pm,level](std::unique_ptr<GameSession>&& game){
     if(!game)
       return std::move(game);
 
-    Tempest::WFile f(slot);
-    Serialize      s(f);
-    game->save(s,name,pm);
+    // snapshot world into memory; compression and disk io are done in background
+    const uint64_t time0 = Application::tickCount();
+    auto           s     = std::make_unique<Serialize>();
+    s->setCompression(level);
+    game->save(*s,name,pm);
+    Log::i("savegame snapshot: ",Application::tickCount()-time0,"ms");
+    Gothic::inst().startSaveWrite(slot,std::move(s));
 
     // no print yet, because threading
     // gothic.print("Game saved");
@@ -73,7 +73,7 @@ class MainWindow : public Tempest::Window {
 
     void startGame(std::string_view slot);
     void loadGame (std::string_view slot);
-    void saveGame (std::string_view slot, std::string_view name);
+    void saveGame (std::string_view slot, std::string_view name, bool quick);
 
     void onVideo(std::string_view fname);
     void onStartLoading();
@@ -95,6 +95,7 @@ Marvin::Marvin() {
     {"set time %d %d",             C_SetTime},
     {"spawnmass %d",               C_Invalid},
     {"spawnmass giga %d",          C_Invalid},
+    {"toggle ailod",               C_ToggleAiLod},
     {"toggle desktop",             C_ToggleDesktop},
     {"toggle freepoints",          C_Invalid},
     {"toggle screen",              C_Invalid},
@@ -332,6 +333,13 @@ bool Marvin::exec(std::string_view v) {
       Gothic::inst().toggleDesktop();
       return true;
       }
+    case C_ToggleAiLod: {
+      World* world = Gothic::inst().world();
+      if(world==nullptr)
+        return false;
+      world->setAiLod(!world->isAiLod());
+      return true;
+      }
     case C_Insert: {
       World* world  = Gothic::inst().world();
       Npc*   player = Gothic::inst().player();
@@ -28,6 +28,7 @@ class Marvin {
       C_ToggleTime,
       // game
       C_ToggleDesktop,
+      C_ToggleAiLod,
       // npc
       C_CheatFull,
       C_CheatGod,
@@ -3,12 +3,14 @@
 #include "collisionworld.h"
 #include "physicmeshshape.h"
 #include "physicvbo.h"
+#include "raybatch.h"
 #include "graphics/mesh/skeleton.h"
 
 #include <algorithm>
 #include <cmath>
 
 #include "graphics/mesh/submesh/packedmesh.h"
+#include "utils/cachefile.h"
 #include "world/objects/item.h"
 #include "world/bullet.h"
 #include "world/world.h"
@@ -17,6 +19,16 @@ const float DynamicWorld::ghostPadding=50-22.5f;
 const float DynamicWorld::ghostHeight =140;
 const float DynamicWorld::worldHeight =20000;
 
+// in-place bvh image depends on build of bullet
+struct LandCacheAbi final {
+  uint32_t version = 1;
+  uint32_t scalar  = sizeof(btScalar);
+  uint32_t pointer = sizeof(void*);
+  uint32_t bvh     = sizeof(btOptimizedBvh);
+  uint32_t bvhNode = sizeof(btQuantizedBvhNode);
+  bool operator == (const LandCacheAbi& other) const = default;
+  };
+
 struct DynamicWorld::HumShape:btCapsuleShape {
   HumShape(btScalar radius, btScalar height):btCapsuleShape((height<=0.f ? 0.f : radius)*0.01f,height*0.01f) {}
 
@@ -404,41 +416,80 @@ struct DynamicWorld::BBoxList final {
   DynamicWorld&          wrld;
   };
 
-DynamicWorld::DynamicWorld(World& owner,const phoenix::mesh& worldMesh) {
-  world.reset(new CollisionWorld());
+struct DynamicWorld::LandRayCallback : btCollisionWorld::ClosestRayResultCallback {
+  phoenix::material_group matId  = phoenix::material_group::undefined;
+  const char*             sector = nullptr;
+  Category                colCat = C_Null;
 
-  {
-  PackedMesh pkg(worldMesh,PackedMesh::PK_Physic);
-  sectors.resize(pkg.subMeshes.size());
-  for(size_t i=0;i<sectors.size();++i)
-    sectors[i] = pkg.subMeshes[i].material.name;
+  LandRayCallback(const Tempest::Vec3& from, const Tempest::Vec3& to)
+    :ClosestRayResultCallback(CollisionWorld::toMeters(from), CollisionWorld::toMeters(to)) {
+    m_flags = btTriangleRaycastCallback::kF_KeepUnflippedNormal | btTriangleRaycastCallback::kF_FilterBackfaces;
+    }
 
-  landVbo.resize(pkg.vertices.size());
-  for(size_t i=0;i<pkg.vertices.size();++i) {
-    auto v = pkg.vertices[i];
-    landVbo[i] = CollisionWorld::toMeters(Tempest::Vec3(v.pos[0],v.pos[1],v.pos[2]));
+  bool needsCollision(btBroadphaseProxy* proxy0) const override {
+    auto obj=reinterpret_cast<btCollisionObject*>(proxy0->m_clientObject);
+    if(obj->getUserIndex()==C_Landscape || obj->getUserIndex()==C_Object)
+      return ClosestRayResultCallback::needsCollision(proxy0);
+    return false;
     }
 
-  landMesh .reset(new PhysicVbo(&landVbo));
-  waterMesh.reset(new PhysicVbo(&landVbo));
+  btScalar addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace) override {
+    auto shape = rayResult.m_collisionObject->getCollisionShape();
+    if(shape!=nullptr) {
+      auto s  = reinterpret_cast<const btMultimaterialTriangleMeshShape*>(shape);
+      auto mt = reinterpret_cast<const PhysicVbo*>(s->getMeshInterface());
 
-  for(size_t i=0;i<pkg.subMeshes.size();++i) {
-    auto& sm = pkg.subMeshes[i];
-    if(!sm.material.disable_collision && sm.iboLength>0) {
-      if(sm.material.group==phoenix::material_group::water) {
-        waterMesh->addIndex(pkg.indices,sm.iboOffset,sm.iboLength,sm.material.group);
-        } else {
-        landMesh ->addIndex(pkg.indices,sm.iboOffset,sm.iboLength,sm.material.group,sectors[i].c_str());
+      size_t id = size_t(rayResult.m_localShapeInfo->m_shapePart);
+      matId  = mt->materialId(id);
+      sector = mt->sectorName(id);
+      }
+    colCat = Category(rayResult.m_collisionObject->getUserIndex());
+    return ClosestRayResultCallback::addSingleResult(rayResult,normalInWorldSpace);
+    }
+
+  RayLandResult result(const Tempest::Vec3& to) const {
+    Tempest::Vec3 hitPos = to, hitNorm;
+    if(hasHit()){
+      hitPos = CollisionWorld::toCentimeters(m_hitPointWorld);
+      if(colCat==DynamicWorld::C_Landscape) {
+        hitNorm.x = m_hitNormalWorld.x();
+        hitNorm.y = m_hitNormalWorld.y();
+        hitNorm.z = m_hitNormalWorld.z();
         }
       }
+    RayLandResult ret;
+    ret.v           = hitPos;
+    ret.n           = hitNorm;
+    ret.mat         = matId;
+    ret.hasCol      = hasHit();
+    ret.hitFraction = m_closestHitFraction;
+    ret.sector      = sector;
+    return ret;
     }
-  }
+  };
+
+DynamicWorld::DynamicWorld(World& owner,const phoenix::mesh& worldMesh, uint64_t cacheKey) {
+  world.reset(new CollisionWorld());
+
+  // packed collision mesh and landscape bvh are cached on disk
+  const auto name   = std::string(owner.name())+".phys";
+  auto       cache  = CacheFile::read(name,cacheKey);
+  const bool cached = !cache.empty() && loadLandscape(cache);
+  cache = std::vector<uint8_t>();
+  if(!cached)
+    packLandscape(worldMesh);
 
   btVector3 bbox[2] = {btVector3(0,0,0), btVector3(0,0,0)};
   if(!landMesh->isEmpty()) {
     Tempest::Matrix4x4 mt;
     mt.identity();
-    landShape.reset(new btMultimaterialTriangleMeshShape(landMesh.get(),landMesh->useQuantization(),true));
+    if(landBvh!=nullptr) {
+      auto shape = new btMultimaterialTriangleMeshShape(landMesh.get(),landMesh->useQuantization(),false);
+      shape->setOptimizedBvh(landBvh);
+      landShape.reset(shape);
+      } else {
+      landShape.reset(new btMultimaterialTriangleMeshShape(landMesh.get(),landMesh->useQuantization(),true));
+      }
     landBody = world->addCollisionBody(*landShape,mt,DynamicWorld::materialFriction(phoenix::material_group::none));
     landBody->setUserIndex(C_Landscape);
 
@@ -464,6 +515,9 @@ DynamicWorld::DynamicWorld(World& owner,const phoenix::mesh& worldMesh) {
     }
 
   world->setBBox(bbox[0],bbox[1]);
+  if(!cached)
+    saveLandscape(name,cacheKey);
+
   npcList   .reset(new NpcBodyList(*this));
   bulletList.reset(new BulletsList(*this));
   bboxList  .reset(new BBoxList   (*this));
@@ -480,6 +534,105 @@ DynamicWorld::DynamicWorld(World& owner,const phoenix::mesh& worldMesh) {
 DynamicWorld::~DynamicWorld(){
   }
 
+void DynamicWorld::packLandscape(const phoenix::mesh& worldMesh) {
+  PackedMesh pkg(worldMesh,PackedMesh::PK_Physic);
+  sectors.resize(pkg.subMeshes.size());
+  for(size_t i=0;i<sectors.size();++i)
+    sectors[i] = pkg.subMeshes[i].material.name;
+
+  landVbo.resize(pkg.vertices.size());
+  for(size_t i=0;i<pkg.vertices.size();++i) {
+    auto v = pkg.vertices[i];
+    landVbo[i] = CollisionWorld::toMeters(Tempest::Vec3(v.pos[0],v.pos[1],v.pos[2]));
+    }
+
+  landMesh .reset(new PhysicVbo(&landVbo));
+  waterMesh.reset(new PhysicVbo(&landVbo));
+
+  for(size_t i=0;i<pkg.subMeshes.size();++i) {
+    auto& sm = pkg.subMeshes[i];
+    if(!sm.material.disable_collision && sm.iboLength>0) {
+      if(sm.material.group==phoenix::material_group::water) {
+        waterMesh->addIndex(pkg.indices,sm.iboOffset,sm.iboLength,sm.material.group);
+        } else {
+        landMesh ->addIndex(pkg.indices,sm.iboOffset,sm.iboLength,sm.material.group,sectors[i].c_str());
+        }
+      }
+    }
+  }
+
+bool DynamicWorld::loadLandscape(std::vector<uint8_t>& data) {
+  CacheFile::Reader in(data);
+  auto fail = [this]() {
+    sectors.clear();
+    landVbo.clear();
+    landMesh .reset();
+    waterMesh.reset();
+    landBvhImage.clear();
+    landBvh = nullptr;
+    return false;
+    };
+
+  LandCacheAbi abi;
+  uint64_t     count = 0;
+  if(!in.get(abi) || abi!=LandCacheAbi() || !in.get(count) || count>data.size())
+    return fail();
+  sectors.resize(size_t(count));
+  for(auto& i:sectors)
+    in.get(i);
+  if(!in.get(landVbo))
+    return fail();
+
+  landMesh .reset(new PhysicVbo(&landVbo));
+  waterMesh.reset(new PhysicVbo(&landVbo));
+  if(!landMesh->deserialize(in,sectors) || !waterMesh->deserialize(in,sectors))
+    return fail();
+
+  uint64_t bvhSize = 0;
+  if(!in.get(bvhSize))
+    return fail();
+  if(bvhSize>0) {
+    const uint8_t* img = in.block(size_t(bvhSize));
+    if(img==nullptr)
+      return fail();
+    landBvhImage.assign(img,img+size_t(bvhSize));
+    if(reinterpret_cast<uintptr_t>(landBvhImage.data())%CacheFile::Alignment!=0)
+      return fail();
+    // placement-new of bvh object and pointer fixup; nodes stay in landBvhImage
+    landBvh = btOptimizedBvh::deSerializeInPlace(landBvhImage.data(),unsigned(bvhSize),false);
+    if(landBvh==nullptr)
+      return fail();
+    }
+  if(!in.isEnd())
+    return fail();
+  return true;
+  }
+
+void DynamicWorld::saveLandscape(std::string_view name, uint64_t key) const {
+  CacheFile::Writer out;
+  out.put(LandCacheAbi());
+  out.put(uint64_t(sectors.size()));
+  for(auto& i:sectors)
+    out.put(i);
+  out.put(landVbo);
+  landMesh ->serialize(out,sectors);
+  waterMesh->serialize(out,sectors);
+
+  btOptimizedBvh* bvh = nullptr;
+  if(landShape!=nullptr)
+    bvh = static_cast<btBvhTriangleMeshShape*>(landShape.get())->getOptimizedBvh();
+  if(bvh==nullptr) {
+    out.put(uint64_t(0));
+    } else {
+    const unsigned size = bvh->calculateSerializeBufferSize();
+    out.put(uint64_t(size));
+    uint8_t* img = out.block(size);
+    if(reinterpret_cast<uintptr_t>(img)%CacheFile::Alignment!=0 || !bvh->serializeInPlace(img,size,false))
+      return;
+    }
+  CacheFile::write(name,key,out.data().data(),out.data().size());
+  }
+
 DynamicWorld::RayLandResult DynamicWorld::landRay(const Tempest::Vec3& from, float maxDy) const {
   world->updateAabbs();
   if(maxDy==0)
@@ -542,56 +695,9 @@ DynamicWorld::RayWaterResult DynamicWorld::implWaterRay(const Tempest::Vec3& fro
   }
 
 DynamicWorld::RayLandResult DynamicWorld::ray(const Tempest::Vec3& from, const Tempest::Vec3& to) const {
-  struct CallBack:btCollisionWorld::ClosestRayResultCallback {
-    using ClosestRayResultCallback::ClosestRayResultCallback;
-    phoenix::material_group matId  = phoenix::material_group::undefined;
-    const char*             sector = nullptr;
-    Category                colCat = C_Null;
-
-    bool needsCollision(btBroadphaseProxy* proxy0) const override {
-      auto obj=reinterpret_cast<btCollisionObject*>(proxy0->m_clientObject);
-      if(obj->getUserIndex()==C_Landscape || obj->getUserIndex()==C_Object)
-        return ClosestRayResultCallback::needsCollision(proxy0);
-      return false;
-      }
-
-    btScalar addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace) override {
-      auto shape = rayResult.m_collisionObject->getCollisionShape();
-      if(shape!=nullptr) {
-        auto s  = reinterpret_cast<const btMultimaterialTriangleMeshShape*>(shape);
-        auto mt = reinterpret_cast<const PhysicVbo*>(s->getMeshInterface());
-
-        size_t id = size_t(rayResult.m_localShapeInfo->m_shapePart);
-        matId  = mt->materialId(id);
-        sector = mt->sectorName(id);
-        }
-      colCat = Category(rayResult.m_collisionObject->getUserIndex());
-      return ClosestRayResultCallback::addSingleResult(rayResult,normalInWorldSpace);
-      }
-    };
-
-  CallBack callback{CollisionWorld::toMeters(from), CollisionWorld::toMeters(to)};
-  callback.m_flags = btTriangleRaycastCallback::kF_KeepUnflippedNormal | btTriangleRaycastCallback::kF_FilterBackfaces;
-
+  LandRayCallback callback{from,to};
   world->rayCast(from,to,callback);
-
-  Tempest::Vec3 hitPos = to, hitNorm;
-  if(callback.hasHit()){
-    hitPos = CollisionWorld::toCentimeters(callback.m_hitPointWorld);
-    if(callback.colCat==DynamicWorld::C_Landscape) {
-      hitNorm.x = callback.m_hitNormalWorld.x();
-      hitNorm.y = callback.m_hitNormalWorld.y();
-      hitNorm.z = callback.m_hitNormalWorld.z();
-      }
-    }
-  RayLandResult ret;
-  ret.v           = hitPos;
-  ret.n           = hitNorm;
-  ret.mat         = callback.matId;
-  ret.hasCol      = callback.hasHit();
-  ret.hitFraction = callback.m_closestHitFraction;
-  ret.sector = callback.sector;
-  return ret;
+  return callback.result(to);
   }
 
 DynamicWorld::RayQueryResult DynamicWorld::rayNpc(const Tempest::Vec3& from, const Tempest::Vec3& to) const {
@@ -604,6 +710,28 @@ DynamicWorld::RayQueryResult DynamicWorld::rayNpc(const Tempest::Vec3& from, con
   return r;
   }
 
+void DynamicWorld::rayBatch(const RayQuery* rays, RayQueryResult* out, size_t count, uint8_t flags) const {
+  if(count==0)
+    return;
+  // not thread-safe: must happen before workers start
+  world->updateAabbs();
+
+  const bool npc = (flags & RF_Npc);
+  RayBatch::cast(rays,out,count,[this,npc](const RayQuery& r, RayQueryResult& ret) {
+    LandRayCallback cb{r.from,r.to};
+    world->rayCast(r.from,r.to,cb);
+    static_cast<RayLandResult&>(ret) = cb.result(r.to);
+
+    ret.npcHit = nullptr;
+    if(!npc)
+      return;
+    if(auto ptr = npcList->rayTest(r.from,(ret.hasCol ? ret.v : r.to),1)) {
+      ret.npcHit = ptr->toNpc();
+      ret.hasCol = true;
+      }
+    });
+  }
+
 float DynamicWorld::soundOclusion(const Tempest::Vec3& from, const Tempest::Vec3& to) const {
   struct CallBack:btCollisionWorld::AllHitsRayResultCallback {
     using AllHitsRayResultCallback::AllHitsRayResultCallback;
@@ -5,8 +5,11 @@
 #include <Tempest/Matrix4x4>
 #include <memory>
 #include <limits>
+#include <string_view>
+#include <vector>
 
 class btTriangleIndexVertexArray;
+class btOptimizedBvh;
 class btCollisionShape;
 class btCollisionObject;
 class btRigidBody;
@@ -32,6 +35,7 @@ class DynamicWorld final {
     struct NpcBodyList;
     struct BulletsList;
     struct BBoxList;
+    struct LandRayCallback;
 
   public:
     static constexpr float gravityMS   = 9.8f; // meters per second^2
@@ -40,7 +44,7 @@ class DynamicWorld final {
     static constexpr float spellSpeed  = 1; // centimeters per milliseconds
     static const     float ghostPadding;
 
-    DynamicWorld(World &world, const phoenix::mesh& mesh);
+    DynamicWorld(World &world, const phoenix::mesh& mesh, uint64_t cacheKey);
     DynamicWorld(const DynamicWorld&)=delete;
     ~DynamicWorld();
 
@@ -151,6 +155,16 @@ class DynamicWorld final {
       Npc* npcHit = nullptr;
       };
 
+    struct RayQuery {
+      Tempest::Vec3 from = {};
+      Tempest::Vec3 to   = {};
+      };
+
+    enum RayFlags : uint8_t {
+      RF_Land     = 0,
+      RF_Npc      = 1, // same as rayNpc
+      };
+
     struct BulletCallback {
       virtual ~BulletCallback()=default;
       virtual void onStop(){}
@@ -234,6 +248,9 @@ class DynamicWorld final {
     RayLandResult  ray          (const Tempest::Vec3& from, const Tempest::Vec3& to) const;
     RayQueryResult rayNpc       (const Tempest::Vec3& from, const Tempest::Vec3& to) const;
     float          soundOclusion(const Tempest::Vec3& from, const Tempest::Vec3& to) const;
+    // out[i] is result for rays[i]; rays are cast in parallel on workers
+    // world must not be modified during the call
+    void           rayBatch     (const RayQuery* rays, RayQueryResult* out, size_t count, uint8_t flags = RF_Land) const;
 
     NpcItem        ghostObj  (std::string_view visual);
     Item           staticObj (const PhysicMeshShape *src, const Tempest::Matrix4x4& m);
@@ -263,6 +280,10 @@ class DynamicWorld final {
                              float mass, float friction, ItemType type);
 
 
+    void           packLandscape(const phoenix::mesh& mesh);
+    bool           loadLandscape(std::vector<uint8_t>& data);
+    void           saveLandscape(std::string_view name, uint64_t key) const;
+
     void           moveBullet(BulletBody& b, const Tempest::Vec3& dir, uint64_t dt);
     RayWaterResult implWaterRay(const Tempest::Vec3& from, const Tempest::Vec3& to) const;
     bool           hasCollision(const NpcItem &it, CollisionTest& out);
@@ -272,6 +293,8 @@ class DynamicWorld final {
     std::vector<std::string>           sectors;
 
     std::vector<btVector3>             landVbo;
+    std::vector<uint8_t>               landBvhImage; // deserialized in-place, outlives landShape
+    btOptimizedBvh*                    landBvh = nullptr;
     std::unique_ptr<PhysicVbo>         landMesh;
     std::unique_ptr<btCollisionShape>  landShape;
     std::unique_ptr<btRigidBody>       landBody;
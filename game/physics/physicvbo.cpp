@@ -108,6 +108,45 @@ void PhysicVbo::adjustMesh(){
     }
   }
 
+void PhysicVbo::serialize(CacheFile::Writer& out, const std::vector<std::string>& sectors) const {
+  out.put(id);
+  out.put(uint64_t(segments.size()));
+  for(auto& i:segments) {
+    int32_t sector = -1;
+    for(size_t r=0; r<sectors.size(); ++r)
+      if(sectors[r].c_str()==i.sector)
+        sector = int32_t(r);
+    out.put(uint64_t(i.off));
+    out.put(int32_t(i.size));
+    out.put(i.mat);
+    out.put(sector);
+    }
+  }
+
+bool PhysicVbo::deserialize(CacheFile::Reader& in, const std::vector<std::string>& sectors) {
+  uint64_t count = 0;
+  if(!in.get(id) || !in.get(count))
+    return false;
+  for(auto i:id)
+    if(i>=vert.size())
+      return false;
+  for(uint64_t i=0; i<count; ++i) {
+    uint64_t                off    = 0;
+    int32_t                 size   = 0;
+    phoenix::material_group mat    = phoenix::material_group::undefined;
+    int32_t                 sector = -1;
+    in.get(off);
+    in.get(size);
+    in.get(mat);
+    in.get(sector);
+    if(!in.isOk() || size<=0 || off>id.size() || uint64_t(size)*3>id.size()-off || sector>=int32_t(sectors.size()))
+      return false;
+    addSegment(size_t(size)*3,size_t(off),mat,sector<0 ? nullptr : sectors[size_t(sector)].c_str());
+    }
+  adjustMesh();
+  return true;
+  }
+
 std::string_view PhysicVbo::validateSectorName(std::string_view name) const {
   if(name.empty())
     return "";
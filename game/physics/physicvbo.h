@@ -5,6 +5,7 @@
 
 #include "graphics/mesh/protomesh.h"
 #include "physics/physics.h"
+#include "utils/cachefile.h"
 
 class PackedMesh;
 
@@ -27,6 +28,10 @@ class PhysicVbo : public btTriangleIndexVertexArray {
 
     void                    adjustMesh();
 
+    // indices and segments; sector names are stored as index in 'sectors'
+    void                    serialize  (CacheFile::Writer& out, const std::vector<std::string>& sectors) const;
+    bool                    deserialize(CacheFile::Reader& in,  const std::vector<std::string>& sectors);
+
     std::string_view validateSectorName(std::string_view name) const;
 
   private:
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include "utils/workers.h"
+
+// Casts a batch of independent rays on workers: cast(rays[i],out[i]) for every i.
+// Tasks take Batch rays each, to amortize scheduling; cast must be thread-safe
+class RayBatch final {
+  public:
+    static constexpr size_t Batch = 32;
+
+    template<class Q, class R, class F>
+    static void cast(const Q* rays, R* out, size_t count, const F& f) {
+      if(count==0)
+        return;
+      Workers::parallelTasks((count+Batch-1)/Batch,[&](uintptr_t task) {
+        const size_t begin = size_t(task)*Batch;
+        const size_t end   = std::min(count,begin+Batch);
+        for(size_t i=begin; i<end; ++i)
+          f(rays[i],out[i]);
+        });
+      }
+  };
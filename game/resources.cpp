@@ -72,9 +72,6 @@ Resources::Resources(Tempest::Device &device)
   dxMusic->addPath(Gothic::inst().nestedPath({u"_work",u"Data",u"Music",u"menu_men"}, Dir::FT_Dir));
   dxMusic->addPath(Gothic::inst().nestedPath({u"_work",u"Data",u"Music",u"orchestra"},Dir::FT_Dir));
 
-  fBuff .reserve(8*1024*1024);
-  ddsBuf.reserve(8*1024*1024);
-
   {
   Pixmap pm(1,1,Pixmap::Format::RGBA);
   uint8_t* pix = reinterpret_cast<uint8_t*>(pm.data());
@@ -148,21 +145,17 @@ Resources::~Resources() {
   }
 
 bool Resources::hasFile(std::string_view name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  // vdfs index is immutable, after loadVdfs
   return static_cast<const phoenix::vdf_file&>(inst->gothicAssets).find_entry(name) != nullptr;
   }
 
 bool Resources::getFileData(std::string_view name, std::vector<uint8_t> &dat) {
   dat.clear();
 
-  const phoenix::vdf_entry* entry = Resources::vdfsIndex().find_entry(name);
-  if(entry==nullptr)
+  auto reader = getFileView(name);
+  if(!reader)
     return false;
-
-  // TODO: This should return a buffer!
-  phoenix::buffer reader = entry->open();
-  dat.assign((uint8_t*) reader.array(), (uint8_t*) reader.array() + reader.limit());
-
+  dat.assign((uint8_t*) reader->array(), (uint8_t*) reader->array() + reader->limit());
   return true;
   }
 
@@ -173,9 +166,17 @@ std::vector<uint8_t> Resources::getFileData(std::string_view name) {
   }
 
 phoenix::buffer Resources::getFileBuffer(std::string_view name) {
-  const phoenix::vdf_entry* entry = Resources::vdfsIndex().find_entry(name);
-  if (entry == nullptr)
+  auto ret = getFileView(name);
+  if(!ret)
     throw std::runtime_error("failed to open resource: " + std::string{name});
+  return std::move(*ret);
+  }
+
+std::optional<phoenix::buffer> Resources::getFileView(std::string_view name) {
+  // entry is a slice of mmap'ed archive - no copy here
+  const phoenix::vdf_entry* entry = Resources::vdfsIndex().find_entry(name);
+  if(entry==nullptr)
+    return std::nullopt;
   return entry->open();
   }
 
@@ -275,94 +276,83 @@ int64_t Resources::vdfTimestamp(const std::u16string& name) {
     }
   }
 
-Tempest::Texture2d* Resources::implLoadTexture(TextureCache& cache, std::string_view cname) {
+Tempest::Texture2d* Resources::implLoadTexture(std::string_view cname) {
   if(cname.empty())
     return nullptr;
 
-  std::string name = std::string(cname);
-  auto it=cache.find(name);
-  if(it!=cache.end())
-    return it->second.get();
+  return texCache.get(cname,[&]() {
+    std::unique_ptr<Texture2d> t;
+    Tempest::Pixmap            pm;
+    if(!implDecodeTexture(cname,pm))
+      return t;
+    try {
+      std::lock_guard<std::mutex> g(syncGpu);
+      t.reset(new Texture2d(dev.texture(pm)));
+      }
+    catch(...) {
+      }
+    return t;
+    });
+  }
 
-  if(FileExt::hasExt(name,"TGA")) {
+bool Resources::implDecodeTexture(std::string_view cname, Tempest::Pixmap& pm) {
+  if(FileExt::hasExt(cname,"TGA")) {
+    std::string name = std::string(cname);
     name.resize(name.size() + 2);
     std::memcpy(&name[0]+name.size()-6,"-C.TEX",6);
 
-    it=cache.find(name);
-    if(it!=cache.end())
-      return it->second.get();
-
     if(const phoenix::vdf_entry* entry = Resources::vdfsIndex().find_entry(name)) {
-      auto reader = entry->open();
-      auto tex = phoenix::texture::parse(reader);
-
-      if (tex.format() == phoenix::tex_dxt1 ||
-          tex.format() == phoenix::tex_dxt2 ||
-          tex.format() == phoenix::tex_dxt3 ||
-          tex.format() == phoenix::tex_dxt4 ||
-          tex.format() == phoenix::tex_dxt5) {
-        auto dds = phoenix::texture_to_dds(tex);
-
-        auto t = implLoadTexture(cache, std::string(cname), dds);
-        if(t!=nullptr)
-          return t;
-        } else {
-        auto rgba = tex.as_rgba8(0);
-
-        try {
-          Tempest::Pixmap    pm(tex.width(), tex.height(), Tempest::Pixmap::Format::RGBA);
+      try {
+        auto reader = entry->open();
+        auto tex    = phoenix::texture::parse(reader);
+
+        if (tex.format() == phoenix::tex_dxt1 ||
+            tex.format() == phoenix::tex_dxt2 ||
+            tex.format() == phoenix::tex_dxt3 ||
+            tex.format() == phoenix::tex_dxt4 ||
+            tex.format() == phoenix::tex_dxt5) {
+          auto dds = phoenix::texture_to_dds(tex);
+
+          Tempest::MemReader rd((uint8_t*)dds.array(),dds.limit());
+          pm = Tempest::Pixmap(rd);
+          return true;
+          } else {
+          auto rgba = tex.as_rgba8(0);
+
+          pm = Tempest::Pixmap(tex.width(), tex.height(), Tempest::Pixmap::Format::RGBA);
           std::memcpy(pm.data(), rgba.data(), rgba.size());
-
-          std::unique_ptr<Texture2d> t{new Texture2d(dev.texture(pm))};
-          Texture2d* ret=t.get();
-          cache[std::move(name)] = std::move(t);
-          return ret;
-          }
-        catch (...) {
+          return true;
           }
         }
+      catch(...) {
+        }
       }
     }
 
   if(const phoenix::vdf_entry* entry = Resources::vdfsIndex().find_entry(cname)) {
-    phoenix::buffer reader = entry->open();
-    return implLoadTexture(cache,std::string(cname),reader);
+    try {
+      phoenix::buffer    reader = entry->open();
+      Tempest::MemReader rd((uint8_t*)reader.array(),reader.limit());
+      pm = Tempest::Pixmap(rd);
+      return true;
+      }
+    catch(...) {
+      }
     }
 
-  cache[name]=nullptr;
-  return nullptr;
-  }
-
-Texture2d *Resources::implLoadTexture(TextureCache& cache, std::string&& name, const phoenix::buffer& data) {
-  try {
-    Tempest::MemReader rd((uint8_t*)data.array(),data.limit());
-    Tempest::Pixmap    pm(rd);
-
-    std::unique_ptr<Texture2d> t{new Texture2d(dev.texture(pm))};
-    Texture2d* ret=t.get();
-    cache[std::move(name)] = std::move(t);
-    return ret;
-    }
-  catch(...){
-    return nullptr;
-    }
+  return false;
   }
 
 ProtoMesh* Resources::implLoadMesh(std::string_view name) {
   if(name.size()==0)
     return nullptr;
 
-  auto cname = std::string(name);
-  auto it    = aniMeshCache.find(cname);
-  if(it!=aniMeshCache.end())
-    return it->second.get();
-
-  auto  t   = implLoadMeshMain(cname);
-  auto  ret = t.get();
-  aniMeshCache[cname] = std::move(t);
-  if(ret==nullptr)
-    Log::e("unable to load mesh \"",cname,"\"");
-  return ret;
+  return aniMeshCache.get(name,[&]() {
+    auto t = implLoadMeshMain(std::string(name));
+    if(t==nullptr)
+      Log::e("unable to load mesh \"",name,"\"");
+    return t;
+    });
   }
 
 std::unique_ptr<ProtoMesh> Resources::implLoadMeshMain(std::string name) {
@@ -473,15 +463,8 @@ std::unique_ptr<ProtoMesh> Resources::implLoadMeshMain(std::string name) {
   return nullptr;
   }
 
-PfxEmitterMesh* Resources::implLoadEmiterMesh(std::string_view name) {
+std::unique_ptr<PfxEmitterMesh> Resources::implLoadEmiterMesh(std::string cname) {
   // TODO: reuse code from Resources::implLoadMeshMain
-  auto cname = std::string(name);
-  auto it    = emiMeshCache.find(cname);
-  if(it!=emiMeshCache.end())
-    return it->second.get();
-
-  auto& ret = emiMeshCache[cname];
-
   if(FileExt::hasExt(cname,"3DS")) {
     FileExt::exchangeExt(cname,"3DS","MRM");
 
@@ -494,12 +477,11 @@ PfxEmitterMesh* Resources::implLoadEmiterMesh(std::string_view name) {
       return nullptr;
 
     PackedMesh packed(zmsh,PackedMesh::PK_Visual);
-    ret = std::unique_ptr<PfxEmitterMesh>(new PfxEmitterMesh(packed));
-    return ret.get();
+    return std::unique_ptr<PfxEmitterMesh>(new PfxEmitterMesh(packed));
     }
 
-  if(FileExt::hasExt(name,"MDM")) {
-    if(!hasFile(name))
+  if(FileExt::hasExt(cname,"MDM")) {
+    if(!hasFile(cname))
       return nullptr;
 
     const phoenix::vdf_entry* entry = Resources::vdfsIndex().find_entry(cname);
@@ -508,8 +490,7 @@ PfxEmitterMesh* Resources::implLoadEmiterMesh(std::string_view name) {
     auto reader = entry->open();
     auto mdm = phoenix::model_mesh::parse(reader);
 
-    ret = std::unique_ptr<PfxEmitterMesh>(new PfxEmitterMesh(std::move(mdm)));
-    return ret.get();
+    return std::unique_ptr<PfxEmitterMesh>(new PfxEmitterMesh(std::move(mdm)));
     }
 
   return nullptr;
@@ -525,37 +506,31 @@ ProtoMesh* Resources::implDecalMesh(const phoenix::vob& vob) {
   if(key.mat.tex==nullptr)
     return nullptr;
 
-  auto it = decalMeshCache.find(key);
-  if(it!=decalMeshCache.end())
-    return it->second.get();
-
-  Resources::Vertex vbo[8] = {
-    {{-1.f, -1.f, 0.f},{0,0,-1},{0,1}, 0xFFFFFFFF},
-    {{ 1.f, -1.f, 0.f},{0,0,-1},{1,1}, 0xFFFFFFFF},
-    {{ 1.f,  1.f, 0.f},{0,0,-1},{1,0}, 0xFFFFFFFF},
-    {{-1.f,  1.f, 0.f},{0,0,-1},{0,0}, 0xFFFFFFFF},
-
-    {{-1.f, -1.f, 0.f},{0,0, 1},{0,1}, 0xFFFFFFFF},
-    {{ 1.f, -1.f, 0.f},{0,0, 1},{1,1}, 0xFFFFFFFF},
-    {{ 1.f,  1.f, 0.f},{0,0, 1},{1,0}, 0xFFFFFFFF},
-    {{-1.f,  1.f, 0.f},{0,0, 1},{0,0}, 0xFFFFFFFF},
-    };
-  for(auto& i:vbo) {
-    i.pos[0]*=key.sX;
-    i.pos[1]*=key.sY;
-    }
-
-  std::vector<Resources::Vertex> cvbo(vbo,vbo+8);
-  std::vector<uint32_t>          cibo;
-  if(key.decal2Sided)
-    cibo = { 0,1,2, 0,2,3, 4,6,5, 4,7,6 }; else
-    cibo = { 0,1,2, 0,2,3 };
+  return decalMeshCache.get(key,[&key]() {
+    Resources::Vertex vbo[8] = {
+      {{-1.f, -1.f, 0.f},{0,0,-1},{0,1}, 0xFFFFFFFF},
+      {{ 1.f, -1.f, 0.f},{0,0,-1},{1,1}, 0xFFFFFFFF},
+      {{ 1.f,  1.f, 0.f},{0,0,-1},{1,0}, 0xFFFFFFFF},
+      {{-1.f,  1.f, 0.f},{0,0,-1},{0,0}, 0xFFFFFFFF},
+
+      {{-1.f, -1.f, 0.f},{0,0, 1},{0,1}, 0xFFFFFFFF},
+      {{ 1.f, -1.f, 0.f},{0,0, 1},{1,1}, 0xFFFFFFFF},
+      {{ 1.f,  1.f, 0.f},{0,0, 1},{1,0}, 0xFFFFFFFF},
+      {{-1.f,  1.f, 0.f},{0,0, 1},{0,0}, 0xFFFFFFFF},
+      };
+    for(auto& i:vbo) {
+      i.pos[0]*=key.sX;
+      i.pos[1]*=key.sY;
+      }
 
-  std::unique_ptr<ProtoMesh> t{new ProtoMesh(key.mat, std::move(cvbo), std::move(cibo))};
+    std::vector<Resources::Vertex> cvbo(vbo,vbo+8);
+    std::vector<uint32_t>          cibo;
+    if(key.decal2Sided)
+      cibo = { 0,1,2, 0,2,3, 4,6,5, 4,7,6 }; else
+      cibo = { 0,1,2, 0,2,3 };
 
-  auto ret = t.get();
-  decalMeshCache[key] = std::move(t);
-  return ret;
+    return std::unique_ptr<ProtoMesh>(new ProtoMesh(key.mat, std::move(cvbo), std::move(cibo)));
+    });
   }
 
 std::unique_ptr<Animation> Resources::implLoadAnimation(std::string name) {
@@ -591,10 +566,11 @@ Tempest::Sound Resources::implLoadSoundBuffer(std::string_view name) {
   if(name.empty())
     return Tempest::Sound();
 
-  if(!getFileData(name,fBuff))
+  auto data = getFileView(name);
+  if(!data)
     return Tempest::Sound();
   try {
-    Tempest::MemReader rd(fBuff.data(),fBuff.size());
+    Tempest::MemReader rd((uint8_t*)data->array(),data->limit());
     return Tempest::Sound(rd);
     }
   catch(...) {
@@ -663,8 +639,7 @@ GthFont &Resources::implLoadFont(std::string_view name, FontType type) {
   }
 
 const Texture2d *Resources::loadTexture(std::string_view name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
-  return inst->implLoadTexture(inst->texCache,name);
+  return inst->implLoadTexture(name);
   }
 
 const Texture2d* Resources::loadTexture(Tempest::Color color) {
@@ -680,7 +655,11 @@ const Texture2d* Resources::loadTexture(Tempest::Color color) {
   Pixmap p2(1,1,Pixmap::Format::RGBA);
   std::memcpy(p2.data(),iv,4);
 
-  auto t       = std::make_unique<Texture2d>(inst->dev.texture(p2));
+  std::unique_ptr<Texture2d> t;
+  {
+    std::lock_guard<std::mutex> gpu(inst->syncGpu);
+    t = std::make_unique<Texture2d>(inst->dev.texture(p2));
+  }
   auto ret     = t.get();
   cache[color] = std::move(t);
   return ret;
@@ -745,8 +724,10 @@ Texture2d Resources::loadTexturePm(const Pixmap &pm) {
   if(pm.isEmpty()) {
     Pixmap p2(1,1,Pixmap::Format::R);
     std::memset(p2.data(),0,1);
+    std::lock_guard<std::mutex> g(inst->syncGpu);
     return inst->dev.texture(p2);
     }
+  std::lock_guard<std::mutex> g(inst->syncGpu);
   return inst->dev.texture(pm);
   }
 
@@ -757,15 +738,15 @@ Material Resources::loadMaterial(const phoenix::material& src, bool enableAlphaT
 const ProtoMesh* Resources::loadMesh(std::string_view name) {
   if(name.size()==0)
     return nullptr;
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
   return inst->implLoadMesh(name);
   }
 
 const PfxEmitterMesh* Resources::loadEmiterMesh(std::string_view name) {
   if(name.empty())
     return nullptr;
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
-  return inst->implLoadEmiterMesh(name);
+  return inst->emiMeshCache.get(name,[name]() {
+    return inst->implLoadEmiterMesh(std::string(name));
+    });
   }
 
 const Skeleton* Resources::loadSkeleton(std::string_view name) {
@@ -776,21 +757,13 @@ const Skeleton* Resources::loadSkeleton(std::string_view name) {
   }
 
 const Animation* Resources::loadAnimation(std::string_view name) {
-  auto cname = std::string(name);
-
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
-  auto& cache = inst->animCache;
-  auto it=cache.find(cname);
-  if(it!=cache.end())
-    return it->second.get();
-  auto t       = inst->implLoadAnimation(cname);
-  auto ret     = t.get();
-  cache[cname] = std::move(t);
-  return ret;
+  return inst->animCache.get(name,[name]() {
+    return inst->implLoadAnimation(std::string(name));
+    });
   }
 
 Tempest::Sound Resources::loadSoundBuffer(std::string_view name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  // no shared state: sound is decoded directly from archive memory
   return inst->implLoadSoundBuffer(name);
   }
 
@@ -800,21 +773,17 @@ Dx8::PatternList Resources::loadDxMusic(std::string_view name) {
   }
 
 const ProtoMesh* Resources::decalMesh(const phoenix::vob& vob) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
   return inst->implDecalMesh(vob);
   }
 
 const Resources::VobTree* Resources::loadVobBundle(std::string_view name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
-  return inst->implLoadVobBundle(name);
+  return inst->zenCache.get(name,[name]() {
+    return inst->implLoadVobBundle(name);
+    });
   }
 
-const Resources::VobTree* Resources::implLoadVobBundle(std::string_view filename) {
+std::unique_ptr<Resources::VobTree> Resources::implLoadVobBundle(std::string_view filename) {
   auto cname = std::string(filename);
-  auto i     = zenCache.find(cname);
-  if(i!=zenCache.end())
-    return i->second.get();
-
   std::vector<std::unique_ptr<phoenix::vob>> bundle;
   try {
     const phoenix::vdf_entry* entry = Resources::vdfsIndex().find_entry(cname);
@@ -830,27 +799,18 @@ const Resources::VobTree* Resources::implLoadVobBundle(std::string_view filename
     Log::e("unable to load Zen-file: \"",cname,"\"");
     }
 
-  auto ret = zenCache.insert(std::make_pair(filename,std::make_unique<VobTree>(std::move(bundle))));
-  return ret.first->second.get();
+  return std::make_unique<VobTree>(std::move(bundle));
   }
 
 const AttachBinder *Resources::bindMesh(const ProtoMesh &anim, const Skeleton &s) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
-
   if(anim.submeshId.size()==0){
     static AttachBinder empty;
     return &empty;
     }
   BindK k = BindK(&s,&anim);
-
-  auto it = inst->bindCache.find(k);
-  if(it!=inst->bindCache.end())
-    return it->second.get();
-
-  std::unique_ptr<AttachBinder> ret(new AttachBinder(s,anim));
-  auto p = ret.get();
-  inst->bindCache[k] = std::move(ret);
-  return p;
+  return inst->bindCache.get(k,[&]() {
+    return std::unique_ptr<AttachBinder>(new AttachBinder(s,anim));
+    });
   }
 
 Tempest::VertexBuffer<Resources::Vertex> Resources::sphere(int passCount, float R){
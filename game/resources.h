@@ -10,10 +10,13 @@
 
 #include <tuple>
 #include <string_view>
+#include <optional>
 #include <map>
+#include <mutex>
 
 #include "graphics/material.h"
 #include "sound/soundfx.h"
+#include "utils/concurrentcache.h"
 
 class StaticMesh;
 class ProtoMesh;
@@ -111,12 +114,12 @@ class Resources final {
     static const VobTree*            loadVobBundle(std::string_view name);
 
     template<class V>
-    static Tempest::VertexBuffer<V>  vbo(const V* data,size_t sz){ return inst->dev.vbo(data,sz); }
+    static Tempest::VertexBuffer<V>  vbo(const V* data,size_t sz){ std::lock_guard<std::mutex> g(inst->syncGpu); return inst->dev.vbo(data,sz); }
 
     template<class V>
-    static Tempest::IndexBuffer<V>   ibo(const V* data,size_t sz){ return inst->dev.ibo(data,sz); }
+    static Tempest::IndexBuffer<V>   ibo(const V* data,size_t sz){ std::lock_guard<std::mutex> g(inst->syncGpu); return inst->dev.ibo(data,sz); }
 
-    static Tempest::StorageBuffer    ssbo(const void* data, size_t size) { return inst->dev.ssbo(data,size); }
+    static Tempest::StorageBuffer    ssbo(const void* data, size_t size) { std::lock_guard<std::mutex> g(inst->syncGpu); return inst->dev.ssbo(data,size); }
 
     template<class V, class I>
     static Tempest::AccelerationStructure
@@ -125,12 +128,14 @@ class Resources final {
                                           size_t offset, size_t size){
       if(!inst->dev.properties().raytracing.rayQuery)
         return Tempest::AccelerationStructure();
+      std::lock_guard<std::mutex> g(inst->syncGpu);
       return inst->dev.blas(b,i,offset,size);
       }
 
     static std::vector<uint8_t>      getFileData(std::string_view name);
     static bool                      getFileData(std::string_view name, std::vector<uint8_t>& dat);
     static phoenix::buffer           getFileBuffer(std::string_view name);
+    static auto                      getFileView  (std::string_view name) -> std::optional<phoenix::buffer>;
     static bool                      hasFile    (std::string_view fname);
 
     static const phoenix::vdf_file&  vdfsIndex();
@@ -160,13 +165,11 @@ class Resources final {
         }
       };
 
-    using TextureCache = std::unordered_map<std::string,std::unique_ptr<Tempest::Texture2d>>;
-
     int64_t               vdfTimestamp(const std::u16string& name);
     void                  detectVdf(std::vector<Archive>& ret, const std::u16string& root);
 
-    Tempest::Texture2d*   implLoadTexture(TextureCache& cache, std::string_view cname);
-    Tempest::Texture2d*   implLoadTexture(TextureCache& cache, std::string &&name, const phoenix::buffer& data);
+    Tempest::Texture2d*   implLoadTexture(std::string_view cname);
+    bool                  implDecodeTexture(std::string_view cname, Tempest::Pixmap& pm);
     ProtoMesh*            implLoadMesh(std::string_view name);
     std::unique_ptr<ProtoMesh> implLoadMeshMain(std::string name);
     std::unique_ptr<Animation> implLoadAnimation(std::string name);
@@ -174,8 +177,8 @@ class Resources final {
     Tempest::Sound        implLoadSoundBuffer(std::string_view name);
     Dx8::PatternList      implLoadDxMusic(std::string_view name);
     GthFont&              implLoadFont(std::string_view fname, FontType type);
-    PfxEmitterMesh*       implLoadEmiterMesh(std::string_view name);
-    const VobTree*        implLoadVobBundle(std::string_view name);
+    std::unique_ptr<PfxEmitterMesh> implLoadEmiterMesh(std::string name);
+    std::unique_ptr<VobTree>        implLoadVobBundle(std::string_view name);
 
     Tempest::VertexBuffer<Vertex> sphere(int passCount, float R);
 
@@ -185,6 +188,9 @@ class Resources final {
     using FontK  = std::pair<const std::string,FontType>;
 
     struct Hash {
+      size_t operator()(std::string_view s) const {
+        return std::hash<std::string_view>()(s);
+        }
       size_t operator()(const BindK& b) const {
         return std::uintptr_t(std::get<0>(b));
         }
@@ -209,21 +215,21 @@ class Resources final {
     Tempest::SoundDevice              sound;
 
     std::recursive_mutex              sync;
+    std::mutex                        syncGpu;
     std::unique_ptr<Dx8::DirectMusic> dxMusic;
     phoenix::vdf_file                 gothicAssets {"Root"};
 
-    std::vector<uint8_t>              fBuff, ddsBuf;
     Tempest::VertexBuffer<VertexFsq>  fsq;
 
-    TextureCache                                                      texCache;
     std::map<Tempest::Color,std::unique_ptr<Tempest::Texture2d>,Less> pixCache;
-    std::unordered_map<std::string,std::unique_ptr<ProtoMesh>>        aniMeshCache;
-    std::unordered_map<DecalK,std::unique_ptr<ProtoMesh>,Hash>        decalMeshCache;
-    std::unordered_map<std::string,std::unique_ptr<Skeleton>>         skeletonCache;
-    std::unordered_map<std::string,std::unique_ptr<Animation>>        animCache;
-    std::unordered_map<BindK,std::unique_ptr<AttachBinder>,Hash>      bindCache;
-    std::unordered_map<std::string,std::unique_ptr<PfxEmitterMesh>>   emiMeshCache;
-    std::unordered_map<std::string,std::unique_ptr<VobTree>>          zenCache;
+
+    ConcurrentCache<std::string,Tempest::Texture2d,Hash>              texCache;
+    ConcurrentCache<std::string,ProtoMesh,Hash>                       aniMeshCache;
+    ConcurrentCache<DecalK,ProtoMesh,Hash>                            decalMeshCache;
+    ConcurrentCache<std::string,Animation,Hash>                       animCache;
+    ConcurrentCache<BindK,AttachBinder,Hash>                          bindCache;
+    ConcurrentCache<std::string,PfxEmitterMesh,Hash>                  emiMeshCache;
+    ConcurrentCache<std::string,VobTree,Hash>                         zenCache;
 
     std::recursive_mutex                                              syncFont;
     std::unordered_map<FontK,std::unique_ptr<GthFont>,Hash>           gothicFnt;
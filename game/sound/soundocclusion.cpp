@@ -0,0 +1,62 @@
+#include "soundocclusion.h"
+
+#include <algorithm>
+
+using namespace Tempest;
+
+const uint64_t SoundOcclusion::interval = 150;
+const uint64_t SoundOcclusion::smooth   = 200;
+const float    SoundOcclusion::move     = 50;   // listener or source must move 50cm, to recompute
+
+void SoundOcclusion::init(Slot& slot, const Vec3& from, const Vec3& to, float occlusion, uint64_t now) {
+  slot.target = std::max(0.f,1.f-occlusion);
+  slot.occ    = slot.target;
+  slot.from   = from;
+  slot.to     = to;
+  slot.next   = now + interval;
+  slot.valid  = true;
+  }
+
+void SoundOcclusion::reset(Slot& slot) {
+  slot.target = 0;
+  slot.occ    = 0;
+  slot.valid  = false;
+  }
+
+bool SoundOcclusion::tick(Slot& slot, const Vec3& head, const Vec3& pos, uint64_t dt, uint64_t now) {
+  bool changed = false;
+  if(slot.valid && slot.occ!=slot.target) {
+    const float k = std::min(1.f, float(dt)/float(smooth));
+    slot.occ = slot.occ + (slot.target-slot.occ)*k;
+    changed  = true;
+    }
+
+  if(slot.valid && now<slot.next)
+    return changed;
+  // static source and listener: cached value is still good
+  const float mv = move*move;
+  if(slot.valid && (slot.from-head).quadLength()<mv && (slot.to-pos).quadLength()<mv) {
+    // keep the phase: otherwise all cached sounds are due on the frame, listener starts to move
+    slot.next += (now-slot.next)/interval*interval + interval;
+    return changed;
+    }
+
+  Query q;
+  q.slot = &slot;
+  q.from = head;
+  q.to   = pos;
+  query.push_back(q);
+  return changed;
+  }
+
+void SoundOcclusion::commit(const Query& q, size_t id, uint64_t now) {
+  auto& slot = *q.slot;
+  slot.target = std::max(0.f,1.f-q.occ);
+  slot.from   = q.from;
+  slot.to     = q.to;
+  // spread queries of sounds, started on the same frame, over few frames
+  slot.next   = now + interval + id%4*interval/4;
+  if(!slot.valid)
+    slot.occ = slot.target;
+  slot.valid  = true;
+  }
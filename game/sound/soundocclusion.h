@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Tempest/Vec>
+#include <cstdint>
+#include <vector>
+
+#include "utils/workers.h"
+
+// Occlusion of 3d sounds. Raycasts of all sounds are batched and run on workers, once per frame.
+// Raycast of a sound is rate-limited and skipped while listener and source stay in place;
+// occlusion follows last result smoothly, so the rate limit is not audible.
+class SoundOcclusion final {
+  public:
+    struct Slot {
+      float         occ    = 1.f; // current value: 1 - not occluded
+      float         target = 1.f; // last raycast result
+      bool          valid  = false;
+      uint64_t      next   = 0;
+      Tempest::Vec3 from, to;
+      };
+
+    static const uint64_t interval;
+    static const uint64_t smooth;
+    static const float    move;
+
+    // first raycast, done by caller, applied immediately
+    void   init(Slot& slot, const Tempest::Vec3& from, const Tempest::Vec3& to, float occlusion, uint64_t now);
+    // out of range: silent, raycast again when back in range
+    void   reset(Slot& slot);
+    // moves slot.occ towards target and queues a new raycast, if due; returns true, if slot.occ changed
+    bool   tick(Slot& slot, const Tempest::Vec3& head, const Tempest::Vec3& pos, uint64_t dt, uint64_t now);
+    size_t pending() const { return query.size(); }
+
+    // ray(from,to) returns occlusion in [0..1] and is called concurrently;
+    // apply(slot) is called on this thread, for every slot with a new result
+    template<class Ray, class Apply>
+    void   flush(uint64_t now, const Ray& ray, const Apply& apply);
+
+  private:
+    struct Query {
+      Slot*         slot = nullptr;
+      Tempest::Vec3 from, to;
+      float         occ  = 0;
+      };
+
+    void   commit(const Query& q, size_t id, uint64_t now);
+
+    std::vector<Query> query;
+  };
+
+template<class Ray, class Apply>
+void SoundOcclusion::flush(uint64_t now, const Ray& ray, const Apply& apply) {
+  if(query.empty())
+    return;
+  Workers::parallelFor(query,[&ray](Query& q) {
+    q.occ = ray(q.from,q.to);
+    });
+  for(size_t i=0; i<query.size(); ++i) {
+    commit(query[i],i,now);
+    apply(*query[i].slot);
+    }
+  query.clear();
+  }
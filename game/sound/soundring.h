@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Single-producer/single-consumer queue of interleaved float samples.
+// Producer and consumer never block each other; positions grow monotonically and wrap by mask.
+class SoundRing final {
+  public:
+    SoundRing(size_t minCapacity, size_t channels) : channels(channels) {
+      size_t cap = 1;
+      while(cap<minCapacity)
+        cap *= 2;
+      ring.resize(cap);
+      }
+
+    size_t capacity() const { return ring.size(); }
+    size_t size()     const { return tail.load(std::memory_order_acquire)-head.load(std::memory_order_acquire); }
+
+    // producer: writes as many whole frames of s, as fit; returns count of written samples
+    size_t push(const float* s, size_t count) {
+      const size_t mask = ring.size()-1;
+      const size_t t    = tail.load(std::memory_order_relaxed);
+      const size_t h    = head.load(std::memory_order_acquire);
+
+      size_t n = std::min(count, ring.size()-(t-h));
+      n -= n%channels;
+
+      const size_t at    = t & mask;
+      const size_t part0 = std::min(n, ring.size()-at);
+      std::memcpy(ring.data()+at, s,       part0*sizeof(float));
+      std::memcpy(ring.data(),    s+part0, (n-part0)*sizeof(float));
+      tail.store(t+n,std::memory_order_release);
+      return n;
+      }
+
+    // consumer: converts up to n samples to pcm16, rest of out is filled with silence; returns count of real samples
+    size_t pop(int16_t* out, size_t n) {
+      const size_t mask = ring.size()-1;
+      const size_t h    = head.load(std::memory_order_relaxed);
+      const size_t t    = tail.load(std::memory_order_acquire);
+      const size_t cnt  = std::min(n, t-h);
+      for(size_t i=0; i<cnt; ++i) {
+        float v = ring[(h+i) & mask];
+        out[i] = (v < -1.00004566f ? int16_t(-32768) : (v > 1.00001514f ? int16_t(32767) : int16_t(v * 32767.5f)));
+        }
+      std::memset(out+cnt, 0, (n-cnt)*sizeof(int16_t));
+      head.store(h+cnt,std::memory_order_release);
+      return cnt;
+      }
+
+  private:
+    const size_t                     channels = 2;
+    std::vector<float>               ring;
+    alignas(64) std::atomic<size_t>  head{0};
+    alignas(64) std::atomic<size_t>  tail{0};
+  };
@@ -5,8 +5,14 @@
 #include <Tempest/Log>
 #include <Tempest/Application>
 
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
 #include "bink/video.h"
+#include "sound/soundring.h"
 #include "utils/fileutil.h"
+#include "utils/workers.h"
 #include "gamemusic.h"
 #include "gothic.h"
 
@@ -46,47 +52,69 @@ struct VideoWidget::Sound : Tempest::SoundProducer {
   };
 
 struct VideoWidget::SoundContext {
-  SoundContext(Context& ctx, SoundDevice& dev, uint16_t sampleRate, bool isMono):  ctx(ctx) {
+  enum {
+    MaxPushWait = 50, // ms; audio thread normally frees space much sooner
+    };
+
+  // ~1 second of audio
+  SoundContext(Context& ctx, SoundDevice& dev, uint16_t sampleRate, bool isMono)
+    :ctx(ctx), ring(size_t(sampleRate)*(isMono ? 1 : 2), isMono ? 1 : 2) {
     snd = dev.load(std::unique_ptr<VideoWidget::Sound>(new VideoWidget::Sound(*this,sampleRate,isMono)));
     }
 
   ~SoundContext() {
     snd = SoundEffect();
+    if(underrun.load()>0 || overrun.load()>0)
+      Log::i("video sound: underruns = ",underrun.load(),", overruns = ",overrun.load());
     }
 
   void play() {
     snd.play();
     }
 
+  // producer: Context::advance; waits for audio thread, if ring is full
   void pushSamples(const std::vector<float>& s) {
-    std::lock_guard<std::mutex> guard(syncSamples);
-    size_t sz = samples.size();
-    samples.resize(sz+s.size());
-    std::memcpy(samples.data()+sz, s.data(), s.size()*sizeof(s[0]));
+    size_t at = ring.push(s.data(),s.size());
+    for(int i=0; at<s.size(); ++i) {
+      if(i==MaxPushWait) {
+        overrun.fetch_add(1,std::memory_order_relaxed);
+        return;
+        }
+      Application::sleep(1);
+      at += ring.push(s.data()+at,s.size()-at);
+      }
+    }
+
+  // consumer: audio thread
+  void popSamples(int16_t* out, size_t n) {
+    if(ring.pop(out,n)<n)
+      underrun.fetch_add(1,std::memory_order_relaxed);
     }
 
-  Context&             ctx;
-  Tempest::SoundEffect snd;
-  std::mutex           syncSamples;
-  std::vector<float>   samples;
+  Context&                         ctx;
+  Tempest::SoundEffect             snd;
+  SoundRing                        ring;
+  std::atomic<uint32_t>            underrun{0};
+  std::atomic<uint32_t>            overrun {0};
   };
 
 void VideoWidget::Sound::renderSound(int16_t *out, size_t n) {
   n = n*channels; // stereo
-
-  std::lock_guard<std::mutex> guard(ctx.syncSamples);
-  auto& s = ctx.samples;
-  if(s.size()<n)
-    return;
-  for(size_t i=0; i<n; ++i) {
-    float v = s[i];
-    out[i] = (v < -1.00004566f ? int16_t(-32768) : (v > 1.00001514f ? int16_t(32767) : int16_t(v * 32767.5f)));
-    }
-  ctx.samples.erase(ctx.samples.begin(),ctx.samples.begin()+int(n));
+  ctx.popSamples(out,n);
   }
 
 struct VideoWidget::Context {
-  Context(const std::u16string& path) : fin(path), input(fin), vid(&input) {
+  enum {
+    DecodeAhead = 3,
+    };
+
+  struct Decoded {
+    const Bink::Frame* frame = nullptr;
+    std::exception_ptr error;
+    };
+
+  // DecodeAhead queued frames + displayed one + reference frame of decoder
+  Context(const std::u16string& path) : fin(path), input(fin), vid(&input,DecodeAhead+2) {
     sndCtx.resize(vid.audioCount());
     for(size_t i=0; i<sndCtx.size(); ++i) {
       auto& aud = vid.audio(uint8_t(i));
@@ -98,68 +126,139 @@ struct VideoWidget::Context {
     sndDev.setGlobalVolume(volume);
     for(size_t i=0; i<vid.audioCount(); ++i)
       sndCtx[i]->play();
+
+    decoder = std::thread([this]() { decodeLoop(); });
     }
 
   ~Context() {
+    {
+      std::lock_guard<std::mutex> guard(sync);
+      stop = true;
+    }
+    queueCv.notify_all();
+    decoder.join();
     }
 
-  void advance() {
-    auto& f = vid.nextFrame();
-    if(pm.w()!=f.width() || pm.h()!=f.height())
-      pm = Pixmap(f.width(),f.height(),Pixmap::Format::RGBA);
+  void decodeLoop() {
+    Workers::setThreadName("Video decoder");
+    decodeFrames();
+    {
+      std::lock_guard<std::mutex> guard(sync);
+      finished = true;
+    }
+    queueCv.notify_all();
+    }
+
+  void decodeFrames() {
+    for(size_t i=0; i<vid.frameCount(); ++i) {
+      {
+        // frame, that is being decoded, must not overwrite displayed one
+        std::unique_lock<std::mutex> guard(sync);
+        queueCv.wait(guard,[this](){ return stop || queue.size()<=DecodeAhead; });
+        if(stop)
+          return;
+      }
 
-    yuvToRgba(f,pm);
+      Decoded d;
+      bool    fatal = false;
+      try {
+        d.frame = &vid.nextFrame();
+        }
+      catch(const Bink::VideoDecodingException&) {
+        d.error = std::current_exception();
+        }
+      catch(...) {
+        d.error = std::current_exception();
+        fatal   = true;
+        }
+
+      {
+        std::lock_guard<std::mutex> guard(sync);
+        queue.push_back(std::move(d));
+      }
+      queueCv.notify_all();
+      if(fatal)
+        return;
+      }
+    }
+
+  bool advance() {
+    if(isEof())
+      return false;
+
+    Decoded d;
+    {
+      std::unique_lock<std::mutex> guard(sync);
+      queueCv.wait(guard,[this](){ return !queue.empty() || finished; });
+      if(queue.empty()) {
+        // decoder has stopped early - nothing more to show
+        shown = vid.frameCount();
+        return false;
+        }
+      d = std::move(queue.front());
+      queue.pop_front();
+    }
+    queueCv.notify_all();
+
+    shown++;
+    if(d.error)
+      std::rethrow_exception(d.error);
+
+    auto& f = *d.frame;
+    frame = &f;
     for(size_t i=0; i<vid.audioCount(); ++i)
       sndCtx[i]->pushSamples(f.audio(uint8_t(i)).samples);
 
-    uint64_t destTick = frameTime+(1000*vid.fps().den*vid.currentFrame())/vid.fps().num;
+    uint64_t destTick = frameTime+(1000*vid.fps().den*shown)/vid.fps().num;
     uint64_t tick     = Application::tickCount();
     if(tick<destTick) {
       Application::sleep(uint32_t(destTick-tick));
       }
+    return true;
     }
 
-  void yuvToRgba(const Bink::Frame& f,Pixmap& pm) {
-    auto planeY = f.plane(0);
-    auto planeU = f.plane(1);
-    auto planeV = f.plane(2);
-    auto dst    = reinterpret_cast<uint8_t*>(pm.data());
-
-    const uint32_t w = pm.w();
-    for(uint32_t y=0; y<pm.h(); ++y)
-      for(uint32_t x=0; x<w; ++x) {
-        uint8_t* rgb = &dst[(x+y*w)*4];
-        float Y = planeY.at(x,  y  );
-        float U = planeU.at(x/2,y/2);
-        float V = planeV.at(x/2,y/2);
-
-        float r = 1.164f * (Y - 16.f) + 1.596f * (V - 128.f);
-        float g = 1.164f * (Y - 16.f) - 0.813f * (V - 128.f) - 0.391f * (U - 128.f);
-        float b = 1.164f * (Y - 16.f) + 2.018f * (U - 128.f);
-
-        r = std::max(0.f,std::min(r,255.f));
-        g = std::max(0.f,std::min(g,255.f));
-        b = std::max(0.f,std::min(b,255.f));
-
-        rgb[0] = uint8_t(r);
-        rgb[1] = uint8_t(g);
-        rgb[2] = uint8_t(b);
-        rgb[3] = 255;
-        }
+  void yuvToRgba() {
+    auto& f = *frame;
+    if(pm.w()!=f.width() || pm.h()!=f.height())
+      pm = Pixmap(f.width(),f.height(),Pixmap::Format::RGBA);
+
+    auto           dst    = reinterpret_cast<uint8_t*>(pm.data());
+    const uint32_t h      = f.height();
+    // split by pairs of rows, to keep 2x2 chroma blocks in one task
+    const uint32_t blocks = (h+1)/2;
+    const uint32_t tasks  = std::min<uint32_t>(Workers::maxThreads(), (blocks+31)/32);
+    if(tasks<=1) {
+      f.yuvToRgba(dst,0,h);
+      return;
+      }
+    Workers::parallelTasks(tasks,[&f,dst,blocks,tasks](uintptr_t i) {
+      const uint32_t begin = uint32_t((blocks*i    )/tasks);
+      const uint32_t end   = uint32_t((blocks*(i+1))/tasks);
+      f.yuvToRgba(dst,begin*2,end*2);
+      });
     }
 
   bool isEof() const {
-    return vid.currentFrame()>=vid.frameCount();
+    return shown>=vid.frameCount();
     }
 
   Tempest::RFile       fin;
   Input                input;
   Bink::Video          vid;
+  const Bink::Frame*   frame = nullptr;
+  size_t               shown = 0;
   Pixmap               pm;
   uint64_t             frameTime = 0;
 
   Tempest::SoundDevice      sndDev;
   std::vector<std::unique_ptr<SoundContext>> sndCtx;
+
+  std::thread               decoder;
+  std::mutex                sync;
+  std::condition_variable   queueCv;
+  std::deque<Decoded>       queue;
+  bool                      stop     = false;
+  bool                      finished = false;
   };
 
 VideoWidget::VideoWidget() {
@@ -246,16 +345,18 @@ void VideoWidget::paint(Tempest::Device& device, uint8_t fId) {
   if(ctx==nullptr)
     return;
   try {
-    ctx->advance();
+    if(!ctx->advance())
+      return;
+    ctx->yuvToRgba();
     tex[fId] = device.texture(ctx->pm,false);
     frame    = &tex[fId];
     update();
     }
   catch(const Bink::VideoDecodingException& e) { // video exception is recoverable
-    Log::e("video decoding error. frame: ",ctx->vid.currentFrame(),", what: \"", e.what(), "\"");
+    Log::e("video decoding error. frame: ",ctx->shown,", what: \"", e.what(), "\"");
     }
   catch(...) {
-    Log::e("video decoding error. frame: ",ctx->vid.currentFrame());
+    Log::e("video decoding error. frame: ",ctx->shown);
     ctx.reset();
     }
   }
@@ -0,0 +1,143 @@
+#include "cachefile.h"
+
+#include <Tempest/File>
+#include <Tempest/Log>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#include "utils/string_frm.h"
+
+using namespace Tempest;
+
+namespace {
+
+struct Header {
+  char     magic[4] = {'O','G','C','F'};
+  uint32_t version  = 2;
+  uint64_t key      = 0;
+  uint64_t size     = 0;
+  uint64_t checksum = 0;
+  };
+
+}
+
+uint64_t CacheFile::hash(const void* data, size_t size, uint64_t seed) {
+  // FNV-1a over 8-byte words, with extra fold of high bits: used on tens of megabytes of world data
+  auto     b = reinterpret_cast<const uint8_t*>(data);
+  uint64_t h = seed;
+  size_t   i = 0;
+  for(; i+8<=size; i+=8) {
+    uint64_t w = 0;
+    std::memcpy(&w,b+i,sizeof(w));
+    h ^= w;
+    h *= 0x100000001b3ull;
+    h ^= h >> 29;
+    }
+  for(; i<size; ++i) {
+    h ^= b[i];
+    h *= 0x100000001b3ull;
+    }
+  return h;
+  }
+
+std::vector<uint8_t> CacheFile::read(std::string_view name, uint64_t key) {
+  string_frm path("cache/",name);
+  if(!std::filesystem::exists(path.c_str()))
+    return {};
+
+  try {
+    RFile  fin(path.c_str());
+    Header hdr, ref;
+    if(fin.read(&hdr,sizeof(hdr))!=sizeof(hdr) || std::memcmp(hdr.magic,ref.magic,sizeof(hdr.magic))!=0 ||
+       hdr.version!=ref.version || hdr.key!=key || hdr.size!=fin.size()-sizeof(hdr))
+      return {};
+
+    std::vector<uint8_t> ret(size_t(hdr.size));
+    if(fin.read(ret.data(),ret.size())!=ret.size() || hash(ret.data(),ret.size())!=hdr.checksum)
+      return {};
+    return ret;
+    }
+  catch(const std::exception& e) {
+    Log::e("unable to read cache file \"",path.c_str(),"\": ",e.what());
+    return {};
+    }
+  }
+
+bool CacheFile::write(std::string_view name, uint64_t key, const void* data, size_t size) {
+  string_frm path("cache/",name);
+  string_frm tmp ("cache/",name,".tmp");
+
+  std::error_code ec;
+  std::filesystem::create_directories("cache",ec);
+  try {
+    {
+    Header hdr;
+    hdr.key      = key;
+    hdr.size     = size;
+    hdr.checksum = hash(data,size);
+    WFile fout(tmp.c_str());
+    fout.write(&hdr,sizeof(hdr));
+    fout.write(data,size);
+    }
+    std::remove(path.c_str());
+    if(std::rename(tmp.c_str(),path.c_str())!=0) {
+      std::remove(tmp.c_str());
+      return false;
+      }
+    return true;
+    }
+  catch(const std::exception& e) {
+    Log::e("unable to write cache file \"",path.c_str(),"\": ",e.what());
+    std::remove(tmp.c_str());
+    return false;
+    }
+  }
+
+void CacheFile::Writer::write(const void* data, size_t size) {
+  const size_t at = img.size();
+  img.resize(at+size);
+  if(size>0)
+    std::memcpy(img.data()+at,data,size);
+  }
+
+uint8_t* CacheFile::Writer::block(size_t size) {
+  const size_t at = (img.size()+Alignment-1)/Alignment*Alignment;
+  img.resize(at+size);
+  return img.data()+at;
+  }
+
+void CacheFile::Writer::put(const std::string& s) {
+  put(uint64_t(s.size()));
+  write(s.data(),s.size());
+  }
+
+bool CacheFile::Reader::read(void* data, size_t size) {
+  if(!ok || size>img.size()-at)
+    return fail();
+  if(size>0)
+    std::memcpy(data,img.data()+at,size);
+  at += size;
+  return true;
+  }
+
+uint8_t* CacheFile::Reader::block(size_t size) {
+  const size_t begin = (at+Alignment-1)/Alignment*Alignment;
+  if(!ok || begin>img.size() || size>img.size()-begin) {
+    fail();
+    return nullptr;
+    }
+  at = begin+size;
+  return img.data()+begin;
+  }
+
+bool CacheFile::Reader::get(std::string& s) {
+  uint64_t sz = 0;
+  if(!get(sz) || sz>img.size()-at)
+    return fail();
+  s.assign(reinterpret_cast<const char*>(img.data()+at),size_t(sz));
+  at += size_t(sz);
+  return true;
+  }
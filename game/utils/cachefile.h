@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Persistent cache of precomputed data, stored in 'cache' folder next to save-games.
+// Entries are validated by key (hash of source data) and checksum; any mismatch is a miss.
+namespace CacheFile {
+  uint64_t             hash (const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull);
+  std::vector<uint8_t> read (std::string_view name, uint64_t key);
+  bool                 write(std::string_view name, uint64_t key, const void* data, size_t size);
+
+  // Sequential binary image. Arrays and blocks are aligned, so reader can use them in-place.
+  enum { Alignment = 16 };
+
+  class Writer final {
+    public:
+      void     write(const void* data, size_t size);
+      // aligned block of given size; pointer is valid until next write
+      uint8_t* block(size_t size);
+
+      template<class T>
+      void put(const T& v) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write(&v,sizeof(v));
+        }
+      void put(const std::string& s);
+      // elements are stored as raw bytes
+      template<class T>
+      void put(const std::vector<T>& v) {
+        static_assert(std::is_standard_layout_v<T> && std::is_trivially_destructible_v<T>);
+        put(uint64_t(v.size()));
+        uint8_t* d = block(v.size()*sizeof(T));
+        if(!v.empty())
+          std::memcpy(d,v.data(),v.size()*sizeof(T));
+        }
+
+      const std::vector<uint8_t>& data() const { return img; }
+
+    private:
+      std::vector<uint8_t> img;
+    };
+
+  // any get fails after first error
+  class Reader final {
+    public:
+      explicit Reader(std::vector<uint8_t>& data):img(data){}
+
+      bool     read(void* data, size_t size);
+      uint8_t* block(size_t size);
+
+      template<class T>
+      bool get(T& v) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return read(&v,sizeof(v));
+        }
+      bool get(std::string& s);
+      template<class T>
+      bool get(std::vector<T>& v) {
+        static_assert(std::is_standard_layout_v<T> && std::is_trivially_destructible_v<T>);
+        uint64_t sz = 0;
+        if(!get(sz) || sz>(img.size()-at)/sizeof(T))
+          return fail();
+        const uint8_t* d = block(size_t(sz)*sizeof(T));
+        if(d==nullptr)
+          return false;
+        v.resize(size_t(sz));
+        if(sz>0)
+          std::memcpy(static_cast<void*>(v.data()),d,size_t(sz)*sizeof(T));
+        return true;
+        }
+
+      bool isOk()  const { return ok; }
+      bool isEnd() const { return ok && at==img.size(); }
+
+    private:
+      bool fail() { ok = false; return false; }
+
+      std::vector<uint8_t>& img;
+      size_t                at = 0;
+      bool                  ok = true;
+    };
+  }
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Insert-only cache, for resources that live until shutdown.
+// Hits are lock-free: readers probe an open-addressing table, that is never modified in-place by growth.
+// Misses are single-flight: first thread creates the value, other threads asking for same key wait for it.
+template<class K, class V, class Hash = std::hash<K>>
+class ConcurrentCache {
+  public:
+    ConcurrentCache() = default;
+    ConcurrentCache(const ConcurrentCache&) = delete;
+    ConcurrentCache& operator = (const ConcurrentCache&) = delete;
+
+    // create: () -> std::unique_ptr<V>; nullptr result is cached as well
+    template<class Q, class F>
+    V* get(const Q& key, const F& create) {
+      const size_t h = mix(Hash()(key));
+      Shard&       s = shard[h%ShardCount];
+
+      Node* n = lookup(s.table.load(std::memory_order_acquire),key,h);
+      if(n!=nullptr && n->state.load(std::memory_order_acquire)==S_Ready)
+        return n->value.get();
+
+      {
+        std::unique_lock<std::mutex> lck(s.sync);
+        if(n==nullptr)
+          n = insert(s,key,h);
+        while(true) {
+          const State st = n->state.load(std::memory_order_relaxed);
+          if(st==S_Ready)
+            return n->value.get();
+          if(st==S_Empty) {
+            n->state.store(S_Loading,std::memory_order_relaxed);
+            n->owner = std::this_thread::get_id();
+            break;
+            }
+          if(n->owner==std::this_thread::get_id())
+            return nullptr; // recursive request for a resource, that is being created right now
+          s.ready.wait(lck);
+          }
+      }
+
+      std::unique_ptr<V> v;
+      try {
+        v = create();
+        }
+      catch(...) {
+        {
+          std::lock_guard<std::mutex> lck(s.sync);
+          n->owner = std::thread::id();
+          n->state.store(S_Empty,std::memory_order_relaxed);
+        }
+        s.ready.notify_all();
+        throw;
+        }
+
+      V* ret = v.get();
+      {
+        std::lock_guard<std::mutex> lck(s.sync);
+        n->value = std::move(v);
+        n->owner = std::thread::id();
+        n->state.store(S_Ready,std::memory_order_release);
+      }
+      s.ready.notify_all();
+      return ret;
+      }
+
+  private:
+    enum State : uint8_t {
+      S_Empty,
+      S_Loading,
+      S_Ready,
+      };
+
+    struct Node {
+      template<class Q>
+      Node(const Q& k, size_t h):key(k),hash(h){}
+      const K             key;
+      const size_t        hash;
+      std::atomic<State>  state{S_Empty};
+      std::thread::id     owner;
+      std::unique_ptr<V>  value;
+      };
+
+    struct Table {
+      explicit Table(size_t sz):size(sz),slot(new std::atomic<Node*>[sz]) {
+        for(size_t i=0; i<sz; ++i)
+          slot[i].store(nullptr,std::memory_order_relaxed);
+        }
+      const size_t                          size;
+      std::unique_ptr<std::atomic<Node*>[]> slot;
+      };
+
+    struct alignas(64) Shard {
+      std::atomic<Table*>                 table{nullptr};
+      std::mutex                          sync;
+      std::condition_variable             ready;
+      std::vector<std::unique_ptr<Node>>  nodes;
+      // old tables are retired, not deleted: lock-free readers may still probe them
+      std::vector<std::unique_ptr<Table>> tables;
+      };
+
+    enum { ShardCount = 16 };
+
+    static size_t mix(size_t h) {
+      // pointer-based hashes have zero low bits
+      uint64_t x = h;
+      x ^= x >> 33;
+      x *= 0xff51afd7ed558ccdull;
+      x ^= x >> 33;
+      return size_t(x);
+      }
+
+    template<class Q>
+    static Node* lookup(const Table* t, const Q& key, size_t h) {
+      if(t==nullptr)
+        return nullptr;
+      const size_t mask = t->size-1;
+      for(size_t i=(h/ShardCount)&mask; ; i=(i+1)&mask) {
+        Node* n = t->slot[i].load(std::memory_order_acquire);
+        if(n==nullptr)
+          return nullptr;
+        if(n->hash==h && n->key==key)
+          return n;
+        }
+      }
+
+    static void place(Table& t, Node* n) {
+      const size_t mask = t.size-1;
+      for(size_t i=(n->hash/ShardCount)&mask; ; i=(i+1)&mask) {
+        if(t.slot[i].load(std::memory_order_relaxed)==nullptr) {
+          t.slot[i].store(n,std::memory_order_release);
+          return;
+          }
+        }
+      }
+
+    template<class Q>
+    Node* insert(Shard& s, const Q& key, size_t h) {
+      Table* t = s.table.load(std::memory_order_relaxed);
+      if(Node* n = lookup(t,key,h))
+        return n;
+
+      if(t==nullptr || 2*(s.nodes.size()+1)>t->size) {
+        // keep load factor below 1/2
+        auto next = std::make_unique<Table>(t==nullptr ? 16 : t->size*2);
+        for(auto& i:s.nodes)
+          place(*next,i.get());
+        t = next.get();
+        s.tables.push_back(std::move(next));
+        s.table.store(t,std::memory_order_release);
+        }
+
+      s.nodes.emplace_back(std::make_unique<Node>(key,h));
+      Node* n = s.nodes.back().get();
+      place(*t,n);
+      return n;
+      }
+
+    Shard shard[ShardCount];
+  };
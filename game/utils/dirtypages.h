@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+// Change tracking of an array, that has Frames gpu copies (one per frame in flight).
+// Granularity is a page of PageSize elements. mark() may be called from any thread;
+// collect() and runs() are called by the owner of copies, one thread at a time.
+template<size_t PageSize, size_t Frames>
+class DirtyPages final {
+  public:
+    // grows only; new pages are clean
+    void resize(size_t elements) {
+      const size_t words = (elements+PageSize*64-1)/(PageSize*64);
+      if(words<=durty.size())
+        return;
+      std::vector<std::atomic<uint64_t>> d(words);
+      for(size_t i=0; i<durty.size(); ++i)
+        d[i].store(durty[i].load());
+      durty.swap(d);
+      for(auto& p:pending)
+        p.resize(words,0);
+      }
+
+    void mark(size_t begin, size_t size) {
+      if(size==0)
+        return;
+      const size_t b = begin/PageSize;
+      const size_t e = (begin+size-1)/PageSize;
+      for(size_t i=b; i<=e; ) {
+        // all bits of this word in [i, e]
+        const size_t   bit  = i%64;
+        const size_t   cnt  = std::min<size_t>(64-bit, e-i+1);
+        const uint64_t mask = (cnt==64 ? ~uint64_t(0) : ((uint64_t(1) << cnt) - 1)) << bit;
+        durty[i/64].fetch_or(mask);
+        i += cnt;
+        }
+      }
+
+    // distributes pages, marked since last call, to every frame
+    void collect() {
+      for(size_t i=0; i<durty.size(); ++i) {
+        const uint64_t bits = durty[i].exchange(0);
+        if(bits==0)
+          continue;
+        for(auto& p:pending)
+          p[i] |= bits;
+        }
+      }
+
+    // copy of frame is fully up to date
+    void clear(size_t fId) {
+      std::fill(pending[fId].begin(),pending[fId].end(),0);
+      }
+
+    // fn(begin,end): dirty elements of frame fId, clamped to size; runs closer than gap pages are merged.
+    // Frame is clean afterwards
+    template<class F>
+    void runs(size_t fId, size_t size, size_t gap, const F& fn) {
+      auto&  p        = pending[fId];
+      size_t runBegin = 0, runEnd = 0;
+      auto   flush    = [&]() {
+        const size_t begin = runBegin*PageSize;
+        const size_t end   = std::min(runEnd*PageSize, size);
+        if(begin<end)
+          fn(begin,end);
+        };
+      for(size_t i=0; i<p.size(); ++i) {
+        uint64_t bits = p[i];
+        p[i] = 0;
+        while(bits!=0) {
+          const size_t page = i*64 + size_t(std::countr_zero(bits));
+          bits &= bits-1;
+          if(runEnd>runBegin && page<=runEnd+gap) {
+            runEnd = page+1;
+            continue;
+            }
+          flush();
+          runBegin = page;
+          runEnd   = page+1;
+          }
+        }
+      flush();
+      }
+
+  private:
+    // bit per page: written by mark from any thread, collected by collect
+    std::vector<std::atomic<uint64_t>> durty;
+    // pages, not yet copied to frame
+    std::vector<uint64_t>              pending[Frames];
+  };
@@ -39,20 +39,126 @@ void Workers::setThreadName(const char* threadName) { (void)threadName; }
 
 using namespace Tempest;
 
+thread_local Workers::Queue* Workers::selfQueue = nullptr;
+static std::atomic<uint32_t> poolSize{0};
+
+uint64_t Workers::Event::prepare() {
+  sleepers.fetch_add(1);
+  return epoch.load();
+  }
+
+void Workers::Event::cancel() {
+  sleepers.fetch_sub(1);
+  }
+
+void Workers::Event::wait(uint64_t key) {
+  {
+  std::unique_lock<std::mutex> lck(sync);
+  while(epoch.load()==key)
+    cv.wait(lck);
+  }
+  sleepers.fetch_sub(1);
+  }
+
+void Workers::Event::notify(bool all) {
+  epoch.fetch_add(1);
+  if(sleepers.load()==0)
+    return;
+  {
+  // waiter is either inside of cv.wait, or didn't check epoch yet
+  std::lock_guard<std::mutex> lck(sync);
+  }
+  if(all)
+    cv.notify_all(); else
+    cv.notify_one();
+  }
+
+Workers::Group::~Group() {
+  join();
+  }
+
+bool Workers::Group::isDone() const {
+  // busy: some thread is still in finish(), touching this group
+  return pending.load()==0 && busy.load()==0;
+  }
+
+void Workers::Group::wait() {
+  join();
+  if(error!=nullptr) {
+    auto e = std::move(error);
+    error = nullptr;
+    std::rethrow_exception(e);
+    }
+  }
+
+void Workers::Group::join() {
+  auto& w = inst();
+  while(!isDone()) {
+    if(auto t = w.findWork(this)) {
+      w.exec(t);
+      continue;
+      }
+    const uint64_t key = w.waiterEvt.prepare();
+    if(isDone()) {
+      w.waiterEvt.cancel();
+      break;
+      }
+    if(auto t = w.findWork(this)) {
+      w.waiterEvt.cancel();
+      w.exec(t);
+      continue;
+      }
+    w.waiterEvt.wait(key);
+    }
+  }
+
+void Workers::Group::finish() {
+  busy.fetch_add(1);
+  const bool done = (pending.fetch_sub(1)==1);
+  if(done) {
+    std::vector<Task*> ready;
+    {
+      std::lock_guard<std::mutex> lck(sync);
+      if(pending.load()==0)
+        ready.swap(next);
+    }
+    for(auto t:ready)
+      inst().push(t,1);
+    }
+  busy.fetch_sub(1);
+  // 'this' may be gone from here
+  if(done)
+    inst().waiterEvt.notify(true);
+  }
+
+void Workers::Group::addDependent(Task* t) {
+  {
+    std::lock_guard<std::mutex> lck(sync);
+    if(pending.load()!=0) {
+      next.push_back(t);
+      return;
+      }
+  }
+  inst().push(t,1);
+  }
+
 Workers::Workers() {
-  size_t id=0;
-  for(auto& i:th) {
-    i = std::thread([this,id]() noexcept {
+  const uint32_t sz  = poolSize.load();
+  const size_t   cnt = (sz>0 ? sz : std::max(2u,std::thread::hardware_concurrency()))-1;
+  queues.resize(cnt);
+  for(auto& i:queues)
+    i = std::make_unique<Queue>();
+  th.resize(cnt);
+  for(size_t id=0; id<cnt; ++id) {
+    th[id] = std::thread([this,id]() noexcept {
       threadFunc(id);
       });
-    ++id;
     }
   }
 
 Workers::~Workers() {
-  running   = false;
-  workTasks = MAX_THREADS;
-  execWork();
+  running.store(false);
+  workerEvt.notify(true);
   for(auto& i:th)
     i.join();
   }
@@ -62,52 +168,114 @@ Workers &Workers::inst() {
   return w;
   }
 
+uint32_t Workers::maxThreads() {
+  return uint32_t(inst().th.size()+1);
+  }
+
+void Workers::setMaxThreads(uint32_t count) {
+  poolSize.store(count);
+  }
+
 void Workers::threadFunc(size_t id) {
   {
   string_frm tname("Workers [",int(id),"]");
   setThreadName(tname.c_str());
   }
+  selfQueue = queues[id].get();
 
   while(true) {
-    {
-    std::unique_lock<std::mutex> lck(sync);
-    while(!workInc[id])
-      workWait.wait(lck);
-    workInc[id]=false;
-    }
-
-    if(!running) {
-      workDone.fetch_add(1);
+    if(auto t = findWork(nullptr)) {
+      exec(t);
+      continue;
+      }
+    const uint64_t key = workerEvt.prepare();
+    if(!running.load()) {
+      workerEvt.cancel();
       return;
       }
-
-    size_t b = std::min((id  )*batchSize, workSize);
-    size_t e = std::min((id+1)*batchSize, workSize);
-    // Log::d("worker: id = ",id," [",b, ", ",e,"]");
-
-    if(b!=e) {
-      void* d = workSet + b*workEltSize;
-      workFunc(d,e-b);
+    if(auto t = findWork(nullptr)) {
+      workerEvt.cancel();
+      exec(t);
+      continue;
       }
-
-    if(size_t(workDone.fetch_add(1)+1)==workTasks)
-      std::this_thread::yield();
+    workerEvt.wait(key);
     }
   }
 
-void Workers::execWork() {
+void Workers::push(Task* t, size_t count) {
+  Queue& q = selfQueue!=nullptr ? *selfQueue : shared;
   {
-    std::unique_lock<std::mutex> lck(sync);
-    for(size_t i=0; i<workTasks; ++i)
-      workInc[i]=true;
-    workWait.notify_all();
+    std::lock_guard<std::mutex> lck(q.sync);
+    for(size_t i=0; i<count; ++i)
+      q.tasks.push_back(t);
+    q.size.store(q.tasks.size());
+  }
+  workerEvt.notify(count>1);
   }
-  std::this_thread::yield();
 
-  while(true) {
-    int expect = int(workTasks);
-    if(workDone.compare_exchange_strong(expect,0,std::memory_order::acq_rel))
+Workers::Task* Workers::findWork(Group* g) {
+  if(selfQueue!=nullptr) {
+    if(auto t = take(*selfQueue,g,true))
+      return t;
+    }
+  if(auto t = take(shared,g,false))
+    return t;
+
+  const size_t cnt = queues.size();
+  const size_t off = std::hash<std::thread::id>()(std::this_thread::get_id());
+  for(size_t i=0; i<cnt; ++i) {
+    auto& q = *queues[(i+off)%cnt];
+    if(&q==selfQueue)
+      continue;
+    if(auto t = take(q,g,false))
+      return t;
+    }
+  return nullptr;
+  }
+
+Workers::Task* Workers::take(Queue& q, Group* g, bool back) {
+  if(q.size.load(std::memory_order_relaxed)==0)
+    return nullptr;
+  std::lock_guard<std::mutex> lck(q.sync);
+  auto& tasks = q.tasks;
+  Task* ret   = nullptr;
+  if(tasks.empty()) {
+    return nullptr;
+    }
+  else if(g==nullptr) {
+    if(back) {
+      ret = tasks.back();
+      tasks.pop_back();
+      } else {
+      ret = tasks.front();
+      tasks.pop_front();
+      }
+    }
+  else {
+    for(size_t i=0; i<tasks.size(); ++i) {
+      const size_t id = back ? tasks.size()-i-1 : i;
+      if(tasks[id]->group!=g)
+        continue;
+      ret = tasks[id];
+      tasks.erase(tasks.begin()+ptrdiff_t(id));
       break;
-    std::this_thread::yield();
+      }
+    }
+  q.size.store(tasks.size());
+  return ret;
+  }
+
+void Workers::exec(Task* t) {
+  Group* g = t->group;
+  try {
+    t->exec();
+    }
+  catch(...) {
+    std::lock_guard<std::mutex> lck(g->sync);
+    if(g->error==nullptr)
+      g->error = std::current_exception();
     }
+  if(t->owned)
+    delete t;
+  g->finish();
   }
@@ -3,27 +3,68 @@
 #include <thread>
 #include <mutex>
 #include <vector>
+#include <deque>
+#include <memory>
 #include <functional>
 #include <atomic>
 #include <algorithm>
 #include <condition_variable>
+#include <exception>
 #include <new>
 
+// Work-stealing task scheduler.
+// Every worker owns a deque: it pops own tasks LIFO and steals from others FIFO.
+// Tasks from non-worker threads go through a shared queue.
 class Workers final {
+  private:
+    struct Task;
+
   public:
     Workers();
     ~Workers();
 
+    // Set of tasks to join on. Waiting thread helps, but only with tasks of this group,
+    // so it never runs unrelated work (and takes its locks) on the caller stack.
+    class Group final {
+      public:
+        Group() = default;
+        Group(const Group&) = delete;
+        Group& operator = (const Group&) = delete;
+        ~Group();
+
+        template<class F>
+        void run(F&& f);
+        // continuation: f starts after all tasks, spawned in dep so far, are complete
+        template<class F>
+        void runAfter(Group& dep, F&& f);
+        // rethrows first exception, thrown by a task
+        void wait();
+
+      private:
+        bool isDone() const;
+        void join();
+        void finish();
+        void addDependent(Task* t);
+
+        std::atomic<size_t>   pending{0};
+        std::atomic<uint32_t> busy{0};
+        std::mutex            sync;
+        std::vector<Task*>    next;
+        std::exception_ptr    error;
+
+      friend class Workers;
+      };
+
     static void setThreadName(const char* threadName);
 
     template<class T,class F>
     static void parallelFor(T* b, T* e, const F& func) {
-      inst().runParallelFor(b,std::distance(b,e),std::thread::hardware_concurrency(),func);
+      inst().runParallelFor(b,size_t(std::distance(b,e)),maxThreads(),func);
       }
 
     template<class T,class F>
     static void parallelFor(std::vector<T>& data, const F& func) {
-      inst().runParallelFor(data.data(),data.size(),std::thread::hardware_concurrency(),func);
+      inst().runParallelFor(data.data(),data.size(),maxThreads(),func);
       }
 
     template<class T,class F>
@@ -33,100 +74,140 @@ class Workers final {
 
     template<class T,class F>
     static void parallelTasks(std::vector<T>& data, const F& func) {
-      inst().runParallelFor2(data.data(),data.size(),std::thread::hardware_concurrency(),func);
+      inst().runParallelFor2(data.data(),data.size(),maxThreads(),func);
       }
 
     template<class F>
     static void parallelTasks(size_t taskCount, const F& func) {
-      inst().runParallelTasks<F>(taskCount,func);
+      inst().runChunks(taskCount,[&func](size_t id) {
+        func(uintptr_t(id));
+        });
       }
 
-    static uint8_t maxThreads() {
-      uint32_t th = std::thread::hardware_concurrency();
-      if(th>MAX_THREADS)
-        return MAX_THREADS;
-      return uint8_t(th);
-      }
+    // worker threads + calling thread
+    static uint32_t maxThreads();
+    // pool size (worker threads + calling thread), 0 - by hardware concurrency; takes effect only before first use
+    static void     setMaxThreads(uint32_t count);
 
   private:
-    enum { MAX_THREADS=16 };
+    struct Task {
+      virtual ~Task() = default;
+      virtual void exec() = 0;
+      Group* group = nullptr;
+      bool   owned = false; // heap allocated, deleted after exec
+      };
+
+    template<class F>
+    struct FnTask final : Task {
+      explicit FnTask(F&& f):fn(std::forward<F>(f)){}
+      void exec() override { fn(); }
+      std::decay_t<F> fn;
+      };
+
+    // one task object, pushed once per chunk
+    template<class F>
+    struct ChunkTask final : Task {
+      explicit ChunkTask(const F& f):fn(f){}
+      void exec() override { fn(next.fetch_add(1)); }
+      const F&            fn;
+      std::atomic<size_t> next{0};
+      };
+
+    struct alignas(64) Queue {
+      std::mutex          sync;
+      std::deque<Task*>   tasks;
+      std::atomic<size_t> size{0};
+      };
+
+    struct Event {
+      std::mutex              sync;
+      std::condition_variable cv;
+      std::atomic<uint64_t>   epoch{0};
+      std::atomic<uint32_t>   sleepers{0};
+
+      uint64_t prepare();
+      void     cancel();
+      void     wait(uint64_t key);
+      void     notify(bool all);
+      };
 
-    void threadFunc(size_t id);
-    void execWork();
     static Workers& inst();
+    static thread_local Queue* selfQueue; // nullptr for non-worker threads
+
+    void  threadFunc(size_t id);
+    void  push(Task* t, size_t count);
+    Task* findWork(Group* g);
+    Task* take(Queue& q, Group* g, bool back);
+    void  exec(Task* t);
+
+    template<class F>
+    void runChunks(size_t count, const F& fn) {
+      if(count==0)
+        return;
+      if(count==1) {
+        fn(size_t(0));
+        return;
+        }
+      Group        g;
+      ChunkTask<F> t(fn);
+      t.group = &g;
+      g.pending.fetch_add(count);
+      push(&t,count);
+      g.wait();
+      }
 
     template<class T,class F>
     void runParallelFor(T* data, size_t sz, size_t maxTh, const F& func) {
-      workSet     = reinterpret_cast<uint8_t*>(data);
-      workSize    = sz;
-      workEltSize = sizeof(T);
-
-      workFunc = [&func](void* data,size_t sz) {
-        T* tdata = reinterpret_cast<T*>(data);
-        for(size_t i=0;i<sz;++i)
-          func(tdata[i]);
-        };
-
-      if(maxTh>MAX_THREADS)
-        workTasks = MAX_THREADS; else
-        workTasks = maxTh;
-
-      batchSize = std::max<size_t>(16,(sz+workTasks-1)/workTasks);
-      execWork();
+      const size_t tasks = std::max<size_t>(1,std::min<size_t>(maxTh,maxThreads()));
+      const size_t batch = std::max<size_t>(16,(sz+tasks-1)/tasks);
+      runChunks((sz+batch-1)/batch,[data,sz,batch,&func](size_t id) {
+        const size_t e = std::min(sz,(id+1)*batch);
+        for(size_t i=id*batch; i<e; ++i)
+          func(data[i]);
+        });
       }
 
     template<class T,class F>
     void runParallelFor2(T* data, size_t sz, size_t maxTh, const F& func) {
-      workTasks   = std::min<size_t>(MAX_THREADS, sz);
-      workTasks   = std::min<size_t>(workTasks,  maxTh);
-      workSize    = workTasks;
-      batchSize   = 1;
-      workEltSize = 0;
-
-      workSet     = reinterpret_cast<uint8_t*>(data);
-      taskDone.store(0);
-      workFunc = [this, &func, sz](void* data, size_t /*sz*/) {
-        T* tdata = reinterpret_cast<T*>(data);
+      const size_t tasks = std::min(std::min<size_t>(maxThreads(),sz),maxTh);
+      std::atomic<size_t> taskDone{0};
+      runChunks(tasks,[data,sz,&func,&taskDone](size_t) {
         const size_t increment = (64+sizeof(T)-1)/sizeof(T);
         while(true) {
-          size_t id = size_t(taskDone.fetch_add(increment));
+          size_t id = taskDone.fetch_add(increment);
           for(size_t i=0;i<increment;++i) {
             if(id+i<sz)
-              func(tdata[id+i]);
+              func(data[id+i]);
             }
-
           if(id+increment>=sz)
             break;
           }
-        };
-      execWork();
+        });
       }
 
-    template<class F>
-    void runParallelTasks(size_t taskCount, const F& func) {
-      workTasks   = taskCount;
-      workSize    = taskCount;
-      batchSize   = 1;
-      workSet     = nullptr;
-      workEltSize = 1;
-      workFunc = [&func](void* data, size_t sz) {
-        func(reinterpret_cast<uintptr_t>(data));
-        };
-      execWork();
-      }
+    std::vector<std::thread>            th;
+    std::vector<std::unique_ptr<Queue>> queues;
+    Queue                               shared;
+    std::atomic_bool                    running{true};
 
-    std::thread                       th     [MAX_THREADS];
-    bool                              workInc[MAX_THREADS] = {};
-
-    bool                              running=true;
-
-    uint8_t*                          workSet=nullptr;
-    size_t                            workSize=0, batchSize=0, workEltSize=0;
-    size_t                            workTasks=0;
-    std::function<void(void*,size_t)> workFunc;
-
-    std::mutex                        sync;
-    std::condition_variable           workWait;
-    std::atomic_int                   workDone{0};
-    std::atomic_int                   taskDone{0};
+    Event                               workerEvt; // new tasks
+    Event                               waiterEvt; // group complete
   };
+
+template<class F>
+void Workers::Group::run(F&& f) {
+  auto t = new FnTask<F>(std::forward<F>(f));
+  t->group = this;
+  t->owned = true;
+  pending.fetch_add(1);
+  inst().push(t,1);
+  }
+
+template<class F>
+void Workers::Group::runAfter(Group& dep, F&& f) {
+  auto t = new FnTask<F>(std::forward<F>(f));
+  t->group = this;
+  t->owned = true;
+  pending.fetch_add(1);
+  dep.addDependent(t);
+  }
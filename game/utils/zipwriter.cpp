@@ -0,0 +1,91 @@
+#include "zipwriter.h"
+
+#include <miniz.h>
+
+#include "utils/workers.h"
+
+namespace {
+
+struct Packed {
+  void*    data = nullptr;
+  size_t   size = 0;
+  uint32_t crc  = 0;
+  };
+
+struct Output {
+  mz_zip_archive    impl   = {};
+  Tempest::ODevice* fout   = nullptr;
+  uint64_t          offset = 0;
+  };
+
+size_t writeFunc(void* pOpaque, uint64_t file_ofs, const void* pBuf, size_t n) {
+  auto& self = *reinterpret_cast<Output*>(pOpaque);
+  file_ofs += mz_zip_get_archive_file_start_offset(&self.impl);
+  if(file_ofs!=self.offset) {
+    self.impl.m_last_error = MZ_ZIP_FILE_SEEK_FAILED;
+    return 0;
+    }
+  size_t ret = self.fout->write(pBuf,n);
+  self.offset+=ret;
+  return ret;
+  }
+
+void compress(const std::vector<ZipWriter::Entry>& entries, std::vector<Packed>& packed, int compression) {
+  packed.resize(entries.size());
+  if(compression<=0)
+    return;
+
+  std::vector<size_t> work;
+  for(size_t i=0; i<entries.size(); ++i)
+    if(entries[i].data.size()>256)
+      work.push_back(i);
+
+  // large entries (world, npc's) are deflated in parallel
+  const int flags = int(tdefl_create_comp_flags_from_zip_params(compression, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY));
+  Workers::parallelTasks(work.size(),[&](uintptr_t id) {
+    auto& e = entries[work[id]];
+    auto& p = packed [work[id]];
+    p.crc  = uint32_t(mz_crc32(MZ_CRC32_INIT, e.data.data(), e.data.size()));
+    p.data = tdefl_compress_mem_to_heap(e.data.data(), e.data.size(), &p.size, flags);
+    });
+  }
+
+}
+
+bool ZipWriter::write(Tempest::ODevice& fout, const std::vector<Entry>& entries, int compression) noexcept {
+  std::vector<Packed> packed;
+  try {
+    compress(entries,packed,compression);
+    }
+  catch(...) {
+    for(auto& p:packed)
+      mz_free(p.data);
+    return false;
+    }
+
+  Output out;
+  out.fout                = &fout;
+  out.impl.m_pWrite       = writeFunc;
+  out.impl.m_pIO_opaque   = &out;
+  out.impl.m_zip_type     = MZ_ZIP_TYPE_USER;
+  mz_bool status = mz_zip_writer_init_v2(&out.impl, 0, 0);
+
+  // entries are assembled in order of creation
+  for(size_t i=0; i<entries.size() && status; ++i) {
+    auto& e = entries[i];
+    auto& p = packed[i];
+    if(p.data!=nullptr) {
+      const mz_uint flg = mz_uint(compression) | MZ_ZIP_FLAG_COMPRESSED_DATA;
+      status = mz_zip_writer_add_mem_ex(&out.impl, e.name.c_str(), p.data, p.size, nullptr, 0, flg, e.data.size(), p.crc);
+      } else {
+      status = mz_zip_writer_add_mem(&out.impl, e.name.c_str(), e.data.data(), e.data.size(), MZ_NO_COMPRESSION);
+      }
+    }
+  if(status)
+    status = mz_zip_writer_finalize_archive(&out.impl);
+  mz_zip_writer_end(&out.impl);
+
+  for(auto& p:packed)
+    mz_free(p.data);
+  return status!=0;
+  }
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <Tempest/ODevice>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Writes zip archive: entries are deflated in parallel on Workers, then assembled in order
+class ZipWriter final {
+  public:
+    struct Entry {
+      std::string          name;
+      std::vector<uint8_t> data;
+      };
+
+    // compression: 0 - store, 1..10 - deflate level
+    static bool write(Tempest::ODevice& fout, const std::vector<Entry>& entries, int compression) noexcept;
+  };
@@ -0,0 +1,24 @@
+#include "ailod.h"
+
+AiLod::Tick AiLod::schedule(Tier tier, uint64_t frame, size_t slot) const {
+  if(!enabled)
+    return T_Full;
+
+  uint32_t period = 1;
+  switch(tier) {
+    case Near:
+      break;
+    case Far:
+      period = farPeriod;
+      break;
+    case Far2:
+      period = far2Period;
+      break;
+    }
+
+  if((frame+slot)%period!=0)
+    return T_Skip;
+  if(far2RoutineOnly && tier==Far2)
+    return T_RoutineOnly;
+  return T_Full;
+  }
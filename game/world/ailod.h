@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Level-of-detail ticking of npc AI: far npcs are ticked every n-th frame.
+// Npcs are spread evenly across frames by their slot; skipped time is accumulated by npc.
+class AiLod final {
+  public:
+    enum Tier : uint8_t {
+      Near,
+      Far,
+      Far2,
+      };
+
+    enum Tick : uint8_t {
+      T_Full,
+      T_Skip,
+      T_RoutineOnly,
+      };
+
+    bool     enabled         = false;
+    uint32_t farPeriod       = 1;
+    uint32_t far2Period      = 1;
+    bool     far2RoutineOnly = false;
+
+    Tick     schedule(Tier tier, uint64_t frame, size_t slot) const;
+  };
@@ -0,0 +1,62 @@
+#include "bspindex.h"
+
+void BspIndex::build(const std::vector<phoenix::bsp_node>&   nodes,
+                     const std::vector<phoenix::bsp_sector>& sectors,
+                     const std::vector<uint64_t>&            leafs) {
+  static const uint32_t ambiguous = uint32_t(-2);
+
+  nodeSector.assign(nodes.size(),NoSector);
+  sectorCount = uint32_t(sectors.size());
+  sectorByName.clear();
+  sectorByName.reserve(sectors.size());
+
+  for(size_t i=0; i<sectors.size(); ++i) {
+    auto& s = sectors[i];
+    sectorByName.emplace(s.name,uint32_t(i));
+    for(auto r:s.node_indices) {
+      if(r>=leafs.size())
+        continue;
+      size_t idx = size_t(leafs[r]);
+      if(idx>=nodes.size())
+        continue;
+      // leaf, that belongs to more than one sector, has no room
+      auto& sec = nodeSector[idx];
+      sec = (sec==NoSector) ? uint32_t(i) : ambiguous;
+      }
+    }
+  }
+
+size_t BspIndex::leafAt(const std::vector<phoenix::bsp_node>& nodes, const Tempest::Vec3& p) {
+  if(nodes.empty())
+    return nodes.size();
+
+  const auto* node=&nodes[0];
+  while(true) {
+    const auto v    = node->plane;
+    float      sgn  = v.x*p.x + v.y*p.y + v.z*p.z - v.w;
+    uint32_t   next = (sgn>0) ? uint32_t(node->front_index) : uint32_t(node->back_index);
+    if(next>=nodes.size())
+      break;
+    node = &nodes[next];
+    }
+
+  if(node->bbox.min.x <= p.x && p.x <node->bbox.max.x &&
+     node->bbox.min.y <= p.y && p.y <node->bbox.max.y &&
+     node->bbox.min.z <= p.z && p.z <node->bbox.max.z) {
+    return size_t(node-nodes.data());
+    }
+  return nodes.size();
+  }
+
+uint32_t BspIndex::sectorOf(size_t node) const {
+  if(node<nodeSector.size() && nodeSector[node]<sectorCount)
+    return nodeSector[node];
+  return NoSector;
+  }
+
+uint32_t BspIndex::findSector(std::string_view name) const {
+  auto it = sectorByName.find(name);
+  if(it==sectorByName.end())
+    return NoSector;
+  return it->second;
+  }
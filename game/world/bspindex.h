@@ -0,0 +1,33 @@
+#pragma once
+
+#include <Tempest/Vec>
+
+#include <phoenix/world.hh>
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Lookup tables over world bsp-tree: leaf-node -> sector and sector-name -> sector.
+// Sector names are referenced, so sectors must outlive the index.
+class BspIndex final {
+  public:
+    static constexpr uint32_t NoSector = uint32_t(-1);
+
+    void     build(const std::vector<phoenix::bsp_node>&   nodes,
+                   const std::vector<phoenix::bsp_sector>& sectors,
+                   const std::vector<uint64_t>&            leafs);
+
+    // leaf-node, that contains p; nodes.size(), if none
+    static size_t leafAt(const std::vector<phoenix::bsp_node>& nodes, const Tempest::Vec3& p);
+
+    // NoSector, if node is not a leaf of exactly one sector
+    uint32_t sectorOf(size_t node) const;
+    uint32_t findSector(std::string_view name) const;
+
+  private:
+    std::vector<uint32_t>                         nodeSector;
+    uint32_t                                      sectorCount = 0;
+    std::unordered_map<std::string_view,uint32_t> sectorByName;
+  };
@@ -0,0 +1,50 @@
+#include "losbatch.h"
+
+#include <cstring>
+
+using namespace Tempest;
+
+void LosBatch::begin(uint64_t f) {
+  index.clear();
+  rays.clear();
+  state.clear();
+  frame = f;
+  }
+
+void LosBatch::request(const Vec3& from, const Vec3& to) {
+  auto ins = index.emplace(key(from,to),uint32_t(rays.size()));
+  if(!ins.second)
+    return;
+  rays.push_back({from,to});
+  state.push_back(S_Pending);
+  }
+
+void LosBatch::resolve(size_t id, bool clear) {
+  state[id] = clear ? S_Clear : S_Blocked;
+  }
+
+bool LosBatch::find(const Vec3& from, const Vec3& to, uint64_t f, bool& clear) const {
+  if(f!=frame)
+    return false;
+  auto it = index.find(key(from,to));
+  if(it==index.end() || state[it->second]==S_Pending)
+    return false;
+  clear = (state[it->second]==S_Clear);
+  return true;
+  }
+
+LosBatch::Key LosBatch::key(const Vec3& from, const Vec3& to) {
+  Key k;
+  const float v[6] = {from.x, from.y, from.z, to.x, to.y, to.z};
+  std::memcpy(k.v,v,sizeof(v));
+  return k;
+  }
+
+size_t LosBatch::Hash::operator()(const Key& k) const {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for(auto i:k.v) {
+    h ^= i;
+    h *= 0x100000001b3ull;
+    }
+  return size_t(h);
+  }
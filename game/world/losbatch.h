@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Tempest/Point>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Line-of-sight rays of sense phase, for one frame.
+// Perception requests rays first, they are cast as one batch and resolved; script dispatch
+// of same frame reads results by exact end-points. Any other ray is not found and is cast by caller.
+class LosBatch final {
+  public:
+    struct Ray final {
+      Tempest::Vec3 from, to;
+      };
+
+    // drops results of previous frame
+    void   begin(uint64_t frame);
+    // queues the ray, unless same ray is already queued
+    void   request(const Tempest::Vec3& from, const Tempest::Vec3& to);
+    const std::vector<Ray>& pending() const { return rays; }
+    void   resolve(size_t id, bool clear);
+
+    // false, if ray was not resolved on this frame
+    bool   find(const Tempest::Vec3& from, const Tempest::Vec3& to, uint64_t frame, bool& clear) const;
+
+  private:
+    enum State : uint8_t {
+      S_Pending,
+      S_Clear,
+      S_Blocked,
+      };
+
+    struct Key final {
+      uint32_t v[6] = {};
+      bool operator == (const Key& other) const = default;
+      };
+
+    struct Hash final {
+      size_t operator()(const Key& k) const;
+      };
+
+    static Key key(const Tempest::Vec3& from, const Tempest::Vec3& to);
+
+    std::unordered_map<Key,uint32_t,Hash> index;
+    std::vector<Ray>                      rays;
+    std::vector<State>                    state;
+    uint64_t                              frame = uint64_t(-1);
+  };
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Tempest/Point>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid over npc positions in xz-plane. Npc is relocated only, when it crosses cell border.
+// T is Npc in game; anything with position() works
+template<class T>
+class NpcGrid final {
+  public:
+    void clear() {
+      cells.clear();
+      where.clear();
+      }
+
+    void insert(T& npc) {
+      const uint64_t k = keyOf(npc.position());
+      auto ins = where.emplace(&npc,k);
+      if(!ins.second)
+        return;
+      cells[k].push_back(&npc);
+      }
+
+    void erase(const T& npc) {
+      auto w = where.find(&npc);
+      if(w==where.end())
+        return;
+      auto c = cells.find(w->second);
+      if(c!=cells.end()) {
+        auto& v = c->second;
+        for(size_t i=0; i<v.size(); ++i)
+          if(v[i]==&npc) {
+            v[i] = v.back();
+            v.pop_back();
+            break;
+            }
+        if(v.empty())
+          cells.erase(c);
+        }
+      where.erase(w);
+      }
+
+    void move(T& npc) {
+      auto w = where.find(&npc);
+      if(w==where.end())
+        return;
+      const uint64_t k = keyOf(npc.position());
+      if(w->second==k)
+        return;
+      erase(npc);
+      where.emplace(&npc,k);
+      cells[k].push_back(&npc);
+      }
+
+    bool   hasObject(const T& npc) const { return where.find(&npc)!=where.end(); }
+    size_t size() const { return where.size(); }
+
+    // npcs closer than R to p
+    template<class Func>
+    void find(const Tempest::Vec3& p, float R, const Func& f) const {
+      const float   qR = R*R;
+      const int32_t x0 = cellOf(p.x-R), x1 = cellOf(p.x+R);
+      const int32_t z0 = cellOf(p.z-R), z1 = cellOf(p.z+R);
+
+      auto test = [&](const std::vector<T*>& v) {
+        for(auto i:v)
+          if((i->position()-p).quadLength()<qR)
+            f(*i);
+        };
+
+      if(uint64_t(x1-x0+1)*uint64_t(z1-z0+1)>cells.size()) {
+        // radius is big, compared to populated area
+        for(auto& i:cells)
+          test(i.second);
+        return;
+        }
+      for(int32_t x=x0; x<=x1; ++x)
+        for(int32_t z=z0; z<=z1; ++z) {
+          auto i = cells.find(key(x,z));
+          if(i!=cells.end())
+            test(i->second);
+          }
+      }
+
+    static constexpr float cellSize = 2000;
+
+  private:
+    static int32_t cellOf(float v) {
+      return int32_t(std::floor(v/cellSize));
+      }
+
+    static uint64_t key(int32_t x, int32_t z) {
+      return (uint64_t(uint32_t(x)) << 32) | uint64_t(uint32_t(z));
+      }
+
+    static uint64_t keyOf(const Tempest::Vec3& p) {
+      return key(cellOf(p.x),cellOf(p.z));
+      }
+
+    std::unordered_map<uint64_t,std::vector<T*>> cells;
+    std::unordered_map<const T*,uint64_t>        where;
+  };
@@ -316,6 +316,7 @@ void Npc::saveAiState(Serialize& fout) const {
   for(auto& i:routines) {
     fout.write(i.start,i.end,i.callback,i.point);
     }
+  fout.write(skippedTime,routineOnlyPt);
   }
 
 void Npc::loadAiState(Serialize& fin) {
@@ -334,6 +335,8 @@ void Npc::loadAiState(Serialize& fin) {
   routines.resize(size);
   for(auto& i:routines)
     fin.read(i.start,i.end,i.callback,i.point);
+  if(fin.version()>45)
+    fin.read(skippedTime,routineOnlyPt);
   }
 
 void Npc::saveTrState(Serialize& fout) const {
@@ -360,6 +363,7 @@ bool Npc::setPosition(float ix, float iy, float iz) {
   z = iz;
   durtyTranform |= TR_Pos;
   physic.setPosition(Vec3{x,y,z});
+  owner.updateNpcIndex(*this);
   return true;
   }
 
@@ -372,6 +376,7 @@ void Npc::setViewPosition(const Tempest::Vec3& pos) {
   y = pos.y;
   z = pos.z;
   durtyTranform |= TR_Pos;
+  owner.updateNpcIndex(*this);
   }
 
 int Npc::aiOutputOrderId() const {
@@ -2014,6 +2019,9 @@ void Npc::tickAnimationTags() {
   }
 
 void Npc::tick(uint64_t dt) {
+  dt += skippedTime;
+  skippedTime = 0;
+
   tickAnimationTags();
 
   if(!visual.pose().hasAnim())
@@ -2071,6 +2079,31 @@ void Npc::tick(uint64_t dt) {
   implAiTick(dt);
   }
 
+void Npc::tickRoutineOnly(uint64_t dt, float hideDist) {
+  // walk between routine points is not visible far away from player: npc is moved to destination instead
+  auto& r = currentRoutine();
+  if(r.point==nullptr || r.point==routineOnlyPt || isDead() || isDown()) {
+    tick(dt);
+    return;
+    }
+
+  bool inRoutine = !aiState.funcIni.isValid();
+  for(auto& i:routines)
+    if(i.callback==aiState.funcIni)
+      inRoutine = true;
+
+  auto pl = owner.player();
+  if(!inRoutine || isTalk() || (pl!=nullptr && pl->qDistTo(r.point)<hideDist*hideDist)) {
+    tick(dt);
+    return;
+    }
+
+  routineOnlyPt = r.point;
+  if(qDistTo(r.point)>float(MAX_AI_USE_DISTANCE*MAX_AI_USE_DISTANCE))
+    resetPositionToTA();
+  tick(dt);
+  }
+
 void Npc::nextAiAction(AiQueue& queue, uint64_t dt) {
   if(queue.size()==0)
     return;
@@ -4058,7 +4091,6 @@ SensesBit Npc::canSenseNpc(const Npc &oth, bool freeLos, float extRange) const {
   }
 
 SensesBit Npc::canSenseNpc(float tx, float ty, float tz, bool freeLos, bool isNoisy, float extRange) const {
-  DynamicWorld* w = owner.physic();
   static const double ref = std::cos(100*M_PI/180.0); // spec requires +-100 view angle range
 
   const float range = float(hnpc->senses_range)+extRange;
@@ -4082,10 +4114,10 @@ SensesBit Npc::canSenseNpc(float tx, float ty, float tz, bool freeLos, bool isNo
     float dir = angleDir(dx,dz);
     float da  = float(M_PI)*(visual.viewDirection()-dir)/180.f;
     if(double(std::cos(da))<=ref)
-      if(!w->ray(head, Vec3(tx,ty,tz)).hasCol)
+      if(owner.lineOfSight(head, Vec3(tx,ty,tz)))
         ret = ret | SensesBit::SENSE_SEE;
     } else {
-    if(!w->ray(head, Vec3(tx,ty,tz)).hasCol)
+    if(owner.lineOfSight(head, Vec3(tx,ty,tz)))
       ret = ret | SensesBit::SENSE_SEE;
     }
   return ret & SensesBit(hnpc->senses);
@@ -110,6 +110,8 @@ class Npc final {
     void       setWalkMode(WalkBit m);
     auto       walkMode() const { return wlkMode; }
     void       tick(uint64_t dt);
+    void       skipTick(uint64_t dt) { skippedTime+=dt; }
+    void       tickRoutineOnly(uint64_t dt, float hideDist);
     void       tickAnimationTags();
     bool       startClimb(JumpStatus jump);
 
@@ -280,6 +282,7 @@ class Npc final {
     bool      perceptionProcess(Npc& pl, Npc *victum, float quadDist, PercType perc);
     bool      hasPerc(PercType perc) const;
     uint64_t  percNextTime() const;
+    uint64_t  percTime() const { return perceptionTime; }
 
     auto      interactive() const -> Interactive* { return currentInteract; }
     bool      setInteraction(Interactive* id, bool quick=false);
@@ -567,6 +570,8 @@ class Npc final {
 
     uint64_t                       aiOutputBarrier=0;
     ProcessPolicy                  aiPolicy=ProcessPolicy::AiNormal;
+    uint64_t                       skippedTime=0;       // time of frames, skipped by world scheduler
+    const WayPoint*                routineOnlyPt=nullptr;
     AiState                        aiState;
     ScriptFn                       aiPrevState;
     AiQueue                        aiQueue;
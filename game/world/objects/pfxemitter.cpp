@@ -29,6 +29,7 @@ PfxEmitter::PfxEmitter(PfxObjects& owner, const ParticleFx* decl) {
     return;
   std::lock_guard<std::recursive_mutex> guard(owner.sync);
   bucket = &owner.getBucket(*decl);
+  std::lock_guard<std::recursive_mutex> bguard(bucket->sync);
   id     = bucket->allocEmitter();
   if(decl->shpMesh!=nullptr && decl->shpMeshRender)
     shpMesh = owner.world.addView(decl->shpMesh_S,0,0,0);
@@ -42,18 +43,20 @@ PfxEmitter::PfxEmitter(World& world, const phoenix::vob& vob) {
       return;
     std::lock_guard<std::recursive_mutex> guard(owner.sync);
     bucket = &owner.getBucket(*decl);
+    std::lock_guard<std::recursive_mutex> bguard(bucket->sync);
     id     = bucket->allocEmitter();
     } else {
     Material mat(vob);
     std::lock_guard<std::recursive_mutex> guard(owner.sync);
     bucket = &owner.getBucket(mat,vob);
+    std::lock_guard<std::recursive_mutex> bguard(bucket->sync);
     id     = bucket->allocEmitter();
     }
   }
 
 PfxEmitter::~PfxEmitter() {
   if(bucket!=nullptr) {
-    std::lock_guard<std::recursive_mutex> guard(bucket->parent.sync);
+    std::scoped_lock guard(bucket->parent.sync,bucket->sync);
     bucket->freeEmitter(id);
     }
   }
@@ -77,7 +80,7 @@ void PfxEmitter::setPosition(float x, float y, float z) {
 void PfxEmitter::setPosition(const Vec3& pos) {
   if(bucket==nullptr)
     return;
-  std::lock_guard<std::recursive_mutex> guard(bucket->parent.sync);
+  std::scoped_lock guard(bucket->parent.sync,bucket->sync);
   auto& v = bucket->get(id);
   v.pos = pos;
   zone.setPosition(pos);
@@ -93,7 +96,7 @@ void PfxEmitter::setPosition(const Vec3& pos) {
 void PfxEmitter::setTarget(const Npc* tg) {
   if(bucket==nullptr)
     return;
-  std::lock_guard<std::recursive_mutex> guard(bucket->parent.sync);
+  std::scoped_lock guard(bucket->parent.sync,bucket->sync);
   auto& v = bucket->get(id);
   v.targetNpc = tg;
   }
@@ -101,7 +104,7 @@ void PfxEmitter::setTarget(const Npc* tg) {
 void PfxEmitter::setDirection(const Matrix4x4& d) {
   if(bucket==nullptr)
     return;
-  std::lock_guard<std::recursive_mutex> guard(bucket->parent.sync);
+  std::scoped_lock guard(bucket->parent.sync,bucket->sync);
   auto& v = bucket->get(id);
   v.direction[0] = Vec3(d.at(0,0),d.at(0,1),d.at(0,2));
   v.direction[1] = Vec3(d.at(1,0),d.at(1,1),d.at(1,2));
@@ -114,7 +117,7 @@ void PfxEmitter::setDirection(const Matrix4x4& d) {
 void PfxEmitter::setActive(bool act) {
   if(bucket==nullptr)
     return;
-  std::lock_guard<std::recursive_mutex> guard(bucket->parent.sync);
+  std::scoped_lock guard(bucket->parent.sync,bucket->sync);
   auto& v     = bucket->get(id);
   auto  state = (act ? PfxBucket::S_Active : PfxBucket::S_Inactive);
   if(v.st==state)
@@ -129,7 +132,7 @@ void PfxEmitter::setActive(bool act) {
 bool PfxEmitter::isActive() const {
   if(bucket==nullptr)
     return false;
-  std::lock_guard<std::recursive_mutex> guard(bucket->parent.sync);
+  std::scoped_lock guard(bucket->parent.sync,bucket->sync);
   auto& v = bucket->get(id);
   return v.st==PfxBucket::S_Active;
   }
@@ -137,7 +140,7 @@ bool PfxEmitter::isActive() const {
 void PfxEmitter::setLooped(bool loop) {
   if(bucket==nullptr)
     return;
-  std::lock_guard<std::recursive_mutex> guard(bucket->parent.sync);
+  std::scoped_lock guard(bucket->parent.sync,bucket->sync);
   auto& v = bucket->get(id);
   v.isLoop = loop;
   if(v.next!=nullptr)
@@ -147,7 +150,7 @@ void PfxEmitter::setLooped(bool loop) {
 void PfxEmitter::setMesh(const MeshObjects::Mesh* mesh, const Pose* pose) {
   const PfxEmitterMesh* m = (mesh!=nullptr) ? mesh->toMeshEmitter() : nullptr;
 
-  std::lock_guard<std::recursive_mutex> guard(bucket->parent.sync);
+  std::scoped_lock guard(bucket->parent.sync,bucket->sync);
   auto& v = bucket->get(id);
   v.mesh = m;
   v.pose = pose;
@@ -156,7 +159,7 @@ void PfxEmitter::setMesh(const MeshObjects::Mesh* mesh, const Pose* pose) {
   }
 
 void PfxEmitter::setPhysicsEnable(World& p, std::function<void (Npc&)> cb) {
-  std::lock_guard<std::recursive_mutex> guard(bucket->parent.sync);
+  std::scoped_lock guard(bucket->parent.sync,bucket->sync);
   auto& v = bucket->get(id);
   zone = CollisionZone(p, v.pos, bucket->decl);
   zone.setCallback(cb);
@@ -175,7 +178,7 @@ uint64_t PfxEmitter::effectPrefferedTime() const {
 bool PfxEmitter::isAlive() const {
   if(bucket==nullptr)
     return false;
-  std::lock_guard<std::recursive_mutex> guard(bucket->parent.sync);
+  std::scoped_lock guard(bucket->parent.sync,bucket->sync);
   auto& v = bucket->get(id);
   if(v.block==size_t(-1))
     return false;
@@ -103,8 +103,10 @@ void Sound::setPosition(const Tempest::Vec3& pos) {
 void Sound::setPosition(float x, float y, float z) {
   if(pos.x==x && pos.y==y && pos.z==z)
     return;
-  if(val!=nullptr)
+  if(val!=nullptr) {
     val->eff.setPosition(x,y,z);
+    val->pos = {x,y,z};
+    }
   pos = {x,y,z};
   }
 
@@ -0,0 +1,31 @@
+#include "soundgrid.h"
+
+#include <cmath>
+
+int32_t SoundGrid::cellOf(float v) {
+  return int32_t(std::floor(v/cellSize));
+  }
+
+uint64_t SoundGrid::key(int32_t x, int32_t z) {
+  return (uint64_t(uint32_t(x)) << 32) | uint64_t(uint32_t(z));
+  }
+
+void SoundGrid::insert(uint32_t id, const Tempest::Vec3& min, const Tempest::Vec3& max) {
+  const int32_t x0 = cellOf(min.x), x1 = cellOf(max.x);
+  const int32_t z0 = cellOf(min.z), z1 = cellOf(max.z);
+  if(int64_t(x1-x0+1)*int64_t(z1-z0+1)>MaxCells) {
+    large.push_back(id);
+    return;
+    }
+  for(int32_t x=x0; x<=x1; ++x)
+    for(int32_t z=z0; z<=z1; ++z)
+      cells[key(x,z)].push_back(id);
+  }
+
+const std::vector<uint32_t>& SoundGrid::at(const Tempest::Vec3& p) const {
+  static const std::vector<uint32_t> empty;
+  auto i = cells.find(key(cellOf(p.x),cellOf(p.z)));
+  if(i==cells.end())
+    return empty;
+  return i->second;
+  }
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <Tempest/Vec>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid over xz plane: ids of objects, that overlap a cell; ids in a cell are ascending,
+// if inserted in ascending order. Used by WorldSound for music zones and sound vobs.
+class SoundGrid final {
+  public:
+    void insert(uint32_t id, const Tempest::Vec3& min, const Tempest::Vec3& max);
+    const std::vector<uint32_t>& at(const Tempest::Vec3& p) const;
+    const std::vector<uint32_t>& everywhere() const { return large; }
+
+  private:
+    static constexpr float cellSize = 2000;
+    enum { MaxCells = 64*64 };
+
+    static int32_t  cellOf(float v);
+    static uint64_t key(int32_t x, int32_t z);
+
+    std::unordered_map<uint64_t,std::vector<uint32_t>> cells;
+    std::vector<uint32_t>                              large; // objects, too big to be spread over cells
+  };
@@ -0,0 +1,338 @@
+#include "wayhierarchy.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "utils/cachefile.h"
+#include "waypoint.h"
+
+namespace {
+
+struct Builder final {
+  using Arc = WayHierarchy::Arc;
+
+  enum { WitnessLimit = 256 };
+
+  std::vector<std::vector<Arc>> g;
+  std::vector<uint8_t>          contracted;
+  std::vector<int32_t>          depth;
+
+  // witness search
+  std::vector<int32_t>          dist;
+  std::vector<uint32_t>         stamp;
+  uint32_t                      gen = 0;
+  std::vector<std::pair<int32_t,uint32_t>> heap;
+
+  static bool cmp(const std::pair<int32_t,uint32_t>& a, const std::pair<int32_t,uint32_t>& b) {
+    return a.first>b.first;
+    }
+
+  explicit Builder(size_t n):g(n),contracted(n,0),depth(n,0),dist(n,0),stamp(n,0) {}
+
+  void addArc(uint32_t a, uint32_t b, int32_t len, uint32_t mid) {
+    for(auto& i:g[a]) {
+      if(i.to!=b)
+        continue;
+      if(len<i.len) {
+        i.len = len;
+        i.mid = mid;
+        }
+      return;
+      }
+    g[a].push_back({b,len,mid});
+    }
+
+  int32_t distTo(uint32_t v) const {
+    return stamp[v]==gen ? dist[v] : std::numeric_limits<int32_t>::max();
+    }
+
+  // bounded Dijkstra among not contracted points, that avoids 'skip'
+  void witness(uint32_t src, uint32_t skip, int32_t maxLen) {
+    gen++;
+    heap.clear();
+    dist[src]  = 0;
+    stamp[src] = gen;
+    heap.push_back({0,src});
+
+    size_t settled = 0;
+    while(!heap.empty()) {
+      std::pop_heap(heap.begin(),heap.end(),cmp);
+      const auto top = heap.back();
+      heap.pop_back();
+      if(top.first!=dist[top.second])
+        continue;
+      if(top.first>maxLen || ++settled>WitnessLimit)
+        break;
+      for(auto& a:g[top.second]) {
+        if(contracted[a.to] || a.to==skip)
+          continue;
+        const int32_t len = top.first+a.len;
+        if(len<distTo(a.to)) {
+          dist [a.to] = len;
+          stamp[a.to] = gen;
+          heap.push_back({len,a.to});
+          std::push_heap(heap.begin(),heap.end(),cmp);
+          }
+        }
+      }
+    }
+
+  // number of shortcuts, required to contract v
+  int32_t contract(uint32_t v, bool apply) {
+    std::vector<Arc> nb;
+    for(auto& a:g[v])
+      if(!contracted[a.to])
+        nb.push_back(a);
+
+    int32_t cnt = 0;
+    for(size_t i=0; i+1<nb.size(); ++i) {
+      int32_t maxLen = 0;
+      for(size_t r=i+1; r<nb.size(); ++r)
+        maxLen = std::max(maxLen,nb[i].len+nb[r].len);
+      witness(nb[i].to,v,maxLen);
+      for(size_t r=i+1; r<nb.size(); ++r) {
+        const int32_t via = nb[i].len+nb[r].len;
+        if(distTo(nb[r].to)<=via)
+          continue;
+        cnt++;
+        if(apply) {
+          addArc(nb[i].to,nb[r].to,via,v);
+          addArc(nb[r].to,nb[i].to,via,v);
+          }
+        }
+      }
+    if(apply) {
+      for(auto& a:nb)
+        depth[a.to] = std::max(depth[a.to],depth[v]+1);
+      }
+    return cnt;
+    }
+
+  int32_t priority(uint32_t v) {
+    int32_t degree = 0;
+    for(auto& a:g[v])
+      if(!contracted[a.to])
+        degree++;
+    return contract(v,false) - degree + depth[v];
+    }
+  };
+
+}
+
+void WayHierarchy::Context::reset(const WayHierarchy& h) {
+  if(owner!=&h || side[0].node.size()!=h.size() || gen==uint32_t(-1)) {
+    owner = &h;
+    gen   = 0;
+    for(auto& s:side)
+      s.node.assign(h.size(),Node());
+    }
+  gen++;
+  for(auto& s:side)
+    s.open.clear();
+  }
+
+void WayHierarchy::Context::relax(Side& s, uint32_t id, int32_t len, uint32_t parent, uint32_t mid) {
+  auto& n = s.node[id];
+  if(n.gen==gen && n.len<=len)
+    return;
+  n.gen    = gen;
+  n.len    = len;
+  n.parent = parent;
+  n.mid    = mid;
+  s.open.push_back({len,id});
+  std::push_heap(s.open.begin(),s.open.end());
+  }
+
+void WayHierarchy::build(const std::vector<WayPoint>& points) {
+  const size_t n = points.size();
+  Builder b(n);
+  for(size_t i=0; i<n; ++i) {
+    for(auto& c:points[i].connections()) {
+      const auto to = uint32_t(c.point-points.data());
+      if(to!=i && to<n)
+        b.addArc(uint32_t(i),to,c.len,None);
+      }
+    }
+
+  // contraction order: lazy updated priority queue by edge difference
+  std::vector<std::pair<int32_t,uint32_t>> queue;
+  for(uint32_t i=0; i<n; ++i)
+    queue.push_back({b.priority(i),i});
+  std::make_heap(queue.begin(),queue.end(),Builder::cmp);
+
+  rank.assign(n,0);
+  uint32_t next = 0;
+  while(!queue.empty()) {
+    std::pop_heap(queue.begin(),queue.end(),Builder::cmp);
+    const uint32_t v = queue.back().second;
+    queue.pop_back();
+
+    const int32_t prio = b.priority(v);
+    if(!queue.empty() && prio>queue.front().first) {
+      queue.push_back({prio,v});
+      std::push_heap(queue.begin(),queue.end(),Builder::cmp);
+      continue;
+      }
+    b.contract(v,true);
+    b.contracted[v] = 1;
+    rank[v]         = next++;
+    }
+
+  upOffset.assign(n+1,0);
+  upArcs.clear();
+  for(size_t i=0; i<n; ++i) {
+    upOffset[i] = uint32_t(upArcs.size());
+    for(auto& a:b.g[i])
+      if(rank[a.to]>rank[i])
+        upArcs.push_back(a);
+    }
+  upOffset[n] = uint32_t(upArcs.size());
+  }
+
+std::vector<uint8_t> WayHierarchy::serialize() const {
+  const uint32_t n = uint32_t(rank.size());
+  const uint32_t m = uint32_t(upArcs.size());
+
+  std::vector<uint8_t> ret(2*sizeof(uint32_t) + n*sizeof(uint32_t) + (n+1)*sizeof(uint32_t) + m*sizeof(Arc));
+  uint8_t* at = ret.data();
+  auto put = [&at](const void* d, size_t sz) {
+    if(sz>0)
+      std::memcpy(at,d,sz);
+    at += sz;
+    };
+  put(&n,sizeof(n));
+  put(&m,sizeof(m));
+  put(rank.data(),    n*sizeof(uint32_t));
+  put(upOffset.data(),(n+1)*sizeof(uint32_t));
+  put(upArcs.data(),  m*sizeof(Arc));
+  return ret;
+  }
+
+bool WayHierarchy::deserialize(const std::vector<uint8_t>& data, size_t pointCount) {
+  uint32_t n = 0, m = 0;
+  if(data.size()<2*sizeof(uint32_t))
+    return false;
+  std::memcpy(&n,data.data(),sizeof(n));
+  std::memcpy(&m,data.data()+sizeof(n),sizeof(m));
+  if(n!=pointCount || data.size()!=2*sizeof(uint32_t) + n*sizeof(uint32_t) + (n+1)*sizeof(uint32_t) + m*sizeof(Arc))
+    return false;
+
+  const uint8_t* at = data.data()+2*sizeof(uint32_t);
+  rank    .resize(n);
+  upOffset.resize(n+1);
+  upArcs  .resize(m);
+  auto get = [&at](void* d, size_t sz) {
+    if(sz>0)
+      std::memcpy(d,at,sz);
+    at += sz;
+    };
+  get(rank.data(),    n*sizeof(uint32_t));
+  get(upOffset.data(),(n+1)*sizeof(uint32_t));
+  get(upArcs.data(),  m*sizeof(Arc));
+
+  // sanity check, to not crash on corrupted cache
+  if(upOffset[n]!=m)
+    return false;
+  for(size_t i=0; i<n; ++i)
+    if(upOffset[i]>upOffset[i+1] || rank[i]>=n)
+      return false;
+  for(auto& a:upArcs)
+    if(a.to>=n || (a.mid!=None && a.mid>=n))
+      return false;
+  return true;
+  }
+
+uint64_t WayHierarchy::graphHash(const std::vector<WayPoint>& points) {
+  const uint64_t n = points.size();
+  uint64_t       h = CacheFile::hash(&n,sizeof(n));
+  for(auto& p:points) {
+    for(auto& c:p.connections()) {
+      const uint64_t e[2] = {uint64_t(c.point-points.data()), uint64_t(uint32_t(c.len))};
+      h = CacheFile::hash(e,sizeof(e),h);
+      }
+    const uint64_t sep = uint64_t(-1);
+    h = CacheFile::hash(&sep,sizeof(sep),h);
+    }
+  return h;
+  }
+
+bool WayHierarchy::route(Context& ctx, const Start* begin, size_t beginSz, uint32_t end, std::vector<uint32_t>& path) const {
+  path.clear();
+  if(end>=size())
+    return false;
+
+  ctx.reset(*this);
+  auto& fwd = ctx.side[0];
+  auto& bwd = ctx.side[1];
+  for(size_t i=0; i<beginSz; ++i)
+    if(begin[i].id<size())
+      ctx.relax(fwd,begin[i].id,begin[i].len,None,None);
+  if(fwd.open.empty())
+    return false;
+  ctx.relax(bwd,end,0,None,None);
+
+  int32_t  best     = std::numeric_limits<int32_t>::max();
+  uint32_t meet     = None;
+  bool     active[] = {true, true};
+  while(active[0] || active[1]) {
+    for(int s=0; s<2; ++s) {
+      if(!active[s])
+        continue;
+      auto& cur   = ctx.side[s];
+      auto& other = ctx.side[1-s];
+      while(!cur.open.empty() && cur.open.front().len!=cur.node[cur.open.front().id].len) {
+        std::pop_heap(cur.open.begin(),cur.open.end());
+        cur.open.pop_back();
+        }
+      if(cur.open.empty() || cur.open.front().len>=best) {
+        active[s] = false;
+        continue;
+        }
+
+      std::pop_heap(cur.open.begin(),cur.open.end());
+      const auto top = cur.open.back();
+      cur.open.pop_back();
+
+      if(ctx.has(other,top.id) && top.len+other.node[top.id].len<best) {
+        best = top.len+other.node[top.id].len;
+        meet = top.id;
+        }
+      for(uint32_t i=upOffset[top.id]; i<upOffset[top.id+1]; ++i) {
+        auto& a = upArcs[i];
+        ctx.relax(cur,a.to,top.len+a.len,top.id,a.mid);
+        }
+      }
+    }
+
+  if(meet==None)
+    return false;
+
+  std::vector<uint32_t> chain;
+  for(uint32_t id=meet; id!=None; id=fwd.node[id].parent)
+    chain.push_back(id);
+  path.push_back(chain.back());
+  for(size_t i=chain.size()-1; i>0; --i)
+    unpack(chain[i],chain[i-1],fwd.node[chain[i-1]].mid,path);
+  for(uint32_t id=meet; bwd.node[id].parent!=None; id=bwd.node[id].parent)
+    unpack(id,bwd.node[id].parent,bwd.node[id].mid,path);
+  return true;
+  }
+
+uint32_t WayHierarchy::findMid(uint32_t a, uint32_t b) const {
+  // arc is stored at lower ranked end
+  if(rank[a]>rank[b])
+    std::swap(a,b);
+  for(uint32_t i=upOffset[a]; i<upOffset[a+1]; ++i)
+    if(upArcs[i].to==b)
+      return upArcs[i].mid;
+  return None;
+  }
+
+void WayHierarchy::unpack(uint32_t a, uint32_t b, uint32_t mid, std::vector<uint32_t>& out) const {
+  if(mid==None) {
+    out.push_back(b);
+    return;
+    }
+  unpack(a,mid,findMid(a,mid),out);
+  unpack(mid,b,findMid(mid,b),out);
+  }
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class WayPoint;
+
+// Contraction hierarchy over the waynet.
+// Points are contracted one by one, shortcuts preserve shortest distances among remaining points.
+// Query is a bidirectional Dijkstra, that only goes 'up' the hierarchy, so it settles few points on any distance.
+class WayHierarchy final {
+  public:
+    enum : uint32_t { None = uint32_t(-1) };
+
+    struct Arc final {
+      uint32_t to  = 0;
+      int32_t  len = 0;
+      uint32_t mid = None; // contracted point, that shortcut skips; None for original edge
+      };
+
+    // search state of one query; one per thread
+    class Context final {
+      struct Node final {
+        int32_t  len    = 0;
+        uint32_t parent = None;
+        uint32_t mid    = None;
+        uint32_t gen    = 0;
+        };
+      struct Open final {
+        int32_t  len = 0;
+        uint32_t id  = 0;
+        bool operator < (const Open& other) const { return len>other.len; }
+        };
+      struct Side final {
+        std::vector<Node> node;
+        std::vector<Open> open;
+        };
+
+      const WayHierarchy* owner = nullptr;
+      uint32_t            gen   = 0;
+      Side                side[2];
+
+      void reset(const WayHierarchy& h);
+      void relax(Side& s, uint32_t id, int32_t len, uint32_t parent, uint32_t mid);
+      bool has(const Side& s, uint32_t id) const { return s.node[id].gen==gen; }
+
+      friend class WayHierarchy;
+      };
+
+    struct Start final {
+      uint32_t id  = None;
+      int32_t  len = 0;
+      };
+
+    void   build(const std::vector<WayPoint>& points);
+    size_t size() const { return rank.size(); }
+
+    std::vector<uint8_t> serialize() const;
+    bool                 deserialize(const std::vector<uint8_t>& data, size_t pointCount);
+    // hash of graph topology and lengths; cache key
+    static uint64_t      graphHash(const std::vector<WayPoint>& points);
+
+    // shortest path from any of begin points (with initial lengths) to the end; path goes from begin to end
+    bool   route(Context& ctx, const Start* begin, size_t beginSz, uint32_t end, std::vector<uint32_t>& path) const;
+
+  private:
+    std::vector<uint32_t> rank;
+    std::vector<uint32_t> upOffset; // CSR: arcs to higher ranked points
+    std::vector<Arc>      upArcs;
+
+    uint32_t findMid(uint32_t a, uint32_t b) const;
+    void     unpack(uint32_t a, uint32_t b, uint32_t mid, std::vector<uint32_t>& out) const;
+  };
@@ -1,10 +1,13 @@
 #include "waymatrix.h"
 
+#include <Tempest/Application>
 #include <Tempest/Log>
 #include <algorithm>
 #include <limits>
 
+#include "utils/cachefile.h"
 #include "utils/dbgpainter.h"
+#include "utils/workers.h"
 #include "utils/versioninfo.h"
 #include "world/objects/interactive.h"
 #include "world.h"
@@ -34,9 +37,6 @@ WayMatrix::WayMatrix(World &world, const phoenix::way_net &dat)
   for(auto& i:wayPoints)
     if(i.name.find("START")!=std::string::npos)
       startPoints.push_back(i);
-
-  stk[0].reserve(256);
-  stk[1].reserve(256);
   }
 
 void WayMatrix::buildIndex() {
@@ -48,11 +48,12 @@ void WayMatrix::buildIndex() {
     return a->name<b->name;
     });
 
-  for(auto& i:freePoints)
-    fpInd.push_back(&i);
-  std::sort(fpInd.begin(),fpInd.end(),[](const WayPoint* a,const WayPoint* b){
-    return a->x<b->x;
-    });
+  std::vector<const WayPoint*> pt;
+  for(auto& i:wayPoints)
+    pt.push_back(&i);
+  wayIndex.build(std::move(pt));
+  pointIndex.build(std::vector<const WayPoint*>(indexPoints.begin(),indexPoints.end()));
+  fpIndex.clear();
 
   for(auto& i:edges) {
     if(i.a<wayPoints.size() && i.b<wayPoints.size()) {
@@ -65,46 +66,23 @@ void WayMatrix::buildIndex() {
     }
 
   calculateLadderPoints();
+  buildHierarchy();
   }
 
 const WayPoint *WayMatrix::findWayPoint(const Vec3& at, const std::function<bool(const WayPoint&)>& filter) const {
-  const WayPoint* ret =nullptr;
-  float           dist=std::numeric_limits<float>::max();
-  for(auto& w:wayPoints) {
-    if(!filter(w))
-      continue;
-    auto  dp0 = at-w.position();
-    float l0  = dp0.quadLength();
-
-    if(l0<dist){
-      ret  = &w;
-      dist = l0;
-      }
-    }
-  return ret;
+  return wayIndex.findNearest(at,std::numeric_limits<float>::max(),filter);
   }
 
 const WayPoint *WayMatrix::findFreePoint(const Vec3& at, std::string_view name, const std::function<bool(const WayPoint&)>& filter) const {
   auto&  index = findFpIndex(name);
-  return findFreePoint(at.x,at.y,at.z,index,filter);
+  return findFreePoint(at,index,filter);
   }
 
 const WayPoint *WayMatrix::findNextPoint(const Vec3& at) const {
-  const WayPoint* ret   = nullptr;
-  float           dist  = distanceThreshold;
-
-  dist*=dist;
-  for(auto pw:indexPoints){
-    auto& w  = *pw;
-    auto  dp = w.position()-at;
-    float l  = dp.quadLength();
-
-    if(l<dist && dp.z*dp.z<300*300 && !w.isLocked()){
-      ret  = &w;
-      dist = l;
-      }
-    }
-  return ret;
+  return pointIndex.findNearest(at,distanceThreshold,[&at](const WayPoint& w){
+    const float dz = w.z-at.z;
+    return dz*dz<300*300 && !w.isLocked();
+    });
   }
 
 void WayMatrix::addFreePoint(const Vec3& pos, const Vec3& dir, std::string_view name) {
@@ -225,6 +203,21 @@ void WayMatrix::calculateLadderPoints() {
     }
   }
 
+void WayMatrix::buildHierarchy() {
+  // precomputation is cached on disk; key is the final graph, so physics or waynet changes invalidate it
+  const uint64_t key  = WayHierarchy::graphHash(wayPoints);
+  const auto     name = std::string(world.name())+".wnet";
+  const auto     data = CacheFile::read(name,key);
+  if(!data.empty() && hierarchy.deserialize(data,wayPoints.size()))
+    return;
+
+  const uint64_t time0 = Application::tickCount();
+  hierarchy.build(wayPoints);
+  auto blob = hierarchy.serialize();
+  CacheFile::write(name,key,blob.data(),blob.size());
+  Log::i("waynet hierarchy: ",Application::tickCount()-time0,"ms");
+  }
+
 const WayMatrix::FpIndex &WayMatrix::findFpIndex(std::string_view name) const {
   auto it = std::lower_bound(fpIndex.begin(),fpIndex.end(),name,[](FpIndex& l, std::string_view r){
     return l.key<r;
@@ -235,55 +228,61 @@ const WayMatrix::FpIndex &WayMatrix::findFpIndex(std::string_view name) const {
 
   FpIndex id;
   id.key = name;
+  std::vector<const WayPoint*> pt;
   for(auto& w:freePoints){
     if(!w.checkName(name))
       continue;
-    id.index.push_back(&w);
+    pt.push_back(&w);
     }
-  // TODO: good index, not sort by 'x' :)
-  std::sort(id.index.begin(),id.index.end(),[](const WayPoint* a,const WayPoint* b){
-    return a->x<b->x;
-    });
+  id.index.build(std::move(pt));
 
   it = fpIndex.insert(it,std::move(id));
   return *it;
   }
 
-const WayPoint *WayMatrix::findFreePoint(float x, float y, float z, const FpIndex& ind,
+const WayPoint *WayMatrix::findFreePoint(const Vec3& at, const FpIndex& ind,
                                          const std::function<bool(const WayPoint&)>& filter) const {
-  float R = distanceThreshold;
-  auto b = std::lower_bound(ind.index.begin(),ind.index.end(), x-R ,[](const WayPoint *a, float b){
-    return a->x<b;
-    });
-  auto e = std::upper_bound(ind.index.begin(),ind.index.end(), x+R ,[](float a,const WayPoint *b){
-    return a<b->x;
+  return ind.index.findNearest(at,distanceThreshold,[&at,&filter](const WayPoint& w){
+    const float dz = w.z-at.z;
+    if(dz*dz>300*300)
+      return false;
+    return filter(w);
     });
+  }
 
-  const WayPoint* ret=nullptr;
-  auto  count = std::distance(b,e);(void) count;
-  float dist  = R*R;
-  for(auto i=b;i!=e;++i){
-    auto& w  = **i;
-    float dx = w.x-x;
-    float dy = w.y-y;
-    float dz = w.z-z;
-    float l  = dx*dx+dy*dy+dz*dz;
-    if(l>dist || dz*dz>300*300)
-      continue;
-    if(!filter(w))
-      continue;
-    ret  = &w;
-    dist = l;
-    }
-  return ret;
+struct WayMatrix::PathContext final {
+  WayHierarchy::Context              search;
+  std::vector<WayHierarchy::Start>   begin;
+  std::vector<uint32_t>              path;
+  };
+
+uint32_t WayMatrix::indexOf(const WayPoint& w) const {
+  if(wayPoints.empty() || &w<wayPoints.data() || &w>=wayPoints.data()+wayPoints.size())
+    return WayHierarchy::None;
+  return uint32_t(&w-wayPoints.data());
   }
 
 WayPath WayMatrix::wayTo(const WayPoint** begin, size_t beginSz, const Tempest::Vec3 exactBegin, const WayPoint& end) const {
+  static thread_local PathContext ctx;
+  return wayTo(ctx,begin,beginSz,exactBegin,end);
+  }
+
+void WayMatrix::wayTo(std::vector<PathRequest>& req) const {
+  // query cost varies a lot with distance: tasks pick requests one by one
+  Workers::parallelTasks(req,[this](PathRequest& r) {
+    if(r.end==nullptr)
+      r.path = WayPath(); else
+      r.path = wayTo(r.begin.data(),r.begin.size(),r.exactBegin,*r.end);
+    });
+  }
+
+WayPath WayMatrix::wayTo(PathContext& ctx, const WayPoint** begin, size_t beginSz,
+                         const Tempest::Vec3 exactBegin, const WayPoint& end) const {
   if(beginSz==0)
     return WayPath();
 
-  intptr_t endId = std::distance<const WayPoint*>(&wayPoints[0],&end);
-  if(endId<0 || size_t(endId)>=wayPoints.size()){
+  const uint32_t endId = indexOf(end);
+  if(endId==WayHierarchy::None) {
     if(end.name.find("FP_")==0) {
       WayPath ret;
       ret.add(end);
@@ -292,75 +291,20 @@ WayPath WayMatrix::wayTo(const WayPoint** begin, size_t beginSz, const Tempest::
     return WayPath();
     }
 
-  pathGen++;
-  if(pathGen==1){
-    // new cycle
-    for(auto& i:wayPoints)
-      i.pathGen=0;
-    }
-
-  std::vector<const WayPoint*> *front=&stk[0], *back=&stk[1];
-  stk[0].clear();
-  stk[1].clear();
-
-  end.pathLen = 0;
-  end.pathGen = pathGen;
-  front->push_back(&end);
-
-  while(front->size()>0) {
-    bool done = true;
-    for(size_t i=0; i<beginSz; ++i)
-      if(begin[i]->pathGen!=pathGen) {
-        done = false;
-        break;
-        }
-    if(done)
-      break;
-
-    for(auto& wp:*front) {
-      int32_t l0 = wp->pathLen;
-
-      for(auto i:wp->connections()){
-        auto& w  = *i.point;
-        int32_t l1 = l0+i.len;
-        if(w.pathGen!=pathGen || w.pathLen>l1){
-          w.pathLen = l1;
-          w.pathGen = pathGen;
-          back->push_back(&w);
-          }
-        }
-      }
-    std::swap(front,back);
-    back->clear();
-    }
-
-  const WayPoint* first = begin[0];
+  // exact position is a virtual start, linked to every begin point
+  ctx.begin.clear();
   for(size_t i=0; i<beginSz; ++i) {
-    int32_t iLen = begin[i]->pathLen + int((exactBegin - begin[i]->position()).length());
-    int32_t fLen = first   ->pathLen + int((exactBegin - first   ->position()).length());
-    if(iLen<fLen)
-      first = begin[i];
+    const uint32_t id = indexOf(*begin[i]);
+    if(id!=WayHierarchy::None)
+      ctx.begin.push_back({id,int32_t((exactBegin - begin[i]->position()).length())});
     }
 
-  WayPath ret;
-  ret.add(*first);
-  const WayPoint* current = first;
-  while(current!=&end) {
-    int32_t l0 = current->pathLen, l1=l0;
-
-    const WayPoint* next=nullptr;
-    for(auto i:current->connections()){
-      if(i.point->pathGen==pathGen && i.point->pathLen+i.len<=l0 && i.point->pathLen<l1){
-        next = i.point;
-        l1   = i.point->pathLen;
-        }
-      }
-    if(next==nullptr)
-      return WayPath();
-    ret.add(*next);
-    current=next;
-    }
+  if(!hierarchy.route(ctx.search,ctx.begin.data(),ctx.begin.size(),endId,ctx.path))
+    return WayPath();
 
-  ret.reverse();
+  // way-path is consumed from the back
+  WayPath ret;
+  for(size_t i=ctx.path.size(); i>0; --i)
+    ret.add(wayPoints[ctx.path[i-1]]);
   return ret;
   }
@@ -10,6 +10,8 @@
 
 #include "waypath.h"
 #include "waypoint.h"
+#include "waypointindex.h"
+#include "wayhierarchy.h"
 
 class World;
 class DbgPainter;
@@ -32,7 +34,17 @@ class WayMatrix final {
     const WayPoint* findPoint(std::string_view name, bool inexact) const;
     void            marchPoints(DbgPainter& p) const;
 
+    struct PathRequest final {
+      std::vector<const WayPoint*> begin;
+      Tempest::Vec3                exactBegin;
+      const WayPoint*              end = nullptr;
+      WayPath                      path;
+      };
+
+    // thread-safe: search state is local to the query
     WayPath         wayTo(const WayPoint** begin, size_t beginSz, const Tempest::Vec3 exactBegin, const WayPoint& end) const;
+    // batch of independent queries, solved by workers
+    void            wayTo(std::vector<PathRequest>& req) const;
 
   private:
     World&                 world;
@@ -44,21 +56,28 @@ class WayMatrix final {
     std::vector<WayPoint>  freePoints, startPoints;
     std::vector<WayPoint*> indexPoints;
 
-    std::vector<WayPoint*> fpInd;
+    WayPointIndex          wayIndex;   // wayPoints
+    WayPointIndex          pointIndex; // indexPoints
+
+    WayHierarchy           hierarchy;
 
     struct FpIndex {
       std::string                  key;
-      std::vector<const WayPoint*> index;
+      WayPointIndex                index;
       };
     mutable std::vector<FpIndex>          fpIndex;
 
-    mutable uint16_t                      pathGen=0;
-    mutable std::vector<const WayPoint*>  stk[2];
+    struct PathContext;
 
     void                   adjustWaypoints(std::vector<WayPoint> &wp);
     void                   calculateLadderPoints();
+    void                   buildHierarchy();
+
+    uint32_t               indexOf(const WayPoint& w) const;
+    WayPath                wayTo(PathContext& ctx, const WayPoint** begin, size_t beginSz,
+                                 const Tempest::Vec3 exactBegin, const WayPoint& end) const;
 
     const FpIndex&         findFpIndex(std::string_view name) const;
-    const WayPoint*        findFreePoint(float x, float y, float z, const FpIndex &ind,
+    const WayPoint*        findFreePoint(const Tempest::Vec3& at, const FpIndex &ind,
                                          const std::function<bool(const WayPoint&)>& filter) const;
   };
@@ -0,0 +1,141 @@
+#include "waypointindex.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "waypoint.h"
+
+using namespace Tempest;
+
+static float boxQDist(const Vec3 bbox[2], const Vec3& p) {
+  const float dx = std::max({bbox[0].x-p.x, 0.f, p.x-bbox[1].x});
+  const float dy = std::max({bbox[0].y-p.y, 0.f, p.y-bbox[1].y});
+  const float dz = std::max({bbox[0].z-p.z, 0.f, p.z-bbox[1].z});
+  return dx*dx+dy*dy+dz*dz;
+  }
+
+static float component(const Vec3& v, int axis) {
+  return axis==0 ? v.x : (axis==1 ? v.y : v.z);
+  }
+
+void WayPointIndex::clear() {
+  points.clear();
+  pos.clear();
+  nodes.clear();
+  }
+
+void WayPointIndex::build(std::vector<const WayPoint*> pt) {
+  clear();
+  points = std::move(pt);
+  if(points.empty())
+    return;
+
+  pos.resize(points.size());
+  for(size_t i=0; i<points.size(); ++i)
+    pos[i] = points[i]->position();
+
+  nodes.reserve(2*(points.size()/LeafSize+1));
+  nodes.emplace_back();
+  nodes[0].begin = 0;
+  nodes[0].end   = uint32_t(points.size());
+  buildNode(0);
+  }
+
+void WayPointIndex::buildNode(uint32_t id) {
+  const uint32_t begin = nodes[id].begin;
+  const uint32_t end   = nodes[id].end;
+
+  Vec3 bbox[2] = {pos[begin],pos[begin]};
+  for(uint32_t i=begin+1; i<end; ++i) {
+    bbox[0].x = std::min(bbox[0].x,pos[i].x);
+    bbox[0].y = std::min(bbox[0].y,pos[i].y);
+    bbox[0].z = std::min(bbox[0].z,pos[i].z);
+    bbox[1].x = std::max(bbox[1].x,pos[i].x);
+    bbox[1].y = std::max(bbox[1].y,pos[i].y);
+    bbox[1].z = std::max(bbox[1].z,pos[i].z);
+    }
+  nodes[id].bbox[0] = bbox[0];
+  nodes[id].bbox[1] = bbox[1];
+  if(end-begin<=LeafSize)
+    return;
+
+  // split by median of the longest axis
+  const Vec3 ext  = bbox[1]-bbox[0];
+  const int  axis = (ext.x>=ext.y && ext.x>=ext.z) ? 0 : (ext.y>=ext.z ? 1 : 2);
+  const uint32_t mid = begin+(end-begin)/2;
+
+  std::vector<uint32_t> order(end-begin);
+  std::iota(order.begin(),order.end(),begin);
+  std::nth_element(order.begin(),order.begin()+(mid-begin),order.end(),[this,axis](uint32_t a, uint32_t b){
+    return component(pos[a],axis)<component(pos[b],axis);
+    });
+  std::vector<const WayPoint*> pt(order.size());
+  std::vector<Vec3>            ps(order.size());
+  for(size_t i=0; i<order.size(); ++i) {
+    pt[i] = points[order[i]];
+    ps[i] = pos   [order[i]];
+    }
+  std::copy(pt.begin(),pt.end(),points.begin()+begin);
+  std::copy(ps.begin(),ps.end(),pos.begin()+begin);
+
+  const uint32_t child = uint32_t(nodes.size());
+  nodes[id].child = child;
+  nodes.resize(nodes.size()+2);
+  nodes[child  ].begin = begin;
+  nodes[child  ].end   = mid;
+  nodes[child+1].begin = mid;
+  nodes[child+1].end   = end;
+  buildNode(child);
+  buildNode(child+1);
+  }
+
+void WayPointIndex::implFind(const Vec3& at, float R, void* ctx, bool (*func)(void*, const WayPoint&)) const {
+  if(nodes.empty())
+    return;
+
+  struct Item {
+    float    qDist = 0;
+    uint32_t id    = 0;
+    bool     point = false;
+    bool operator < (const Item& other) const { return qDist>other.qDist; }
+    };
+
+  const float R2 = R<std::numeric_limits<float>::max() ? R*R : std::numeric_limits<float>::infinity();
+  std::vector<Item> heap;
+  heap.reserve(64);
+  heap.push_back({boxQDist(nodes[0].bbox,at),0,false});
+
+  while(!heap.empty()) {
+    std::pop_heap(heap.begin(),heap.end());
+    const Item top = heap.back();
+    heap.pop_back();
+    if(top.qDist>R2)
+      break;
+
+    if(top.point) {
+      // every item left in the heap is farther away
+      if(func(ctx,*points[top.id]))
+        return;
+      continue;
+      }
+
+    auto& n = nodes[top.id];
+    if(n.child==0) {
+      for(uint32_t i=n.begin; i<n.end; ++i) {
+        const float d = (pos[i]-at).quadLength();
+        if(d<=R2) {
+          heap.push_back({d,i,true});
+          std::push_heap(heap.begin(),heap.end());
+          }
+        }
+      } else {
+      for(uint32_t c=n.child; c<n.child+2; ++c) {
+        const float d = boxQDist(nodes[c].bbox,at);
+        if(d<=R2) {
+          heap.push_back({d,c,false});
+          std::push_heap(heap.begin(),heap.end());
+          }
+        }
+      }
+    }
+  }
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <Tempest/Vec>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class WayPoint;
+
+// k-d tree over way-points. Queries visit points in order of increasing distance,
+// so expensive filters (visibility tests) are called only until first match.
+class WayPointIndex final {
+  public:
+    WayPointIndex() = default;
+
+    void   build(std::vector<const WayPoint*> points);
+    void   clear();
+    size_t size() const { return points.size(); }
+
+    // nearest point within R, accepted by filter
+    template<class F>
+    const WayPoint* findNearest(const Tempest::Vec3& at, float R, const F& filter) const {
+      struct Ctx {
+        const F*        filter;
+        const WayPoint* ret;
+        } ctx = {&filter, nullptr};
+      implFind(at,R,&ctx,[](void* c, const WayPoint& w){
+        auto& ctx = *reinterpret_cast<Ctx*>(c);
+        if(!(*ctx.filter)(w))
+          return false;
+        ctx.ret = &w;
+        return true;
+        });
+      return ctx.ret;
+      }
+
+    // up to k nearest points within R, accepted by filter; closest first
+    template<class F>
+    void findNearest(const Tempest::Vec3& at, float R, size_t k, const F& filter, std::vector<const WayPoint*>& out) const {
+      out.clear();
+      if(k==0)
+        return;
+      struct Ctx {
+        const F*                      filter;
+        std::vector<const WayPoint*>* out;
+        size_t                        k;
+        } ctx = {&filter, &out, k};
+      implFind(at,R,&ctx,[](void* c, const WayPoint& w){
+        auto& ctx = *reinterpret_cast<Ctx*>(c);
+        if(!(*ctx.filter)(w))
+          return false;
+        ctx.out->push_back(&w);
+        return ctx.out->size()>=ctx.k;
+        });
+      }
+
+  private:
+    enum { LeafSize = 8 };
+
+    struct Node final {
+      Tempest::Vec3 bbox[2];
+      uint32_t      begin = 0;
+      uint32_t      end   = 0;
+      uint32_t      child = 0; // index of first of two children; 0 for leaf
+      };
+
+    std::vector<const WayPoint*> points;
+    std::vector<Tempest::Vec3>   pos;
+    std::vector<Node>            nodes;
+
+    void buildNode(uint32_t id);
+    // func returns true to stop the search
+    void implFind(const Tempest::Vec3& at, float R, void* ctx, bool (*func)(void*, const WayPoint&)) const;
+  };
@@ -3,7 +3,9 @@
 #include <fstream>
 #include <functional>
 #include <cctype>
+#include <algorithm>
 
+#include <Tempest/Application>
 #include <Tempest/Log>
 #include <Tempest/Painter>
 
@@ -17,6 +19,9 @@
 #include "game/globaleffects.h"
 #include "game/serialize.h"
 #include "utils/string_frm.h"
+#include "utils/cachefile.h"
+#include "utils/fileext.h"
+#include "utils/workers.h"
 #include "gothic.h"
 #include "focus.h"
 #include "resources.h"
@@ -62,6 +67,46 @@ const char* materialTag(phoenix::material_group src) {
   return "UD";
   }
 
+static void collectVisuals(const std::vector<std::unique_ptr<phoenix::vob>>& vobs,
+                           std::vector<std::string>& mesh, std::vector<std::string>& tex) {
+  // same mapping as ObjVisual::setVisual
+  for(auto& v:vobs) {
+    if(v==nullptr)
+      continue;
+    auto& visual = v->visual_name;
+    if(FileExt::hasExt(visual,"3DS") || FileExt::hasExt(visual,"MDS") || FileExt::hasExt(visual,"MMS")) {
+      mesh.push_back(visual);
+      }
+    else if(FileExt::hasExt(visual,"ASC")) {
+      auto mdl = visual;
+      FileExt::exchangeExt(mdl,"ASC","MDL");
+      mesh.push_back(std::move(mdl));
+      }
+    else if(FileExt::hasExt(visual,"TGA") && v->sprite_camera_facing_mode==phoenix::sprite_alignment::none) {
+      tex.push_back(visual);
+      }
+    collectVisuals(v->children,mesh,tex);
+    }
+  }
+
+static void dedup(std::vector<std::string>& v) {
+  std::sort(v.begin(),v.end());
+  v.erase(std::unique(v.begin(),v.end()),v.end());
+  }
+
+static PackedMesh packLandscape(std::string_view world, const phoenix::mesh& mesh, uint64_t key) {
+  const auto name = std::string(world)+".lnd";
+  auto       data = CacheFile::read(name,key);
+  PackedMesh ret;
+  if(!data.empty() && ret.deserialize(data,mesh))
+    return ret;
+
+  ret = PackedMesh(mesh,PackedMesh::PK_VisualLnd);
+  auto blob = ret.serialize();
+  CacheFile::write(name,key,blob.data(),blob.size());
+  return ret;
+  }
+
 World::World(GameSession& game, std::string_view file, bool startup, std::function<void(int)> loadProgress)
   :wname(std::move(file)), game(game), wsound(game,*this), wobj(*this) {
   const phoenix::vdf_entry* entry = Resources::vdfsIndex().find_entry(wname);
@@ -72,34 +117,54 @@ World::World(GameSession& game, std::string_view file, bool startup, std::functi
     }
 
   try {
+    uint64_t time[7] = {};
+    time[0] = Tempest::Application::tickCount();
+
     auto buf = entry->open();
+    // key of landscape caches: packed meshes and physics are derived from zen content only
+    const uint64_t landKey = CacheFile::hash(buf.array(),buf.limit());
     auto world = phoenix::world::parse(buf, version().game == 1 ? phoenix::game_version::gothic_1
                                                                 : phoenix::game_version::gothic_2);
+    time[1] = Tempest::Application::tickCount();
     loadProgress(20);
 
     auto& worldMesh = world.world_mesh;
     {
-      PackedMesh vmesh(worldMesh,PackedMesh::PK_VisualLnd);
+      PackedMesh vmesh = packLandscape(wname,worldMesh,landKey);
       wview.reset   (new WorldView(*this,vmesh));
     }
 
+    time[2] = Tempest::Application::tickCount();
     loadProgress(50);
-    wdynamic.reset(new DynamicWorld(*this,worldMesh));
+    wdynamic.reset(new DynamicWorld(*this,worldMesh,landKey));
+    time[3] = Tempest::Application::tickCount();
     loadProgress(70);
 
     globFx.reset(new GlobalEffects(*this));
 
     wmatrix.reset(new WayMatrix(*this,world.world_way_net));
 
+    prefetchVisuals(world.world_vobs);
+    time[4] = Tempest::Application::tickCount();
+
     for(auto& vob:world.world_vobs)
       wobj.addRoot(vob,startup);
+    time[5] = Tempest::Application::tickCount();
 
     wmatrix->buildIndex();
+    time[6] = Tempest::Application::tickCount();
+    Tempest::Log::i("world loaded: parse = ",   time[1]-time[0],
+                    "ms, landscape = ",         time[2]-time[1],
+                    "ms, physics = ",           time[3]-time[2],
+                    "ms, prefetch = ",          time[4]-time[3],
+                    "ms, vobs = ",              time[5]-time[4],
+                    "ms, waynet = ",            time[6]-time[5], "ms");
     // bsp = std::move(world.world_bsp_tree);
     bsp.nodes             = std::move(world.world_bsp_tree.nodes);
     bsp.sectors           = std::move(world.world_bsp_tree.sectors);
     bsp.leaf_node_indices = std::move(world.world_bsp_tree.leaf_node_indices);
     bsp.sectorsData.resize(bsp.sectors.size());
+    bsp.index.build(bsp.nodes,bsp.sectors,bsp.leaf_node_indices);
     loadProgress(100);
     }
   catch(...) {
@@ -284,50 +349,17 @@ Npc *World::findNpcByInstance(size_t instance) {
   }
 
 std::string_view World::roomAt(const Tempest::Vec3& p) {
-  if(bsp.nodes.empty())
-    return "";
-
-  const auto* node=&bsp.nodes[0];
-
-  while(true) {
-    const auto v    = node->plane;
-    float        sgn  = v.x*p.x + v.y*p.y + v.z*p.z - v.w;
-    uint32_t     next = (sgn>0) ? uint32_t(node->front_index) : uint32_t(node->back_index);
-    if(next>=bsp.nodes.size())
-      break;
-
-    node = &bsp.nodes[next];
-    }
-
-  if(node->bbox.min.x <= p.x && p.x <node->bbox.max.x &&
-     node->bbox.min.y <= p.y && p.y <node->bbox.max.y &&
-     node->bbox.min.z <= p.z && p.z <node->bbox.max.z) {
-    return roomAt(*node);
-    }
-
+  const size_t leaf = BspIndex::leafAt(bsp.nodes,p);
+  if(leaf<bsp.nodes.size())
+    return roomAt(bsp.nodes[leaf]);
   return "";
   }
 
 std::string_view World::roomAt(const phoenix::bsp_node& node) {
-  const std::string* ret=nullptr;
-  size_t       count=0;
-  auto         id = &node-bsp.nodes.data();(void)id;
-
-  for(auto& i:bsp.sectors) {
-    for(auto r:i.node_indices)
-      if(r<bsp.leaf_node_indices.size()){
-        size_t idx = bsp.leaf_node_indices[r];
-        if(idx>=bsp.nodes.size())
-          continue;
-        if(&bsp.nodes[idx]==&node) {
-          ret = &i.name;
-          count++;
-          }
-        }
-    }
-  if(count==1) {
+  const uint32_t id = bsp.index.sectorOf(size_t(&node-bsp.nodes.data()));
+  if(id!=BspIndex::NoSector) {
     // TODO: portals
-    return *ret;
+    return bsp.sectors[id].name;
     }
   static std::string empty;
   return empty;
@@ -337,10 +369,10 @@ World::BspSector* World::portalAt(std::string_view tag) {
   if(tag.empty())
     return nullptr;
 
-  for(size_t i=0;i<bsp.sectors.size();++i)
-    if(bsp.sectors[i].name==tag)
-      return &bsp.sectorsData[i];
-  return nullptr;
+  const uint32_t id = bsp.index.findSector(tag);
+  if(id==BspIndex::NoSector)
+    return nullptr;
+  return &bsp.sectorsData[id];
   }
 
 void World::scaleTime(uint64_t& dt) {
@@ -359,10 +391,42 @@ void World::tick(uint64_t dt) {
   globFx->tick(dt);
   }
 
+void World::prefetchVisuals(const std::vector<std::unique_ptr<phoenix::vob>>& vobs) {
+  // decode assets in parallel, so vob-tree instantiation mostly hits Resources cache
+  std::vector<std::string> mesh, tex;
+  collectVisuals(vobs,mesh,tex);
+  dedup(mesh);
+  dedup(tex);
+
+  Workers::parallelTasks(mesh,[](std::string& name) {
+    try {
+      Resources::loadMesh(name);
+      }
+    catch(...) {
+      // reported later, by actual vob load
+      }
+    });
+  Workers::parallelTasks(tex,[](std::string& name) {
+    Resources::loadTexture(name);
+    });
+  }
+
 uint64_t World::tickCount() const {
   return game.tickCount();
   }
 
+float World::npcTickTime() const {
+  return wobj.npcTickTime();
+  }
+
+bool World::isAiLod() const {
+  return wobj.isAiLod();
+  }
+
+void World::setAiLod(bool l) {
+  wobj.setAiLod(l);
+  }
+
 void World::setDayTime(int32_t h, int32_t min) {
   gtime now     = game.time();
   auto  day     = now.day();
@@ -762,6 +826,10 @@ void World::invalidateVobIndex() {
   wobj.invalidateVobIndex();
   }
 
+void World::updateNpcIndex(Npc& npc) {
+  wobj.updateNpcIndex(npc);
+  }
+
 const phoenix::c_focus& World::searchPolicy(const Npc& pl, TargetCollect& coll, WorldObjects::SearchFlg& opt) const {
   opt  = WorldObjects::NoFlg;
   coll = TARGET_COLLECT_FOCUS;
@@ -873,6 +941,10 @@ void World::detectItem(const Tempest::Vec3& p, const float r, const std::functio
   wobj.detectItem(p.x,p.y,p.z,r,f);
   }
 
+bool World::lineOfSight(const Tempest::Vec3& from, const Tempest::Vec3& to) const {
+  return wobj.lineOfSight(from,to);
+  }
+
 WayPath World::wayTo(const Npc &npc, const WayPoint &end) const {
   auto p     = npc.position();
 
@@ -946,11 +1018,7 @@ int32_t World::guildOfRoom(std::string_view portalName) {
     return -1;
 
   auto name = portalName.substr(b,e-b);
-
-  for(size_t i=0;i<bsp.sectors.size();++i) {
-    auto& s = bsp.sectors[i].name;
-    if(s==name)
-      return bsp.sectorsData[i].guild;
-    }
+  if(auto room=portalAt(name))
+    return room->guild;
   return GIL_NONE;
   }
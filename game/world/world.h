@@ -14,6 +14,7 @@
 #include "game/gamescript.h"
 #include "physics/dynamicworld.h"
 #include "worldobjects.h"
+#include "bspindex.h"
 #include "worldsound.h"
 #include "waypoint.h"
 #include "waymatrix.h"
@@ -70,6 +71,7 @@ class World final {
     void                 detectNpcNear(std::function<void(Npc&)> f);
     void                 detectNpc (const Tempest::Vec3& p, const float r, const std::function<void(Npc&)>& f);
     void                 detectItem(const Tempest::Vec3& p, const float r, const std::function<void(Item&)>& f);
+    bool                 lineOfSight(const Tempest::Vec3& from, const Tempest::Vec3& to) const;
 
     WayPath              wayTo(const Npc& pos,const WayPoint& end) const;
 
@@ -110,6 +112,9 @@ class World final {
     void                 scaleTime(uint64_t& dt);
     void                 tick(uint64_t dt);
     uint64_t             tickCount() const;
+    float                npcTickTime() const;
+    bool                 isAiLod() const;
+    void                 setAiLod(bool l);
     void                 setDayTime(int32_t h,int32_t min);
     gtime                time() const;
 
@@ -172,6 +177,7 @@ class World final {
     void                 addSound      (const phoenix::vob& vob);
 
     void                 invalidateVobIndex();
+    void                 updateNpcIndex(Npc& npc);
 
   private:
     const phoenix::c_focus&     searchPolicy(const Npc& pl, TargetCollect& coll, WorldObjects::SearchFlg& opt) const;
@@ -189,6 +195,7 @@ class World final {
       std::vector<phoenix::bsp_sector>      sectors;
       std::vector<std::uint64_t>            leaf_node_indices;
       std::vector<BspSector>                sectorsData;
+      BspIndex                              index;
       } bsp;
 
     Npc*                                  npcPlayer=nullptr;
@@ -202,6 +209,7 @@ class World final {
 
     auto         roomAt(const phoenix::bsp_node &node) -> std::string_view;
     auto         portalAt(std::string_view tag) -> BspSector*;
+    void         prefetchVisuals(const std::vector<std::unique_ptr<phoenix::vob>>& vobs);
 
     void         initScripts(bool firstTime);
 
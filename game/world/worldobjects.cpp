@@ -21,6 +21,9 @@
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <chrono>
+#include <cmath>
+
 using namespace Tempest;
 
 int32_t WorldObjects::MobStates::stateByTime(gtime t) const {
@@ -60,6 +63,10 @@ WorldObjects::SearchOpt::SearchOpt(float rangeMin, float rangeMax, float azi, Ta
 
 WorldObjects::WorldObjects(World& owner):owner(owner){
   npcNear.reserve(512);
+  aiLod.enabled         = Gothic::settingsGetI("GAME","aiLod")!=0;
+  aiLod.farPeriod       = uint32_t(std::max(Gothic::settingsGetI("GAME","aiFarTickPeriod"), 1));
+  aiLod.far2Period      = uint32_t(std::max(Gothic::settingsGetI("GAME","aiFar2TickPeriod"),1));
+  aiLod.far2RoutineOnly = Gothic::settingsGetI("GAME","aiFar2RoutineOnly")!=0;
   }
 
 WorldObjects::~WorldObjects() {
@@ -82,6 +89,7 @@ void WorldObjects::load(Serialize &fin) {
   for(size_t i=0; i<npcArr.size(); ++i) {
     npcArr[i]->load(fin,i);
     }
+  rebuildNpcIndex();
 
   fin.setEntry("worlds/",fin.worldName(),"/items");
   fin.read(sz);
@@ -163,12 +171,23 @@ void WorldObjects::tick(uint64_t dt, uint64_t dtPlayer) {
 
   const bool freeCam = (Gothic::inst().camera()!=nullptr && Gothic::inst().camera()->isFree());
   const auto pl      = owner.player();
+  const auto time0   = std::chrono::steady_clock::now();
   for(size_t i=0; i<npcArr.size(); ++i) {
     auto& npc = *npcArr[i];
-    uint64_t d = (pl==&npc ? dtPlayer : dt);
-    if(freeCam && pl==&npc)
+    if(pl==&npc) {
+      if(!freeCam)
+        npc.tick(dtPlayer);
       continue;
-    npc.tick(d);
+      }
+    tickNpc(npc,i,dt);
+    }
+  tickFrame++;
+
+  // average over several frames, to not flicker
+  npcTickSum += std::chrono::duration<float,std::micro>(std::chrono::steady_clock::now()-time0).count();
+  if(tickFrame%npcTickFrames==0) {
+    npcTickAvg = npcTickSum/float(npcTickFrames*1000);
+    npcTickSum = 0;
     }
 
   for(auto& i:routines) {
@@ -203,29 +222,13 @@ void WorldObjects::tick(uint64_t dt, uint64_t dtPlayer) {
   if(pl==nullptr)
     return;
 
-  npcNear.clear();
-  const int   PERC_DIST_INTERMEDIAT = 1000;
-  const float nearDist              = 3000*3000;
-  const float farDist               = 6000*6000;
-
-  auto plPos = pl->position();
-  for(auto& i:npcArr) {
-    float dist = (i->position()-plPos).quadLength();
-    if(dist<nearDist){
-      npcNear.push_back(i.get());
-      if(i.get()!=pl)
-        i->setProcessPolicy(Npc::ProcessPolicy::AiNormal);
-      } else
-    if(dist<farDist) {
-      i->setProcessPolicy(Npc::ProcessPolicy::AiFar);
-      } else {
-      i->setProcessPolicy(Npc::ProcessPolicy::AiFar2);
-      }
-    }
+  const int PERC_DIST_INTERMEDIAT = 1000;
+  tickPolicy(*pl);
   tickNear(dt);
   for(CollisionZone* z:collisionZn)
     z->tick(dt);
   tickTriggers(dt);
+  tickSenses(passive);
 
   for(auto& ptr:npcNear) {
     Npc& i = *ptr;
@@ -330,6 +333,7 @@ Npc* WorldObjects::addNpc(size_t npcInstance, std::string_view at) {
     npc->attachToPoint(pos);
     npc->updateTransform();
     npcArr.emplace_back(npc);
+    indexNpc(*npc);
     } else {
     auto& point = owner.deadPoint();
     npc->attachToPoint(nullptr);
@@ -348,6 +352,7 @@ Npc* WorldObjects::addNpc(size_t npcInstance, const Vec3& pos) {
   npc->updateTransform();
 
   npcArr.emplace_back(npc);
+  indexNpc(*npc);
   return npc;
   }
 
@@ -369,6 +374,7 @@ Npc* WorldObjects::insertPlayer(std::unique_ptr<Npc> &&npc, std::string_view at)
   npc->attachToPoint(pos);
   npc->updateTransform();
   npcArr.emplace_back(std::move(npc));
+  indexNpc(*npcArr.back());
   return npcArr.back().get();
   }
 
@@ -379,12 +385,91 @@ std::unique_ptr<Npc> WorldObjects::takeNpc(const Npc* ptr) {
       auto ret=std::move(npcArr[i]);
       npcArr[i] = std::move(npcArr.back());
       npcArr.pop_back();
+      npcIndex.erase(*ret);
+      std::erase(npcActive,ret.get());
+      std::erase(npcNear,  ret.get());
       return ret;
       }
     }
   return nullptr;
   }
 
+void WorldObjects::tickPolicy(Npc& pl) {
+  // only npcs around player are classified; those, that left far range since last tick, become AiFar2
+  const auto plPos = pl.position();
+  npcScratch.clear();
+  npcIndex.find(plPos,npcFarDist,[this](Npc& n){
+    npcScratch.push_back(&n);
+    });
+  // same order as in npcArr: perception is processed in npcNear order
+  std::sort(npcScratch.begin(),npcScratch.end(),[](Npc* a, Npc* b){
+    return a->handle().id<b->handle().id;
+    });
+
+  npcNear.clear();
+  for(auto i:npcScratch) {
+    float dist = (i->position()-plPos).quadLength();
+    if(dist<npcNearDist*npcNearDist){
+      npcNear.push_back(i);
+      if(i!=&pl)
+        i->setProcessPolicy(Npc::ProcessPolicy::AiNormal);
+      } else {
+      i->setProcessPolicy(Npc::ProcessPolicy::AiFar);
+      }
+    }
+
+  std::sort(npcScratch.begin(),npcScratch.end());
+  for(auto i:npcActive)
+    if(!std::binary_search(npcScratch.begin(),npcScratch.end(),i))
+      i->setProcessPolicy(Npc::ProcessPolicy::AiFar2);
+  std::swap(npcActive,npcScratch);
+  }
+
+void WorldObjects::tickNpc(Npc& npc, size_t slot, uint64_t dt) {
+  AiLod::Tier tier = AiLod::Near;
+  switch(npc.processPolicy()) {
+    case Npc::ProcessPolicy::Player:
+    case Npc::ProcessPolicy::AiNormal:
+      break;
+    case Npc::ProcessPolicy::AiFar:
+      tier = AiLod::Far;
+      break;
+    case Npc::ProcessPolicy::AiFar2:
+      tier = AiLod::Far2;
+      break;
+    }
+
+  switch(aiLod.schedule(tier,tickFrame,slot)) {
+    case AiLod::T_Full:
+      npc.tick(dt);
+      break;
+    case AiLod::T_Skip:
+      npc.skipTick(dt);
+      break;
+    case AiLod::T_RoutineOnly:
+      npc.tickRoutineOnly(dt,npcFarDist);
+      break;
+    }
+  }
+
+void WorldObjects::indexNpc(Npc& npc) {
+  npcIndex.insert(npc);
+  // new npc is classified on next tick
+  npcActive.push_back(&npc);
+  }
+
+void WorldObjects::rebuildNpcIndex() {
+  npcIndex.clear();
+  npcActive.clear();
+  npcNear.clear();
+  for(auto& i:npcArr)
+    indexNpc(*i);
+  }
+
+void WorldObjects::updateNpcIndex(Npc& npc) {
+  npcIndex.move(npc);
+  }
+
 void WorldObjects::tickNear(uint64_t /*dt*/) {
   for(Npc* i:npcNear) {
     auto pos = i->position() + Vec3(0,i->translateY(),0);
@@ -394,6 +479,80 @@ void WorldObjects::tickNear(uint64_t /*dt*/) {
     }
   }
 
+void WorldObjects::tickSenses(const std::vector<PerceptionMsg>& passive) {
+  // sense phase: line-of-sight rays, that perception below is going to ask for, are cast in parallel
+  // scripts are still called serially, canSenseNpc picks results from losBatch
+  const uint64_t now = owner.tickCount();
+  losBatch.begin(now);
+
+  auto add = [&](Npc& self, const Npc* other, float extRange) {
+    if(other==nullptr || other==&self)
+      return;
+    const auto  mid   = other->bounds().midTr;
+    const float range = float(self.handle().senses_range)+extRange;
+    if(self.qDistTo(mid.x,mid.y,mid.z)>range*range)
+      return;
+    losBatch.request(self.mapHeadBone(),mid);
+    };
+
+  const int PERC_DIST_INTERMEDIAT = 1000;
+  for(Npc* ptr:npcNear) {
+    Npc& i = *ptr;
+    if(i.isPlayer() || i.isDead() || i.processPolicy()!=Npc::AiNormal)
+      continue;
+
+    if(i.percNextTime()<=now) {
+      // same candidates as in Npc::perceptionProcess
+      const bool enemy = i.hasPerc(PERC_ASSESSENEMY);
+      const bool body  = i.hasPerc(PERC_ASSESSBODY);
+      if(i.hasPerc(PERC_ASSESSPLAYER))
+        add(i,owner.player(),0);
+      if(enemy || body) {
+        // margin: range is tested against bounding-box center of target
+        const float range = float(i.handle().senses_range)+200.f;
+        npcIndex.find(i.position(),range,[&](Npc& n){
+          auto p = n.processPolicy();
+          if(p==Npc::AiFar || p==Npc::AiFar2)
+            return; // not in npcNear
+          if(n.isDead() ? body : (enemy && !n.isDown() && i.isEnemy(n)))
+            add(i,&n,0);
+          });
+        }
+      }
+
+    if(i.isDown() || !i.isAiQueueEmpty())
+      continue;
+    for(auto& r:passive) {
+      if(r.self==&i || r.other==nullptr)
+        continue;
+      const float l     = i.qDistTo(r.pos.x,r.pos.y,r.pos.z);
+      const float range = float(std::min(i.handle().senses_range,PERC_DIST_INTERMEDIAT));
+      if(l>range*range)
+        continue;
+      add(i,r.other,0);
+      add(i,r.victum,float(r.other->handle().senses_range));
+      }
+    }
+
+  auto& rays = losBatch.pending();
+  if(rays.empty())
+    return;
+  losQuery.resize(rays.size());
+  losResult.resize(rays.size());
+  for(size_t i=0; i<rays.size(); ++i)
+    losQuery[i] = {rays[i].from,rays[i].to};
+  owner.physic()->rayBatch(losQuery.data(),losResult.data(),losQuery.size());
+  for(size_t i=0; i<losResult.size(); ++i)
+    losBatch.resolve(i,!losResult[i].hasCol);
+  }
+
+bool WorldObjects::lineOfSight(const Vec3& from, const Vec3& to) const {
+  bool clear = false;
+  if(losBatch.find(from,to,owner.tickCount(),clear))
+    return clear;
+  return !owner.physic()->ray(from,to).hasCol;
+  }
+
 void WorldObjects::tickTriggers(uint64_t /*dt*/) {
   auto evt = std::move(triggerEvents);
   triggerEvents.clear();
@@ -432,8 +591,9 @@ void WorldObjects::updateAnimation(uint64_t dt) {
   }
 
 bool WorldObjects::isTargeted(Npc& dst) {
+  // isTargetedBy requires AiNormal: no need to look outside of npcActive
   std::atomic_flag flg = ATOMIC_FLAG_INIT;
-  Workers::parallelFor(npcArr,[&dst,&flg](std::unique_ptr<Npc>& i) {
+  Workers::parallelFor(npcActive,[&dst,&flg](Npc* i) {
     if(isTargetedBy(*i,dst))
       flg.test_and_set();
     });
@@ -472,12 +632,7 @@ void WorldObjects::detectNpcNear(const std::function<void(Npc&)>& f) {
 
 void WorldObjects::detectNpc(const float x, const float y, const float z,
                              const float r, const std::function<void(Npc&)>& f) {
-  float maxDist=r*r;
-  for(auto& i:npcArr) {
-    auto qDist = (i->position()-Vec3(x,y,z)).quadLength();
-    if(qDist<maxDist)
-      f(*i);
-    }
+  npcIndex.find(Vec3(x,y,z),r,f);
   }
 
 void WorldObjects::detectItem(const float x, const float y, const float z,
@@ -881,6 +1036,7 @@ void WorldObjects::resetPositionToTA() {
       npc.updateTransform();
       }
     }
+  rebuildNpcIndex();
   for(auto& i:routines) {
     auto s = i.stateByTime(owner.time());
     i.curState = s;
@@ -5,7 +5,10 @@
 
 #include <phoenix/vobs/misc.hh>
 
+#include "ailod.h"
 #include "bullet.h"
+#include "losbatch.h"
+#include "npcgrid.h"
 #include "spaceindex.h"
 #include "game/gametime.h"
 #include "game/perceptionmsg.h"
@@ -49,11 +52,16 @@ class WorldObjects final {
     void           load(Serialize& fout);
     void           save(Serialize& fout);
     void           tick(uint64_t dt, uint64_t dtPlayer);
+    // wall time of npc tick, milliseconds per frame
+    float          npcTickTime() const { return npcTickAvg; }
+    bool           isAiLod() const { return aiLod.enabled; }
+    void           setAiLod(bool l) { aiLod.enabled = l; }
 
     Npc*           addNpc(size_t itemInstance, std::string_view     at);
     Npc*           addNpc(size_t itemInstance, const Tempest::Vec3& at);
     Npc*           insertPlayer(std::unique_ptr<Npc>&& npc, std::string_view at);
     auto           takeNpc(const Npc* npc) -> std::unique_ptr<Npc>;
+    void           updateNpcIndex(Npc& npc);
 
     void           updateAnimation(uint64_t dt);
 
@@ -63,6 +71,7 @@ class WorldObjects final {
     void           detectNpcNear(const std::function<void(Npc&)>& f);
     void           detectNpc (const float x, const float y, const float z, const float r, const std::function<void(Npc&)>&  f);
     void           detectItem(const float x, const float y, const float z, const float r, const std::function<void(Item&)>& f);
+    bool           lineOfSight(const Tempest::Vec3& from, const Tempest::Vec3& to) const;
 
     uint32_t       npcId(const Npc *ptr) const;
     size_t         npcCount()    const { return npcArr.size(); }
@@ -163,6 +172,9 @@ class WorldObjects final {
     std::vector<std::unique_ptr<Npc>>  npcArr;
     std::vector<std::unique_ptr<Npc>>  npcInvalid;
     std::vector<Npc*>                  npcNear;
+    NpcGrid<Npc>                       npcIndex;
+    std::vector<Npc*>                  npcActive;  // npcs with policy other than AiFar2 (except player)
+    std::vector<Npc*>                  npcScratch;
 
     std::vector<AbstractTrigger*>      triggers;
     std::vector<AbstractTrigger*>      triggersZn;
@@ -170,6 +182,20 @@ class WorldObjects final {
     std::vector<PerceptionMsg>         sndPerc;
     std::vector<TriggerEvent>          triggerEvents;
 
+    LosBatch                                    losBatch;
+    std::vector<DynamicWorld::RayQuery>         losQuery;
+    std::vector<DynamicWorld::RayQueryResult>   losResult;
+
+    static constexpr float npcNearDist = 3000;
+    static constexpr float npcFarDist  = 6000;
+
+    uint64_t                           tickFrame          = 0;
+    AiLod                              aiLod;
+
+    static constexpr uint64_t          npcTickFrames      = 64;
+    float                              npcTickSum         = 0;
+    float                              npcTickAvg         = 0;
+
     template<class T>
     auto findObj(T &src, const Npc &pl, const SearchOpt& opt) -> typename std::remove_reference<decltype(src[0])>::type;
 
@@ -181,6 +207,11 @@ class WorldObjects final {
     void             setMobState(std::string_view scheme, int32_t st);
 
     void             tickNear(uint64_t dt);
+    void             tickPolicy(Npc& pl);
+    void             tickNpc(Npc& npc, size_t slot, uint64_t dt);
+    void             indexNpc(Npc& npc);
+    void             rebuildNpcIndex();
+    void             tickSenses(const std::vector<PerceptionMsg>& passive);
     void             tickTriggers(uint64_t dt);
     static bool      isTargetedBy(Npc& npc,Npc& by);
   };
@@ -50,11 +50,15 @@ struct WorldSound::Zone final {
 
 void WorldSound::Effect::setOcclusion(float v) {
   occ = v;
-  eff.setVolume(occ*vol);
+  updateVolume();
   }
 
 void WorldSound::Effect::setVolume(float v) {
   vol = v;
+  updateVolume();
+  }
+
+void WorldSound::Effect::updateVolume() {
   eff.setVolume(occ*vol);
   }
 
@@ -80,6 +84,7 @@ void WorldSound::addZone(const phoenix::vobs::zone_music &vob) {
   z.bbox[1] = {vob.bbox.max.x, vob.bbox.max.y, vob.bbox.max.z};
   z.name    = vob.vob_name;
 
+  zoneGrid.insert(uint32_t(zones.size()),z.bbox[0],z.bbox[1]);
   zones.emplace_back(std::move(z));
   }
 
@@ -108,6 +113,9 @@ void WorldSound::addSound(const phoenix::vobs::sound &vob) {
     s.sndEnd   = gtime(24,0);
     }
 
+  // same range, as in isInListenerRange
+  const float r = s.sndRadius+800;
+  worldEffGrid.insert(uint32_t(worldEff.size()),s.pos-Tempest::Vec3(r,r,r),s.pos+Tempest::Vec3(r,r,r));
   worldEff.emplace_back(std::move(s));
   }
 
@@ -160,49 +168,67 @@ void WorldSound::tick(Npc& player) {
 
   game.updateListenerPos(cx);
 
-  for(auto& i:worldEff) {
-    if(!i.active || !i.current.isFinished())
-      continue;
-    if(i.current.isFinished())
+  // release sounds, that are done; listener may be far away from them by now
+  for(size_t r=0; r<worldEffPlaying.size(); ) {
+    auto& i = worldEff[worldEffPlaying[r]];
+    if(i.current.isFinished()) {
       i.current = Sound();
+      worldEffPlaying[r] = worldEffPlaying.back();
+      worldEffPlaying.pop_back();
+      } else {
+      ++r;
+      }
+    }
 
-    if(i.restartTimeout>owner.tickCount() && !i.loop)
-      continue;
+  for(auto* ids:{&worldEffGrid.at(plPos), &worldEffGrid.everywhere()})
+    for(auto id:*ids) {
+      auto& i = worldEff[id];
+      if(!i.active || !i.current.isFinished())
+        continue;
 
-    if(!isInListenerRange(i.pos,i.sndRadius))
-      continue;
+      if(i.restartTimeout>owner.tickCount() && !i.loop)
+        continue;
 
-    auto time = owner.time();
-    time = gtime(0,time.hour(),time.minute());
+      if(!isInListenerRange(i.pos,i.sndRadius))
+        continue;
 
-    const SoundFx* snd = nullptr;
-    if(i.sndStart<= time && time<i.sndEnd) {
-      snd = i.eff0;
-      } else {
-      snd = i.eff1;
-      }
+      auto time = owner.time();
+      time = gtime(0,time.hour(),time.minute());
 
-    if(snd==nullptr)
-      continue;
+      const SoundFx* snd = nullptr;
+      if(i.sndStart<= time && time<i.sndEnd) {
+        snd = i.eff0;
+        } else {
+        snd = i.eff1;
+        }
 
-    i.current = implAddSound(*snd,i.pos,i.sndRadius);
-    if(!i.current.isEmpty()) {
-      effect.emplace_back(i.current.val);
-      i.current.play();
-      }
+      if(snd==nullptr)
+        continue;
 
-    i.restartTimeout = owner.tickCount() + i.delay;
-    if(i.delayVar>0)
-      i.restartTimeout += uint64_t(std::rand())%i.delayVar;
+      i.current = implAddSound(*snd,i.pos,i.sndRadius);
+      if(!i.current.isEmpty()) {
+        effect.emplace_back(i.current.val);
+        worldEffPlaying.push_back(id);
+        i.current.play();
+        }
 
-    if(!i.loop)
-      i.active = false;
-    }
+      i.restartTimeout = owner.tickCount() + i.delay;
+      if(i.delayVar>0)
+        i.restartTimeout += uint64_t(std::rand())%i.delayVar;
 
-  tickSlot(effect);
-  tickSlot(effect3d);
+      if(!i.loop)
+        i.active = false;
+      }
+
+  const uint64_t now = owner.tickCount();
+  const uint64_t dt  = now>lastTick ? now-lastTick : 0;
+  lastTick = now;
+
+  tickSlot(effect,dt);
+  tickSlot(effect3d,dt);
   for(auto& i:freeSlot)
-    tickSlot(*i.second);
+    tickSlot(*i.second,dt);
+  tickOcclusion();
   tickSoundZone(player);
   }
 
@@ -226,11 +252,16 @@ void WorldSound::tickSoundZone(Npc& player) {
      currentZone->checkPos(plPos.x,plPos.y+player.translateY(),plPos.z)){
     zone = currentZone;
     } else {
-    for(auto& z:zones) {
-      if(z.checkPos(plPos.x,plPos.y+player.translateY(),plPos.z)) {
-        zone = &z;
+    // last zone in the list wins
+    uint32_t zId = uint32_t(-1);
+    for(auto* ids:{&zoneGrid.at(plPos), &zoneGrid.everywhere()})
+      for(auto id:*ids) {
+        auto& z = zones[id];
+        if((zId==uint32_t(-1) || id>zId) && z.checkPos(plPos.x,plPos.y+player.translateY(),plPos.z))
+          zId = id;
         }
-      }
+    if(zId!=uint32_t(-1))
+      zone = &zones[zId];
     }
 
   gtime           time  = owner.time().timeInDay();
@@ -272,7 +303,7 @@ void WorldSound::tickSoundZone(Npc& player) {
         }
   }
 
-void WorldSound::tickSlot(std::vector<PEffect>& effect) {
+void WorldSound::tickSlot(std::vector<PEffect>& effect, uint64_t dt) {
   for(size_t i=0;i<effect.size();) {
     auto& e = *effect[i];
     if(e.eff.isFinished() && !(e.loop && e.active)){
@@ -283,11 +314,11 @@ void WorldSound::tickSlot(std::vector<PEffect>& effect) {
       }
     }
   for(auto& i:effect) {
-    tickSlot(*i);
+    tickSlot(*i,dt);
     }
   }
 
-void WorldSound::tickSlot(Effect& slot) {
+void WorldSound::tickSlot(Effect& slot, uint64_t dt) {
   if(slot.eff.isFinished()) {
     if(!slot.loop)
       return;
@@ -296,23 +327,35 @@ void WorldSound::tickSlot(Effect& slot) {
 
   if(slot.ambient) {
     slot.setOcclusion(1.f);
-    } else {
-    auto  dyn  = owner.physic();
-    auto  head = plPos;
-    auto  pos  = slot.pos;
-    float occ  = 1;
-
-    if((pos-head).quadLength()<slot.maxDist*slot.maxDist)
-      occ = dyn->soundOclusion(head, pos);
-    slot.setOcclusion(std::max(0.f,1.f-occ));
+    return;
+    }
+
+  const auto head = plPos;
+  const auto pos  = slot.pos;
+  if((pos-head).quadLength()>=slot.maxDist*slot.maxDist) {
+    occlusion.reset(slot);
+    slot.updateVolume();
+    return;
     }
+
+  if(occlusion.tick(slot,head,pos,dt,lastTick))
+    slot.updateVolume();
+  }
+
+void WorldSound::tickOcclusion() {
+  auto dyn = owner.physic();
+  occlusion.flush(lastTick,[dyn](const Tempest::Vec3& from, const Tempest::Vec3& to) {
+    return dyn->soundOclusion(from,to);
+    },[](SoundOcclusion::Slot& slot) {
+    static_cast<Effect&>(slot).updateVolume();
+    });
   }
 
 void WorldSound::initSlot(WorldSound::Effect& slot) {
   auto  dyn = owner.physic();
-  auto  pos = slot.pos;
-  float occ = dyn->soundOclusion(plPos, pos);
-  slot.setOcclusion(std::max(0.f,1.f-occ));
+  float occ = dyn->soundOclusion(plPos, slot.pos);
+  occlusion.init(slot,plPos,slot.pos,occ,lastTick);
+  slot.updateVolume();
   }
 
 bool WorldSound::setMusic(std::string_view zone, GameMusic::Tags tags) {
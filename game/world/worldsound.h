@@ -8,7 +8,10 @@
 #include <phoenix/vobs/sound.hh>
 
 #include <mutex>
+#include <unordered_map>
 
+#include "sound/soundocclusion.h"
+#include "world/soundgrid.h"
 #include "gamemusic.h"
 
 class GameSession;
@@ -43,11 +46,11 @@ class WorldSound final {
     struct WSound;
     struct Zone;
 
-    struct Effect {
+    // occlusion state is kept in base
+    struct Effect : SoundOcclusion::Slot {
       Tempest::SoundEffect eff;
       Tempest::Vec3        pos;
       float                vol     = 1.f;
-      float                occ     = 1.f;
       float                maxDist = 0.f;
       bool                 loop    = false;
       bool                 active  = true;
@@ -55,13 +58,15 @@ class WorldSound final {
 
       void setOcclusion(float occ);
       void setVolume(float v);
+      void updateVolume();
       };
 
     using PEffect = std::shared_ptr<Effect>;
 
     void    tickSoundZone(Npc& player);
-    void    tickSlot(std::vector<PEffect>& eff);
-    void    tickSlot(Effect& slot);
+    void    tickSlot(std::vector<PEffect>& eff, uint64_t dt);
+    void    tickSlot(Effect& slot, uint64_t dt);
+    void    tickOcclusion();
     void    initSlot(Effect& slot);
     bool    setMusic(std::string_view zone, GameMusic::Tags tags);
 
@@ -72,6 +77,7 @@ class WorldSound final {
     World&                                  owner;
 
     std::vector<Zone>                       zones;
+    SoundGrid                               zoneGrid;
     std::unique_ptr<Zone>                   def;
 
     uint64_t                                nextSoundUpdate=0;
@@ -84,6 +90,10 @@ class WorldSound final {
     std::vector<PEffect>                    effect;
     std::vector<PEffect>                    effect3d; // snd_play3d
     std::vector<WSound>                     worldEff;
+    SoundGrid                               worldEffGrid;
+    std::vector<uint32_t>                   worldEffPlaying;
+    SoundOcclusion                          occlusion;
+    uint64_t                                lastTick = 0;
 
     std::mutex                              sync;
 
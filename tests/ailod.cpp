@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "world/ailod.h"
+#include "testing.h"
+
+// Stand-in for Npc: scripts, world and physics are not available headless.
+// Full tick is a fixed amount of arithmetic, in place of AI queue, movement and animation;
+// routine-only tick is a cheap check, as Npc::tickRoutineOnly is, once npc stands at its routine point
+struct FakeNpc {
+  AiLod::Tier tier        = AiLod::Near;
+  uint64_t    skipped     = 0;
+  uint64_t    consumed    = 0;
+  uint32_t    ticks       = 0;
+  float       state       = 1;
+
+  void tick(uint64_t dt) {
+    consumed += dt+skipped;
+    skipped   = 0;
+    ticks++;
+    float s = state;
+    for(int i=0; i<400; ++i)
+      s = std::sqrt(s*1.0001f+float(i));
+    state = s;
+    }
+  void skipTick(uint64_t dt) {
+    skipped += dt;
+    }
+  void tickRoutineOnly(uint64_t dt) {
+    consumed += dt+skipped;
+    skipped   = 0;
+    ticks++;
+    }
+  };
+
+// same as WorldObjects::tickNpc
+static void tickNpc(const AiLod& lod, FakeNpc& npc, uint64_t frame, size_t slot, uint64_t dt) {
+  switch(lod.schedule(npc.tier,frame,slot)) {
+    case AiLod::T_Full:
+      npc.tick(dt);
+      break;
+    case AiLod::T_Skip:
+      npc.skipTick(dt);
+      break;
+    case AiLod::T_RoutineOnly:
+      npc.tickRoutineOnly(dt);
+      break;
+    }
+  }
+
+static AiLod defaultLod(bool enabled) {
+  // GAME settings defaults
+  AiLod lod;
+  lod.enabled         = enabled;
+  lod.farPeriod       = 2;
+  lod.far2Period      = 8;
+  lod.far2RoutineOnly = true;
+  return lod;
+  }
+
+// population of a big world: few npc near the player, most of them far away
+static std::vector<FakeNpc> population(size_t nearCnt, size_t farCnt, size_t far2Cnt) {
+  std::vector<FakeNpc> npc(nearCnt+farCnt+far2Cnt);
+  for(size_t i=0; i<npc.size(); ++i) {
+    // tiers are interleaved, as npcArr is sorted by instance id, not by distance
+    const size_t k = (i*7919)%npc.size();
+    npc[i].tier = k<nearCnt ? AiLod::Near : (k<nearCnt+farCnt ? AiLod::Far : AiLod::Far2);
+    }
+  return npc;
+  }
+
+static void testSchedule() {
+  const uint64_t Frames = 800, dt = 16;
+  for(bool enabled : {false,true}) {
+    const AiLod lod = defaultLod(enabled);
+    auto        npc = population(60,200,740);
+    std::vector<size_t> perFrame;
+    for(uint64_t f=0; f<Frames; ++f) {
+      size_t full = 0;
+      for(size_t i=0; i<npc.size(); ++i) {
+        const uint32_t t0 = npc[i].ticks;
+        tickNpc(lod,npc[i],f,i,dt);
+        if(npc[i].ticks!=t0 && lod.schedule(npc[i].tier,f,i)==AiLod::T_Full)
+          full++;
+        }
+      perFrame.push_back(full);
+      }
+
+    bool exact = true, time = true;
+    for(auto& n:npc) {
+      uint32_t period = 1;
+      if(enabled && n.tier==AiLod::Far)
+        period = lod.farPeriod;
+      if(enabled && n.tier==AiLod::Far2)
+        period = lod.far2Period;
+      // ticked exactly every period-th frame; no game time is lost
+      exact &= (n.ticks==Frames/period);
+      time  &= (n.consumed+n.skipped==Frames*dt);
+      }
+    CHECK(exact);
+    CHECK(time);
+
+    // load is spread evenly: no frame runs noticeably more full ticks than average
+    const auto mm = std::minmax_element(perFrame.begin(),perFrame.end());
+    if(!CHECK(*mm.second-*mm.first<=npc.size()/20))
+      std::fprintf(stderr,"  full ticks per frame: %d..%d\n",int(*mm.first),int(*mm.second));
+    }
+
+  // 1/1/off restores the old behaviour
+  AiLod lod = defaultLod(true);
+  lod.farPeriod       = 1;
+  lod.far2Period      = 1;
+  lod.far2RoutineOnly = false;
+  for(auto tier : {AiLod::Near,AiLod::Far,AiLod::Far2})
+    for(uint64_t f=0; f<16; ++f)
+      CHECK(lod.schedule(tier,f,size_t(f*3))==AiLod::T_Full);
+  }
+
+// tick cost per tier, LOD off and on
+static void bench() {
+  const uint64_t Frames = 400, dt = 16;
+  const size_t   cnt[3] = {60, 200, 740};
+  const char*    name[3] = {"near", "far", "far2"};
+
+  for(bool enabled : {false,true}) {
+    const AiLod lod = defaultLod(enabled);
+    auto        npc = population(cnt[0],cnt[1],cnt[2]);
+    double      us[3] = {};
+    for(uint64_t f=0; f<Frames; ++f) {
+      for(size_t i=0; i<npc.size(); ++i) {
+        Testing::Timer t;
+        tickNpc(lod,npc[i],f,i,dt);
+        us[npc[i].tier] += t.us();
+        }
+      }
+
+    double total = 0;
+    char   n[96] = {};
+    for(int t=0; t<3; ++t) {
+      std::snprintf(n,sizeof(n),"lod %-3s: %-4s x %3d (per frame)",enabled ? "on" : "off",name[t],int(cnt[t]));
+      Testing::report(n,us[t]/double(Frames),"us");
+      total += us[t];
+      }
+    std::snprintf(n,sizeof(n),"lod %-3s: total     (per frame)",enabled ? "on" : "off");
+    Testing::report(n,total/double(Frames),"us");
+    }
+  }
+
+int main() {
+  testSchedule();
+  bench();
+  return Testing::result();
+  }
@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "bink/video.h"
+#include "testdata.h"
+#include "testing.h"
+
+// decoding of game videos; audio tracks are decoded by workers, concurrently with video
+struct FileInput : Bink::Video::Input {
+  explicit FileInput(const std::filesystem::path& p):fin(p,std::ios::binary) {}
+
+  void read(void* dest, size_t count) override {
+    if(!fin.read(reinterpret_cast<char*>(dest),std::streamsize(count)))
+      throw std::runtime_error("i/o error");
+    }
+  void skip(size_t count) override {
+    fin.seekg(std::streamoff(count),std::ios::cur);
+    }
+  void seek(size_t pos) override {
+    fin.seekg(std::streamoff(pos),std::ios::beg);
+    }
+
+  std::ifstream fin;
+  };
+
+static void benchVideo(const std::filesystem::path& path) {
+  FileInput   in(path);
+  Bink::Video vid(&in);
+
+  const size_t count   = vid.frameCount();
+  double       total   = 0, worst = 0;
+  size_t       samples = 0;
+  for(size_t i=0; i<count; ++i) {
+    Testing::Timer t;
+    auto&          f = vid.nextFrame();
+    const double   ms = t.ms();
+    total += ms;
+    worst  = std::max(worst,ms);
+    for(size_t a=0; a<f.audioCount(); ++a)
+      samples += f.audio(uint8_t(a)).samples.size();
+    }
+
+  const auto&  fps      = vid.fps();
+  const double duration = double(count)*double(fps.den)/double(std::max(fps.num,1u));
+  const auto   name     = path.filename().string();
+  std::printf("%s: %u audio track(s), %d frames\n",name.c_str(),unsigned(vid.audioCount()),int(count));
+  Testing::report("  decode (per frame, average)",total/double(std::max<size_t>(count,1)),"ms");
+  Testing::report("  decode (per frame, worst)",worst,"ms");
+  Testing::report("  decode speed, relative to playback",duration*1000.0/std::max(total,1e-3),"x");
+  Testing::report("  audio samples",double(samples),"");
+  CHECK(vid.audioCount()==0 || samples>0);
+  }
+
+int main() {
+  if(!TestData::isAvailable())
+    return Testing::Skipped;
+  auto videos = TestData::videos();
+  if(!CHECK(!videos.empty()))
+    return Testing::result();
+  for(auto& v:videos) {
+    try {
+      benchVideo(v);
+      }
+    catch(const std::exception& e) {
+      std::fprintf(stderr,"%s: %s\n",v.filename().string().c_str(),e.what());
+      CHECK(false);
+      }
+    }
+  return Testing::result();
+  }
@@ -0,0 +1,193 @@
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "bink/dsp.h"
+#include "testing.h"
+
+using namespace Bink;
+
+// reference: scalar idct, as it was in Video::decodePlane before Dsp kernels
+namespace Ref {
+
+template<class T>
+static void idctTransform(T* dest, const int* src,
+                          int s0, int s1, int s2, int s3, int s4, int s5, int s6, int s7,
+                          int d0, int d1, int d2, int d3, int d4, int d5, int d6, int d7,
+                          T (*munge)(int)) {
+  enum {
+    A1 = 2896, /* (1/sqrt(2))<<12 */
+    A2 = 2217,
+    A3 = 3784,
+    A4 = -5352
+    };
+  static int (*mul)(int,int) = [](int x,int y) -> int { return int(uint32_t(x)*uint32_t(y)) >> 11; };
+
+  const int a0 = (src)[s0] + (src)[s4];
+  const int a1 = (src)[s0] - (src)[s4];
+  const int a2 = (src)[s2] + (src)[s6];
+  const int a3 = mul(A1, (src)[s2] - (src)[s6]);
+  const int a4 = (src)[s5] + (src)[s3];
+  const int a5 = (src)[s5] - (src)[s3];
+  const int a6 = (src)[s1] + (src)[s7];
+  const int a7 = (src)[s1] - (src)[s7];
+  const int b0 = a4 + a6;
+  const int b1 = mul(A3, a5 + a7);
+  const int b2 = mul(A4, a5) - b0 + b1;
+  const int b3 = mul(A1, a6 - a4) - b2;
+  const int b4 = mul(A2, a7) + b3 - b1;
+  dest[d0] = munge(a0+a2   +b0);
+  dest[d1] = munge(a1+a3-a2+b2);
+  dest[d2] = munge(a1-a3+a2+b3);
+  dest[d3] = munge(a0-a2   -b4);
+  dest[d4] = munge(a0-a2   +b4);
+  dest[d5] = munge(a1-a3+a2-b3);
+  dest[d6] = munge(a1+a3-a2-b2);
+  dest[d7] = munge(a0+a2   -b0);
+  }
+
+template<class T>
+static void idctCol(T* dest, const int* src) {
+  static T (*munge)(int) = [](int x) -> T { return T(x); };
+  idctTransform(dest,src,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,munge);
+  }
+
+template<class T>
+static void idctRow(T* dest, const int* src) {
+  static T (*munge)(int) = [](int x) -> T { return T((x + 0x7F)>>8); };
+  idctTransform(dest,src,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,munge);
+  }
+
+static void idctColDc(int* dest, const int32_t* src) {
+  if((src[8]|src[16]|src[24]|src[32]|src[40]|src[48]|src[56])==0) {
+    for(int i=0; i<64; i+=8)
+      dest[i] = src[0];
+    } else {
+    idctCol(dest, src);
+    }
+  }
+
+static void idctPut(uint8_t* dst, const int32_t* block) {
+  int temp[64]={};
+  for(int i=0; i<8; i++)
+    idctColDc(&temp[i], &block[i]);
+  for(int i=0; i<8; i++)
+    idctRow(&dst[i*8], &temp[8*i]);
+  }
+
+static void idctAdd(uint8_t* dst, const uint8_t* prev, const int32_t* block) {
+  int32_t dctblock[64];
+  std::memcpy(dctblock,block,sizeof(dctblock));
+  int temp[64]={};
+  for(int i=0; i<8; i++)
+    idctColDc(&temp[i], &dctblock[i]);
+  for(int i=0; i<8; i++)
+    idctRow(&dctblock[i*8], &temp[8*i]);
+  for(int i=0; i<64; ++i)
+    dst[i] = uint8_t(prev[i]+dctblock[i]);
+  }
+}
+
+// typical and degenerate coefficient distributions
+static void mkBlock(std::mt19937& rng, int mode, int32_t* b, uint8_t* prev) {
+  for(int i=0; i<64; ++i) {
+    prev[i] = uint8_t(rng());
+    switch(mode) {
+      case 0: b[i] = int32_t(rng()%4096)-2048; break;
+      case 1: b[i] = (rng()%8==0) ? int32_t(rng()%65536)-32768 : 0; break;
+      case 2: b[i] = int32_t(rng()>>8)-(1<<23); break; // overflow in 32-bit multiply
+      default:b[i] = (i%8==0 || i<8) ? int32_t(rng()%2048)-1024 : 0; break; // dc-only columns
+      }
+    }
+  }
+
+static uint64_t fnv(uint64_t h, const uint8_t* d, size_t n) {
+  for(size_t i=0; i<n; ++i)
+    h = (h^d[i])*1099511628211ull;
+  return h;
+  }
+
+static std::vector<const Dsp::Kernels*> allKernels() {
+  std::vector<const Dsp::Kernels*> ret = {&Dsp::scalarKernels()};
+  if(auto k = Dsp::simdKernels())
+    ret.push_back(k);
+  if(auto k = Dsp::avx2Kernels())
+    ret.push_back(k);
+  return ret;
+  }
+
+static void testGolden() {
+  // hash of reference output over fixed input; pins behavior of reference itself
+  const uint64_t golden = 0x62e047b6b3445a5full;
+
+  std::mt19937 rng(1);
+  uint64_t     h = 1469598103934665603ull;
+  for(int it=0; it<4096; ++it) {
+    int32_t b[64]; uint8_t prev[64], put[64], add[64];
+    mkBlock(rng,it%4,b,prev);
+    Ref::idctPut(put,b);
+    Ref::idctAdd(add,prev,b);
+    h = fnv(h,put,64);
+    h = fnv(h,add,64);
+    }
+  if(!CHECK(h==golden))
+    std::fprintf(stderr,"golden hash: 0x%016llx\n",static_cast<unsigned long long>(h));
+  }
+
+static void testKernels() {
+  auto ks = allKernels();
+  std::printf("active kernels: %s\n",Dsp::kernels().name);
+
+  std::mt19937 rng(2);
+  for(int it=0; it<200000; ++it) {
+    int32_t b[64]; uint8_t prev[64], rPut[64], rAdd[64], out[64];
+    mkBlock(rng,it%4,b,prev);
+    Ref::idctPut(rPut,b);
+    Ref::idctAdd(rAdd,prev,b);
+    for(auto k:ks) {
+      k->idctPut(out,b);
+      if(!CHECK(std::memcmp(out,rPut,64)==0)) {
+        std::fprintf(stderr,"  idctPut, kernels: %s, mode: %d\n",k->name,it%4);
+        return;
+        }
+      k->idctAdd(out,prev,b);
+      if(!CHECK(std::memcmp(out,rAdd,64)==0)) {
+        std::fprintf(stderr,"  idctAdd, kernels: %s, mode: %d\n",k->name,it%4);
+        return;
+        }
+      }
+    }
+  }
+
+static void bench() {
+  enum { Blocks = 4096, Reps = 50 };
+  std::mt19937         rng(3);
+  std::vector<int32_t> blocks(64*Blocks);
+  std::vector<uint8_t> out(64*Blocks);
+  uint8_t              prev[64] = {};
+  for(auto& v:blocks)
+    v = int32_t(rng()%512)-256;
+
+  auto run = [&](auto fn) {
+    Testing::Timer t;
+    for(int r=0; r<Reps; ++r)
+      for(size_t i=0; i<Blocks; ++i)
+        fn(&out[64*i],&blocks[64*i]);
+    Testing::doNotOptimize(out);
+    return t.ns()/double(Blocks*Reps);
+    };
+
+  Testing::report("idctAdd, reference (per block)",run([&](uint8_t* d, const int32_t* b){ Ref::idctAdd(d,prev,b); }),"ns");
+  for(auto k:allKernels()) {
+    char name[64] = {};
+    std::snprintf(name,sizeof(name),"idctAdd, %s (per block)",k->name);
+    Testing::report(name,run([&](uint8_t* d, const int32_t* b){ k->idctAdd(d,prev,b); }),"ns");
+    }
+  }
+
+int main() {
+  testGolden();
+  testKernels();
+  bench();
+  return Testing::result();
+  }
@@ -0,0 +1,127 @@
+#include <random>
+#include <vector>
+
+#include "world/bspindex.h"
+#include "testdata.h"
+#include "testing.h"
+
+using namespace Tempest;
+
+// reference: scan of all sectors, as World::roomAt did before BspIndex
+static uint32_t sectorOfScan(const std::vector<phoenix::bsp_node>&   nodes,
+                             const std::vector<phoenix::bsp_sector>& sectors,
+                             const std::vector<uint64_t>&            leafs,
+                             size_t node) {
+  uint32_t ret   = BspIndex::NoSector;
+  size_t   count = 0;
+  for(size_t i=0; i<sectors.size(); ++i) {
+    for(auto r:sectors[i].node_indices) {
+      if(r>=leafs.size() || leafs[r]>=nodes.size())
+        continue;
+      if(leafs[r]==node) {
+        ret = uint32_t(i);
+        count++;
+        }
+      }
+    }
+  return count==1 ? ret : BspIndex::NoSector;
+  }
+
+static void testSynthetic() {
+  std::vector<phoenix::bsp_node> nodes(3);
+  nodes[0].plane       = {1,0,0,0};
+  nodes[0].front_index = 1;
+  nodes[0].back_index  = 2;
+  for(size_t i=1; i<3; ++i) {
+    nodes[i].front_index = -1;
+    nodes[i].back_index  = -1;
+    }
+  nodes[1].bbox.min = {   0,-100,-100};
+  nodes[1].bbox.max = { 100, 100, 100};
+  nodes[2].bbox.min = {-100,-100,-100};
+  nodes[2].bbox.max = {   0, 100, 100};
+
+  std::vector<uint64_t>            leafs = {1,2,2};
+  std::vector<phoenix::bsp_sector> sectors(3);
+  sectors[0].name = "ROOM_A";
+  sectors[0].node_indices = {0};
+  sectors[1].name = "ROOM_B";
+  sectors[1].node_indices = {1};
+  sectors[2].name = "ROOM_C";
+  sectors[2].node_indices = {2, 7}; // out of range index is ignored
+
+  BspIndex index;
+  index.build(nodes,sectors,leafs);
+
+  CHECK(BspIndex::leafAt(nodes,Vec3( 50,0,0))==1);
+  CHECK(BspIndex::leafAt(nodes,Vec3(-50,0,0))==2);
+  CHECK(BspIndex::leafAt(nodes,Vec3(500,0,0))==nodes.size());
+  CHECK(BspIndex::leafAt({},Vec3(0,0,0))==0);
+
+  CHECK(index.sectorOf(0)==BspIndex::NoSector);
+  CHECK(index.sectorOf(1)==0);
+  CHECK(index.sectorOf(2)==BspIndex::NoSector); // shared by ROOM_B and ROOM_C
+  CHECK(index.sectorOf(3)==BspIndex::NoSector);
+
+  CHECK(index.findSector("ROOM_B")==1);
+  CHECK(index.findSector("ROOM_X")==BspIndex::NoSector);
+
+  for(size_t i=0; i<nodes.size(); ++i)
+    CHECK(index.sectorOf(i)==sectorOfScan(nodes,sectors,leafs,i));
+  }
+
+static void benchWorld() {
+  if(!TestData::isAvailable())
+    return;
+  auto world = TestData::world();
+  if(!CHECK(world.has_value()))
+    return;
+
+  auto& bsp = world->world_bsp_tree;
+  BspIndex   index;
+  Testing::Timer tBuild;
+  index.build(bsp.nodes,bsp.sectors,bsp.leaf_node_indices);
+  Testing::report("bsp index build",tBuild.ms(),"ms");
+
+  // npc positions: way-points with some jitter
+  std::mt19937                          rng(1);
+  std::uniform_real_distribution<float> jitter(-200.f,200.f);
+  std::vector<Vec3>                     pos;
+  for(auto& wp:world->world_way_net.waypoints) {
+    for(int i=0; i<4; ++i)
+      pos.emplace_back(wp.position.x+jitter(rng), wp.position.y+jitter(rng)*0.25f, wp.position.z+jitter(rng));
+    }
+  if(!CHECK(!pos.empty()))
+    return;
+
+  std::vector<uint32_t> fast(pos.size()), ref(pos.size());
+  Testing::Timer tFast;
+  for(size_t i=0; i<pos.size(); ++i) {
+    const size_t leaf = BspIndex::leafAt(bsp.nodes,pos[i]);
+    fast[i] = index.sectorOf(leaf);
+    }
+  const double fastUs = tFast.us();
+
+  Testing::Timer tRef;
+  for(size_t i=0; i<pos.size(); ++i) {
+    const size_t leaf = BspIndex::leafAt(bsp.nodes,pos[i]);
+    ref[i] = leaf<bsp.nodes.size() ? sectorOfScan(bsp.nodes,bsp.sectors,bsp.leaf_node_indices,leaf) : BspIndex::NoSector;
+    }
+  const double refUs = tRef.us();
+
+  size_t mismatch = 0;
+  for(size_t i=0; i<pos.size(); ++i)
+    if(fast[i]!=ref[i])
+      ++mismatch;
+  CHECK(mismatch==0);
+
+  Testing::report("roomAt queries",double(pos.size()),"");
+  Testing::report("roomAt, index  (per query)",fastUs/double(pos.size()),"us");
+  Testing::report("roomAt, scan   (per query)",refUs /double(pos.size()),"us");
+  }
+
+int main() {
+  testSynthetic();
+  benchWorld();
+  return Testing::result();
+  }
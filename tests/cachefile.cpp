@@ -0,0 +1,170 @@
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "utils/cachefile.h"
+#include "testdata.h"
+#include "testing.h"
+
+struct Item {
+  float    pos[3];
+  uint32_t id;
+  };
+
+static void testImage() {
+  CacheFile::Writer out;
+  out.put(uint8_t(7));
+  out.put(std::string("NEWWORLD.ZEN"));
+  out.put(std::vector<Item>{{{1,2,3},4},{{5,6,7},8}});
+  out.put(std::vector<uint16_t>());
+  uint8_t* blk = out.block(5);
+  for(uint8_t i=0; i<5; ++i)
+    blk[i] = i;
+  out.put(uint64_t(0x1122334455667788ull));
+
+  auto img = out.data();
+  {
+  CacheFile::Reader     in(img);
+  uint8_t               a = 0;
+  std::string           s;
+  std::vector<Item>     v;
+  std::vector<uint16_t> e = {1};
+  uint64_t              tail = 0;
+  CHECK(in.get(a) && a==7);
+  CHECK(in.get(s) && s=="NEWWORLD.ZEN");
+  CHECK(in.get(v) && v.size()==2 && v[1].pos[2]==7 && v[1].id==8);
+  CHECK(in.get(e) && e.empty());
+  const uint8_t* b = in.block(5);
+  CHECK(b!=nullptr && b[4]==4);
+  // blocks are aligned relative to image start
+  CHECK(b!=nullptr && size_t(b-img.data())%CacheFile::Alignment==0);
+  CHECK(in.get(tail) && tail==0x1122334455667788ull);
+  CHECK(in.isEnd());
+  }
+
+  // truncated image: every read fails after first error, nothing is read out of bounds
+  for(size_t len=0; len<img.size(); ++len) {
+    std::vector<uint8_t> part(img.begin(),img.begin()+std::ptrdiff_t(len));
+    CacheFile::Reader    in(part);
+    uint8_t              a = 0;
+    std::string          s;
+    std::vector<Item>    v;
+    std::vector<uint16_t> e;
+    uint64_t             tail = 0;
+    in.get(a);
+    in.get(s);
+    in.get(v);
+    in.get(e);
+    in.block(5);
+    in.get(tail);
+    CHECK(!in.isOk());
+    CHECK(!in.isEnd());
+    }
+
+  // huge array size must not allocate
+  CacheFile::Writer bad;
+  bad.put(uint64_t(1)<<60);
+  auto              badImg = bad.data();
+  CacheFile::Reader in(badImg);
+  std::vector<Item> v;
+  CHECK(!in.get(v) && v.empty());
+  }
+
+static void testHash() {
+  std::vector<uint8_t> d(1000);
+  for(size_t i=0; i<d.size(); ++i)
+    d[i] = uint8_t(i*31);
+  const uint64_t h = CacheFile::hash(d.data(),d.size());
+  CHECK(h==CacheFile::hash(d.data(),d.size()));
+  CHECK(h!=CacheFile::hash(d.data(),d.size()-1));
+  CHECK(h!=CacheFile::hash(d.data(),d.size(),1));
+  // every byte position matters, in word and tail parts
+  for(size_t i : {size_t(0),size_t(7),size_t(8),size_t(500),size_t(999)}) {
+    auto c = d;
+    c[i] ^= 1;
+    CHECK(h!=CacheFile::hash(c.data(),c.size()));
+    }
+  }
+
+static void testFile() {
+  std::vector<uint8_t> blob(100000);
+  std::mt19937         rng(1);
+  for(auto& i:blob)
+    i = uint8_t(rng());
+
+  CHECK(CacheFile::read("test.bin",1).empty());
+  CHECK(CacheFile::write("test.bin",1,blob.data(),blob.size()));
+  CHECK(CacheFile::read("test.bin",1)==blob);
+  // other key is a miss
+  CHECK(CacheFile::read("test.bin",2).empty());
+
+  // overwrite keeps only new data
+  CHECK(CacheFile::write("test.bin",2,blob.data(),blob.size()/2));
+  CHECK(CacheFile::read("test.bin",1).empty());
+  CHECK(CacheFile::read("test.bin",2).size()==blob.size()/2);
+
+  // corrupted or truncated file is a miss
+  CHECK(CacheFile::write("test.bin",3,blob.data(),blob.size()));
+  {
+  std::FILE* f = std::fopen("cache/test.bin","r+b");
+  CHECK(f!=nullptr);
+  if(f!=nullptr) {
+    std::fseek(f,1000,SEEK_SET);
+    const int c = std::fgetc(f);
+    std::fseek(f,1000,SEEK_SET);
+    std::fputc(c^0xFF,f);
+    std::fclose(f);
+    }
+  }
+  CHECK(CacheFile::read("test.bin",3).empty());
+  std::filesystem::resize_file("cache/test.bin",500);
+  CHECK(CacheFile::read("test.bin",3).empty());
+  }
+
+// cost of cache validation and load: hash of zen file (key), read of image of same size
+static void bench() {
+  std::vector<uint8_t> blob(64*1024*1024);
+  for(size_t i=0; i<blob.size(); ++i)
+    blob[i] = uint8_t(i*2654435761u >> 13);
+
+  if(TestData::isAvailable()) {
+    auto zen = TestData::file(TestData::version()==phoenix::game_version::gothic_2 ? "NEWWORLD.ZEN" : "WORLD.ZEN");
+    if(zen.has_value()) {
+      auto b = reinterpret_cast<const uint8_t*>(zen->array());
+      blob.assign(b,b+zen->limit());
+      }
+    }
+  Testing::report("image size",double(blob.size())/1024.0/1024.0,"MB");
+
+  Testing::Timer tHash;
+  Testing::doNotOptimize(CacheFile::hash(blob.data(),blob.size()));
+  Testing::report("hash",tHash.ms(),"ms");
+
+  CacheFile::write("bench.bin",1,blob.data(),blob.size());
+  Testing::Timer tRead;
+  auto data = CacheFile::read("bench.bin",1);
+  Testing::report("read and validate",tRead.ms(),"ms");
+  CHECK(data.size()==blob.size());
+  }
+
+int main() {
+  // cache is written to current directory
+  std::error_code ec;
+  auto dir = std::filesystem::temp_directory_path(ec)/"opengothic_test_cachefile";
+  std::filesystem::remove_all(dir,ec);
+  std::filesystem::create_directories(dir,ec);
+  std::filesystem::current_path(dir,ec);
+  if(!CHECK(!ec))
+    return Testing::result();
+
+  testImage();
+  testHash();
+  testFile();
+  bench();
+
+  std::filesystem::current_path(dir.parent_path(),ec);
+  std::filesystem::remove_all(dir,ec);
+  return Testing::result();
+  }
@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/concurrentcache.h"
+#include "testing.h"
+
+struct Hash {
+  size_t operator()(std::string_view s) const { return std::hash<std::string_view>()(s); }
+  };
+
+using Cache = ConcurrentCache<std::string,int,Hash>;
+
+static void testBasic() {
+  Cache cache;
+  int   created = 0;
+
+  int* a = cache.get(std::string("A"),[&](){ created++; return std::make_unique<int>(1); });
+  int* b = cache.get(std::string_view("A"),[&](){ created++; return std::make_unique<int>(2); });
+  CHECK(a!=nullptr && *a==1);
+  CHECK(a==b);
+  CHECK(created==1);
+
+  // nullptr is cached, as missing resource
+  int* n0 = cache.get(std::string("missing"),[&](){ created++; return std::unique_ptr<int>(); });
+  int* n1 = cache.get(std::string("missing"),[&](){ created++; return std::make_unique<int>(3); });
+  CHECK(n0==nullptr && n1==nullptr);
+  CHECK(created==2);
+
+  // many keys: table growth keeps old pointers valid
+  std::vector<int*> ptr;
+  for(int i=0; i<1000; ++i)
+    ptr.push_back(cache.get(std::to_string(i),[i](){ return std::make_unique<int>(i); }));
+  for(int i=0; i<1000; ++i) {
+    int* p = cache.get(std::to_string(i),[](){ return std::make_unique<int>(-1); });
+    CHECK(p==ptr[size_t(i)] && *p==i);
+    }
+  }
+
+static void testException() {
+  Cache cache;
+  bool  thrown = false;
+  try {
+    cache.get(std::string("E"),[]() -> std::unique_ptr<int> { throw std::runtime_error("load failed"); });
+    }
+  catch(const std::runtime_error&) {
+    thrown = true;
+    }
+  CHECK(thrown);
+
+  // failed load is not cached
+  int* p = cache.get(std::string("E"),[](){ return std::make_unique<int>(5); });
+  CHECK(p!=nullptr && *p==5);
+  }
+
+static void testRecursive() {
+  Cache cache;
+  int*  inner = reinterpret_cast<int*>(1);
+  int*  outer = cache.get(std::string("R"),[&](){
+    inner = cache.get(std::string("R"),[](){ return std::make_unique<int>(1); });
+    return std::make_unique<int>(2);
+    });
+  CHECK(inner==nullptr);
+  CHECK(outer!=nullptr && *outer==2);
+  }
+
+static void testConcurrent() {
+  enum { Threads = 8, Keys = 2000, Rounds = 3 };
+  Cache                          cache;
+  std::vector<std::atomic<int>>  created(Keys);
+  std::vector<std::atomic<int*>> first(Keys);
+  std::atomic<int>               bad{0};
+  for(auto& i:first)
+    i.store(nullptr);
+
+  std::vector<std::thread> th;
+  for(int t=0; t<Threads; ++t) {
+    th.emplace_back([&,t]() {
+      for(int r=0; r<Rounds; ++r) {
+        for(int k=0; k<Keys; ++k) {
+          const int  id  = (k*7+t*131)%Keys; // different order per thread
+          const auto key = std::to_string(id);
+          int* p = cache.get(key,[&,id](){
+            created[size_t(id)]++;
+            if(id%64==0)
+              std::this_thread::yield(); // widen window for waiters
+            return std::make_unique<int>(id);
+            });
+          int* expect = nullptr;
+          if(p==nullptr || *p!=id)
+            bad++;
+          else if(!first[size_t(id)].compare_exchange_strong(expect,p) && expect!=p)
+            bad++;
+          }
+        }
+      });
+    }
+  for(auto& i:th)
+    i.join();
+
+  CHECK(bad==0);
+  int dup = 0;
+  for(auto& i:created)
+    if(i!=1)
+      dup++;
+  CHECK(dup==0);
+  }
+
+static void benchHits() {
+  enum { Keys = 1024, Iterations = 200000 };
+  const size_t thCount = std::max(2u,std::thread::hardware_concurrency());
+
+  std::vector<std::string> keys;
+  for(int i=0; i<Keys; ++i)
+    keys.push_back("TEXTURE_"+std::to_string(i)+".TGA");
+
+  Cache cache;
+  std::unordered_map<std::string,std::unique_ptr<int>> map;
+  std::mutex                                           sync;
+  for(int i=0; i<Keys; ++i) {
+    cache.get(keys[size_t(i)],[i](){ return std::make_unique<int>(i); });
+    map[keys[size_t(i)]] = std::make_unique<int>(i);
+    }
+
+  auto run = [&](bool locked) {
+    std::vector<std::thread> th;
+    std::atomic<int64_t>     sum{0};
+    Testing::Timer           t;
+    for(size_t id=0; id<thCount; ++id)
+      th.emplace_back([&,id]() {
+        int64_t s = 0;
+        for(size_t i=0; i<Iterations; ++i) {
+          auto& k = keys[(i*31+id)%Keys];
+          if(locked) {
+            std::lock_guard<std::mutex> g(sync);
+            s += *map.find(k)->second;
+            } else {
+            s += *cache.get(k,[](){ return std::make_unique<int>(0); });
+            }
+          }
+        sum += s;
+        });
+    for(auto& i:th)
+      i.join();
+    Testing::doNotOptimize(sum);
+    return t.ns()/double(Iterations*thCount);
+    };
+
+  Testing::report("threads",double(thCount),"");
+  Testing::report("hit, mutex + unordered_map (per lookup)",run(true), "ns");
+  Testing::report("hit, ConcurrentCache       (per lookup)",run(false),"ns");
+  }
+
+int main() {
+  testBasic();
+  testException();
+  testRecursive();
+  testConcurrent();
+  benchHits();
+  return Testing::result();
+  }
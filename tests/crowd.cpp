@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "physics/raybatch.h"
+#include "world/losbatch.h"
+#include "testing.h"
+
+using namespace Tempest;
+
+static void testBatch() {
+  LosBatch b;
+  bool     clear = false;
+  b.begin(0);
+  b.request(Vec3(0,0,0),Vec3(100,0,0));
+  // same ray is queued once; other ray, however close, is a different ray
+  b.request(Vec3(0,0,0),Vec3(100,0,0));
+  b.request(Vec3(1,0,0),Vec3(100,0,0));
+  CHECK(b.pending().size()==2);
+  CHECK(!b.find(Vec3(0,0,0),Vec3(100,0,0),0,clear));
+
+  b.resolve(0,true);
+  b.resolve(1,false);
+  CHECK(b.find(Vec3(0,0,0),Vec3(100,0,0),0,clear) && clear);
+  CHECK(b.find(Vec3(1,0,0),Vec3(100,0,0),0,clear) && !clear);
+  CHECK(!b.find(Vec3(0,0,0),Vec3(200,0,0),0,clear));
+  // valid for one frame only
+  CHECK(!b.find(Vec3(0,0,0),Vec3(100,0,0),20,clear));
+
+  b.begin(20);
+  CHECK(b.pending().empty());
+  CHECK(!b.find(Vec3(0,0,0),Vec3(100,0,0),20,clear));
+  }
+
+// market place: stalls and walls as boxes; rays are tested against all of them
+struct Scene {
+  struct Box {
+    Vec3 min, max;
+    };
+  std::vector<Box> box;
+
+  bool ray(const Vec3& a, const Vec3& b) const {
+    const Vec3 d = b-a;
+    for(auto& bx:box) {
+      float t0 = 0, t1 = 1;
+      const float o[3] = {a.x,a.y,a.z}, dd[3] = {d.x,d.y,d.z};
+      const float mn[3] = {bx.min.x,bx.min.y,bx.min.z}, mx[3] = {bx.max.x,bx.max.y,bx.max.z};
+      for(int c=0; c<3 && t0<=t1; ++c) {
+        if(dd[c]==0.f) {
+          if(o[c]<mn[c] || o[c]>mx[c])
+            t0 = 2;
+          continue;
+          }
+        const float inv = 1.f/dd[c];
+        float ta = (mn[c]-o[c])*inv, tb = (mx[c]-o[c])*inv;
+        if(ta>tb)
+          std::swap(ta,tb);
+        t0 = std::max(t0,ta);
+        t1 = std::min(t1,tb);
+        }
+      if(t0<=t1)
+        return true;
+      }
+    return false;
+    }
+  };
+
+struct CrowdNpc {
+  Vec3     pos;
+  uint64_t percNext = 0;
+  Vec3 head() const { return pos+Vec3(0,170,0); }
+  Vec3 mid()  const { return pos+Vec3(0,90,0);  }
+  };
+
+// 200 npc in 60x60 meters, as in a crowded city market; everyone perceives everyone in senses range
+static void benchCrowd() {
+  const size_t   NpcCount    = 200;
+  const float    SenseRange  = 2000;
+  const uint64_t PercTime    = 500, FrameTime = 20, Frames = 250;
+
+  std::mt19937                          rng(1);
+  std::uniform_real_distribution<float> xz(-3000,3000), sz(50,300), walk(-3,3);
+
+  Scene scene;
+  for(int i=0; i<400; ++i) {
+    const Vec3 c = Vec3(xz(rng),0,xz(rng)), s = Vec3(sz(rng),sz(rng),sz(rng));
+    scene.box.push_back({c-Vec3(s.x,0,s.z),c+Vec3(s.x,s.y,s.z)});
+    }
+
+  std::vector<CrowdNpc> npc(NpcCount);
+  for(size_t i=0; i<npc.size(); ++i) {
+    npc[i].pos      = Vec3(xz(rng),0,xz(rng));
+    npc[i].percNext = (i*PercTime)/NpcCount; // perception is spread over interval
+    }
+
+  LosBatch                              batch;
+  std::vector<char>                     result;
+  std::vector<std::pair<size_t,size_t>> due;
+  size_t                                pairs = 0, raysSerial = 0, raysBatch = 0, mismatch = 0, missed = 0;
+  double                                msSerial = 0, msBatch = 0;
+
+  for(uint64_t now=0; now<Frames*FrameTime; now+=FrameTime) {
+    for(auto& n:npc)
+      n.pos += Vec3(walk(rng),0,walk(rng));
+
+    due.clear();
+    for(size_t i=0; i<npc.size(); ++i) {
+      if(npc[i].percNext>now)
+        continue;
+      npc[i].percNext = now+PercTime;
+      for(size_t r=0; r<npc.size(); ++r) {
+        const Vec3 d = npc[r].mid()-npc[i].pos;
+        if(r!=i && d.quadLength()<SenseRange*SenseRange)
+          due.emplace_back(i,r);
+        }
+      }
+    pairs += due.size();
+
+    // before: ray per candidate, from script dispatch
+    std::vector<char> ref(due.size());
+    {
+    Testing::Timer t;
+    for(size_t k=0; k<due.size(); ++k)
+      ref[k] = scene.ray(npc[due[k].first].head(),npc[due[k].second].mid()) ? 0 : 1;
+    raysSerial += due.size();
+    msSerial   += t.ms();
+    }
+
+    // sense phase: request, batch on workers, then serial dispatch reads results
+    {
+    Testing::Timer t;
+    batch.begin(now);
+    for(auto& p:due)
+      batch.request(npc[p.first].head(),npc[p.second].mid());
+    auto& rays = batch.pending();
+    result.resize(rays.size());
+    RayBatch::cast(rays.data(),result.data(),rays.size(),[&scene](const LosBatch::Ray& r, char& ret) {
+      ret = scene.ray(r.from,r.to) ? 0 : 1;
+      });
+    for(size_t k=0; k<result.size(); ++k)
+      batch.resolve(k,result[k]!=0);
+    raysBatch += rays.size();
+
+    for(size_t k=0; k<due.size(); ++k) {
+      bool clear = false;
+      if(!batch.find(npc[due[k].first].head(),npc[due[k].second].mid(),now,clear)) {
+        missed++;
+        continue;
+        }
+      if(clear!=(ref[k]!=0))
+        mismatch++;
+      }
+    msBatch += t.ms();
+    }
+    }
+
+  CHECK(missed==0);
+  CHECK(mismatch==0);
+
+  const double fr = double(Frames);
+  Testing::report("npc",double(NpcCount),"");
+  Testing::report("worker threads + caller",double(Workers::maxThreads()),"");
+  Testing::report("perception pairs (per frame)",double(pairs)/fr,"");
+  Testing::report("rays, per-candidate (per frame)",double(raysSerial)/fr,"");
+  Testing::report("rays, sense phase   (per frame)",double(raysBatch)/fr,"");
+  Testing::report("time, per-candidate (per frame)",msSerial/fr,"ms");
+  Testing::report("time, sense phase   (per frame)",msBatch/fr,"ms");
+  }
+
+int main() {
+  testBatch();
+  benchCrowd();
+  return Testing::result();
+  }
@@ -0,0 +1,176 @@
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "utils/dirtypages.h"
+#include "testing.h"
+
+// same as MatrixStorage: pages of 8 matrices, 2 frames in flight
+enum { PageSize = 8, MergeGap = 2, Frames = 2 };
+using Pages = DirtyPages<PageSize,Frames>;
+
+// gpu side of one frame in flight: copy of cpu data, updated by runs
+struct Frame {
+  std::vector<uint32_t> gpu;
+  size_t                bytes = 0;
+  };
+
+static void upload(Pages& pages, const std::vector<uint32_t>& cpu, Frame& f, size_t fId) {
+  pages.runs(fId,cpu.size(),MergeGap,[&](size_t begin, size_t end) {
+    for(size_t i=begin; i<end; ++i)
+      f.gpu[i] = cpu[i];
+    f.bytes += (end-begin)*64; // sizeof(Matrix4x4)
+    });
+  }
+
+static void testBasic() {
+  Pages pages;
+  pages.resize(1000);
+
+  std::vector<uint32_t> runs;
+  auto collect = [&](size_t fId) {
+    runs.clear();
+    pages.runs(fId,1000,0,[&](size_t b, size_t e){ runs.push_back(uint32_t(b)); runs.push_back(uint32_t(e)); });
+    };
+
+  pages.mark(3,2);
+  pages.mark(500,100);
+  pages.mark(995,0);
+  pages.collect();
+  collect(0);
+  CHECK((runs==std::vector<uint32_t>{0,8, 496,600}));
+  // other frame keeps its own copy of marks
+  collect(1);
+  CHECK((runs==std::vector<uint32_t>{0,8, 496,600}));
+  collect(1);
+  CHECK(runs.empty());
+
+  // last page is clamped to size; word boundaries
+  pages.mark(990,10);
+  pages.mark(510,1);
+  pages.collect();
+  pages.clear(0);
+  collect(0);
+  CHECK(runs.empty());
+  collect(1);
+  CHECK((runs==std::vector<uint32_t>{504,512, 984,1000}));
+
+  // resize keeps marks
+  pages.mark(7,1);
+  pages.resize(100000);
+  pages.mark(99999,1);
+  pages.collect();
+  runs.clear();
+  pages.runs(0,100000,0,[&](size_t b, size_t e){ runs.push_back(uint32_t(b)); runs.push_back(uint32_t(e)); });
+  CHECK((runs==std::vector<uint32_t>{0,8, 99992,100000}));
+  }
+
+// marks from several threads, as Id::set does from animation workers
+static void testThreads() {
+  const size_t size = 64*1024;
+  Pages pages;
+  pages.resize(size);
+
+  std::vector<std::thread> th;
+  for(size_t t=0; t<4; ++t)
+    th.emplace_back([&pages,t]() {
+      for(size_t i=t*PageSize; i<size; i+=4*PageSize)
+        pages.mark(i,1);
+      });
+  for(auto& t:th)
+    t.join();
+  pages.collect();
+
+  size_t total = 0;
+  pages.runs(0,size,0,[&](size_t b, size_t e){ total += e-b; });
+  CHECK(total==size);
+  }
+
+// random writes and growth: every frame, its gpu copy must match cpu data
+static void testCopies() {
+  std::mt19937          rng(1);
+  std::vector<uint32_t> cpu(1);
+  Frame                 fr[Frames];
+  Pages                 pages;
+  pages.resize(cpu.size());
+
+  size_t mismatch = 0;
+  for(uint32_t frame=0; frame<2000; ++frame) {
+    if(rng()%50==0) {
+      cpu.resize(cpu.size()+rng()%700);
+      pages.resize(cpu.size());
+      }
+    for(int i=0; i<20; ++i) {
+      const size_t b = rng()%cpu.size();
+      const size_t n = std::min<size_t>(cpu.size()-b, 1+rng()%90);
+      for(size_t r=b; r<b+n; ++r)
+        cpu[r] = frame;
+      pages.mark(b,n);
+      }
+
+    const size_t fId = frame%Frames;
+    auto&        f   = fr[fId];
+    pages.collect();
+    if(f.gpu.size()!=cpu.size()) {
+      // new buffer, with full copy
+      f.gpu = cpu;
+      pages.clear(fId);
+      } else {
+      upload(pages,cpu,f,fId);
+      }
+    if(f.gpu!=cpu)
+      mismatch++;
+    }
+  CHECK(mismatch==0);
+  }
+
+// 500 npc: skeleton of 50..90 bones and object matrix each, some share animated every frame
+static void bench() {
+  std::mt19937        rng(2);
+  std::vector<size_t> npcBegin, npcSize;
+  size_t              size = 1; // identity at 0
+  for(int i=0; i<500; ++i) {
+    const size_t bones = 50+rng()%41;
+    npcBegin.push_back(size);
+    npcSize .push_back(bones+1);
+    size += bones+1;
+    }
+  const std::vector<uint32_t> cpu(size);
+  Testing::report("matrices",double(size),"");
+  Testing::report("full upload (per frame)",double(size*64)/1024.0,"KB");
+
+  for(int percent : {5,20,100}) {
+    Pages  pages;
+    Frame  fr[Frames];
+    size_t frames = 500;
+    pages.resize(size);
+    for(auto& f:fr)
+      f.gpu = cpu;
+
+    Testing::Timer t;
+    for(size_t frame=0; frame<frames; ++frame) {
+      for(size_t i=0; i<npcBegin.size(); ++i)
+        if(int(rng()%100)<percent)
+          pages.mark(npcBegin[i],npcSize[i]);
+      pages.collect();
+      upload(pages,cpu,fr[frame%Frames],frame%Frames);
+      }
+    const double us = t.us()/double(frames);
+
+    const size_t bytes = fr[0].bytes+fr[1].bytes;
+    char name[64] = {};
+    std::snprintf(name,sizeof(name),"%3d%% animated: upload (per frame)",percent);
+    Testing::report(name,double(bytes)/double(frames)/1024.0,"KB");
+    std::snprintf(name,sizeof(name),"%3d%% animated: cpu time (per frame)",percent);
+    Testing::report(name,us,"us");
+    }
+  }
+
+int main() {
+  testBasic();
+  testThreads();
+  testCopies();
+  bench();
+  return Testing::result();
+  }
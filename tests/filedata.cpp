@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+#include "testdata.h"
+#include "testing.h"
+
+// Resources read path: copy of archive entry into shared buffer under global lock (old getFileData + fBuff)
+// against direct read from mmap'ed archive (getFileView).
+
+// heap accounting: every allocation carries its size in a header
+namespace {
+  std::atomic<size_t> heapCalls{0};
+  std::atomic<size_t> heapBytes{0};
+  std::atomic<size_t> heapLive {0};
+  std::atomic<size_t> heapPeak {0};
+
+  constexpr size_t    heapHeader = alignof(std::max_align_t);
+  }
+
+void* operator new(size_t size) {
+  auto* p = static_cast<uint8_t*>(std::malloc(size+heapHeader));
+  if(p==nullptr)
+    throw std::bad_alloc();
+  *reinterpret_cast<size_t*>(p) = size;
+  heapCalls.fetch_add(1,std::memory_order_relaxed);
+  heapBytes.fetch_add(size,std::memory_order_relaxed);
+  const size_t live = heapLive.fetch_add(size,std::memory_order_relaxed)+size;
+  size_t peak = heapPeak.load(std::memory_order_relaxed);
+  while(live>peak && !heapPeak.compare_exchange_weak(peak,live,std::memory_order_relaxed))
+    ;
+  return p+heapHeader;
+  }
+
+void operator delete(void* ptr) noexcept {
+  if(ptr==nullptr)
+    return;
+  auto* p = static_cast<uint8_t*>(ptr)-heapHeader;
+  heapLive.fetch_sub(*reinterpret_cast<size_t*>(p),std::memory_order_relaxed);
+  std::free(p);
+  }
+
+void operator delete(void* ptr, size_t) noexcept {
+  operator delete(ptr);
+  }
+
+struct HeapStat {
+  size_t calls = 0;
+  size_t bytes = 0;
+  size_t peak  = 0; // above live heap at start
+
+  static size_t peakRssKb() {
+#if defined(__linux__)
+    rusage u = {};
+    getrusage(RUSAGE_SELF,&u);
+    return size_t(u.ru_maxrss);
+#else
+    return 0;
+#endif
+    }
+  };
+
+class HeapScope final {
+  public:
+    HeapScope():calls(heapCalls.load()),bytes(heapBytes.load()),live(heapLive.load()) {
+      heapPeak.store(live);
+      }
+    HeapStat stat() const {
+      HeapStat s;
+      s.calls = heapCalls.load()-calls;
+      s.bytes = heapBytes.load()-bytes;
+      s.peak  = heapPeak.load()-live;
+      return s;
+      }
+
+  private:
+    size_t calls, bytes, live;
+  };
+
+static void collectFiles(const std::set<phoenix::vdf_entry,phoenix::vdf_entry_comparator>& dir,
+                         std::vector<const phoenix::vdf_entry*>& out) {
+  for(auto& i:dir) {
+    if(i.is_directory()) {
+      collectFiles(i.children,out);
+      continue;
+      }
+    auto ext = i.name.size()>4 ? i.name.substr(i.name.size()-4) : std::string();
+    if(ext==".WAV")
+      out.push_back(&i);
+    }
+  }
+
+static uint64_t checksum(const uint8_t* data, size_t size) {
+  // stands for decoder, that touches every byte once
+  uint64_t h = 1469598103934665603ull;
+  for(size_t i=0; i<size; ++i)
+    h = (h^data[i])*1099511628211ull;
+  return h;
+  }
+
+static uint64_t readCopy(const phoenix::vdf_entry& e, std::vector<uint8_t>& buf) {
+  auto rd = e.open();
+  buf.assign(reinterpret_cast<const uint8_t*>(rd.array()), reinterpret_cast<const uint8_t*>(rd.array())+rd.limit());
+  return checksum(buf.data(),buf.size());
+  }
+
+// old getFileData(name): new vector per file
+static uint64_t readAlloc(const phoenix::vdf_entry& e) {
+  auto rd = e.open();
+  std::vector<uint8_t> buf(reinterpret_cast<const uint8_t*>(rd.array()), reinterpret_cast<const uint8_t*>(rd.array())+rd.limit());
+  return checksum(buf.data(),buf.size());
+  }
+
+static uint64_t readView(const phoenix::vdf_entry& e) {
+  auto rd = e.open();
+  return checksum(reinterpret_cast<const uint8_t*>(rd.array()),rd.limit());
+  }
+
+static void benchFiles() {
+  std::vector<const phoenix::vdf_entry*> files;
+  collectFiles(TestData::vdfs().entries,files);
+  if(!CHECK(!files.empty()))
+    return;
+
+  size_t bytes = 0;
+  for(auto i:files)
+    bytes += i->open().limit();
+  const double mb = double(bytes)/(1024.0*1024.0);
+
+  std::vector<uint64_t> hCopy(files.size()), hView(files.size());
+  std::vector<uint8_t>  fBuff;
+  std::mutex            sync;
+
+  // warm up page cache
+  for(size_t i=0; i<files.size(); ++i)
+    hView[i] = readView(*files[i]);
+  const size_t rss0 = HeapStat::peakRssKb();
+
+  // view first: peak RSS is monotonic, so copy paths are measured on top of it
+  HeapScope      hsView;
+  Testing::Timer tView;
+  for(size_t i=0; i<files.size(); ++i)
+    hView[i] = readView(*files[i]);
+  const double   viewMs   = tView.ms();
+  const HeapStat viewHeap = hsView.stat();
+  const size_t   rssView  = HeapStat::peakRssKb();
+
+  HeapScope      hsCopy;
+  Testing::Timer tCopy;
+  for(size_t i=0; i<files.size(); ++i)
+    hCopy[i] = readCopy(*files[i],fBuff);
+  const double   copyMs   = tCopy.ms();
+  const HeapStat copyHeap = hsCopy.stat();
+  CHECK(hCopy==hView);
+
+  HeapScope      hsAlloc;
+  Testing::Timer tAlloc;
+  for(size_t i=0; i<files.size(); ++i)
+    hCopy[i] = readAlloc(*files[i]);
+  const double   allocMs   = tAlloc.ms();
+  const HeapStat allocHeap = hsAlloc.stat();
+  const size_t   rssCopy   = HeapStat::peakRssKb();
+  CHECK(hCopy==hView);
+
+  // concurrent sound loading: every thread reads whole set
+  const size_t thCount = std::max(2u,std::thread::hardware_concurrency());
+  auto run = [&](bool copy) {
+    std::vector<std::thread> th;
+    std::vector<uint64_t>    mismatch(thCount,0);
+    Testing::Timer           t;
+    for(size_t id=0; id<thCount; ++id)
+      th.emplace_back([&,id]() {
+        for(size_t i=0; i<files.size(); ++i) {
+          uint64_t h = 0;
+          if(copy) {
+            std::lock_guard<std::mutex> g(sync);
+            h = readCopy(*files[i],fBuff);
+            } else {
+            h = readView(*files[i]);
+            }
+          if(h!=hView[i])
+            mismatch[id]++;
+          }
+        });
+    for(auto& i:th)
+      i.join();
+    for(auto i:mismatch)
+      CHECK(i==0);
+    return t.ms();
+    };
+  const double copyMt = run(true);
+  const double viewMt = run(false);
+
+  Testing::report("wav files",double(files.size()),"");
+  Testing::report("wav data",mb,"MiB");
+  Testing::report("read, copy into shared buffer",copyMs,"ms");
+  Testing::report("read, copy into new vector",allocMs,"ms");
+  Testing::report("read, mmap view",viewMs,"ms");
+  Testing::report("heap, copy into shared buffer: allocations",double(copyHeap.calls),"");
+  Testing::report("heap, copy into shared buffer: allocated",double(copyHeap.bytes)/(1024.0*1024.0),"MiB");
+  Testing::report("heap, copy into shared buffer: peak",double(copyHeap.peak)/(1024.0*1024.0),"MiB");
+  Testing::report("heap, copy into new vector: allocations",double(allocHeap.calls),"");
+  Testing::report("heap, copy into new vector: allocated",double(allocHeap.bytes)/(1024.0*1024.0),"MiB");
+  Testing::report("heap, copy into new vector: peak",double(allocHeap.peak)/(1024.0*1024.0),"MiB");
+  Testing::report("heap, mmap view: allocations",double(viewHeap.calls),"");
+  Testing::report("heap, mmap view: peak",double(viewHeap.peak)/(1024.0*1024.0),"MiB");
+  if(rss0>0) {
+    Testing::report("peak RSS, after warm-up",double(rss0)/1024.0,"MiB");
+    Testing::report("peak RSS, growth by mmap view",double(rssView-rss0)/1024.0,"MiB");
+    Testing::report("peak RSS, growth by copy paths",double(rssCopy-rssView)/1024.0,"MiB");
+    }
+  Testing::report("threads",double(thCount),"");
+  Testing::report("read, copy under lock (all threads)",copyMt,"ms");
+  Testing::report("read, mmap view       (all threads)",viewMt,"ms");
+  }
+
+int main() {
+  if(!TestData::isAvailable())
+    return Testing::Skipped;
+  benchFiles();
+  return Testing::result();
+  }
@@ -0,0 +1,164 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "graphics/dynamic/frustrum.h"
+#include "testing.h"
+
+using namespace Tempest;
+
+struct Pose {
+  Vec3  pos;
+  float yaw   = 0;
+  float pitch = 0;
+  };
+
+// view-projection, as Camera::viewProj: x right, y down, clip-space w is distance along view direction
+static Matrix4x4 viewProj(const Pose& p, float fov, float aspect, float zNear, float zFar) {
+  const Vec3 f = Vec3(std::sin(p.yaw)*std::cos(p.pitch), std::sin(p.pitch), std::cos(p.yaw)*std::cos(p.pitch));
+  const Vec3 r = Vec3::normalize(Vec3::crossProduct(Vec3(0,1,0),f));
+  const Vec3 u = Vec3::crossProduct(f,r);
+
+  const float fy = 1.f/std::tan(fov*0.5f);
+  const float fx = fy/aspect;
+  const float A  = zFar/(zFar-zNear);
+  const float B  = -zNear*A;
+
+  // data[i*4+a]: weight of world coordinate i (3 - translation) in clip coordinate a
+  const Vec3 axis[4] = {r*fx, u*(-fy), f*A, f};
+  float m[16] = {};
+  for(int a=0; a<4; ++a) {
+    const float v[3] = {axis[a].x, axis[a].y, axis[a].z};
+    for(int i=0; i<3; ++i)
+      m[i*4+a] = v[i];
+    m[12+a] = -Vec3::dotProduct(axis[a],p.pos) + (a==2 ? B : 0.f);
+    }
+  return Matrix4x4(m);
+  }
+
+static std::vector<Pose> poses(std::mt19937& rng) {
+  std::uniform_real_distribution<float> pos(-4000,4000), ang(-3.14f,3.14f), pitch(-1.2f,1.2f);
+  std::vector<Pose> ret;
+  ret.push_back({Vec3(0,0,0),0,0});
+  ret.push_back({Vec3(0,0,0),0,1.5f}); // looking up
+  ret.push_back({Vec3(100,-50,20),2.f,-1.5f});
+  while(ret.size()<16)
+    ret.push_back({Vec3(pos(rng),pos(rng)*0.2f,pos(rng)),ang(rng),pitch(rng)});
+  return ret;
+  }
+
+struct Light {
+  Vec3  pos;
+  float range = 0;
+  };
+
+static std::vector<Light> lights(std::mt19937& rng, size_t n) {
+  std::uniform_real_distribution<float> pos(-12000,12000), range(50,2500);
+  std::vector<Light> ret(n);
+  for(auto& l:ret) {
+    l.pos   = Vec3(pos(rng),pos(rng)*0.2f,pos(rng));
+    l.range = range(rng);
+    }
+  ret[0].range = 0;      // disabled
+  ret[1].range = 1e6f;   // covers everything
+  ret[2].pos   = Vec3(0,0,0);
+  ret[2].range = 10;
+  return ret;
+  }
+
+// same as LightGroup::cullLights
+static void cull(const Frustrum& fr, const std::vector<Light>& lt, std::vector<uint32_t>& vis) {
+  vis.clear();
+  for(size_t i=0; i<lt.size(); ++i)
+    if(lt[i].range>0 && fr.testPoint(lt[i].pos,lt[i].range))
+      vis.push_back(uint32_t(i));
+  }
+
+// point is in view volume: -w<=x,y<=w, 0<=z<=w
+static bool inClip(const Matrix4x4& m, const Vec3& p) {
+  const float* d = m.data();
+  float c[4] = {};
+  for(int a=0; a<4; ++a)
+    c[a] = d[0*4+a]*p.x + d[1*4+a]*p.y + d[2*4+a]*p.z + d[3*4+a];
+  const float w = c[3];
+  return w>0 && std::abs(c[0])<=w && std::abs(c[1])<=w && 0<=c[2] && c[2]<=w;
+  }
+
+// culling is conservative: every light, that has a point in view, is drawn
+static void testConservative() {
+  std::mt19937          rng(1);
+  auto                  lt = lights(rng,600);
+  std::vector<uint32_t> vis;
+
+  size_t missed = 0, samples = 0, visible = 0, seen = 0;
+  bool   disabled = false, all = true, ascending = true;
+  for(auto& p:poses(rng)) {
+    const Matrix4x4 vp = viewProj(p,1.2f,16.f/9.f,10.f,20000.f);
+    Frustrum        fr;
+    fr.make(vp,1,1);
+    cull(fr,lt,vis);
+
+    std::vector<char> isVis(lt.size(),0);
+    for(size_t i=0; i<vis.size(); ++i) {
+      isVis[vis[i]] = 1;
+      ascending &= (i==0 || vis[i-1]<vis[i]);
+      }
+    disabled |= isVis[0]!=0;
+    all      &= isVis[1]!=0;
+    visible  += vis.size();
+
+    std::uniform_real_distribution<float> u(-1,1);
+    for(size_t i=2; i<lt.size(); ++i) {
+      bool hit = inClip(vp,lt[i].pos);
+      for(int k=0; k<64; ++k) {
+        Vec3 d = Vec3(u(rng),u(rng),u(rng));
+        if(d.quadLength()>1.f)
+          continue;
+        if(!inClip(vp,lt[i].pos+d*lt[i].range))
+          continue;
+        hit = true;
+        samples++;
+        if(!isVis[i])
+          missed++;
+        }
+      if(hit)
+        seen++;
+      }
+    }
+  if(!CHECK(missed==0))
+    std::fprintf(stderr,"  %d of %d sampled points are missing their light\n",int(missed),int(samples));
+  CHECK(samples>1000);
+  CHECK(!disabled && all && ascending);
+  // and not too coarse: most of drawn lights have a sampled point in view
+  if(!CHECK(seen*10>=visible*7))
+    std::fprintf(stderr,"  %d lights drawn, %d seen\n",int(visible),int(seen));
+  }
+
+static void bench() {
+  std::mt19937          rng(2);
+  auto                  lt = lights(rng,3000);
+  auto                  ps = poses(rng);
+  std::vector<uint32_t> vis;
+
+  size_t visible = 0;
+  const int Reps = 20;
+  Testing::Timer t;
+  for(int r=0; r<Reps; ++r)
+    for(auto& p:ps) {
+      Frustrum fr;
+      fr.make(viewProj(p,1.2f,16.f/9.f,10.f,20000.f),1,1);
+      cull(fr,lt,vis);
+      visible += vis.size();
+      }
+  const double n = double(Reps)*double(ps.size());
+  Testing::report("lights",double(lt.size()),"");
+  Testing::report("visible (per view)",double(visible)/n,"");
+  Testing::report("cull (per view)",t.us()/n,"us");
+  }
+
+int main() {
+  testConservative();
+  bench();
+  return Testing::result();
+  }
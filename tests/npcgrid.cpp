@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "world/npcgrid.h"
+#include "testing.h"
+
+using namespace Tempest;
+
+struct FakeNpc {
+  Vec3 pos;
+  const Vec3& position() const { return pos; }
+  };
+
+using Grid = NpcGrid<FakeNpc>;
+
+static void brute(const std::vector<FakeNpc*>& npc, const Vec3& p, float R, std::vector<FakeNpc*>& out) {
+  for(auto i:npc)
+    if((i->position()-p).quadLength()<R*R)
+      out.push_back(i);
+  }
+
+// random walk, spawn and removal: every query must return same set, as linear scan
+static void testBruteForce() {
+  std::mt19937                          rng(1);
+  std::uniform_real_distribution<float> xz(-40000,40000), y(-2000,2000), step(-900,900), rad(0,9000);
+
+  std::vector<FakeNpc>  storage(1500);
+  std::vector<FakeNpc*> alive;
+  Grid                  grid;
+  for(size_t i=0; i<1000; ++i) {
+    storage[i].pos = Vec3(xz(rng),y(rng),xz(rng));
+    alive.push_back(&storage[i]);
+    grid.insert(storage[i]);
+    }
+  // cell borders and negative coordinates
+  storage[0].pos = Vec3(0,0,0);
+  storage[1].pos = Vec3(-Grid::cellSize,0,Grid::cellSize);
+  storage[2].pos = Vec3(Grid::cellSize-0.01f,0,-0.01f);
+  for(size_t i=0; i<3; ++i)
+    grid.move(storage[i]);
+  // insert is idempotent
+  grid.insert(storage[0]);
+  CHECK(grid.size()==alive.size());
+
+  size_t                mismatch = 0, found = 0, queries = 0;
+  std::vector<FakeNpc*> a, b;
+  size_t                spawn = 1000;
+  for(int tick=0; tick<200; ++tick) {
+    for(auto i:alive) {
+      i->pos += Vec3(step(rng),0,step(rng));
+      grid.move(*i);
+      }
+    if(spawn<storage.size() && rng()%2==0) {
+      storage[spawn].pos = Vec3(xz(rng),y(rng),xz(rng));
+      alive.push_back(&storage[spawn]);
+      grid.insert(storage[spawn]);
+      spawn++;
+      }
+    if(rng()%2==0) {
+      const size_t id = rng()%alive.size();
+      grid.erase(*alive[id]);
+      CHECK(!grid.hasObject(*alive[id]));
+      alive[id] = alive.back();
+      alive.pop_back();
+      }
+
+    for(int q=0; q<50; ++q) {
+      // mostly around npc, as perception does; sometimes huge radius
+      const Vec3  p = q%2==0 ? alive[rng()%alive.size()]->pos : Vec3(xz(rng),y(rng),xz(rng));
+      const float R = q%10==0 ? 200000.f : rad(rng);
+      a.clear();
+      b.clear();
+      brute(alive,p,R,a);
+      grid.find(p,R,[&](FakeNpc& n){ b.push_back(&n); });
+      std::sort(a.begin(),a.end());
+      std::sort(b.begin(),b.end());
+      if(a!=b)
+        mismatch++;
+      found += a.size();
+      queries++;
+      }
+    }
+  if(!CHECK(mismatch==0))
+    std::fprintf(stderr,"  %d of %d queries differ\n",int(mismatch),int(queries));
+  CHECK(grid.size()==alive.size());
+  CHECK(found>queries);
+
+  grid.clear();
+  CHECK(grid.size()==0);
+  size_t n = 0;
+  grid.find(Vec3(),1e6f,[&](FakeNpc&){ n++; });
+  CHECK(n==0);
+  }
+
+// 1000 npc over a world of 80x80 km; per tick: classification around player, then senses of near npcs
+static void bench() {
+  const size_t NpcCount = 1000, Ticks = 100;
+  const float  FarDist = 6000, NearDist = 3000, SenseRange = 2200;
+
+  std::mt19937                          rng(2);
+  std::uniform_real_distribution<float> xz(-40000,40000), town(-5000,5000), step(-10,10);
+
+  // half of population is in town, as Khorinis
+  std::vector<FakeNpc>  storage(NpcCount);
+  std::vector<FakeNpc*> npc;
+  for(size_t i=0; i<NpcCount; ++i) {
+    storage[i].pos = i%2==0 ? Vec3(town(rng),0,town(rng)) : Vec3(xz(rng),0,xz(rng));
+    npc.push_back(&storage[i]);
+    }
+  const Vec3 player = Vec3(0,0,0);
+
+  Grid grid;
+  for(auto i:npc)
+    grid.insert(*i);
+
+  std::vector<FakeNpc*> near;
+  double                usGrid = 0, usBrute = 0, usMove = 0;
+  size_t                queries = 0, nearCnt = 0;
+  for(size_t tick=0; tick<Ticks; ++tick) {
+    for(auto i:npc)
+      i->pos += Vec3(step(rng),0,step(rng));
+    {
+    Testing::Timer t;
+    for(auto i:npc)
+      grid.move(*i);
+    usMove += t.us();
+    }
+
+    near.clear();
+    for(auto i:npc)
+      if((i->pos-player).quadLength()<NearDist*NearDist)
+        near.push_back(i);
+    nearCnt += near.size();
+
+    {
+    Testing::Timer t;
+    size_t n = 0;
+    grid.find(player,FarDist,[&](FakeNpc&){ n++; });
+    for(auto i:near)
+      grid.find(i->pos,SenseRange,[&](FakeNpc&){ n++; });
+    Testing::doNotOptimize(n);
+    usGrid += t.us();
+    }
+    {
+    Testing::Timer t;
+    size_t n = 0;
+    for(auto i:npc)
+      n += (i->pos-player).quadLength()<FarDist*FarDist ? 1 : 0;
+    for(auto i:near)
+      for(auto r:npc)
+        n += (r->pos-i->pos).quadLength()<SenseRange*SenseRange ? 1 : 0;
+    Testing::doNotOptimize(n);
+    usBrute += t.us();
+    }
+    queries += 1+near.size();
+    }
+
+  const double tk = double(Ticks);
+  Testing::report("npc",double(NpcCount),"");
+  Testing::report("queries (per tick)",double(queries)/tk,"");
+  Testing::report("near npc (per tick)",double(nearCnt)/tk,"");
+  Testing::report("move all npc (per tick)",usMove/tk,"us");
+  Testing::report("queries, grid        (per tick)",usGrid/tk,"us");
+  Testing::report("queries, brute force (per tick)",usBrute/tk,"us");
+  Testing::report("query, grid          (per query)",usGrid/double(queries),"us");
+  Testing::report("query, brute force   (per query)",usBrute/double(queries),"us");
+  }
+
+int main() {
+  testBruteForce();
+  bench();
+  return Testing::result();
+  }
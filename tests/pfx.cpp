@@ -0,0 +1,186 @@
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "graphics/pfx/pfxintegrate.h"
+#include "testing.h"
+
+using namespace Tempest;
+
+// reference: array of structures, per-particle tick, as PfxBucket was before SoA storage
+namespace Ref {
+
+struct ParState {
+  uint16_t life = 0;
+  Vec3     pos, dir;
+  };
+
+static void tick(std::vector<ParState>& ps, uint64_t dt, const Vec3& gravity, size_t& alive) {
+  const float dtF = float(dt);
+  for(auto& p:ps) {
+    if(p.life==0)
+      continue;
+    if(p.life<=dt) {
+      p.life = 0;
+      alive--;
+      continue;
+      }
+    p.life  = uint16_t(p.life-dt);
+    p.pos  += p.dir*dtF;
+    p.dir  += gravity*dtF;
+    }
+  }
+
+}
+
+// SoA block of emitter, ticked as PfxBucket::tick(Block&,...)
+struct SoA {
+  std::vector<uint16_t> life;
+  std::vector<float>    pos[3], dir[3];
+
+  explicit SoA(size_t n):life(n,0) {
+    for(int c=0; c<3; ++c) {
+      pos[c].resize(n,0.f);
+      dir[c].resize(n,0.f);
+      }
+    }
+
+  void set(size_t i, uint16_t l, const Vec3& p, const Vec3& d) {
+    life[i] = l;
+    pos[0][i] = p.x; pos[1][i] = p.y; pos[2][i] = p.z;
+    dir[0][i] = d.x; dir[1][i] = d.y; dir[2][i] = d.z;
+    }
+
+  void tick(size_t offset, size_t n, uint64_t dt, const Vec3& gravity, size_t& alive) {
+    uint16_t* l = life.data()+offset;
+    for(size_t i=0; i<n; ++i) {
+      if(l[i]==0)
+        continue;
+      if(l[i]<=dt) {
+        l[i] = 0;
+        alive--;
+        continue;
+        }
+      l[i] = uint16_t(l[i]-dt);
+      }
+    float* p[3] = {}, *d[3] = {};
+    for(int c=0; c<3; ++c) {
+      p[c] = pos[c].data()+offset;
+      d[c] = dir[c].data()+offset;
+      }
+    Pfx::integrate(l,p,d,n,float(dt),gravity);
+    }
+  };
+
+// particle emission, same for both layouts; engine is per emitter block, as it is per bucket in game
+struct Spawn {
+  uint16_t life;
+  Vec3     pos, dir;
+  };
+
+static Spawn spawn(std::mt19937& rng) {
+  std::uniform_real_distribution<float> u(-1.f,1.f);
+  Spawn s;
+  s.life = uint16_t(200+rng()%3000);
+  s.pos  = Vec3(u(rng)*100.f,u(rng)*100.f,u(rng)*100.f);
+  s.dir  = Vec3(u(rng)*0.3f,u(rng)*0.3f+0.2f,u(rng)*0.3f);
+  return s;
+  }
+
+// many emitters (blocks), some particles die and are re-emitted every tick; SoA state must match AoS bit for bit
+static void testSoaMatchesAos() {
+  const Vec3 gravity = Vec3(0.f,-0.0003f,0.f);
+  for(size_t blockSize : {size_t(1),size_t(3),size_t(7),size_t(16),size_t(61)}) {
+    const size_t blocks = 40;
+    std::vector<std::vector<Ref::ParState>> aos(blocks,std::vector<Ref::ParState>(blockSize));
+    SoA          soa(blocks*blockSize);
+    std::mt19937 rngA(1), rngS(1), rngDt(2);
+    size_t       aliveA = 0, aliveS = 0;
+
+    bool same = true;
+    for(int frame=0; frame<300 && same; ++frame) {
+      const uint64_t dt = 5+rngDt()%40;
+      for(size_t b=0; b<blocks; ++b) {
+        Ref::tick(aos[b],dt,gravity,aliveA);
+        soa.tick(b*blockSize,blockSize,dt,gravity,aliveS);
+        // emit into free slots
+        for(size_t i=0; i<blockSize; ++i) {
+          if(aos[b][i].life==0 && rngA()%3==0) {
+            auto s = spawn(rngA);
+            aos[b][i] = {s.life,s.pos,s.dir};
+            aliveA++;
+            }
+          if(soa.life[b*blockSize+i]==0 && rngS()%3==0) {
+            auto s = spawn(rngS);
+            soa.set(b*blockSize+i,s.life,s.pos,s.dir);
+            aliveS++;
+            }
+          }
+        }
+
+      for(size_t b=0; b<blocks && same; ++b)
+        for(size_t i=0; i<blockSize; ++i) {
+          const size_t id = b*blockSize+i;
+          auto&        r  = aos[b][i];
+          const float  p[3] = {r.pos.x,r.pos.y,r.pos.z}, d[3] = {r.dir.x,r.dir.y,r.dir.z};
+          same &= (soa.life[id]==r.life);
+          if(r.life==0)
+            continue;
+          for(int c=0; c<3; ++c) {
+            same &= std::memcmp(&soa.pos[c][id],&p[c],sizeof(float))==0;
+            same &= std::memcmp(&soa.dir[c][id],&d[c],sizeof(float))==0;
+            }
+          }
+      }
+    if(!CHECK(same && aliveA==aliveS))
+      std::fprintf(stderr,"  block size: %d\n",int(blockSize));
+    }
+  }
+
+// emitter heavy scene: many small emitters (torches, fires, magic), ticked each frame
+static void bench() {
+  const Vec3 gravity = Vec3(0.f,-0.0003f,0.f);
+  const int  Frames  = 200;
+  for(size_t emitters : {size_t(500),size_t(4000)}) {
+    const size_t blockSize = 48;
+    std::mt19937 rng(3);
+    std::vector<std::vector<Ref::ParState>> aos(emitters,std::vector<Ref::ParState>(blockSize));
+    SoA soa(emitters*blockSize);
+    for(size_t b=0; b<emitters; ++b)
+      for(size_t i=0; i<blockSize; ++i) {
+        auto s = spawn(rng);
+        aos[b][i] = {s.life,s.pos,s.dir};
+        soa.set(b*blockSize+i,s.life,s.pos,s.dir);
+        }
+
+    // particles are not re-emitted here: dead ones stay in blocks, as free slots do in game
+    size_t         aliveA = emitters*blockSize, aliveS = aliveA;
+    Testing::Timer tA;
+    for(int f=0; f<Frames; ++f)
+      for(auto& b:aos)
+        Ref::tick(b,16,gravity,aliveA);
+    const double msA = tA.ms();
+
+    Testing::Timer tS;
+    for(int f=0; f<Frames; ++f)
+      for(size_t b=0; b<emitters; ++b)
+        soa.tick(b*blockSize,blockSize,16,gravity,aliveS);
+    const double msS = tS.ms();
+    CHECK(aliveA==aliveS);
+    Testing::doNotOptimize(aos);
+    Testing::doNotOptimize(soa);
+
+    char name[96] = {};
+    std::snprintf(name,sizeof(name),"%4d emitters x %d: tick, AoS (per frame)",int(emitters),int(blockSize));
+    Testing::report(name,msA/Frames,"ms");
+    std::snprintf(name,sizeof(name),"%4d emitters x %d: tick, SoA (per frame)",int(emitters),int(blockSize));
+    Testing::report(name,msS/Frames,"ms");
+    }
+  }
+
+int main() {
+  testSoaMatchesAos();
+  bench();
+  return Testing::result();
+  }
@@ -0,0 +1,270 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "graphics/dynamic/staticbvh.h"
+#include "physics/raybatch.h"
+#include "testdata.h"
+#include "testing.h"
+
+using namespace Tempest;
+
+// Stand-in for DynamicWorld: bullet is not available to tests, so landscape is a triangle soup in StaticBvh,
+// with closest-hit raycast. It is thread-safe in the same way: const traversal, stack on caller side
+struct Landscape {
+  struct Hit {
+    Vec3  v;
+    bool  hasCol      = false;
+    float hitFraction = 1;
+    };
+
+  std::vector<Vec3>     vbo;
+  std::vector<uint32_t> ibo;
+  StaticBvh             bvh;
+  Vec3                  bbox[2];
+
+  void build() {
+    bvh = StaticBvh();
+    for(size_t i=0; i+2<ibo.size(); i+=3) {
+      StaticBvh::Item itm;
+      itm.tok     = i/3;
+      itm.bbox[0] = vbo[ibo[i]];
+      itm.bbox[1] = vbo[ibo[i]];
+      for(size_t k=1; k<3; ++k) {
+        const Vec3 p[2] = {vbo[ibo[i+k]], vbo[ibo[i+k]]};
+        StaticBvh::merge(itm.bbox,p);
+        }
+      itm.midTr = (itm.bbox[0]+itm.bbox[1])*0.5f;
+      bvh.items.push_back(itm);
+      }
+    bvh.build();
+    bbox[0] = bvh.nodes[0].bbox[0];
+    bbox[1] = bvh.nodes[0].bbox[1];
+    }
+
+  Hit ray(const Vec3& from, const Vec3& to) const {
+    const Vec3 d   = to-from;
+    const Vec3 inv = Vec3(1.f/d.x, 1.f/d.y, 1.f/d.z);
+    Hit        ret;
+    ret.v = to;
+
+    uint32_t stk[64] = {};
+    size_t   sp      = 0;
+    stk[sp++] = 0;
+    while(sp>0) {
+      auto& n = bvh.nodes[stk[--sp]];
+      if(!slab(n.bbox,from,inv,ret.hitFraction))
+        continue;
+      if(n.child!=0) {
+        stk[sp++] = n.child+0;
+        stk[sp++] = n.child+1;
+        continue;
+        }
+      for(size_t i=n.begin; i<n.end; ++i) {
+        const size_t t = bvh.items[i].tok*3;
+        float        k = 0;
+        if(triangle(from,d,vbo[ibo[t]],vbo[ibo[t+1]],vbo[ibo[t+2]],k) && k<ret.hitFraction) {
+          ret.hitFraction = k;
+          ret.hasCol      = true;
+          }
+        }
+      }
+    if(ret.hasCol)
+      ret.v = from + d*ret.hitFraction;
+    return ret;
+    }
+
+  static bool slab(const Vec3* b, const Vec3& o, const Vec3& inv, float tmax) {
+    float t0 = 0, t1 = tmax;
+    const float org[3] = {o.x,o.y,o.z}, iv[3] = {inv.x,inv.y,inv.z};
+    const float mn [3] = {b[0].x,b[0].y,b[0].z}, mx[3] = {b[1].x,b[1].y,b[1].z};
+    for(int c=0; c<3; ++c) {
+      float a = (mn[c]-org[c])*iv[c];
+      float e = (mx[c]-org[c])*iv[c];
+      if(a>e)
+        std::swap(a,e);
+      t0 = std::max(t0,a);
+      t1 = std::min(t1,e);
+      }
+    return t0<=t1;
+    }
+
+  // Moller-Trumbore, double sided
+  static bool triangle(const Vec3& o, const Vec3& d, const Vec3& a, const Vec3& b, const Vec3& c, float& t) {
+    const Vec3  e1  = b-a, e2 = c-a;
+    const Vec3  p   = Vec3::crossProduct(d,e2);
+    const float det = Vec3::dotProduct(e1,p);
+    if(std::abs(det)<1e-8f)
+      return false;
+    const float id = 1.f/det;
+    const Vec3  s  = o-a;
+    const float u  = Vec3::dotProduct(s,p)*id;
+    if(u<0 || u>1)
+      return false;
+    const Vec3  q = Vec3::crossProduct(s,e1);
+    const float v = Vec3::dotProduct(d,q)*id;
+    if(v<0 || u+v>1)
+      return false;
+    t = Vec3::dotProduct(e2,q)*id;
+    return t>=0 && t<=1;
+    }
+  };
+
+static float hill(float x, float z) {
+  return 400.f*std::sin(x/900.f)*std::cos(z/700.f) + 150.f*std::sin(z/230.f+x/410.f);
+  }
+
+// heightfield with hills and some walls, in place of a world mesh
+static Landscape synthetic() {
+  Landscape    l;
+  const int    N    = 160;
+  const float  step = 100;
+  for(int z=0; z<=N; ++z)
+    for(int x=0; x<=N; ++x)
+      l.vbo.push_back(Vec3(float(x)*step,hill(float(x)*step,float(z)*step),float(z)*step));
+  for(int z=0; z<N; ++z)
+    for(int x=0; x<N; ++x) {
+      const uint32_t i = uint32_t(z*(N+1)+x);
+      l.ibo.insert(l.ibo.end(),{i,i+1,i+uint32_t(N)+1, i+1,i+uint32_t(N)+2,i+uint32_t(N)+1});
+      }
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> pos(0,float(N)*step), dir(0,6.28f);
+  for(int w=0; w<300; ++w) {
+    const Vec3 a = Vec3(pos(rng),0,pos(rng));
+    const float ang = dir(rng);
+    const Vec3 b = a + Vec3(std::cos(ang),0,std::sin(ang))*600.f;
+    const uint32_t i = uint32_t(l.vbo.size());
+    l.vbo.push_back(Vec3(a.x,hill(a.x,a.z)-100,a.z));
+    l.vbo.push_back(Vec3(b.x,hill(b.x,b.z)-100,b.z));
+    l.vbo.push_back(Vec3(b.x,hill(b.x,b.z)+400,b.z));
+    l.vbo.push_back(Vec3(a.x,hill(a.x,a.z)+400,a.z));
+    l.ibo.insert(l.ibo.end(),{i,i+1,i+2, i,i+2,i+3});
+    }
+  l.build();
+  return l;
+  }
+
+static std::optional<Landscape> worldLandscape() {
+  if(!TestData::isAvailable())
+    return std::nullopt;
+  auto world = TestData::world();
+  if(!world)
+    return std::nullopt;
+  auto& mesh = world->world_mesh;
+  if(mesh.polygons.vertex_indices.empty())
+    return std::nullopt;
+  Landscape l;
+  for(auto& v:mesh.vertices)
+    l.vbo.push_back(Vec3(v.x,v.y,v.z));
+  l.ibo = mesh.polygons.vertex_indices;
+  l.build();
+  return l;
+  }
+
+struct Query {
+  Vec3 from, to;
+  };
+
+// line of sight between npc eyes, as in sense phase: npc stands on landscape, neighbours within sense range
+static std::vector<Query> senseRays(const Landscape& l, size_t npcCount, std::mt19937& rng) {
+  std::uniform_real_distribution<float> x(l.bbox[0].x,l.bbox[1].x), z(l.bbox[0].z,l.bbox[1].z);
+  std::vector<Vec3> eye;
+  while(eye.size()<npcCount) {
+    const Vec3 p   = Vec3(x(rng),0,z(rng));
+    const auto hit = l.ray(Vec3(p.x,l.bbox[1].y+100,p.z),Vec3(p.x,l.bbox[0].y-100,p.z));
+    if(hit.hasCol)
+      eye.push_back(hit.v+Vec3(0,180,0));
+    }
+  std::vector<Query> ret;
+  for(size_t i=0; i<eye.size(); ++i)
+    for(size_t r=0; r<eye.size(); ++r)
+      if(i!=r && (eye[i]-eye[r]).quadLength()<3000.f*3000.f)
+        ret.push_back({eye[i],eye[r]});
+  return ret;
+  }
+
+static bool same(const Landscape::Hit& a, const Landscape::Hit& b) {
+  return a.hasCol==b.hasCol && std::memcmp(&a.v,&b.v,sizeof(Vec3))==0 &&
+         std::memcmp(&a.hitFraction,&b.hitFraction,sizeof(float))==0;
+  }
+
+static void castBatch(const Landscape& l, const std::vector<Query>& q, std::vector<Landscape::Hit>& out) {
+  out.assign(q.size(),Landscape::Hit());
+  RayBatch::cast(q.data(),out.data(),q.size(),[&l](const Query& r, Landscape::Hit& ret) {
+    ret = l.ray(r.from,r.to);
+    });
+  }
+
+// batched rays return same results, as serial ray(), for any batch size
+static void testBatchMatchesSerial(const Landscape& l, const char* name) {
+  std::mt19937 rng(1);
+  auto         all = senseRays(l,300,rng);
+  // some long random rays too
+  std::uniform_real_distribution<float> x(l.bbox[0].x,l.bbox[1].x), y(l.bbox[0].y,l.bbox[1].y), z(l.bbox[0].z,l.bbox[1].z);
+  for(int i=0; i<2000; ++i)
+    all.push_back({Vec3(x(rng),y(rng),z(rng)),Vec3(x(rng),y(rng),z(rng))});
+
+  size_t mismatch = 0, hits = 0;
+  for(size_t count : {size_t(0),size_t(1),RayBatch::Batch-1,RayBatch::Batch,RayBatch::Batch+1,all.size()}) {
+    std::vector<Query>         q(all.begin(),all.begin()+std::ptrdiff_t(count));
+    std::vector<Landscape::Hit> out;
+    castBatch(l,q,out);
+    for(size_t i=0; i<q.size(); ++i) {
+      const auto ref = l.ray(q[i].from,q[i].to);
+      if(!same(ref,out[i]))
+        mismatch++;
+      if(count==all.size() && ref.hasCol)
+        hits++;
+      }
+    }
+  if(!CHECK(mismatch==0))
+    std::fprintf(stderr,"  %s: %d rays differ\n",name,int(mismatch));
+  // both blocked and clear rays are present
+  if(!CHECK(hits>all.size()/20 && hits<all.size()*19/20))
+    std::fprintf(stderr,"  %s: %d of %d rays hit\n",name,int(hits),int(all.size()));
+  }
+
+static void bench(const Landscape& l, const char* name) {
+  std::mt19937 rng(2);
+  auto         q = senseRays(l,200,rng);
+  std::vector<Landscape::Hit> out(q.size());
+
+  const int Reps = 10;
+  Testing::Timer ts;
+  for(int r=0; r<Reps; ++r)
+    for(size_t i=0; i<q.size(); ++i)
+      out[i] = l.ray(q[i].from,q[i].to);
+  const double msSerial = ts.ms()/Reps;
+  Testing::doNotOptimize(out);
+
+  Testing::Timer tb;
+  for(int r=0; r<Reps; ++r)
+    castBatch(l,q,out);
+  const double msBatch = tb.ms()/Reps;
+  Testing::doNotOptimize(out);
+
+  char n[96] = {};
+  std::snprintf(n,sizeof(n),"%s: triangles",name);
+  Testing::report(n,double(l.ibo.size()/3),"");
+  std::snprintf(n,sizeof(n),"%s: 200 npc, sense rays",name);
+  Testing::report(n,double(q.size()),"");
+  std::snprintf(n,sizeof(n),"%s: serial ray()",name);
+  Testing::report(n,double(q.size())/msSerial,"rays/ms");
+  std::snprintf(n,sizeof(n),"%s: rayBatch, %d workers",name,int(Workers::maxThreads()));
+  Testing::report(n,double(q.size())/msBatch,"rays/ms");
+  }
+
+int main() {
+  const auto syn = synthetic();
+  const auto wrl = worldLandscape();
+  testBatchMatchesSerial(syn,"synthetic");
+  if(wrl)
+    testBatchMatchesSerial(*wrl,"world");
+
+  bench(syn,"synthetic");
+  if(wrl)
+    bench(*wrl,"world");
+  return Testing::result();
+  }
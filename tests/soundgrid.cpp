@@ -0,0 +1,191 @@
+#include <phoenix/vobs/sound.hh>
+#include <phoenix/vobs/zone.hh>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "world/soundgrid.h"
+#include "testdata.h"
+#include "testing.h"
+
+using namespace Tempest;
+
+struct Emitter {
+  Vec3  pos;
+  float radius = 0;
+  };
+
+struct Zone {
+  Vec3 bbox[2];
+  };
+
+// same as WorldSound::isInListenerRange
+static bool inRange(const Emitter& e, const Vec3& listener) {
+  const float dist = e.radius+800;
+  return (e.pos-listener).quadLength()<dist*dist;
+  }
+
+// same as WorldSound::Zone::checkPos
+static bool inZone(const Zone& z, const Vec3& p) {
+  return z.bbox[0].x<=p.x && p.x<z.bbox[1].x &&
+         z.bbox[0].y<=p.y && p.y<z.bbox[1].y &&
+         z.bbox[0].z<=p.z && p.z<z.bbox[1].z;
+  }
+
+static void compare(const std::vector<Emitter>& eff, const std::vector<Zone>& zones,
+                    const std::vector<Vec3>& query, const char* name) {
+  SoundGrid effGrid, zoneGrid;
+  for(size_t i=0; i<eff.size(); ++i) {
+    const float r = eff[i].radius+800;
+    effGrid.insert(uint32_t(i),eff[i].pos-Vec3(r,r,r),eff[i].pos+Vec3(r,r,r));
+    }
+  for(size_t i=0; i<zones.size(); ++i)
+    zoneGrid.insert(uint32_t(i),zones[i].bbox[0],zones[i].bbox[1]);
+
+  size_t                mismatch = 0, visited = 0, found = 0;
+  std::vector<uint32_t> a, b;
+  for(auto& p:query) {
+    a.clear();
+    b.clear();
+    for(uint32_t i=0; i<eff.size(); ++i)
+      if(inRange(eff[i],p))
+        a.push_back(i);
+    for(auto* ids:{&effGrid.at(p), &effGrid.everywhere()})
+      for(auto id:*ids) {
+        visited++;
+        if(inRange(eff[id],p))
+          b.push_back(id);
+        }
+    std::sort(b.begin(),b.end());
+    if(a!=b)
+      mismatch++;
+    found += a.size();
+
+    // last zone in the list wins
+    uint32_t zRef = uint32_t(-1), zGrid = uint32_t(-1);
+    for(uint32_t i=0; i<zones.size(); ++i)
+      if(inZone(zones[i],p))
+        zRef = i;
+    for(auto* ids:{&zoneGrid.at(p), &zoneGrid.everywhere()})
+      for(auto id:*ids)
+        if((zGrid==uint32_t(-1) || id>zGrid) && inZone(zones[id],p))
+          zGrid = id;
+    if(zRef!=zGrid)
+      mismatch++;
+    }
+  if(!CHECK(mismatch==0))
+    std::fprintf(stderr,"  %s: %d mismatches\n",name,int(mismatch));
+
+  Testing::Timer tLinear;
+  for(auto& p:query) {
+    size_t n = 0;
+    for(auto& e:eff)
+      n += inRange(e,p) ? 1 : 0;
+    Testing::doNotOptimize(n);
+    }
+  const double linearUs = tLinear.us();
+
+  Testing::Timer tGrid;
+  for(auto& p:query) {
+    size_t n = 0;
+    for(auto* ids:{&effGrid.at(p), &effGrid.everywhere()})
+      for(auto id:*ids)
+        n += inRange(eff[id],p) ? 1 : 0;
+    Testing::doNotOptimize(n);
+    }
+  const double gridUs = tGrid.us();
+
+  char buf[128] = {};
+  std::snprintf(buf,sizeof(buf),"%s: sound emitters",name);
+  Testing::report(buf,double(eff.size()),"");
+  std::snprintf(buf,sizeof(buf),"%s: music zones",name);
+  Testing::report(buf,double(zones.size()),"");
+  std::snprintf(buf,sizeof(buf),"%s: emitters in range (per query)",name);
+  Testing::report(buf,double(found)/double(query.size()),"");
+  std::snprintf(buf,sizeof(buf),"%s: emitters visited, grid (per query)",name);
+  Testing::report(buf,double(visited)/double(query.size()),"");
+  std::snprintf(buf,sizeof(buf),"%s: emitter lookup, grid   (per query)",name);
+  Testing::report(buf,gridUs/double(query.size()),"us");
+  std::snprintf(buf,sizeof(buf),"%s: emitter lookup, linear (per query)",name);
+  Testing::report(buf,linearUs/double(query.size()),"us");
+  }
+
+static void testSynthetic() {
+  std::mt19937                          rng(1);
+  std::uniform_real_distribution<float> xz(-60000,60000), y(-3000,3000), rad(300,4000), ext(500,20000);
+
+  std::vector<Emitter> eff(1500);
+  for(auto& e:eff) {
+    e.pos    = Vec3(xz(rng),y(rng),xz(rng));
+    e.radius = rad(rng);
+    }
+  // huge emitter: goes to 'everywhere' list
+  eff.push_back({Vec3(0,0,0),200000.f});
+
+  std::vector<Zone> zones(60);
+  for(auto& z:zones) {
+    const Vec3 c = Vec3(xz(rng),y(rng),xz(rng));
+    const Vec3 d = Vec3(ext(rng),ext(rng),ext(rng));
+    z.bbox[0] = c-d;
+    z.bbox[1] = c+d;
+    }
+  zones.push_back({{Vec3(-1e6f,-1e6f,-1e6f),Vec3(1e6f,1e6f,1e6f)}});
+  zones.push_back({{Vec3(-1000,-1000,-1000),Vec3(1000,1000,1000)}});
+
+  std::vector<Vec3> query(100000);
+  for(auto& p:query)
+    p = Vec3(xz(rng),y(rng),xz(rng));
+  // cell borders
+  query.push_back(Vec3(0,0,0));
+  query.push_back(Vec3(-2000,0,2000));
+  query.push_back(Vec3(1999.99f,0,-0.01f));
+  compare(eff,zones,query,"synthetic");
+  }
+
+static void collect(const std::vector<std::unique_ptr<phoenix::vob>>& vobs,
+                    std::vector<Emitter>& eff, std::vector<Zone>& zones) {
+  for(auto& v:vobs) {
+    if(v->type==phoenix::vob_type::zCVobSound || v->type==phoenix::vob_type::zCVobSoundDaytime) {
+      auto& s = reinterpret_cast<const phoenix::vobs::sound&>(*v);
+      eff.push_back({Vec3(s.position.x,s.position.y,s.position.z),s.radius});
+      }
+    else if(v->type==phoenix::vob_type::oCZoneMusic) {
+      Zone z;
+      z.bbox[0] = Vec3(v->bbox.min.x,v->bbox.min.y,v->bbox.min.z);
+      z.bbox[1] = Vec3(v->bbox.max.x,v->bbox.max.y,v->bbox.max.z);
+      zones.push_back(z);
+      }
+    collect(v->children,eff,zones);
+    }
+  }
+
+static void testWorld() {
+  if(!TestData::isAvailable())
+    return;
+  auto world = TestData::world();
+  if(!CHECK(world.has_value()))
+    return;
+
+  std::vector<Emitter> eff;
+  std::vector<Zone>    zones;
+  collect(world->world_vobs,eff,zones);
+  if(!CHECK(!eff.empty()))
+    return;
+
+  // listener: near every emitter, and all over the world bbox
+  std::mt19937                          rng(2);
+  std::uniform_real_distribution<float> jitter(-3000.f,3000.f);
+  std::vector<Vec3>                     query;
+  for(auto& e:eff)
+    for(int i=0; i<20; ++i)
+      query.push_back(e.pos+Vec3(jitter(rng),jitter(rng)*0.1f,jitter(rng)));
+  compare(eff,zones,query,"world");
+  }
+
+int main() {
+  testSynthetic();
+  testWorld();
+  return Testing::result();
+  }
@@ -0,0 +1,169 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "sound/soundocclusion.h"
+#include "testing.h"
+
+using namespace Tempest;
+
+// stand-in for DynamicWorld::soundOclusion: walls along x, every 1000 units; each crossed wall occludes 0.35.
+// Marches along the ray, as a raycast visits many cells
+static float rayOcclusion(const Vec3& from, const Vec3& to) {
+  const int steps = 64;
+  int       walls = 0;
+  float     prev  = std::floor(from.x/1000.f);
+  for(int i=1; i<=steps; ++i) {
+    const float k = float(i)/float(steps);
+    const float x = from.x + (to.x-from.x)*k;
+    const float c = std::floor(x/1000.f);
+    if(c!=prev)
+      walls++;
+    prev = c;
+    }
+  return std::min(1.f,float(walls)*0.35f);
+  }
+
+struct Scene {
+  std::vector<SoundOcclusion::Slot> slot;
+  std::vector<Vec3>                 pos;
+  SoundOcclusion                    occlusion;
+  size_t                            rays = 0;
+
+  explicit Scene(size_t n, std::mt19937& rng) : slot(n), pos(n) {
+    std::uniform_real_distribution<float> xz(-5000,5000);
+    for(auto& p:pos)
+      p = Vec3(xz(rng),0,xz(rng));
+    }
+
+  // same as WorldSound::tick
+  void tick(const Vec3& head, uint64_t dt, uint64_t now) {
+    for(size_t i=0; i<slot.size(); ++i)
+      occlusion.tick(slot[i],head,pos[i],dt,now);
+    rays += occlusion.pending();
+    occlusion.flush(now,rayOcclusion,[](SoundOcclusion::Slot&){});
+    }
+  };
+
+// batched parallel raycasts give the same result, as serial ray per sound
+static void testBatchMatchesSerial() {
+  std::mt19937 rng(1);
+  Scene        s(2000,rng);
+  const Vec3   head = Vec3(120,0,-40);
+  s.tick(head,16,1000);
+  CHECK(s.rays==s.slot.size());
+
+  size_t mismatch = 0;
+  for(size_t i=0; i<s.slot.size(); ++i) {
+    auto&       sl  = s.slot[i];
+    const float ref = std::max(0.f,1.f-rayOcclusion(head,s.pos[i]));
+    // first result is applied immediately
+    if(!sl.valid || sl.target!=ref || sl.occ!=ref)
+      mismatch++;
+    }
+  if(!CHECK(mismatch==0))
+    std::fprintf(stderr,"  %d of %d sounds differ\n",int(mismatch),int(s.slot.size()));
+  }
+
+// raycasts are rate-limited, skipped for static listener and sources, and spread over frames
+static void testRateLimit() {
+  std::mt19937 rng(2);
+  Scene        s(400,rng);
+
+  // static: one ray per sound, then cache
+  uint64_t now = 1000;
+  for(int f=0; f<120; ++f, now+=16)
+    s.tick(Vec3(0,0,0),16,now);
+  CHECK(s.rays==s.slot.size());
+
+  // moving listener: at most one ray per interval
+  s.rays = 0;
+  const int frames = 120;
+  size_t    perFrameMax = 0;
+  for(int f=0; f<frames; ++f, now+=16) {
+    const size_t r0 = s.rays;
+    s.tick(Vec3(float(f)*20.f,0,0),16,now);
+    perFrameMax = std::max(perFrameMax,s.rays-r0);
+    }
+  const size_t limit = s.slot.size()*(size_t(frames*16)/SoundOcclusion::interval+1);
+  if(!CHECK(s.rays>0 && s.rays<=limit))
+    std::fprintf(stderr,"  %d rays, limit %d\n",int(s.rays),int(limit));
+  // sounds started on same frame are staggered: no frame raycasts all of them
+  if(!CHECK(perFrameMax<s.slot.size()/2))
+    std::fprintf(stderr,"  %d rays in one frame\n",int(perFrameMax));
+
+  // out of range and back: raycasted and applied immediately
+  s.occlusion.reset(s.slot[0]);
+  CHECK(!s.slot[0].valid && s.slot[0].occ==0);
+  s.tick(Vec3(0,0,0),16,now);
+  const float ref = std::max(0.f,1.f-rayOcclusion(Vec3(0,0,0),s.pos[0]));
+  CHECK(s.slot[0].valid && s.slot[0].occ==ref);
+  }
+
+// occlusion follows result smoothly and settles within 'smooth' time after next raycast
+static void testSmooth() {
+  SoundOcclusion       occlusion;
+  SoundOcclusion::Slot slot;
+  const Vec3           src = Vec3(500,0,0);
+  occlusion.init(slot,Vec3(0,0,0),src,rayOcclusion(Vec3(0,0,0),src),0);
+  CHECK(slot.occ==1.f);
+
+  // listener walks behind a wall
+  const Vec3 head = Vec3(-1500,0,0);
+  uint64_t   now  = 16;
+  float      prev = slot.occ;
+  bool       monotonic = true;
+  for(; now<SoundOcclusion::interval+SoundOcclusion::smooth*4; now+=16) {
+    occlusion.tick(slot,head,src,16,now);
+    occlusion.flush(now,rayOcclusion,[](SoundOcclusion::Slot&){});
+    monotonic &= slot.occ<=prev;
+    prev = slot.occ;
+    }
+  const float target = 1.f-rayOcclusion(head,src);
+  CHECK(slot.target==target && target<1.f);
+  CHECK(monotonic);
+  if(!CHECK(std::abs(slot.occ-target)<0.02f))
+    std::fprintf(stderr,"  occ = %f, target = %f\n",double(slot.occ),double(target));
+  }
+
+// 3d sounds of a busy scene; listener walks. Rays per frame and cost, vs a raycast per sound and frame
+static void bench() {
+  const int Frames = 300;
+  for(size_t count : {size_t(64),size_t(512)}) {
+    std::mt19937 rng(3);
+    Scene        s(count,rng);
+
+    Testing::Timer t;
+    uint64_t       now = 1000;
+    for(int f=0; f<Frames; ++f, now+=16)
+      s.tick(Vec3(float(f)*5.f,0,0),16,now);
+    const double usBatch = t.us()/Frames;
+
+    Testing::Timer tn;
+    float          sum = 0;
+    for(int f=0; f<Frames; ++f)
+      for(auto& p:s.pos)
+        sum += rayOcclusion(Vec3(float(f)*5.f,0,0),p);
+    const double usNaive = tn.us()/Frames;
+    Testing::doNotOptimize(sum);
+
+    char name[96] = {};
+    std::snprintf(name,sizeof(name),"%3d sounds: rays, every frame    (per frame)",int(count));
+    Testing::report(name,double(count),"");
+    std::snprintf(name,sizeof(name),"%3d sounds: rays, batched        (per frame)",int(count));
+    Testing::report(name,double(s.rays)/Frames,"");
+    std::snprintf(name,sizeof(name),"%3d sounds: occlusion, every frame",int(count));
+    Testing::report(name,usNaive,"us");
+    std::snprintf(name,sizeof(name),"%3d sounds: occlusion, batched",int(count));
+    Testing::report(name,usBatch,"us");
+    }
+  }
+
+int main() {
+  testBatchMatchesSerial();
+  testRateLimit();
+  testSmooth();
+  bench();
+  return Testing::result();
+  }
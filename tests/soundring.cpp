@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "sound/soundring.h"
+#include "testing.h"
+
+// sample k is stored, so that pcm16 conversion gives exactly (k%Period)
+enum { Period = 30000 };
+
+static float sampleOf(size_t k) {
+  return (float(k%Period)+0.5f)/32767.5f;
+  }
+
+static void testBasic() {
+  SoundRing ring(1000,2);
+  CHECK(ring.capacity()==1024);
+  CHECK(ring.size()==0);
+
+  std::vector<float> s(1500);
+  for(size_t i=0; i<s.size(); ++i)
+    s[i] = sampleOf(i);
+
+  // full ring accepts whole frames only
+  CHECK(ring.push(s.data(),1023)==1022);
+  CHECK(ring.push(s.data()+1022,100)==2);
+  CHECK(ring.size()==1024);
+  CHECK(ring.push(s.data(),2)==0);
+
+  // short read: real samples first, then silence
+  std::vector<int16_t> out(2048,-1);
+  CHECK(ring.pop(out.data(),1000)==1000);
+  CHECK(ring.pop(out.data()+1000,100)==24);
+  for(size_t i=0; i<1024; ++i)
+    CHECK(out[i]==int16_t(i));
+  for(size_t i=1024; i<1100; ++i)
+    CHECK(out[i]==0);
+  CHECK(ring.size()==0);
+
+  // wrap around the end of storage
+  CHECK(ring.push(s.data(),600)==600);
+  CHECK(ring.pop(out.data(),600)==600);
+  CHECK(ring.push(s.data(),900)==900);
+  CHECK(ring.pop(out.data(),900)==900);
+  for(size_t i=0; i<900; ++i)
+    CHECK(out[i]==int16_t(i));
+
+  int16_t clip[2] = {};
+  float   big [2] = {4.f,-4.f};
+  ring.push(big,2);
+  ring.pop(clip,2);
+  CHECK(clip[0]==32767 && clip[1]==-32768);
+  }
+
+// producer pushes with retry (as VideoWidget does), consumer pops random sizes in real-time fashion
+static void testStress() {
+  const size_t channels = 2;
+  const size_t total    = 1024*1024;
+  SoundRing    ring(4096,channels);
+
+  size_t       errors   = 0;
+  size_t       padded   = 0;
+  size_t       received = 0;
+  std::thread consumer([&]() {
+    std::mt19937         rng(2);
+    std::vector<int16_t> out(1024);
+    while(received<total) {
+      const size_t n   = channels*(1+rng()%(out.size()/channels));
+      const size_t cnt = ring.pop(out.data(),n);
+      for(size_t i=0; i<cnt; ++i)
+        if(out[i]!=int16_t((received+i)%Period))
+          errors++;
+      for(size_t i=cnt; i<n; ++i)
+        if(out[i]!=0)
+          errors++;
+      received += cnt;
+      if(cnt<n)
+        padded++;
+      }
+    });
+
+  std::mt19937       rng(1);
+  std::vector<float> chunk;
+  size_t             sent = 0;
+  while(sent<total) {
+    const size_t n = std::min(total-sent, channels*(1+rng()%1500));
+    chunk.resize(n);
+    for(size_t i=0; i<n; ++i)
+      chunk[i] = sampleOf(sent+i);
+    size_t at = 0;
+    while(at<n) {
+      at += ring.push(chunk.data()+at,n-at);
+      if(at<n)
+        std::this_thread::yield();
+      }
+    sent += n;
+    }
+  consumer.join();
+
+  CHECK(errors==0);
+  CHECK(received==total);
+  CHECK(ring.size()==0);
+  Testing::report("samples",double(total),"");
+  Testing::report("short reads",double(padded),"");
+  }
+
+int main() {
+  testBasic();
+  testStress();
+  return Testing::result();
+  }
@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "graphics/dynamic/staticbvh.h"
+#include "testing.h"
+
+using namespace Tempest;
+
+// token bookkeeping, same as VisibilityGroup::updateStaticTree: refit, reinsert, overflow list
+struct Scene {
+  struct Obj {
+    Vec3   bbox[2];
+    size_t treeId = size_t(-1);
+    bool   alive  = false;
+    };
+  std::vector<Obj>      obj;
+  std::vector<size_t>   overflow;
+  std::vector<uint32_t> refit;
+  StaticBvh             tree;
+  size_t                dead = 0;
+
+  void detach(size_t id) {
+    auto& o = obj[id];
+    if(o.treeId==size_t(-1))
+      return;
+    auto& itm = tree.items[o.treeId];
+    itm.tok  = size_t(-1);
+    o.treeId = size_t(-1);
+    refit.push_back(itm.leaf);
+    dead++;
+    }
+
+  void rebuild() {
+    tree = StaticBvh();
+    dead = 0;
+    overflow.clear();
+    for(size_t i=0; i<obj.size(); ++i) {
+      obj[i].treeId = size_t(-1);
+      if(!obj[i].alive)
+        continue;
+      StaticBvh::Item itm;
+      itm.tok     = i;
+      itm.bbox[0] = obj[i].bbox[0];
+      itm.bbox[1] = obj[i].bbox[1];
+      itm.midTr   = (itm.bbox[0]+itm.bbox[1])*0.5f;
+      tree.items.push_back(itm);
+      }
+    tree.build();
+    for(size_t i=0; i<tree.items.size(); ++i)
+      obj[tree.items[i].tok].treeId = i;
+    }
+
+  void move(size_t id, const Vec3& d) {
+    auto& o = obj[id];
+    o.bbox[0] += d;
+    o.bbox[1] += d;
+    if(o.treeId==size_t(-1))
+      return;
+    auto& itm = tree.items[o.treeId];
+    if(tree.fits(itm.leaf,o.bbox)) {
+      itm.bbox[0] = o.bbox[0];
+      itm.bbox[1] = o.bbox[1];
+      refit.push_back(itm.leaf);
+      return;
+      }
+    const uint32_t leaf = tree.findLeaf(o.bbox);
+    detach(id);
+    if(!tree.fits(leaf,o.bbox)) {
+      overflow.push_back(id);
+      return;
+      }
+    StaticBvh::Item n;
+    n.tok     = id;
+    n.bbox[0] = o.bbox[0];
+    n.bbox[1] = o.bbox[1];
+    o.treeId  = tree.insert(leaf,n);
+    refit.push_back(leaf);
+    }
+
+  void add(size_t id, const Vec3* bbox) {
+    auto& o = obj[id];
+    o.bbox[0] = bbox[0];
+    o.bbox[1] = bbox[1];
+    o.alive   = true;
+    overflow.push_back(id);
+    }
+
+  void remove(size_t id) {
+    detach(id);
+    obj[id].alive = false;
+    }
+
+  void commit() {
+    tree.refit(refit);
+    // drop dead or reinserted entries of overflow list
+    std::erase_if(overflow,[this](size_t id){ return !obj[id].alive || obj[id].treeId!=size_t(-1); });
+    std::sort(overflow.begin(),overflow.end());
+    overflow.erase(std::unique(overflow.begin(),overflow.end()),overflow.end());
+    }
+
+  template<class F>
+  void query(const Vec3* box, F f) const {
+    if(tree.nodes.size()>0)
+      query(0,box,f);
+    for(auto id:overflow)
+      if(overlap(obj[id].bbox,box))
+        f(id);
+    }
+
+  template<class F>
+  void query(uint32_t node, const Vec3* box, F& f) const {
+    auto& n = tree.nodes[node];
+    if(!overlap(n.bbox,box))
+      return;
+    if(n.child!=0) {
+      query(n.child+0,box,f);
+      query(n.child+1,box,f);
+      return;
+      }
+    auto test = [&](const StaticBvh::Item& i) {
+      if(i.tok!=size_t(-1) && overlap(obj[i.tok].bbox,box))
+        f(i.tok);
+      };
+    for(size_t i=n.begin; i<n.end; ++i)
+      test(tree.items[i]);
+    for(auto i=n.extra; i!=StaticBvh::NoItem; i=tree.items[i].next)
+      test(tree.items[i]);
+    }
+
+  static bool overlap(const Vec3* a, const Vec3* b) {
+    return a[0].x<=b[1].x && b[0].x<=a[1].x &&
+           a[0].y<=b[1].y && b[0].y<=a[1].y &&
+           a[0].z<=b[1].z && b[0].z<=a[1].z;
+    }
+  };
+
+static void randomBox(std::mt19937& rng, Vec3* bbox) {
+  std::uniform_real_distribution<float> xz(-50000,50000), y(-2000,2000), sz(20,800);
+  const Vec3 c = Vec3(xz(rng),y(rng),xz(rng));
+  const Vec3 s = Vec3(sz(rng),sz(rng),sz(rng));
+  bbox[0] = c-s;
+  bbox[1] = c+s;
+  }
+
+static Scene makeScene(std::mt19937& rng, size_t count) {
+  Scene s;
+  s.obj.resize(count);
+  for(auto& o:s.obj) {
+    randomBox(rng,o.bbox);
+    o.alive = true;
+    }
+  s.rebuild();
+  return s;
+  }
+
+// churn: every query must return same objects, as linear scan
+static void testChurn() {
+  std::mt19937                          rng(1);
+  std::uniform_real_distribution<float> small(-100,100), big(-20000,20000);
+  Scene s = makeScene(rng,5000);
+  s.obj.resize(6000);
+
+  size_t mismatch = 0, queries = 0, found = 0, reinserted = 0;
+  std::vector<size_t> a, b;
+  for(int frame=0; frame<300; ++frame) {
+    for(int i=0; i<50; ++i) {
+      const size_t id = rng()%s.obj.size();
+      if(!s.obj[id].alive) {
+        Vec3 bbox[2];
+        randomBox(rng,bbox);
+        s.add(id,bbox);
+        continue;
+        }
+      const int op = int(rng()%10);
+      if(op==0)
+        s.remove(id);
+      else if(op<3)
+        s.move(id,Vec3(big(rng),0,big(rng)));
+      else
+        s.move(id,Vec3(small(rng),small(rng),small(rng)));
+      }
+    s.commit();
+    reinserted += s.tree.items.size()-s.tree.built;
+
+    for(int q=0; q<10; ++q) {
+      Vec3 box[2];
+      randomBox(rng,box);
+      box[0] -= Vec3(3000,3000,3000);
+      box[1] += Vec3(3000,3000,3000);
+      a.clear();
+      b.clear();
+      for(size_t i=0; i<s.obj.size(); ++i)
+        if(s.obj[i].alive && Scene::overlap(s.obj[i].bbox,box))
+          a.push_back(i);
+      s.query(box,[&](size_t id){ b.push_back(id); });
+      std::sort(b.begin(),b.end());
+      if(a!=b)
+        mismatch++;
+      found += a.size();
+      queries++;
+      }
+    if(frame%100==99)
+      s.rebuild();
+    }
+  if(!CHECK(mismatch==0))
+    std::fprintf(stderr,"  %d of %d queries differ\n",int(mismatch),int(queries));
+  CHECK(found>queries);
+  CHECK(reinserted>0);
+  }
+
+// static objects of a big world; per frame, some of them move (doors, chests, moving mobs), are added or removed
+static void bench() {
+  const size_t Count = 40000, Frames = 200;
+
+  for(size_t churn : {size_t(10),size_t(100),size_t(1000)}) {
+    std::mt19937                          rng(2);
+    std::uniform_real_distribution<float> step(-150,150);
+    Scene s = makeScene(rng,Count);
+
+    double usInc = 0, usRebuild = 0;
+    size_t overflow = 0, rebuilds = 0;
+    for(size_t frame=0; frame<Frames; ++frame) {
+      Testing::Timer t;
+      for(size_t i=0; i<churn; ++i) {
+        const size_t id = rng()%s.obj.size();
+        if(i%10==0) {
+          Vec3 bbox[2];
+          randomBox(rng,bbox);
+          s.remove(id);
+          s.add(id,bbox);
+          } else {
+          s.move(id,Vec3(step(rng),0,step(rng)));
+          }
+        }
+      s.commit();
+      usInc    += t.us();
+      overflow += s.overflow.size();
+
+      // same policy as VisibilityGroup::pass; there rebuild runs in background
+      const size_t alive = s.tree.items.size()-s.dead;
+      if(s.overflow.size()+s.dead>std::max<size_t>(256,alive/16) || s.tree.cost>s.tree.cost0*1.25) {
+        Testing::Timer tr;
+        s.rebuild();
+        usRebuild += tr.us();
+        rebuilds++;
+        }
+      }
+
+    Testing::Timer t;
+    for(size_t frame=0; frame<10; ++frame)
+      s.rebuild();
+    const double usFull = t.us()/10.0;
+
+    char name[96] = {};
+    std::snprintf(name,sizeof(name),"%4d changes: incremental update (per frame)",int(churn));
+    Testing::report(name,usInc/double(Frames),"us");
+    std::snprintf(name,sizeof(name),"%4d changes: full rebuild       (per frame)",int(churn));
+    Testing::report(name,usFull,"us");
+    std::snprintf(name,sizeof(name),"%4d changes: overflow list      (per frame)",int(churn));
+    Testing::report(name,double(overflow)/double(Frames),"");
+    std::snprintf(name,sizeof(name),"%4d changes: rebuilds, policy   (per %d frames)",int(churn),int(Frames));
+    Testing::report(name,double(rebuilds),"");
+    std::snprintf(name,sizeof(name),"%4d changes: rebuild, policy   (per frame)",int(churn));
+    Testing::report(name,usRebuild/double(Frames),"us");
+    }
+  }
+
+int main() {
+  testChurn();
+  bench();
+  return Testing::result();
+  }
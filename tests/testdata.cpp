@@ -0,0 +1,122 @@
+#include "testdata.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+static std::string toUpper(std::string s) {
+  for(auto& c:s)
+    c = char(std::toupper(static_cast<unsigned char>(c)));
+  return s;
+  }
+
+static fs::path dataRoot() {
+  const char* env = std::getenv("OPENGOTHIC_TEST_DATA");
+  if(env==nullptr || env[0]=='\0')
+    return fs::path();
+  return fs::path(env);
+  }
+
+static fs::path findSegment(const fs::path& dir, std::string_view name) {
+  std::error_code ec;
+  for(auto& i:fs::directory_iterator(dir,ec)) {
+    if(toUpper(i.path().filename().string())==name)
+      return i.path();
+    }
+  return fs::path();
+  }
+
+static phoenix::vdf_file loadVdfs() {
+  phoenix::vdf_file ret{"Root"};
+  const auto data = findSegment(dataRoot(),"DATA");
+  if(data.empty())
+    return ret;
+
+  std::vector<fs::path> archives;
+  std::error_code ec;
+  for(auto& i:fs::directory_iterator(data,ec)) {
+    auto ext = toUpper(i.path().extension().string());
+    if(ext==".VDF" || ext==".MOD")
+      archives.push_back(i.path());
+    }
+  // same as in game: addon archives are merged first
+  std::sort(archives.begin(),archives.end(),[](const fs::path& a, const fs::path& b){
+    return fs::last_write_time(a)>fs::last_write_time(b);
+    });
+
+  for(auto& i:archives) {
+    try {
+      auto in     = phoenix::buffer::mmap(i);
+      auto header = phoenix::vdf_header::read(in);
+      if(header.version==160)
+        continue;
+      in.rewind();
+      ret.merge(phoenix::vdf_file::open(in), false);
+      }
+    catch(const std::exception& err) {
+      std::fprintf(stderr,"unable to load archive: \"%s\", reason: %s\n",i.string().c_str(),err.what());
+      }
+    }
+  return ret;
+  }
+
+bool TestData::isAvailable() {
+  if(dataRoot().empty()) {
+    std::printf("OPENGOTHIC_TEST_DATA is not set - skipped\n");
+    return false;
+    }
+  return true;
+  }
+
+const phoenix::vdf_file& TestData::vdfs() {
+  static phoenix::vdf_file vdf = loadVdfs();
+  return vdf;
+  }
+
+phoenix::game_version TestData::version() {
+  if(vdfs().find_entry("NEWWORLD.ZEN")!=nullptr)
+    return phoenix::game_version::gothic_2;
+  return phoenix::game_version::gothic_1;
+  }
+
+std::optional<phoenix::world> TestData::world() {
+  std::string name = version()==phoenix::game_version::gothic_2 ? "NEWWORLD.ZEN" : "WORLD.ZEN";
+  if(const char* env = std::getenv("OPENGOTHIC_TEST_WORLD"))
+    name = env;
+
+  auto buf = file(name);
+  if(!buf.has_value()) {
+    std::fprintf(stderr,"unable to open zen-file: \"%s\"\n",name.c_str());
+    return std::nullopt;
+    }
+  return phoenix::world::parse(*buf,version());
+  }
+
+std::optional<phoenix::buffer> TestData::file(std::string_view name) {
+  const phoenix::vdf_entry* entry = vdfs().find_entry(name);
+  if(entry==nullptr)
+    return std::nullopt;
+  return entry->open();
+  }
+
+std::vector<fs::path> TestData::videos() {
+  std::vector<fs::path> ret;
+  fs::path dir = findSegment(dataRoot(),"_WORK");
+  for(auto seg : {"DATA","VIDEO"}) {
+    if(dir.empty())
+      return ret;
+    dir = findSegment(dir,seg);
+    }
+  std::error_code ec;
+  for(auto& i:fs::directory_iterator(dir,ec)) {
+    if(toUpper(i.path().extension().string())==".BIK")
+      ret.push_back(i.path());
+    }
+  std::sort(ret.begin(),ret.end());
+  return ret;
+  }
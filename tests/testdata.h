@@ -0,0 +1,21 @@
+#pragma once
+
+#include <phoenix/vdfs.hh>
+#include <phoenix/world.hh>
+
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Game data for benchmarks. OPENGOTHIC_TEST_DATA points to Gothic installation directory;
+// OPENGOTHIC_TEST_WORLD optionally selects zen-file (NEWWORLD.ZEN or WORLD.ZEN by default).
+namespace TestData {
+  bool                           isAvailable();
+  const phoenix::vdf_file&       vdfs();
+  phoenix::game_version          version();
+  std::optional<phoenix::world>  world();
+  std::optional<phoenix::buffer> file(std::string_view name);
+  // *.bik files from _work/Data/Video
+  std::vector<std::filesystem::path> videos();
+  }
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal harness for tests and benchmarks: CHECK counts failures, main returns Testing::result().
+namespace Testing {
+  // ctest SKIP_RETURN_CODE, for benchmarks without game data
+  enum : int { Skipped = 77 };
+
+  inline int& failures() {
+    static int cnt = 0;
+    return cnt;
+    }
+
+  inline bool check(bool cond, const char* expr, const char* file, int line) {
+    if(!cond) {
+      std::fprintf(stderr,"%s:%d: check failed: %s\n",file,line,expr);
+      failures()++;
+      }
+    return cond;
+    }
+
+  inline int result() {
+    if(failures()>0)
+      std::fprintf(stderr,"%d check(s) failed\n",failures());
+    return failures()>0 ? 1 : 0;
+    }
+
+  class Timer final {
+    public:
+      Timer():start(std::chrono::steady_clock::now()){}
+      double ms() const { return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count(); }
+      double us() const { return std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now()-start).count(); }
+      double ns() const { return std::chrono::duration<double,std::nano> (std::chrono::steady_clock::now()-start).count(); }
+
+    private:
+      std::chrono::steady_clock::time_point start;
+    };
+
+  inline void report(const char* name, double value, const char* unit) {
+    std::printf("%-48s %12.3f %s\n",name,value,unit);
+    std::fflush(stdout);
+    }
+
+  // keeps result of benchmarked code alive
+  template<class T>
+  inline void doNotOptimize(const T& v) {
+    static volatile const void* sink = nullptr;
+    sink = &v;
+    (void)sink;
+    }
+  }
+
+#define CHECK(expr) Testing::check(bool(expr),#expr,__FILE__,__LINE__)
@@ -0,0 +1,466 @@
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "world/wayhierarchy.h"
+#include "world/waypoint.h"
+#include "utils/workers.h"
+#include "testdata.h"
+#include "testing.h"
+
+using namespace Tempest;
+
+// reference: wave-front flood fill from the end, as WayMatrix::wayTo was before WayHierarchy
+struct FloodFill {
+  std::vector<int32_t>  pathLen;
+  std::vector<uint32_t> pathGen;
+  uint32_t              gen = 0;
+  std::vector<uint32_t> stk[2];
+
+  bool route(const std::vector<WayPoint>& wp, const uint32_t* begin, size_t beginSz, const Vec3& exact,
+             uint32_t end, std::vector<uint32_t>& path) {
+    path.clear();
+    if(pathLen.size()!=wp.size()) {
+      pathLen.assign(wp.size(),0);
+      pathGen.assign(wp.size(),0);
+      }
+    gen++;
+    auto  idOf  = [&wp](const WayPoint* w) { return uint32_t(w-wp.data()); };
+    auto* front = &stk[0];
+    auto* back  = &stk[1];
+    front->clear();
+    back ->clear();
+
+    pathLen[end] = 0;
+    pathGen[end] = gen;
+    front->push_back(end);
+    while(front->size()>0) {
+      bool done = true;
+      for(size_t i=0; i<beginSz; ++i)
+        if(pathGen[begin[i]]!=gen) {
+          done = false;
+          break;
+          }
+      if(done)
+        break;
+      for(auto id:*front) {
+        const int32_t l0 = pathLen[id];
+        for(auto& c:wp[id].connections()) {
+          const uint32_t w  = idOf(c.point);
+          const int32_t  l1 = l0+c.len;
+          if(pathGen[w]!=gen || pathLen[w]>l1) {
+            pathLen[w] = l1;
+            pathGen[w] = gen;
+            back->push_back(w);
+            }
+          }
+        }
+      std::swap(front,back);
+      back->clear();
+      }
+
+    uint32_t first = begin[0];
+    for(size_t i=0; i<beginSz; ++i) {
+      const int32_t iLen = pathLen[begin[i]] + int((exact - wp[begin[i]].position()).length());
+      const int32_t fLen = pathLen[first]    + int((exact - wp[first]   .position()).length());
+      if(iLen<fLen)
+        first = begin[i];
+      }
+    if(pathGen[first]!=gen)
+      return false;
+
+    path.push_back(first);
+    uint32_t current = first;
+    while(current!=end) {
+      const int32_t l0 = pathLen[current];
+      int32_t       l1 = l0;
+      uint32_t      next = WayHierarchy::None;
+      for(auto& c:wp[current].connections()) {
+        const uint32_t w = idOf(c.point);
+        if(pathGen[w]==gen && pathLen[w]+c.len<=l0 && pathLen[w]<l1) {
+          next = w;
+          l1   = pathLen[w];
+          }
+        }
+      if(next==WayHierarchy::None)
+        return false;
+      path.push_back(next);
+      current = next;
+      }
+    return true;
+    }
+  };
+
+// waynet: points are never moved, after connections are made
+struct WayNet {
+  std::vector<WayPoint> points;
+  std::vector<uint32_t> component;
+
+  void connect(uint32_t a, uint32_t b) {
+    points[a].connect(points[b]);
+    points[b].connect(points[a]);
+    }
+
+  void finish() {
+    component.assign(points.size(),WayHierarchy::None);
+    uint32_t cnt = 0;
+    std::vector<uint32_t> stk;
+    for(uint32_t i=0; i<points.size(); ++i) {
+      if(component[i]!=WayHierarchy::None)
+        continue;
+      component[i] = cnt;
+      stk.push_back(i);
+      while(!stk.empty()) {
+        const uint32_t id = stk.back();
+        stk.pop_back();
+        for(auto& c:points[id].connections()) {
+          const auto to = uint32_t(c.point-points.data());
+          if(component[to]==WayHierarchy::None) {
+            component[to] = cnt;
+            stk.push_back(to);
+            }
+          }
+        }
+      cnt++;
+      }
+    }
+
+  int32_t edge(uint32_t a, uint32_t b) const {
+    for(auto& c:points[a].connections())
+      if(c.point==&points[b])
+        return c.len;
+    return -1;
+    }
+
+  // length of path, including way from exact position to the first point; -1 if path is broken
+  int64_t length(const std::vector<uint32_t>& path, const Vec3& exact) const {
+    if(path.empty())
+      return -1;
+    int64_t ret = int32_t((exact-points[path[0]].position()).length());
+    for(size_t i=1; i<path.size(); ++i) {
+      const int32_t l = edge(path[i-1],path[i]);
+      if(l<0)
+        return -1;
+      ret += l;
+      }
+    return ret;
+    }
+  };
+
+// jittered grid with holes and missing links, similar to outdoor waynet
+static WayNet randomNet(std::mt19937& rng, int w, int h, float linkProb) {
+  std::uniform_real_distribution<float> jitter(-250,250), chance(0,1);
+  WayNet net;
+  std::vector<uint32_t> cell(size_t(w*h),WayHierarchy::None);
+  for(int y=0; y<h; ++y)
+    for(int x=0; x<w; ++x) {
+      if(chance(rng)<0.1f)
+        continue;
+      cell[size_t(x+y*w)] = uint32_t(net.points.size());
+      net.points.emplace_back(Vec3(float(x)*800.f+jitter(rng),jitter(rng),float(y)*800.f+jitter(rng)),"WP");
+      }
+  auto at = [&](int x, int y) { return (x<w && y<h) ? cell[size_t(x+y*w)] : WayHierarchy::None; };
+  for(int y=0; y<h; ++y)
+    for(int x=0; x<w; ++x) {
+      const uint32_t a = at(x,y);
+      if(a==WayHierarchy::None)
+        continue;
+      for(uint32_t b : {at(x+1,y),at(x,y+1),chance(rng)<0.2f ? at(x+1,y+1) : WayHierarchy::None})
+        if(b!=WayHierarchy::None && chance(rng)<linkProb)
+          net.connect(a,b);
+      }
+  net.finish();
+  return net;
+  }
+
+// waynet of game world; edges are linked the same way as in WayMatrix::buildIndex
+static bool worldNet(WayNet& net) {
+  if(!TestData::isAvailable())
+    return false;
+  auto world = TestData::world();
+  if(!CHECK(world.has_value()))
+    return false;
+  auto& wn = world->world_way_net;
+  for(auto& w:wn.waypoints)
+    net.points.emplace_back(w);
+  for(auto& e:wn.edges)
+    if(e.a<net.points.size() && e.b<net.points.size())
+      net.connect(e.a,e.b);
+  net.finish();
+  return !net.points.empty();
+  }
+
+struct Query {
+  std::vector<uint32_t> begin; // nearest point and its neighbours, as World::wayTo
+  Vec3                  exact;
+  uint32_t              end = 0;
+  };
+
+static std::vector<Query> randomQueries(std::mt19937& rng, const WayNet& net, size_t count, bool reachable) {
+  std::uniform_real_distribution<float> jitter(-300,300);
+  std::vector<Query> ret;
+  while(ret.size()<count) {
+    Query q;
+    const auto b = uint32_t(rng()%net.points.size());
+    q.end   = uint32_t(rng()%net.points.size());
+    q.exact = net.points[b].position()+Vec3(jitter(rng),0,jitter(rng));
+    if(reachable && net.component[b]!=net.component[q.end])
+      continue;
+    q.begin.push_back(b);
+    for(auto& c:net.points[b].connections())
+      q.begin.push_back(uint32_t(c.point-net.points.data()));
+    ret.push_back(std::move(q));
+    }
+  return ret;
+  }
+
+static bool route(const WayHierarchy& h, WayHierarchy::Context& ctx, const WayNet& net, const Query& q, std::vector<uint32_t>& path) {
+  std::vector<WayHierarchy::Start> st;
+  for(auto b:q.begin)
+    st.push_back({b,int32_t((q.exact-net.points[b].position()).length())});
+  return h.route(ctx,st.data(),st.size(),q.end,path);
+  }
+
+// reference: plain multi-source Dijkstra; distance to the end, or -1 if unreachable
+static int64_t dijkstra(const WayNet& net, const Query& q) {
+  std::vector<int64_t> dist(net.points.size(),std::numeric_limits<int64_t>::max());
+  std::vector<std::pair<int64_t,uint32_t>> heap;
+  auto cmp = [](const std::pair<int64_t,uint32_t>& a, const std::pair<int64_t,uint32_t>& b) { return a.first>b.first; };
+  for(auto b:q.begin) {
+    const int64_t l = int32_t((q.exact-net.points[b].position()).length());
+    if(l<dist[b]) {
+      dist[b] = l;
+      heap.push_back({l,b});
+      std::push_heap(heap.begin(),heap.end(),cmp);
+      }
+    }
+  while(!heap.empty()) {
+    std::pop_heap(heap.begin(),heap.end(),cmp);
+    const auto top = heap.back();
+    heap.pop_back();
+    if(top.first!=dist[top.second])
+      continue;
+    if(top.second==q.end)
+      return top.first;
+    for(auto& c:net.points[top.second].connections()) {
+      const auto    to = uint32_t(c.point-net.points.data());
+      const int64_t l  = top.first+c.len;
+      if(l<dist[to]) {
+        dist[to] = l;
+        heap.push_back({l,to});
+        std::push_heap(heap.begin(),heap.end(),cmp);
+        }
+      }
+    }
+  return -1;
+  }
+
+// every query: same reachability and length as Dijkstra, path is made of original edges, from a begin point to the end
+static size_t compareDijkstra(const WayHierarchy& h, const WayNet& net, const std::vector<Query>& query, size_t& unreachable) {
+  WayHierarchy::Context ctx;
+  std::vector<uint32_t> path;
+  size_t                mismatch = 0;
+  for(auto& q:query) {
+    const int64_t ref = dijkstra(net,q);
+    const bool    ok  = route(h,ctx,net,q,path);
+    if(ref<0) {
+      unreachable++;
+      if(ok || !path.empty())
+        mismatch++;
+      continue;
+      }
+    if(!ok || path.back()!=q.end ||
+       std::find(q.begin.begin(),q.begin.end(),path.front())==q.begin.end() ||
+       net.length(path,q.exact)!=ref)
+      mismatch++;
+    }
+  return mismatch;
+  }
+
+static void testRandomGraphs() {
+  std::mt19937 rng(2);
+  size_t unreachable = 0, total = 0;
+  // sparse nets fall apart into many components: unreachable pairs
+  for(float linkProb : {0.45f,0.6f,0.8f,1.f}) {
+    for(int it=0; it<4; ++it) {
+      const auto   net   = randomNet(rng,12+int(rng()%30),12+int(rng()%30),linkProb);
+      WayHierarchy h;
+      h.build(net.points);
+      CHECK(h.size()==net.points.size());
+
+      const auto   query    = randomQueries(rng,net,300,false);
+      const size_t mismatch = compareDijkstra(h,net,query,unreachable);
+      total += query.size();
+      if(!CHECK(mismatch==0))
+        std::fprintf(stderr,"  random graph %d, link probability %.2f: %d mismatches\n",it,double(linkProb),int(mismatch));
+      }
+    }
+  CHECK(unreachable>0);
+  CHECK(unreachable<total);
+  }
+
+static void testWorldNet() {
+  WayNet net;
+  if(!worldNet(net))
+    return;
+  WayHierarchy h;
+  h.build(net.points);
+
+  std::mt19937 rng(3);
+  size_t       unreachable = 0;
+  const auto   query       = randomQueries(rng,net,2000,false);
+  const size_t mismatch    = compareDijkstra(h,net,query,unreachable);
+  if(!CHECK(mismatch==0))
+    std::fprintf(stderr,"  world waynet: %d mismatches\n",int(mismatch));
+  }
+
+static void testEdgeCases() {
+  std::mt19937 rng(4);
+  const auto   net = randomNet(rng,10,10,1.f);
+  WayHierarchy h;
+  h.build(net.points);
+
+  WayHierarchy::Context ctx;
+  std::vector<uint32_t> path = {1,2,3};
+  const WayHierarchy::Start st[] = {{0,0}};
+  CHECK(!h.route(ctx,st,0,1,path));
+  CHECK(path.empty());
+  CHECK(!h.route(ctx,st,1,uint32_t(net.points.size()),path));
+
+  // invalid begin points are ignored
+  const WayHierarchy::Start bad[] = {{WayHierarchy::None,0},{uint32_t(net.points.size()),0}};
+  CHECK(!h.route(ctx,bad,2,0,path));
+  const WayHierarchy::Start mixed[] = {{WayHierarchy::None,0},{0,0}};
+  CHECK(h.route(ctx,mixed,2,0,path) && path==std::vector<uint32_t>{0});
+
+  // begin point with smaller initial length wins, even if it is farther away from the end
+  Query q;
+  q.end = uint32_t(net.points.size()-1);
+  for(auto& c:net.points[0].connections())
+    q.begin.push_back(uint32_t(c.point-net.points.data()));
+  q.begin.push_back(0);
+  q.exact = net.points[0].position();
+  CHECK(route(h,ctx,net,q,path) && net.length(path,q.exact)==dijkstra(net,q));
+
+  WayHierarchy empty;
+  empty.build(std::vector<WayPoint>());
+  CHECK(empty.size()==0);
+  CHECK(!empty.route(ctx,st,1,0,path));
+  }
+
+static void testSerialize() {
+  std::mt19937 rng(5);
+  const auto   net = randomNet(rng,30,30,0.7f);
+  WayHierarchy h;
+  h.build(net.points);
+
+  const auto   blob = h.serialize();
+  WayHierarchy r;
+  CHECK(r.deserialize(blob,net.points.size()));
+  CHECK(r.size()==h.size());
+  CHECK(r.serialize()==blob);
+
+  WayHierarchy::Context c0, c1;
+  std::vector<uint32_t> p0, p1;
+  size_t mismatch = 0;
+  for(auto& q:randomQueries(rng,net,500,false)) {
+    if(route(h,c0,net,q,p0)!=route(r,c1,net,q,p1) || p0!=p1)
+      mismatch++;
+    }
+  CHECK(mismatch==0);
+
+  // damaged or stale blobs are rejected
+  WayHierarchy x;
+  CHECK(!x.deserialize(blob,net.points.size()+1));
+  CHECK(!x.deserialize(std::vector<uint8_t>(blob.begin(),blob.end()-1),net.points.size()));
+  auto longer = blob;
+  longer.push_back(0);
+  CHECK(!x.deserialize(longer,net.points.size()));
+  CHECK(!x.deserialize(std::vector<uint8_t>(blob.begin(),blob.begin()+4),net.points.size()));
+  CHECK(!x.deserialize(std::vector<uint8_t>(),net.points.size()));
+
+  // arc, that points out of graph: last bytes of blob are 'mid' of last arc
+  auto corrupt = blob;
+  std::fill(corrupt.end()-4,corrupt.end(),uint8_t(0x7F));
+  CHECK(!x.deserialize(corrupt,net.points.size()));
+  }
+
+// random query set: flood fill against hierarchy, serial and batched on workers (as WayMatrix::wayTo(PathRequest))
+static void benchRouting(const WayNet& net, const char* name) {
+  std::mt19937 rng(11);
+  const auto   query = randomQueries(rng,net,2000,true);
+
+  Testing::Timer tBuild;
+  WayHierarchy   h;
+  h.build(net.points);
+  const double msBuild = tBuild.ms();
+
+  std::vector<std::vector<uint32_t>> pFlood(query.size()), pSerial(query.size()), pBatch(query.size());
+
+  FloodFill      flood;
+  Testing::Timer tFlood;
+  for(size_t i=0; i<query.size(); ++i)
+    flood.route(net.points,query[i].begin.data(),query[i].begin.size(),query[i].exact,query[i].end,pFlood[i]);
+  const double msFlood = tFlood.ms();
+
+  WayHierarchy::Context ctx;
+  Testing::Timer        tSerial;
+  for(size_t i=0; i<query.size(); ++i)
+    route(h,ctx,net,query[i],pSerial[i]);
+  const double msSerial = tSerial.ms();
+
+  std::vector<size_t> id(query.size());
+  for(size_t i=0; i<id.size(); ++i)
+    id[i] = i;
+  Testing::Timer tBatch;
+  Workers::parallelTasks(id,[&](size_t& i) {
+    static thread_local WayHierarchy::Context ctx;
+    route(h,ctx,net,query[i],pBatch[i]);
+    });
+  const double msBatch = tBatch.ms();
+
+  size_t shorter = 0, broken = 0, mismatch = 0;
+  for(size_t i=0; i<query.size(); ++i) {
+    const int64_t lf = net.length(pFlood [i],query[i].exact);
+    const int64_t lh = net.length(pSerial[i],query[i].exact);
+    if(lh<0 || pSerial[i].back()!=query[i].end)
+      broken++;
+    if(pBatch[i]!=pSerial[i])
+      mismatch++;
+    // flood fill stops, once every begin point is reached, so it may settle for a longer path
+    if(lf<0 || lh<lf)
+      shorter++;
+    else if(lh>lf)
+      mismatch++;
+    }
+  CHECK(broken==0);
+  CHECK(mismatch==0);
+
+  char buf[128] = {};
+  auto report = [&](const char* what, double v, const char* unit) {
+    std::snprintf(buf,sizeof(buf),"%s: %s",name,what);
+    Testing::report(buf,v,unit);
+    };
+  report("way-points",double(net.points.size()),"");
+  report("hierarchy build",msBuild,"ms");
+  report("flood fill          (per query)",msFlood *1000.0/double(query.size()),"us");
+  report("hierarchy, serial   (per query)",msSerial*1000.0/double(query.size()),"us");
+  report("hierarchy, batched  (per query)",msBatch *1000.0/double(query.size()),"us");
+  report("queries, where flood fill path is longer",double(shorter),"");
+  }
+
+int main() {
+  testRandomGraphs();
+  testWorldNet();
+  testEdgeCases();
+  testSerialize();
+
+  std::mt19937 rng(1);
+  benchRouting(randomNet(rng,60,60,0.9f),"synthetic");
+  WayNet world;
+  if(worldNet(world))
+    benchRouting(world,"world");
+  return Testing::result();
+  }
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "world/waypointindex.h"
+#include "world/waypoint.h"
+#include "testdata.h"
+#include "testing.h"
+
+using namespace Tempest;
+
+// reference: linear scan, as WayMatrix did before WayPointIndex
+template<class F>
+static const WayPoint* findLinear(const std::vector<WayPoint>& wp, const Vec3& at, float R, const F& filter) {
+  const WayPoint* ret  = nullptr;
+  float           dist = R<std::numeric_limits<float>::max() ? R*R : std::numeric_limits<float>::infinity();
+  for(auto& w:wp) {
+    const float l = (at-w.position()).quadLength();
+    if(l<=dist && filter(w)) {
+      ret  = &w;
+      dist = l;
+      }
+    }
+  return ret;
+  }
+
+static float qDist(const WayPoint* w, const Vec3& at) {
+  return w==nullptr ? -1.f : (w->position()-at).quadLength();
+  }
+
+static std::vector<const WayPoint*> pointers(const std::vector<WayPoint>& wp) {
+  std::vector<const WayPoint*> ret;
+  for(auto& w:wp)
+    ret.push_back(&w);
+  return ret;
+  }
+
+static void testEmpty() {
+  WayPointIndex index;
+  CHECK(index.findNearest(Vec3(),1000.f,[](const WayPoint&){ return true; })==nullptr);
+  std::vector<const WayPoint*> out = {nullptr};
+  index.findNearest(Vec3(),1000.f,4,[](const WayPoint&){ return true; },out);
+  CHECK(out.empty());
+  }
+
+static void compare(const std::vector<WayPoint>& wp, const std::vector<Vec3>& query, const char* name) {
+  WayPointIndex index;
+  index.build(pointers(wp));
+  CHECK(index.size()==wp.size());
+
+  // fixed rejection set stands for visibility/lock tests
+  std::mt19937      rng(7);
+  std::vector<char> reject(wp.size());
+  for(auto& r:reject)
+    r = (rng()%4==0);
+  size_t callsIndex = 0, callsLinear = 0;
+  auto filterIndex  = [&](const WayPoint& w){ callsIndex++;  return !reject[size_t(&w-wp.data())]; };
+  auto filterLinear = [&](const WayPoint& w){ callsLinear++; return !reject[size_t(&w-wp.data())]; };
+  auto any          = [](const WayPoint&){ return true; };
+
+  size_t mismatch = 0;
+  std::vector<const WayPoint*> knn;
+  for(auto& p:query) {
+    // distances are compared: equidistant points may be returned in any order
+    if(qDist(index.findNearest(p,std::numeric_limits<float>::max(),filterIndex),p)!=
+       qDist(findLinear(wp,p,std::numeric_limits<float>::max(),filterLinear),p))
+      mismatch++;
+    if(qDist(index.findNearest(p,900.f,any),p)!=qDist(findLinear(wp,p,900.f,any),p))
+      mismatch++;
+
+    index.findNearest(p,5000.f,4,any,knn);
+    std::vector<float> ref;
+    for(auto& w:wp) {
+      const float l = (w.position()-p).quadLength();
+      if(l<=5000.f*5000.f)
+        ref.push_back(l);
+      }
+    std::sort(ref.begin(),ref.end());
+    ref.resize(std::min<size_t>(ref.size(),4));
+    if(knn.size()!=ref.size()) {
+      mismatch++;
+      continue;
+      }
+    for(size_t i=0; i<knn.size(); ++i)
+      if(qDist(knn[i],p)!=ref[i])
+        mismatch++;
+    }
+  if(!CHECK(mismatch==0))
+    std::fprintf(stderr,"  %s: %d mismatches\n",name,int(mismatch));
+  // search stops at first accepted point
+  CHECK(callsIndex<callsLinear);
+
+  callsIndex = callsLinear = 0;
+  Testing::Timer tIndex;
+  for(auto& p:query)
+    Testing::doNotOptimize(index.findNearest(p,std::numeric_limits<float>::max(),filterIndex));
+  const double indexUs = tIndex.us();
+
+  Testing::Timer tLinear;
+  for(auto& p:query)
+    Testing::doNotOptimize(findLinear(wp,p,std::numeric_limits<float>::max(),filterLinear));
+  const double linearUs = tLinear.us();
+
+  char buf[128] = {};
+  std::snprintf(buf,sizeof(buf),"%s: way-points",name);
+  Testing::report(buf,double(wp.size()),"");
+  std::snprintf(buf,sizeof(buf),"%s: findWayPoint, index  (per query)",name);
+  Testing::report(buf,indexUs/double(query.size()),"us");
+  std::snprintf(buf,sizeof(buf),"%s: findWayPoint, linear (per query)",name);
+  Testing::report(buf,linearUs/double(query.size()),"us");
+  std::snprintf(buf,sizeof(buf),"%s: filter calls, index  (per query)",name);
+  Testing::report(buf,double(callsIndex)/double(query.size()),"");
+  std::snprintf(buf,sizeof(buf),"%s: filter calls, linear (per query)",name);
+  Testing::report(buf,double(callsLinear)/double(query.size()),"");
+  }
+
+static void testSynthetic() {
+  std::mt19937                          rng(3);
+  std::uniform_real_distribution<float> xz(-40000,40000), y(-2000,2000);
+
+  std::vector<WayPoint> wp;
+  for(int i=0; i<2800; ++i)
+    wp.emplace_back(Vec3(xz(rng),y(rng),xz(rng)),"WP");
+  // duplicates and a tight cluster
+  for(int i=0; i<16; ++i)
+    wp.emplace_back(Vec3(100,0,100),"WP_DUP");
+  for(int i=0; i<64; ++i)
+    wp.emplace_back(Vec3(float(i%8),0,float(i/8)),"WP_GRID");
+
+  std::vector<Vec3> query(2000);
+  for(auto& p:query)
+    p = Vec3(xz(rng),y(rng),xz(rng));
+  query.push_back(Vec3(100,0,100));
+  query.push_back(Vec3(3.5f,0,3.5f));
+  compare(wp,query,"synthetic");
+  }
+
+static void testWorld() {
+  if(!TestData::isAvailable())
+    return;
+  auto world = TestData::world();
+  if(!CHECK(world.has_value()))
+    return;
+
+  std::vector<WayPoint> wp;
+  for(auto& w:world->world_way_net.waypoints)
+    wp.emplace_back(w);
+  if(!CHECK(!wp.empty()))
+    return;
+
+  // npc positions: way-points with some jitter
+  std::mt19937                          rng(1);
+  std::uniform_real_distribution<float> jitter(-500.f,500.f);
+  std::vector<Vec3>                     query;
+  for(auto& w:wp)
+    query.push_back(w.position()+Vec3(jitter(rng),jitter(rng)*0.25f,jitter(rng)));
+  compare(wp,query,"world");
+  }
+
+int main() {
+  testEmpty();
+  testSynthetic();
+  testWorld();
+  return Testing::result();
+  }
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "utils/workers.h"
+#include "testing.h"
+
+static void testParallelFor() {
+  std::vector<int> v(100000);
+  Workers::parallelFor(v,[](int& x){ x+=1; });
+  CHECK(std::accumulate(v.begin(),v.end(),0)==100000);
+  Workers::parallelTasks(v,[](int& x){ x+=1; });
+  CHECK(std::accumulate(v.begin(),v.end(),0)==200000);
+
+  std::atomic<int> cnt{0};
+  Workers::parallelTasks(100,[&](uintptr_t){ cnt++; });
+  CHECK(cnt==100);
+  }
+
+static void testNested() {
+  std::atomic<long> n{0};
+  Workers::parallelTasks(32,[&](uintptr_t){
+    std::vector<int> w(1000,1);
+    Workers::parallelFor(w,[&](int& x){ n+=x; });
+    });
+  CHECK(n==32000);
+
+  // several non-worker threads fork-join at same time
+  std::vector<std::thread> ext;
+  std::atomic<long>        m{0};
+  for(int t=0; t<4; ++t)
+    ext.emplace_back([&](){
+      for(int k=0; k<500; ++k) {
+        std::vector<int> w(200,1);
+        Workers::parallelFor(w,[&](int& x){ m+=x; });
+        }
+      });
+  for(auto& t:ext)
+    t.join();
+  CHECK(m==4L*500*200);
+  }
+
+static void testGroups() {
+  Workers::Group   a, b;
+  std::atomic<int> sa{0};
+  std::atomic_bool ordered{true};
+  for(int i=0; i<50; ++i)
+    a.run([&](){ std::this_thread::sleep_for(std::chrono::microseconds(100)); sa++; });
+  b.runAfter(a,[&](){ if(sa!=50) ordered = false; });
+  b.wait();
+  a.wait();
+  CHECK(ordered);
+
+  // continuation of already finished group
+  Workers::Group d;
+  d.runAfter(a,[&](){ sa++; });
+  d.wait();
+  CHECK(sa==51);
+
+  Workers::Group e;
+  e.run([](){ throw std::runtime_error("task failed"); });
+  bool caught = false;
+  try {
+    e.wait();
+    }
+  catch(const std::runtime_error&) {
+    caught = true;
+    }
+  CHECK(caught);
+  }
+
+// fork-join overhead: 1..64 empty tasks, scheduler cost only; pool has hardware_concurrency threads
+static void benchForkJoin() {
+  const int Iterations = 2000;
+  Testing::report("worker threads + caller",double(Workers::maxThreads()),"");
+
+  for(size_t tasks=1; tasks<=64; tasks*=2) {
+    std::atomic<size_t> sum{0};
+    Testing::Timer      t;
+    for(int i=0; i<Iterations; ++i)
+      Workers::parallelTasks(tasks,[&](uintptr_t){ sum.fetch_add(1,std::memory_order_relaxed); });
+    const double us = t.us()/Iterations;
+    CHECK(sum==tasks*Iterations);
+
+    char name[64] = {};
+    std::snprintf(name,sizeof(name),"fork-join, %2d tasks",int(tasks));
+    Testing::report(name,us,"us");
+    }
+
+  // reference: thread per task
+  for(size_t tasks=1; tasks<=64; tasks*=8) {
+    std::atomic<size_t> sum{0};
+    Testing::Timer      t;
+    for(int i=0; i<Iterations/20; ++i) {
+      std::vector<std::thread> th;
+      for(size_t r=0; r<tasks; ++r)
+        th.emplace_back([&](){ sum.fetch_add(1,std::memory_order_relaxed); });
+      for(auto& x:th)
+        x.join();
+      }
+    char name[64] = {};
+    std::snprintf(name,sizeof(name),"fork-join, %2d std::thread",int(tasks));
+    Testing::report(name,t.us()/(Iterations/20),"us");
+    }
+  }
+
+// scaling with pool size: fork-join overhead and cpu-bound parallelFor, against same work on calling thread
+static void benchPool(uint32_t pool) {
+  CHECK(Workers::maxThreads()==pool);
+  char name[96] = {};
+
+  const int Iterations = 2000;
+  std::atomic<size_t> sum{0};
+  Testing::Timer      tFj;
+  for(int i=0; i<Iterations; ++i)
+    Workers::parallelTasks(16,[&](uintptr_t){ sum.fetch_add(1,std::memory_order_relaxed); });
+  CHECK(sum==16*Iterations);
+  std::snprintf(name,sizeof(name),"pool %2d: fork-join, 16 tasks",int(pool));
+  Testing::report(name,tFj.us()/Iterations,"us");
+
+  // ~10us per item
+  std::vector<float> items(4096);
+  auto work = [](float& v) {
+    float x = v;
+    for(int i=0; i<2000; ++i)
+      x = std::sqrt(x*x+1.f);
+    v = x;
+    };
+
+  for(auto& i:items)
+    i = 1;
+  Testing::Timer tSerial;
+  for(auto& i:items)
+    work(i);
+  const double msSerial = tSerial.ms();
+  const float  ref      = items[0];
+
+  for(auto& i:items)
+    i = 1;
+  Testing::Timer tParallel;
+  Workers::parallelFor(items,work);
+  const double msParallel = tParallel.ms();
+  CHECK(std::all_of(items.begin(),items.end(),[ref](float v){ return v==ref; }));
+
+  std::snprintf(name,sizeof(name),"pool %2d: parallelFor, 4096 items",int(pool));
+  Testing::report(name,msParallel,"ms");
+  std::snprintf(name,sizeof(name),"pool %2d: speedup vs calling thread",int(pool));
+  Testing::report(name,msSerial/msParallel,"x");
+  }
+
+int main(int argc, const char** argv) {
+  if(argc==3 && std::strcmp(argv[1],"--pool")==0) {
+    // child process: pool size is fixed for process lifetime
+    const uint32_t pool = uint32_t(std::atoi(argv[2]));
+    Workers::setMaxThreads(pool);
+    benchPool(pool);
+    return Testing::result();
+    }
+
+  testParallelFor();
+  testNested();
+  testGroups();
+  benchForkJoin();
+
+  std::printf("hardware threads: %u\n",std::thread::hardware_concurrency());
+  for(uint32_t pool=1; pool<=64; pool*=2) {
+    const std::string cmd = std::string("\"") + argv[0] + "\" --pool " + std::to_string(pool);
+    CHECK(std::system(cmd.c_str())==0);
+    }
+  return Testing::result();
+  }
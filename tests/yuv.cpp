@@ -0,0 +1,166 @@
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "bink/dsp.h"
+#include "testing.h"
+
+using namespace Bink;
+
+// reference: per-pixel conversion, as it was in Frame::yuvToRgba before Dsp kernels
+namespace Ref {
+
+static uint8_t clampU8(int v) {
+  return uint8_t(v<0 ? 0 : (v>255 ? 255 : v));
+  }
+
+static void yuvPixel(uint8_t* rgba, int y, int u, int v, int kB = 516) {
+  const int c = 298*(y-16) + 128;
+  const int d = u - 128;
+  const int e = v - 128;
+  rgba[0] = clampU8((c + 409*e)         >> 8);
+  rgba[1] = clampU8((c - 100*d - 208*e) >> 8);
+  rgba[2] = clampU8((c + kB*d)          >> 8);
+  rgba[3] = 255;
+  }
+
+}
+
+// BT.601 studio swing, in floating point
+struct Bt601 {
+  static constexpr double Kr = 0.299, Kb = 0.114, Kg = 1.0-Kr-Kb;
+  static constexpr double sY = 255.0/219.0, sC = 255.0/224.0;
+  static constexpr double rV = 2.0*(1.0-Kr)*sC;
+  static constexpr double gU = 2.0*(1.0-Kb)*Kb/Kg*sC;
+  static constexpr double gV = 2.0*(1.0-Kr)*Kr/Kg*sC;
+  static constexpr double bU = 2.0*(1.0-Kb)*sC;
+
+  static int channel(double v) {
+    return int(std::lround(std::min(255.0,std::max(0.0,v))));
+    }
+  static void pixel(int* rgb, int y, int u, int v) {
+    const double c = sY*(y-16), d = u-128, e = v-128;
+    rgb[0] = channel(c + rV*e);
+    rgb[1] = channel(c - gU*d - gV*e);
+    rgb[2] = channel(c + bU*d);
+    }
+  };
+
+static std::vector<const Dsp::Kernels*> allKernels() {
+  std::vector<const Dsp::Kernels*> ret = {&Dsp::scalarKernels()};
+  if(auto k = Dsp::simdKernels())
+    ret.push_back(k);
+  if(auto k = Dsp::avx2Kernels())
+    ret.push_back(k);
+  return ret;
+  }
+
+// fixed point coefficients are BT.601 ones, rounded to nearest in 8.8
+static void testCoefficients() {
+  CHECK(std::lround(Bt601::sY*256.0)==298);
+  CHECK(std::lround(Bt601::rV*256.0)==409);
+  CHECK(std::lround(Bt601::gU*256.0)==100);
+  CHECK(std::lround(Bt601::gV*256.0)==208);
+  CHECK(std::lround(Bt601::bU*256.0)==516); // 516.41, not 2.018*256 = 516.6
+
+  // every input: at most 1 off from exact conversion; 516 is closer to it than 517
+  size_t  err516 = 0, err517 = 0, maxErr = 0, total = 0;
+  uint8_t px516[4], px517[4];
+  int     exact[3];
+  for(int u=0; u<256; ++u)
+    for(int v=0; v<256; ++v)
+      for(int y=0; y<256; ++y) {
+        Ref::yuvPixel(px516,y,u,v,516);
+        Ref::yuvPixel(px517,y,u,v,517);
+        Bt601::pixel(exact,y,u,v);
+        for(int i=0; i<3; ++i) {
+          const size_t e = size_t(std::abs(px516[i]-exact[i]));
+          maxErr = std::max(maxErr,e);
+          err516 += e;
+          }
+        err517 += size_t(std::abs(px517[2]-exact[2])) + size_t(std::abs(px516[0]-exact[0])) + size_t(std::abs(px516[1]-exact[1]));
+        total  += 3;
+        }
+  CHECK(maxErr<=1);
+  CHECK(err516<err517);
+  Testing::report("channels off by one, vs exact BT.601",100.0*double(err516)/double(total),"%");
+  Testing::report("channels off by one, with kB=517",    100.0*double(err517)/double(total),"%");
+  }
+
+// kernels: bit-exact with reference for every width, odd tails and single-row calls
+static void testKernels() {
+  std::printf("active kernels: %s\n",Dsp::kernels().name);
+  std::mt19937 rng(1);
+  const uint8_t sentinel = 0xCD;
+  for(auto k:allKernels()) {
+    for(uint32_t w=1; w<=80; ++w) {
+      std::vector<uint8_t> py0(w), py1(w), pu((w+1)/2), pv((w+1)/2);
+      for(auto* p:{&py0,&py1,&pu,&pv})
+        for(auto& i:*p)
+          i = uint8_t(rng());
+      // extreme values, to hit saturation
+      if(w%3==0) {
+        pu[0] = 0;
+        pv[0] = 255;
+        }
+
+      std::vector<uint8_t> ref0(w*4), ref1(w*4);
+      for(uint32_t x=0; x<w; ++x) {
+        Ref::yuvPixel(&ref0[x*4],py0[x],pu[x/2],pv[x/2]);
+        Ref::yuvPixel(&ref1[x*4],py1[x],pu[x/2],pv[x/2]);
+        }
+
+      std::vector<uint8_t> out0(w*4+16,sentinel), out1(w*4+16,sentinel);
+      k->yuvRow2(out0.data(),out1.data(),py0.data(),py1.data(),pu.data(),pv.data(),w);
+      bool ok = std::memcmp(out0.data(),ref0.data(),w*4)==0 && std::memcmp(out1.data(),ref1.data(),w*4)==0;
+      for(size_t i=w*4; i<out0.size(); ++i)
+        ok &= (out0[i]==sentinel && out1[i]==sentinel);
+
+      std::vector<uint8_t> single(w*4+16,sentinel);
+      k->yuvRow2(single.data(),nullptr,py0.data(),nullptr,pu.data(),pv.data(),w);
+      ok &= std::memcmp(single.data(),ref0.data(),w*4)==0;
+
+      if(!CHECK(ok)) {
+        std::fprintf(stderr,"  kernels: %s, width: %d\n",k->name,int(w));
+        break;
+        }
+      }
+    }
+  }
+
+// whole frame, as Frame::yuvToRgba: 16-aligned plane strides, tightly packed output
+static void bench() {
+  struct Size { uint32_t w, h; const char* name; };
+  for(auto sz : {Size{640,480,"640x480"},Size{1920,1080,"1920x1080"}}) {
+    const uint32_t sY = ((sz.w+15)/16)*16, sC = ((sz.w/2+15)/16)*16;
+    std::vector<uint8_t> py(sY*sz.h), pu(sC*sz.h/2), pv(sC*sz.h/2), rgba(size_t(sz.w)*sz.h*4);
+    std::mt19937 rng(2);
+    for(auto* p:{&py,&pu,&pv})
+      for(auto& i:*p)
+        i = uint8_t(rng());
+
+    const int frames = sz.w>1000 ? 50 : 200;
+    for(auto k:allKernels()) {
+      Testing::Timer t;
+      for(int f=0; f<frames; ++f) {
+        for(uint32_t y=0; y<sz.h; y+=2) {
+          uint8_t* dst = rgba.data()+size_t(y)*sz.w*4;
+          k->yuvRow2(dst,dst+size_t(sz.w)*4,py.data()+y*sY,py.data()+(y+1)*sY,
+                     pu.data()+(y/2)*sC,pv.data()+(y/2)*sC,sz.w);
+          }
+        Testing::doNotOptimize(rgba);
+        }
+      char name[64] = {};
+      std::snprintf(name,sizeof(name),"%s, %s (per frame)",sz.name,k->name);
+      Testing::report(name,t.ms()/frames,"ms");
+      }
+    }
+  }
+
+int main() {
+  testCoefficients();
+  testKernels();
+  bench();
+  return Testing::result();
+  }
@@ -0,0 +1,152 @@
+#include <Tempest/MemWriter>
+
+#include <miniz.h>
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "utils/zipwriter.h"
+#include "testing.h"
+
+using Entries = std::vector<ZipWriter::Entry>;
+
+// device, that fails after limit bytes
+struct LimitedDevice : Tempest::ODevice {
+  size_t limit = 0;
+  size_t write(const void*, size_t size) override {
+    size = std::min(size,limit);
+    limit -= size;
+    return size;
+    }
+  void flush() override {}
+  };
+
+// structure similar to savegame: directories, small header entries, npc data, big world entries
+static Entries savegame(std::mt19937& rng, size_t npcCount, size_t worldSize) {
+  Entries ret;
+  auto add = [&](std::string name, size_t size, bool random) {
+    ZipWriter::Entry e;
+    e.name = std::move(name);
+    e.data.resize(size);
+    for(size_t i=0; i<size; ++i)
+      e.data[i] = random ? uint8_t(rng()) : uint8_t((i%16)<12 ? 0 : rng()%64);
+    ret.push_back(std::move(e));
+    };
+  ret.push_back({"header",{}});
+  add("header/version",2,false);
+  add("priview.png",64*1024,true);
+  ret.push_back({"worlds/",{}});
+  ret.push_back({"worlds/newworld/",{}});
+  add("worlds/newworld/world",worldSize,false);
+  ret.push_back({"worlds/newworld/npc/",{}});
+  for(size_t i=0; i<npcCount; ++i) {
+    char name[64] = {};
+    std::snprintf(name,sizeof(name),"worlds/newworld/npc/%d/data",int(i));
+    add(name,2000+rng()%3000,false);
+    std::snprintf(name,sizeof(name),"worlds/newworld/npc/%d/visual",int(i));
+    add(name,100+rng()%200,false);
+    }
+  return ret;
+  }
+
+static bool sameAsArchive(const Entries& entries, const std::vector<uint8_t>& zip) {
+  mz_zip_archive rd = {};
+  if(!mz_zip_reader_init_mem(&rd,zip.data(),zip.size(),0))
+    return false;
+  bool ok = (mz_zip_reader_get_num_files(&rd)==entries.size());
+  for(mz_uint i=0; ok && i<entries.size(); ++i) {
+    mz_zip_archive_file_stat stat = {};
+    ok = mz_zip_reader_file_stat(&rd,i,&stat) && entries[i].name==stat.m_filename &&
+         stat.m_uncomp_size==entries[i].data.size();
+    if(!ok || entries[i].data.empty())
+      continue;
+    std::vector<uint8_t> data(entries[i].data.size());
+    ok = mz_zip_reader_extract_to_mem(&rd,i,data.data(),data.size(),0) && data==entries[i].data;
+    }
+  mz_zip_reader_end(&rd);
+  return ok;
+  }
+
+static void testRoundTrip() {
+  std::mt19937 rng(1);
+  auto         entries = savegame(rng,50,300*1024);
+  for(int level : {0,1,9}) {
+    std::vector<uint8_t> zip;
+    Tempest::MemWriter   wr{zip};
+    CHECK(ZipWriter::write(wr,entries,level));
+    if(!CHECK(sameAsArchive(entries,zip)))
+      std::fprintf(stderr,"  compression level %d\n",level);
+    }
+
+  // empty archive
+  std::vector<uint8_t> zip;
+  Tempest::MemWriter   wr{zip};
+  CHECK(ZipWriter::write(wr,Entries(),9));
+  CHECK(sameAsArchive(Entries(),zip));
+
+  // device error is reported
+  for(size_t limit : {size_t(0),size_t(100),size_t(50000)}) {
+    LimitedDevice dev;
+    dev.limit = limit;
+    CHECK(!ZipWriter::write(dev,entries,1));
+    }
+  }
+
+// main-thread time of save: before, archive was compressed by caller; now it is handed to save thread
+static void bench() {
+  std::mt19937 rng(2);
+  const auto   src = savegame(rng,800,8*1024*1024);
+  size_t       raw = 0;
+  for(auto& e:src)
+    raw += e.data.size();
+  Testing::report("savegame entries",double(src.size()),"");
+  Testing::report("savegame size, uncompressed",double(raw)/1024.0/1024.0,"MB");
+
+  for(int level : {1,9}) {
+    // synchronous: caller waits for compression and write
+    auto entries = src;
+    std::vector<uint8_t> zipSync;
+    Testing::Timer tSync;
+    {
+    Tempest::MemWriter wr{zipSync};
+    ZipWriter::write(wr,entries,level);
+    }
+    const double msSync = tSync.ms();
+
+    // background, as Gothic::startSaveWrite: caller only moves archive into save thread
+    entries = src;
+    std::vector<uint8_t> zipAsync;
+    double               msWrite = 0;
+    Testing::Timer       tBlock;
+    std::thread th([&zipAsync,&msWrite,level,ar=std::move(entries)]() {
+      Testing::Timer     t;
+      Tempest::MemWriter wr{zipAsync};
+      ZipWriter::write(wr,ar,level);
+      msWrite = t.ms();
+      });
+    const double msBlock = tBlock.ms();
+    th.join();
+    // archives differ in timestamps only
+    CHECK(zipAsync.size()==zipSync.size());
+    CHECK(sameAsArchive(src,zipAsync));
+
+    char name[96] = {};
+    std::snprintf(name,sizeof(name),"level %d: archive size",level);
+    Testing::report(name,double(zipSync.size())/1024.0/1024.0,"MB");
+    std::snprintf(name,sizeof(name),"level %d: main thread blocked, synchronous",level);
+    Testing::report(name,msSync,"ms");
+    std::snprintf(name,sizeof(name),"level %d: main thread blocked, background",level);
+    Testing::report(name,msBlock,"ms");
+    std::snprintf(name,sizeof(name),"level %d: background write",level);
+    Testing::report(name,msWrite,"ms");
+    }
+  }
+
+int main() {
+  testRoundTrip();
+  bench();
+  return Testing::result();
+  }